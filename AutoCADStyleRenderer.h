@@ -2,6 +2,7 @@
 #include "pch.h"
 #include "Camera.h"
 #include "Models.h"
+#include "TextLayoutCache.h"
 
 namespace winrt::estimate1
 {
@@ -47,9 +48,8 @@ namespace winrt::estimate1
             float fontSize = static_cast<float>(70.0 * camera.GetZoom());
             fontSize = (std::max)(10.0f, (std::min)(20.0f, fontSize));
 
-            auto format = Microsoft::Graphics::Canvas::Text::CanvasTextFormat();
-            format.FontSize(fontSize);
-            format.HorizontalAlignment(Microsoft::Graphics::Canvas::Text::CanvasHorizontalAlignment::Center);
+            auto format = TextLayoutCache::Shared().GetFormat(
+                DisplayFont::Default, fontSize, DisplayTextAlign::TopCenter);
 
             // : 
             Windows::UI::Color color = Windows::UI::ColorHelper::FromArgb(255, 255, 160, 50);
@@ -111,9 +111,8 @@ namespace winrt::estimate1
             wchar_t angleText[32];
             swprintf_s(angleText, L"%.2f", angleDegrees);
 
-            auto format = Microsoft::Graphics::Canvas::Text::CanvasTextFormat();
-            format.FontSize(11);
-            format.HorizontalAlignment(Microsoft::Graphics::Canvas::Text::CanvasHorizontalAlignment::Center);
+            auto format = TextLayoutCache::Shared().GetFormat(
+                DisplayFont::Default, 11.0f, DisplayTextAlign::TopCenter);
 
             session.DrawText(angleText, Windows::Foundation::Numerics::float2(textPos.X, textPos.Y), arcColor, format);
         }
@@ -153,12 +152,9 @@ namespace winrt::estimate1
             pos.X += 15.0f;
             pos.Y += 15.0f;
 
-            auto format = Microsoft::Graphics::Canvas::Text::CanvasTextFormat();
-            format.FontSize(12);
-
             //   ( )
-            auto layout = Microsoft::Graphics::Canvas::Text::CanvasTextLayout(
-                session, hintText.c_str(), format, 0.0f, 0.0f);
+            auto layout = TextLayoutCache::Shared().GetLayout(
+                session, hintText, DisplayFont::Default, 12.0f);
             
             auto bounds = layout.LayoutBounds();
             Windows::Foundation::Rect bgRect(
@@ -170,11 +166,10 @@ namespace winrt::estimate1
             session.FillRectangle(bgRect, Windows::UI::ColorHelper::FromArgb(220, 255, 255, 255));
             session.DrawRectangle(bgRect, Windows::UI::ColorHelper::FromArgb(255, 100, 100, 100), 1.0f);
 
-            session.DrawText(
-                hintText.c_str(),
+            session.DrawTextLayout(
+                layout,
                 Windows::Foundation::Numerics::float2(pos.X, pos.Y),
-                Windows::UI::ColorHelper::FromArgb(255, 50, 50, 50),
-                format);
+                Windows::UI::ColorHelper::FromArgb(255, 50, 50, 50));
         }
 
         //    (   )
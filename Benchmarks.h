@@ -0,0 +1,816 @@
+#pragma once
+
+// ============================================================================
+// ARC-Estimate Benchmarks
+// Performance measurements for geometry passes on synthetic plans
+// ============================================================================
+
+#include "pch.h"
+#include "Camera.h"
+#include "Models.h"
+#include "Element.h"
+#include "WallStore.h"
+#include "RoomDetector.h"
+#include "WallJoinSystem.h"
+#include "WallAttachmentSystem.h"
+#include "WallJoinGraph.h"
+#include "WallJunctionSolver.h"
+#include "GeometryKernels.h"
+#include "WallSnapSystem.h"
+#include "DrawingTools.h"
+#include "ReferenceSnapProvider.h"
+#include "DxfReferenceRenderer.h"
+#include "LabelDeclutter.h"
+#include "FrameProfiler.h"
+#include "WallRenderer.h"
+#include <vector>
+#include <string>
+#include <functional>
+#include <sstream>
+#include <chrono>
+#include <random>
+
+namespace winrt::estimate1::benchmarks
+{
+    // ============================================================================
+    // Benchmark Framework
+    // ============================================================================
+
+    struct BenchmarkResult
+    {
+        std::wstring Name;
+        size_t Items{ 0 };           // elements processed per iteration
+        size_t Iterations{ 0 };
+        double TotalMs{ 0.0 };
+        double NsPerItem{ 0.0 };
+        double Checksum{ 0.0 };      // keeps the optimizer from dropping the work
+    };
+
+    struct BenchmarkSuite
+    {
+        std::wstring Name;
+        std::vector<BenchmarkResult> Results;
+    };
+
+    // With a profiler set through Profiler() and enabled, every measured
+    // iteration is recorded as a frame holding a scope named after the
+    // benchmark, so a headless run yields the same histogram and Chrome
+    // trace as the canvas. None is set by default: the app runs the
+    // benchmarks off the UI thread, which owns FrameProfiler::Shared().
+    class BenchmarkRunner
+    {
+    public:
+        // The function returns a checksum of its work
+        using BenchFunc = std::function<double()>;
+
+        explicit BenchmarkRunner(double minDurationMs = 50.0)
+            : m_minDurationMs(minDurationMs)
+        {
+        }
+
+        void Add(const std::wstring& name, size_t items, BenchFunc func)
+        {
+            m_benchmarks.push_back({ name, items, std::move(func) });
+        }
+
+        static FrameProfiler*& Profiler()
+        {
+            static FrameProfiler* profiler = nullptr;
+            return profiler;
+        }
+
+        BenchmarkSuite Run(const std::wstring& suiteName)
+        {
+            FrameProfiler idle;                 // disabled stand-in when none is set
+            FrameProfiler& profiler = Profiler() ? *Profiler() : idle;
+
+            BenchmarkSuite suite;
+            suite.Name = suiteName;
+
+            for (const auto& bench : m_benchmarks)
+            {
+                BenchmarkResult result;
+                result.Name = bench.Name;
+                result.Items = bench.Items;
+
+                // Warm-up run
+                result.Checksum = bench.Func();
+
+                auto start = std::chrono::high_resolution_clock::now();
+                double elapsedMs = 0.0;
+                do
+                {
+                    ProfileFrame frame(profiler);
+                    ProfileScope scope(bench.Name.c_str(), profiler);
+                    result.Checksum += bench.Func();
+                    ++result.Iterations;
+                    elapsedMs = std::chrono::duration<double, std::milli>(
+                        std::chrono::high_resolution_clock::now() - start).count();
+                } while (elapsedMs < m_minDurationMs);
+
+                result.TotalMs = elapsedMs;
+                size_t work = (std::max)(static_cast<size_t>(1), result.Items) * result.Iterations;
+                result.NsPerItem = elapsedMs * 1.0e6 / static_cast<double>(work);
+
+                suite.Results.push_back(result);
+            }
+
+            return suite;
+        }
+
+    private:
+        struct Entry
+        {
+            std::wstring Name;
+            size_t Items;
+            BenchFunc Func;
+        };
+
+        std::vector<Entry> m_benchmarks;
+        double m_minDurationMs;
+    };
+
+    // ============================================================================
+    // Synthetic plans
+    // ============================================================================
+
+    // Grid of rectangular rooms: (cols+1)*rows + (rows+1)*cols walls
+    inline void BuildRoomGrid(DocumentModel& doc, int cols, int rows, double cell = 3000.0)
+    {
+        bool autoDims = doc.IsAutoDimensionsEnabled();
+        doc.SetAutoDimensionsEnabled(false);
+
+        for (int r = 0; r <= rows; ++r)
+            for (int c = 0; c < cols; ++c)
+                doc.AddWall({ c * cell, r * cell }, { (c + 1) * cell, r * cell }, 200.0);
+
+        for (int c = 0; c <= cols; ++c)
+            for (int r = 0; r < rows; ++r)
+                doc.AddWall({ c * cell, r * cell }, { c * cell, (r + 1) * cell }, 200.0);
+
+        doc.SetAutoDimensionsEnabled(autoDims);
+    }
+
+    // Same grid as bare wall axes, bypassing DocumentModel (joins and
+    // dimensions on AddWall dominate setup time for large grids)
+    inline WallHotData BuildRoomGridHotData(int cols, int rows, double cell = 3000.0)
+    {
+        WallHotData hot;
+        for (int r = 0; r <= rows; ++r)
+            for (int c = 0; c < cols; ++c)
+                hot.PushBack(Wall({ c * cell, r * cell }, { (c + 1) * cell, r * cell }, 200.0));
+
+        for (int c = 0; c <= cols; ++c)
+            for (int r = 0; r < rows; ++r)
+                hot.PushBack(Wall({ c * cell, r * cell }, { c * cell, (r + 1) * cell }, 200.0));
+
+        return hot;
+    }
+
+    // Same grid as standalone walls, for the join systems
+    inline std::vector<std::unique_ptr<Wall>> BuildRoomGridWalls(int cols, int rows, double cell = 3000.0)
+    {
+        std::vector<std::unique_ptr<Wall>> walls;
+        for (int r = 0; r <= rows; ++r)
+            for (int c = 0; c < cols; ++c)
+                walls.push_back(std::make_unique<Wall>(WorldPoint{ c * cell, r * cell }, WorldPoint{ (c + 1) * cell, r * cell }, 200.0));
+
+        for (int c = 0; c <= cols; ++c)
+            for (int r = 0; r < rows; ++r)
+                walls.push_back(std::make_unique<Wall>(WorldPoint{ c * cell, r * cell }, WorldPoint{ c * cell, (r + 1) * cell }, 200.0));
+
+        return walls;
+    }
+
+    // Walls with their heap objects scattered between unrelated allocations,
+    // as they are after a long editing session
+    inline std::vector<std::unique_ptr<Wall>> BuildScatteredWalls(size_t count, std::vector<std::unique_ptr<char[]>>& padding)
+    {
+        std::mt19937 rng(12345);
+        std::uniform_real_distribution<double> coord(0.0, 100000.0);
+        std::uniform_int_distribution<int> gap(64, 4096);
+
+        std::vector<std::unique_ptr<Wall>> walls;
+        walls.reserve(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            padding.push_back(std::make_unique<char[]>(static_cast<size_t>(gap(rng))));
+            walls.push_back(std::make_unique<Wall>(
+                WorldPoint{ coord(rng), coord(rng) }, WorldPoint{ coord(rng), coord(rng) }, 200.0));
+        }
+        std::shuffle(walls.begin(), walls.end(), rng);
+        return walls;
+    }
+
+    // ============================================================================
+    // WallStore Benchmarks
+    // ============================================================================
+
+    inline BenchmarkSuite RunWallStoreBenchmarks()
+    {
+        BenchmarkRunner runner;
+
+        const size_t wallCount = 20000;
+        auto padding = std::make_shared<std::vector<std::unique_ptr<char[]>>>();
+        auto scattered = std::make_shared<std::vector<std::unique_ptr<Wall>>>(BuildScatteredWalls(wallCount, *padding));
+
+        auto store = std::make_shared<WallStore>();
+        for (const auto& w : *scattered)
+            store->Insert(std::make_unique<Wall>(*w));
+
+        // Bulk pass over pointer-per-wall storage
+        runner.Add(L"LengthAndBounds_UniquePtr", wallCount, [scattered]() {
+            double sum = 0.0;
+            for (const auto& w : *scattered)
+            {
+                WorldPoint s = w->GetStartPoint();
+                WorldPoint e = w->GetEndPoint();
+                sum += s.Distance(e) + (std::min)(s.X, e.X) + w->GetThickness();
+            }
+            return sum;
+        });
+
+        // Same pass over the dense hot arrays
+        runner.Add(L"LengthAndBounds_HotData", wallCount, [store]() {
+            const WallHotData& hot = store->Hot();
+            double sum = 0.0;
+            for (size_t i = 0; i < hot.Size(); ++i)
+            {
+                double dx = hot.EndX[i] - hot.StartX[i];
+                double dy = hot.EndY[i] - hot.StartY[i];
+                sum += std::sqrt(dx * dx + dy * dy) + (std::min)(hot.StartX[i], hot.EndX[i]) + hot.Thickness[i];
+            }
+            return sum;
+        });
+
+        runner.Add(L"LookupById_WallStore", wallCount, [store]() {
+            double sum = 0.0;
+            for (uint64_t id : store->Hot().Ids)
+                sum += store->FindById(id)->GetThickness();
+            return sum;
+        });
+
+        return runner.Run(L"WallStore Benchmarks");
+    }
+
+    // ============================================================================
+    // Room Detector Benchmarks
+    // ============================================================================
+
+    inline BenchmarkSuite RunRoomDetectorBenchmarks()
+    {
+        BenchmarkRunner runner;
+
+        // Square grids from 12 to ~10,000 walls
+        const int sizes[] = { 2, 7, 22, 70 };
+        for (int n : sizes)
+        {
+            auto hot = std::make_shared<WallHotData>(BuildRoomGridHotData(n, n));
+            size_t wallCount = hot->Size();
+
+            runner.Add(L"DetectRooms_Grid" + std::to_wstring(wallCount), wallCount, [hot]() {
+                auto rooms = RoomDetector::DetectRooms(*hot);
+                return static_cast<double>(rooms.size());
+            });
+
+            runner.Add(L"WallGraphBuild_Grid" + std::to_wstring(wallCount), wallCount, [hot]() {
+                WallGraph graph = WallGraph::Build(*hot);
+                return static_cast<double>(graph.GetNodeCount());
+            });
+
+            // Re-trace after one wall edit, against a full detection above
+            auto graph = std::make_shared<WallGraph>(WallGraph::Build(*hot));
+            auto rooms = std::make_shared<std::vector<std::shared_ptr<Room>>>(RoomDetector::DetectRooms(*graph));
+            std::vector<uint64_t> changed{ hot->Ids[hot->Size() / 2] };
+            runner.Add(L"UpdateRoomsOneWall_Grid" + std::to_wstring(wallCount), wallCount, [graph, rooms, changed]() {
+                RoomUpdate update = RoomDetector::UpdateRooms(*graph, *rooms, changed);
+                return static_cast<double>(rooms->size() + update.Modified.size());
+            });
+        }
+
+        return runner.Run(L"Room Detector Benchmarks");
+    }
+
+    // ============================================================================
+    // Wall Join Benchmarks
+    // ============================================================================
+
+    inline BenchmarkSuite RunWallJoinBenchmarks()
+    {
+        BenchmarkRunner runner;
+
+        const int sizes[] = { 7, 22, 70 };
+        for (int n : sizes)
+        {
+            auto walls = std::make_shared<std::vector<std::unique_ptr<Wall>>>(BuildRoomGridWalls(n, n));
+            size_t wallCount = walls->size();
+
+            runner.Add(L"FindAllJoins_Indexed_Grid" + std::to_wstring(wallCount), wallCount, [walls]() {
+                WallJoinSystem joins;
+                return static_cast<double>(joins.FindAllJoins(*walls).size());
+            });
+
+            runner.Add(L"FindAllAttachmentJoins_Indexed_Grid" + std::to_wstring(wallCount), wallCount, [walls]() {
+                WallAttachmentSystem joins;
+                return static_cast<double>(joins.FindAllJoins(*walls).size());
+            });
+
+            // Persistent join graph: full build against a one-wall patch
+            auto store = std::make_shared<WallStore>();
+            for (auto& wall : BuildRoomGridWalls(n, n))
+                store->Insert(std::move(wall));
+            auto index = std::make_shared<WallJoinIndex>(store->Objects());
+
+            runner.Add(L"JoinGraphRebuild_Grid" + std::to_wstring(wallCount), wallCount, [store, index]() {
+                WallJoinGraph graph;
+                graph.Rebuild(*store, *index);
+                return static_cast<double>(graph.GetJoinCount());
+            });
+
+            auto graph = std::make_shared<WallJoinGraph>();
+            graph->Rebuild(*store, *index);
+            ChangeSet changes;
+            changes.Modified.push_back(store->Objects()[wallCount / 2]->GetId());
+            runner.Add(L"JoinGraphUpdateOneWall_Grid" + std::to_wstring(wallCount), wallCount, [store, index, graph, changes]() {
+                graph->Update(*store, *index, changes);
+                return static_cast<double>(graph->GetLastRefreshedCount());
+            });
+
+            // Per-wall queries over the plain list, as callers did before
+            if (n > 22)
+                continue;
+            runner.Add(L"FindJoinsPerWall_Linear_Grid" + std::to_wstring(wallCount), wallCount, [walls]() {
+                WallJoinSystem joins;
+                size_t count = 0;
+                for (const auto& wall : *walls)
+                    count += joins.FindJoins(*wall, *walls).size();
+                return static_cast<double>(count);
+            });
+        }
+
+        // End caps at a four-way node: one solver pass against pairwise joins
+        auto cross = std::make_shared<std::vector<std::unique_ptr<Wall>>>();
+        cross->push_back(std::make_unique<Wall>(WorldPoint{ 0, 0 }, WorldPoint{ 3000, 0 }, 200.0));
+        cross->push_back(std::make_unique<Wall>(WorldPoint{ 0, 3000 }, WorldPoint{ 0, 0 }, 200.0));
+        cross->push_back(std::make_unique<Wall>(WorldPoint{ -3000, 0 }, WorldPoint{ 0, 0 }, 200.0));
+        cross->push_back(std::make_unique<Wall>(WorldPoint{ 0, 0 }, WorldPoint{ 0, -3000 }, 200.0));
+
+        runner.Add(L"JunctionCaps_Cross4_Solver", cross->size(), [cross]() {
+            std::vector<JunctionArm> arms;
+            for (const auto& wall : *cross)
+                WallJunctionSolver::AddArms(*wall, { 0, 0 }, 5.0, arms);
+            return static_cast<double>(WallJunctionSolver::Solve({ 0, 0 }, arms).size());
+        });
+
+        runner.Add(L"JunctionCaps_Cross4_Pairwise", cross->size(), [cross]() {
+            WallAttachmentSystem joins;
+            size_t points = 0;
+            for (const auto& wall : *cross)
+                points += joins.BuildWallContour(*wall, joins.FindJoins(*wall, *cross)).size();
+            return static_cast<double>(points);
+        });
+
+        return runner.Run(L"Wall Join Benchmarks");
+    }
+
+    // ============================================================================
+    // Geometry Kernel Benchmarks
+    // ============================================================================
+
+    inline BenchmarkSuite RunGeometryKernelBenchmarks()
+    {
+        BenchmarkRunner runner;
+        std::wstring isa = GeometryKernels::GetInstructionSetName();
+
+        for (size_t count : { 1000, 10000, 100000 })
+        {
+            auto hot = std::make_shared<WallHotData>();
+            std::mt19937 rng(7);
+            std::uniform_real_distribution<double> coord(0.0, 100000.0);
+            for (size_t i = 0; i < count; ++i)
+            {
+                double x = coord(rng), y = coord(rng);
+                hot->Ids.push_back(i + 1);
+                hot->StartX.push_back(x);
+                hot->StartY.push_back(y);
+                hot->EndX.push_back(x + 3000.0);
+                hot->EndY.push_back(y + 1000.0);
+                hot->Thickness.push_back(200.0);
+            }
+            std::wstring n = std::to_wstring(count);
+            WorldPoint p(50000.0, 50000.0);
+
+            // The per-wall loop hit testing used before the kernels
+            runner.Add(L"HitTest_" + n + L"_Scalar", count, [hot, p]() {
+                size_t hits = 0;
+                for (size_t i = 0; i < hot->Size(); ++i)
+                {
+                    double d = GeometryKernels::DistancePointToSegment(p,
+                        { hot->StartX[i], hot->StartY[i] }, { hot->EndX[i], hot->EndY[i] });
+                    if (d <= hot->Thickness[i] / 2.0 + 500.0)
+                        ++hits;
+                }
+                return static_cast<double>(hits);
+            });
+
+            runner.Add(L"HitTest_" + n + L"_" + isa, count, [hot, p]() {
+                std::vector<uint32_t> hits;
+                GeometryKernels::CollectWithin(p, hot->Segments(), hot->Thickness.data(), 500.0, hits);
+                return static_cast<double>(hits.size());
+            });
+
+            runner.Add(L"Nearest_" + n + L"_" + isa, count, [hot, p]() {
+                double distance;
+                return static_cast<double>(GeometryKernels::NearestSegment(p, hot->Segments(), 1e9, distance));
+            });
+        }
+
+        return runner.Run(L"Geometry Kernel Benchmarks");
+    }
+
+    // ============================================================================
+    // Snap Benchmarks
+    // ============================================================================
+
+    inline BenchmarkSuite RunSnapBenchmarks()
+    {
+        BenchmarkRunner runner;
+
+        // ~10,000 walls; one query per pointer move along a diagonal
+        auto doc = std::make_shared<DocumentModel>();
+        BuildRoomGrid(*doc, 70, 70);
+        doc->SetAutoDimensionsEnabled(false);
+        const size_t moves = 100;
+        auto cursorAt = [](size_t i) { return WorldPoint(1500.0 + i * 2003.0, 1000.0 + i * 1999.0); };
+
+        runner.Add(L"FindBestSnap_FullScan", moves, [doc, cursorAt]() {
+            WallSnapSystem snap;
+            double sum = 0.0;
+            for (size_t i = 0; i < moves; ++i)
+                sum += snap.FindBestSnap(cursorAt(i), WorldPoint(0, 0), doc->GetWalls(), 0.2).Distance;
+            return sum;
+        });
+
+        auto indexed = std::make_shared<WallSnapSystem>();
+        indexed->FindBestSnap(WorldPoint(0, 0), std::nullopt, *doc, 0.2);
+        runner.Add(L"FindBestSnap_Index", moves, [doc, indexed, cursorAt]() {
+            double sum = 0.0;
+            for (size_t i = 0; i < moves; ++i)
+                sum += indexed->FindBestSnap(cursorAt(i), WorldPoint(0, 0), *doc, 0.2).Distance;
+            return sum;
+        });
+
+        // The wall tool's query through SnapEngine: faces and alignment
+        // first, then wall ends, crossings, midpoints
+        auto planes = std::make_shared<WallSnapSystem>();
+        auto engine = std::make_shared<SnapManager>();
+        const SnapProvider* preferred = engine->AddProvider(std::make_unique<WallPlaneSnapProvider>(*planes));
+        doc->GetWallGraph();
+        planes->FindBestSnap(WorldPoint(0, 0), std::nullopt, *doc, 0.2);
+        runner.Add(L"SnapEngine_WallTool", moves, [doc, planes, engine, preferred, cursorAt]() {
+            Camera camera;
+            camera.SetZoom(0.2);
+            LayerManager layers;
+            double sum = 0.0;
+            for (size_t i = 0; i < moves; ++i)
+            {
+                SnapQuery query = engine->MakeQuery(cursorAt(i), *doc, layers, camera);
+                query.StartPoint = WorldPoint(0, 0);
+                query.WallPlanes = true;
+                query.Preferred = preferred;
+                sum += engine->FindSnap(query).point.X;
+            }
+            return sum;
+        });
+
+        // Index kept current across a one-wall edit per query
+        runner.Add(L"FindBestSnap_Index_AfterEdit", moves, [doc, indexed, cursorAt]() {
+            double sum = 0.0;
+            Wall* wall = doc->GetWalls()[0].get();
+            for (size_t i = 0; i < moves; ++i)
+            {
+                wall->SetEndPoint({ 3000.0, (i % 2) * 10.0 });
+                doc->SyncWallEdits();
+                sum += indexed->FindBestSnap(cursorAt(i), WorldPoint(0, 0), *doc, 0.2).Distance;
+            }
+            return sum;
+        });
+
+        return runner.Run(L"Snap Benchmarks");
+    }
+
+    // ============================================================================
+    // Reference Snap Benchmarks
+    // ============================================================================
+
+    // About 1M segments: a 200 m square of plan-like line work, short
+    // strokes with some long grid lines, as a large DXF underlay
+    inline void BuildReferenceLinework(ReferenceSnapIndex& index, size_t count)
+    {
+        std::mt19937 rng(11);
+        std::uniform_real_distribution<double> pos(0.0, 200000.0);
+        std::uniform_real_distribution<double> len(50.0, 1500.0);
+        for (size_t i = 0; i < count; ++i)
+        {
+            WorldPoint a(pos(rng), pos(rng));
+            double l = i % 1000 == 0 ? 50000.0 : len(rng);
+            index.AddSegment(a, i % 2 ? WorldPoint(a.X + l, a.Y) : WorldPoint(a.X, a.Y + l));
+        }
+    }
+
+    inline BenchmarkSuite RunReferenceSnapBenchmarks()
+    {
+        BenchmarkRunner runner;
+        const size_t segments = 1000000;
+
+        runner.Add(L"ReferenceSnapIndex_Build", segments, [segments]() {
+            ReferenceSnapIndex index;
+            BuildReferenceLinework(index, segments);
+            index.Finish();
+            return static_cast<double>(index.GetMemoryUsage());
+        });
+
+        auto index = std::make_shared<ReferenceSnapIndex>();
+        BuildReferenceLinework(*index, segments);
+        index->Finish();
+        auto cursorAt = [](size_t i) { return WorldPoint(1000.0 + i * 1993.0, 1500.0 + i * 1987.0); };
+
+        // Nearest line by a batched scan of every segment
+        const size_t scans = 10;
+        runner.Add(L"ReferenceSnap_FullScan", scans, [index, cursorAt, scans]() {
+            double sum = 0.0;
+            for (size_t i = 0; i < scans; ++i)
+            {
+                double distance = 0.0;
+                GeometryKernels::NearestSegment(cursorAt(i), index->GetSegments(), 75.0, distance);
+                sum += distance;
+            }
+            return sum;
+        });
+
+        // Every snap kind through the grid, 15 px at zoom 0.2
+        auto dxf = std::make_shared<DxfReferenceManager>();
+        auto ifc = std::make_shared<IfcReferenceManager>();
+        auto provider = std::make_shared<ReferenceSnapProvider>(*dxf, *ifc);
+        const size_t moves = 100;
+        runner.Add(L"ReferenceSnap_Index", moves, [index, provider, cursorAt, dxf, ifc]() {
+            double sum = 0.0;
+            for (size_t i = 0; i < moves; ++i)
+            {
+                SnapQuery query;
+                query.Cursor = cursorAt(i);
+                query.StartPoint = WorldPoint(0, 0);
+                query.Tolerance = 75.0;
+                SnapHitList hits;
+                provider->QueryIndex(*index, query, hits);
+                sum += hits.Size();
+            }
+            return sum;
+        });
+
+        return runner.Run(L"Reference Snap Benchmarks");
+    }
+
+    // ============================================================================
+    // Display List Benchmarks
+    // ============================================================================
+
+    // A DXF underlay of plan-like line work: mostly lines, some bulged
+    // polylines, circles and text
+    inline std::shared_ptr<DxfReferenceLayer> BuildDxfUnderlay(size_t count)
+    {
+        std::mt19937 rng(5);
+        std::uniform_real_distribution<double> pos(0.0, 200000.0);
+        std::uniform_real_distribution<double> len(50.0, 1500.0);
+        std::vector<std::unique_ptr<DxfEntity>> entities;
+        entities.reserve(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            WorldPoint a(pos(rng), pos(rng));
+            if (i % 50 == 0)
+            {
+                auto poly = std::make_unique<DxfPolyline>();
+                poly->Vertices = { { a, 0.0 }, { WorldPoint(a.X + len(rng), a.Y), 0.5 },
+                                   { WorldPoint(a.X + 1500, a.Y + len(rng)), 0.0 } };
+                entities.push_back(std::move(poly));
+            }
+            else if (i % 50 == 1)
+            {
+                auto circle = std::make_unique<DxfCircle>();
+                circle->Center = a;
+                circle->Radius = len(rng) / 4.0;
+                entities.push_back(std::move(circle));
+            }
+            else if (i % 50 == 2)
+            {
+                auto text = std::make_unique<DxfText>();
+                text->Position = a;
+                text->Height = 250.0;
+                text->Content = L"R" + std::to_wstring(i);
+                entities.push_back(std::move(text));
+            }
+            else
+            {
+                auto line = std::make_unique<DxfLine>();
+                line->Start = a;
+                line->End = i % 2 ? WorldPoint(a.X + len(rng), a.Y) : WorldPoint(a.X, a.Y + len(rng));
+                entities.push_back(std::move(line));
+            }
+        }
+
+        auto layer = std::make_shared<DxfReferenceLayer>();
+        layer->TakeEntities(entities);
+        return layer;
+    }
+
+    inline BenchmarkSuite RunDisplayListBenchmarks()
+    {
+        BenchmarkRunner runner;
+        const size_t entities = 200000;
+        auto layer = BuildDxfUnderlay(entities);
+
+        // Rebuilding an underlay's list, as on every frame before
+        runner.Add(L"DisplayList_BuildDxf", entities, [layer]() {
+            DisplayList list;
+            DxfReferenceRenderer::BuildLayer(list, *layer);
+            return static_cast<double>(list.GetCommandCount());
+        });
+
+        auto list = std::make_shared<DisplayList>();
+        DxfReferenceRenderer::BuildLayer(*list, *layer);
+
+        // Merging a retained list into a frame list
+        runner.Add(L"DisplayList_Append", list->GetPointCount(), [list]() {
+            DisplayList frame;
+            frame.Append(*list);
+            return static_cast<double>(frame.GetMemoryUsage());
+        });
+
+        runner.Add(L"DisplayList_Hash", list->GetPointCount(), [list]() {
+            return static_cast<double>(list->ComputeHash() & 0xFFFF);
+        });
+
+        // Culling the underlay to a 20 x 12 m view, as Draw does per frame
+        auto index = std::make_shared<DisplayCommandIndex>();
+        index->Build(*list);
+        const size_t views = 1000;
+        runner.Add(L"DisplayList_CullQuery", views, [index]() {
+            std::vector<uint32_t> found;
+            double sum = 0.0;
+            for (size_t i = 0; i < views; ++i)
+            {
+                float x = static_cast<float>((i * 7919) % 180) * 1000.0f;
+                float y = static_cast<float>((i * 104729) % 188) * 1000.0f;
+                DisplayBounds view;
+                view.Extend(x, y);
+                view.Extend(x + 20000.0f, y + 12000.0f);
+                index->Query(view, found);
+                sum += found.size();
+            }
+            return sum;
+        });
+
+        // Decluttering a dense frame: 5,000 labels over a 1920 x 1080
+        // canvas, most of them colliding
+        const size_t labels = 5000;
+        runner.Add(L"DisplayList_DeclutterLabels", labels, []() {
+            LabelDeclutter declutter;
+            declutter.Begin(1920.0f, 1080.0f);
+            for (size_t i = 0; i < labels; ++i)
+            {
+                float x = static_cast<float>((i * 7919) % 1920);
+                float y = static_cast<float>((i * 104729) % 1080);
+                declutter.TryPlace(LabelDeclutter::EstimateBox(L"3600 mm", 12.0f, DisplayTextAlign::TopLeft, x, y));
+            }
+            return static_cast<double>(declutter.GetPlacedCount());
+        });
+
+        // ~10,000 walls: a frame of a static plan, then a frame after
+        // one wall was edited (the renderer's share only: the journal
+        // and join graph are not synced)
+        auto doc = std::make_shared<DocumentModel>();
+        BuildRoomGrid(*doc, 70, 70);
+        doc->SetAutoDimensionsEnabled(false);
+        auto walls = std::make_shared<WallRenderer>();
+        auto layers = std::make_shared<LayerManager>();
+        ViewSettings view;
+        walls->Update(*doc, *layers, 0, view);
+
+        const size_t frames = 100;
+        runner.Add(L"WallRenderer_StaticFrame", frames, [doc, walls, layers, view]() {
+            double sum = 0.0;
+            for (size_t i = 0; i < frames; ++i)
+            {
+                walls->Update(*doc, *layers, 0, view);
+                sum += walls->GetLastRebuiltCount();
+            }
+            return sum;
+        });
+
+        runner.Add(L"WallRenderer_EditFrame", 10, [doc, walls, layers, view]() {
+            double sum = 0.0;
+            for (size_t i = 0; i < 10; ++i)
+            {
+                Wall* wall = doc->GetWalls()[500 + i].get();
+                wall->SetThickness(wall->GetThickness() + 10.0);
+                walls->Update(*doc, *layers, 0, view);
+                sum += walls->GetLastRebuiltCount();
+            }
+            return sum;
+        });
+
+        return runner.Run(L"Display List Benchmarks");
+    }
+
+    // ============================================================================
+    // Frame Profiler Benchmarks
+    // ============================================================================
+
+    inline BenchmarkSuite RunFrameProfilerBenchmarks()
+    {
+        BenchmarkRunner runner;
+
+        // A frame with the canvas's ~20 scopes, recorded
+        auto profiler = std::make_shared<FrameProfiler>();
+        profiler->SetEnabled(true);
+        const wchar_t* names[] = { L"Grid", L"Walls update", L"Plan build", L"Tiles", L"Underlay draw",
+            L"Slabs draw", L"Walls draw", L"Plan draw", L"Label placement", L"Highlights draw" };
+        const size_t scopes = 2 * std::size(names);
+        runner.Add(L"FrameProfiler_Scopes", scopes, [profiler, names]() {
+            ProfileFrame frame(*profiler);
+            for (int pass = 0; pass < 2; ++pass)
+            {
+                for (const wchar_t* name : names)
+                {
+                    ProfileScope scope(name, *profiler);
+                }
+            }
+            return static_cast<double>(profiler->GetEventCount());
+        });
+
+        // The same scopes with the profiler off, as when the overlay is hidden
+        auto idle = std::make_shared<FrameProfiler>();
+        runner.Add(L"FrameProfiler_ScopesDisabled", scopes, [idle, names]() {
+            ProfileFrame frame(*idle);
+            for (int pass = 0; pass < 2; ++pass)
+            {
+                for (const wchar_t* name : names)
+                {
+                    ProfileScope scope(name, *idle);
+                }
+            }
+            return static_cast<double>(idle->GetFrameCount());
+        });
+
+        // Statistics and trace of a full window, as the overlay and F4 do
+        runner.Add(L"FrameProfiler_Export", 1, [profiler]() {
+            auto stats = profiler->GetFrameStats();
+            return stats.AverageMs + static_cast<double>(profiler->ExportChromeTrace().size());
+        });
+
+        return runner.Run(L"Frame Profiler Benchmarks");
+    }
+
+    // ============================================================================
+    // Run All Benchmarks
+    // ============================================================================
+
+    struct AllBenchmarksResult
+    {
+        std::vector<BenchmarkSuite> Suites;
+
+        std::wstring GetSummary() const
+        {
+            std::wstringstream ss;
+            ss << L"=== BENCHMARKS ===\n\n";
+
+            for (const auto& suite : Suites)
+            {
+                ss << L"[" << suite.Name << L"]\n";
+                for (const auto& r : suite.Results)
+                {
+                    ss << L"  " << r.Name << L": " << r.NsPerItem << L" ns/item ("
+                       << r.Items << L" items x " << r.Iterations << L")\n";
+                }
+                ss << L"\n";
+            }
+
+            return ss.str();
+        }
+    };
+
+    inline AllBenchmarksResult RunAllBenchmarks()
+    {
+        AllBenchmarksResult result;
+        result.Suites.push_back(RunWallStoreBenchmarks());
+        result.Suites.push_back(RunRoomDetectorBenchmarks());
+        result.Suites.push_back(RunWallJoinBenchmarks());
+        result.Suites.push_back(RunGeometryKernelBenchmarks());
+        result.Suites.push_back(RunSnapBenchmarks());
+        result.Suites.push_back(RunReferenceSnapBenchmarks());
+        result.Suites.push_back(RunDisplayListBenchmarks());
+        result.Suites.push_back(RunFrameProfilerBenchmarks());
+        return result;
+    }
+
+} // namespace winrt::estimate1::benchmarks
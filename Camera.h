@@ -58,6 +58,8 @@ namespace winrt::estimate1
         void SetZoom(double zoom) { 
             m_zoom = std::clamp(zoom, m_minZoom, m_maxZoom); 
         }
+        static constexpr double GetMinZoom() { return m_minZoom; }
+        static constexpr double GetMaxZoom() { return m_maxZoom; }
 
         //   
         float GetCanvasWidth() const { return m_canvasWidth; }
@@ -0,0 +1,256 @@
+#pragma once
+
+#include "pch.h"
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <functional>
+#include <algorithm>
+
+namespace winrt::estimate1
+{
+    // =================================================================
+    // CHANGE JOURNAL - document revisions for derived caches
+    // =================================================================
+    // Every mutation through DocumentModel bumps the document revision
+    // and appends a record. Each element remembers the revision of its
+    // last change. A derived cache (wall geometry, rooms, zones, snap
+    // index, estimate) stores the revision it was built at and asks
+    // GetChangesSince() for what to patch, instead of being cleared.
+    //
+    // The journal keeps a bounded history. A cache older than the
+    // history gets a ChangeSet with IsFullReset set and rebuilds.
+    // =================================================================
+
+    enum class ChangeKind : uint8_t
+    {
+        Added,
+        Removed,
+        Modified
+    };
+
+    enum class JournalElementKind : uint8_t
+    {
+        Wall,
+        Door,
+        Window,
+        Column,
+        Slab,
+        Beam,
+        Dimension,
+        Other
+    };
+
+    struct ChangeRecord
+    {
+        uint64_t Revision{ 0 };
+        uint64_t ElementId{ 0 };
+        JournalElementKind ElementKind{ JournalElementKind::Other };
+        ChangeKind Kind{ ChangeKind::Modified };
+    };
+
+    // Net effect of the records between two revisions. An element added
+    // and removed in the range appears in neither list; an element added
+    // and then modified appears only in Added.
+    struct ChangeSet
+    {
+        uint64_t FromRevision{ 0 };
+        uint64_t ToRevision{ 0 };
+        bool IsFullReset{ false };
+
+        std::vector<uint64_t> Added;
+        std::vector<uint64_t> Removed;
+        std::vector<uint64_t> Modified;
+
+        bool Empty() const
+        {
+            return !IsFullReset && Added.empty() && Removed.empty() && Modified.empty();
+        }
+
+        size_t Count() const { return Added.size() + Removed.size() + Modified.size(); }
+    };
+
+    class ChangeJournal
+    {
+    public:
+        using Listener = std::function<void(const ChangeRecord&)>;
+        using SubscriptionId = uint64_t;
+
+        explicit ChangeJournal(size_t maxRecords = 8192)
+            : m_maxRecords((std::max)(maxRecords, static_cast<size_t>(16)))
+        {
+        }
+
+        ChangeJournal(const ChangeJournal&) = delete;
+        ChangeJournal& operator=(const ChangeJournal&) = delete;
+
+        uint64_t GetRevision() const { return m_revision; }
+
+        // Revision of the last change to the element, 0 if never recorded
+        uint64_t GetElementRevision(uint64_t id) const
+        {
+            auto it = m_elementRevisions.find(id);
+            return it != m_elementRevisions.end() ? it->second : 0;
+        }
+
+        void RecordAdded(uint64_t id, JournalElementKind kind) { Record(id, kind, ChangeKind::Added); }
+        void RecordRemoved(uint64_t id, JournalElementKind kind) { Record(id, kind, ChangeKind::Removed); }
+        void RecordModified(uint64_t id, JournalElementKind kind) { Record(id, kind, ChangeKind::Modified); }
+
+        // Whole document replaced (clear, load). Caches must rebuild.
+        void RecordReset()
+        {
+            ++m_revision;
+            m_records.clear();
+            m_elementRevisions.clear();
+            m_historyStart = m_revision;
+
+            ChangeRecord record;
+            record.Revision = m_revision;
+            Notify(record);
+        }
+
+        // Net changes after 'revision' up to the current one.
+        // Pass kind to restrict the result to one element kind.
+        ChangeSet GetChangesSince(uint64_t revision) const
+        {
+            return Collect(revision, nullptr);
+        }
+
+        ChangeSet GetChangesSince(uint64_t revision, JournalElementKind kind) const
+        {
+            return Collect(revision, &kind);
+        }
+
+        bool HasChangesSince(uint64_t revision) const { return revision != m_revision; }
+
+        // Listeners are called synchronously after each record.
+        // A reset is delivered as a record with ElementId 0.
+        SubscriptionId Subscribe(Listener listener)
+        {
+            SubscriptionId id = ++m_nextSubscriptionId;
+            m_listeners.push_back({ id, std::move(listener) });
+            return id;
+        }
+
+        void Unsubscribe(SubscriptionId id)
+        {
+            m_listeners.erase(
+                std::remove_if(m_listeners.begin(), m_listeners.end(),
+                    [id](const Subscription& s) { return s.Id == id; }),
+                m_listeners.end());
+        }
+
+        size_t GetRecordCount() const { return m_records.size(); }
+
+    private:
+        struct Subscription
+        {
+            SubscriptionId Id;
+            Listener Callback;
+        };
+
+        void Record(uint64_t id, JournalElementKind kind, ChangeKind change)
+        {
+            if (id == 0)
+                return;
+
+            ++m_revision;
+
+            ChangeRecord record{ m_revision, id, kind, change };
+            m_records.push_back(record);
+            m_elementRevisions[id] = m_revision;
+
+            // Drop the oldest half in one go; consumers behind it get a reset
+            if (m_records.size() > m_maxRecords)
+            {
+                size_t drop = m_records.size() / 2;
+                m_historyStart = m_records[drop - 1].Revision;
+                m_records.erase(m_records.begin(), m_records.begin() + drop);
+            }
+
+            Notify(record);
+        }
+
+        void Notify(const ChangeRecord& record)
+        {
+            for (const auto& s : m_listeners)
+            {
+                if (s.Callback)
+                    s.Callback(record);
+            }
+        }
+
+        ChangeSet Collect(uint64_t revision, const JournalElementKind* kind) const
+        {
+            ChangeSet set;
+            set.FromRevision = revision;
+            set.ToRevision = m_revision;
+
+            if (revision >= m_revision)
+                return set;
+
+            if (revision < m_historyStart)
+            {
+                set.IsFullReset = true;
+                return set;
+            }
+
+            // Records are ordered by revision
+            auto first = std::upper_bound(m_records.begin(), m_records.end(), revision,
+                [](uint64_t rev, const ChangeRecord& r) { return rev < r.Revision; });
+
+            struct NetChange
+            {
+                bool Existed;   // present before the range
+                bool Exists;    // present after the range
+                size_t Order;
+            };
+            std::unordered_map<uint64_t, NetChange> net;
+            size_t order = 0;
+
+            for (auto it = first; it != m_records.end(); ++it)
+            {
+                if (kind && it->ElementKind != *kind)
+                    continue;
+
+                auto found = net.find(it->ElementId);
+                if (found == net.end())
+                {
+                    bool existed = it->Kind != ChangeKind::Added;
+                    found = net.emplace(it->ElementId, NetChange{ existed, existed, order++ }).first;
+                }
+                found->second.Exists = it->Kind != ChangeKind::Removed;
+            }
+
+            // Emit in first-touch order so results are deterministic
+            std::vector<std::pair<size_t, uint64_t>> ordered;
+            ordered.reserve(net.size());
+            for (const auto& kv : net)
+                ordered.push_back({ kv.second.Order, kv.first });
+            std::sort(ordered.begin(), ordered.end());
+
+            for (const auto& entry : ordered)
+            {
+                const NetChange& c = net.at(entry.second);
+                if (!c.Existed && c.Exists)
+                    set.Added.push_back(entry.second);
+                else if (c.Existed && !c.Exists)
+                    set.Removed.push_back(entry.second);
+                else if (c.Existed && c.Exists)
+                    set.Modified.push_back(entry.second);
+            }
+
+            return set;
+        }
+
+        uint64_t m_revision{ 0 };
+        uint64_t m_historyStart{ 0 };       // changes after this revision are in m_records
+        size_t m_maxRecords;
+        std::deque<ChangeRecord> m_records;
+        std::unordered_map<uint64_t, uint64_t> m_elementRevisions;
+
+        std::vector<Subscription> m_listeners;
+        SubscriptionId m_nextSubscriptionId{ 0 };
+    };
+}
@@ -5,6 +5,9 @@
 #include "Dimension.h"
 #include "Layer.h"
 #include "Models.h"
+#include "DisplayList.h"
+#include "DisplayListRenderer.h"
+#include "TextLayoutCache.h"
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
@@ -31,17 +34,27 @@ namespace winrt::estimate1
         {
             (void)layerManager;
 
+            m_scratch.Clear();
+            Build(m_scratch, document);
+            m_backend.Draw(session, camera, m_scratch);
+        }
+
+        //      
+        void Build(DisplayList& list, const DocumentModel& document)
+        {
             //  
             for (const auto& dim : document.GetDimensions())
             {
-                DrawDimension(session, camera, *dim, false);
+                BuildDimension(list, *dim, false);
             }
 
             //    ( )
             for (const auto& dim : document.GetManualDimensions())
             {
-                DrawDimension(session, camera, *dim, true);
+                BuildDimension(list, *dim, true);
             }
+
+            m_labels.EndPass();
         }
 
         //      
@@ -59,7 +72,9 @@ namespace winrt::estimate1
             Dimension preview(p1, p2);
             preview.SetOffset(offset);
 
-            DrawDimension(session, camera, preview, true, true);
+            m_scratch.Clear();
+            BuildDimension(m_scratch, preview, true, true);
+            m_backend.Draw(session, camera, m_scratch);
         }
 
         // =====================================================
@@ -105,11 +120,9 @@ namespace winrt::estimate1
             float textX = screenCenter.X + textRadius * static_cast<float>(std::cos(midAngle));
             float textY = screenCenter.Y + textRadius * static_cast<float>(std::sin(midAngle));
 
-            auto textFormat = Microsoft::Graphics::Canvas::Text::CanvasTextFormat();
-            textFormat.FontSize(11);
-
-            auto textLayout = Microsoft::Graphics::Canvas::Text::CanvasTextLayout(
-                session.Device(), angleText, textFormat, 100, 30);
+            auto textLayout = TextLayoutCache::Shared().GetLayout(
+                session, angleText, DisplayFont::Default, 11.0f,
+                DisplayTextAlign::TopLeft, 100.0f, 30.0f);
 
             float textWidth = textLayout.LayoutBounds().Width;
             float textHeight = textLayout.LayoutBounds().Height;
@@ -120,7 +133,7 @@ namespace winrt::estimate1
                 3.0f, 3.0f,
                 Windows::UI::ColorHelper::FromArgb(220, 255, 255, 230));
 
-            session.DrawText(angleText, textX - textWidth / 2, textY - textHeight / 2, arcColor);
+            session.DrawTextLayout(textLayout, textX - textWidth / 2, textY - textHeight / 2, arcColor);
         }
 
         //     (  )
@@ -187,6 +200,7 @@ namespace winrt::estimate1
     private:
         uint64_t m_hoverDimensionId{ 0 };
         DimensionHandle m_hoverHandle{ DimensionHandle::None };
+        LabelTextCache m_labels;            //    Id
 
         void DrawArc(
             const Microsoft::Graphics::Canvas::CanvasDrawingSession& session,
@@ -229,114 +243,81 @@ namespace winrt::estimate1
                 : Windows::UI::ColorHelper::FromArgb(180, 80, 80, 80);
         }
 
-        void DrawDimension(
-            const Microsoft::Graphics::Canvas::CanvasDrawingSession& session,
-            const Camera& camera,
-                const Dimension& dim,
-                bool isManual = false,
-                bool isPreview = false)
-            {
-                WorldPoint p1 = dim.GetP1();
-                WorldPoint p2 = dim.GetP2();
-
-                // 
-                double dx = p2.X - p1.X;
-                double dy = p2.Y - p1.Y;
-                double len = std::sqrt(dx * dx + dy * dy);
-                if (len < 0.001)
-                    return;
-
-                double nx = -dy / len;
-                double ny = dx / len;
-
-                double offset = dim.GetOffset();
-                WorldPoint a1(p1.X + nx * offset, p1.Y + ny * offset);
-                WorldPoint a2(p2.X + nx * offset, p2.Y + ny * offset);
-
-                auto s1 = camera.WorldToScreen(p1);
-                auto s2 = camera.WorldToScreen(p2);
-                auto sa1 = camera.WorldToScreen(a1);
-                auto sa2 = camera.WorldToScreen(a2);
-
-                Windows::UI::Color color = BaseColor(dim.IsSelected(), isManual || dim.IsManual());
-            
-                //    
-                if (isPreview)
-                {
-                    color.A = 150;
-                }
+        void BuildDimension(
+            DisplayList& list,
+            const Dimension& dim,
+            bool isManual = false,
+            bool isPreview = false)
+        {
+            WorldPoint p1 = dim.GetP1();
+            WorldPoint p2 = dim.GetP2();
+
+            // 
+            double dx = p2.X - p1.X;
+            double dy = p2.Y - p1.Y;
+            double len = std::sqrt(dx * dx + dy * dy);
+            if (len < 0.001)
+                return;
 
-                //  
-                session.DrawLine(
-                    Windows::Foundation::Numerics::float2(s1.X, s1.Y),
-                    Windows::Foundation::Numerics::float2(sa1.X, sa1.Y),
-                    color,
-                    1.0f);
+            double nx = -dy / len;
+            double ny = dx / len;
 
-                session.DrawLine(
-                    Windows::Foundation::Numerics::float2(s2.X, s2.Y),
-                    Windows::Foundation::Numerics::float2(sa2.X, sa2.Y),
-                    color,
-                    1.0f);
+            double offset = dim.GetOffset();
+            WorldPoint a1(p1.X + nx * offset, p1.Y + ny * offset);
+            WorldPoint a2(p2.X + nx * offset, p2.Y + ny * offset);
 
-                //  
-                float lineWidth = isPreview ? 1.0f : 1.5f;
-                session.DrawLine(
-                    Windows::Foundation::Numerics::float2(sa1.X, sa1.Y),
-                    Windows::Foundation::Numerics::float2(sa2.X, sa2.Y),
-                    color,
-                    lineWidth);
-
-                // 
-                DimensionTickType tickType = dim.GetTickType();
-                
-                //    ( p1  p2)
-                double dimDirX = ny; 
-                double dimDirY = -nx;
-                
-                //  Arrow   "" (   )
-                //  sa1 ()   (p1 - p2) ->  (nx,-ny) -> .. (-ny, nx)
-                //    nx,ny    .
-                //   (dx, dy).  (-dy, dx).
-                //    .
-                
-                //      
-                float sdx = sa2.X - sa1.X;
-                float sdy = sa2.Y - sa1.Y;
-                float slen = std::sqrt(sdx*sdx + sdy*sdy);
-                float dirX = (slen > 0.001f) ? sdx / slen : 0.0f;
-                float dirY = (slen > 0.001f) ? sdy / slen : 0.0f;
-
-                //  
-                //  sa1 (Start):    ( sa2).     ()   ()?
-                //  "Filled Arrow":    .
-                //         (<).
-                //       (>).
-                
-                DrawTick(session, sa1, -dirX, -dirY, color, tickType);
-                DrawTick(session, sa2, dirX, dirY, color, tickType);
-
-                // 
-                double value = dim.GetValueMm();
+            Windows::UI::Color color = BaseColor(dim.IsSelected(), isManual || dim.IsManual());
+        
+            //    
+            if (isPreview)
+            {
+                color.A = 150;
+            }
+
+            //  
+            uint16_t thin = list.AddStyle(DisplayStyle::Stroke(color, 1.0f));
+            list.AddLine(thin, p1, a1);
+            list.AddLine(thin, p2, a2);
+
+            //  
+            float lineWidth = isPreview ? 1.0f : 1.5f;
+            list.AddLine(list.AddStyle(DisplayStyle::Stroke(color, lineWidth)), a1, a2);
+
+            // .  "Filled Arrow":   
+            // ,      ,   - .
+            //         .
+            WorldPoint dir(dx / len, dy / len);
+            DimensionTickType tickType = dim.GetTickType();
+            AddTick(list, a1, WorldPoint(-dir.X, -dir.Y), color, tickType);
+            AddTick(list, a2, dir, color, tickType);
+
+            // 
+            //        
+            double value = dim.GetValueMm();
+            auto formatValue = [value]()
+            {
                 wchar_t text[64];
                 swprintf_s(text, L"%.0f ", value);
-
-                //   -   
-                ScreenPoint mid((sa1.X + sa2.X) * 0.5f, (sa1.Y + sa2.Y) * 0.5f);
-                session.DrawText(
-                text,
-                mid.X + 6.0f,
-                mid.Y - 10.0f,
-                Windows::UI::ColorHelper::FromArgb(220, 40, 40, 40));
+                return std::wstring(text);
+            };
+            std::wstring text = isPreview
+                ? formatValue()
+                : m_labels.Get(dim.GetId(), LabelTextCache::ValueStamp(value), formatValue);
+
+            //   -   
+            WorldPoint mid((a1.X + a2.X) * 0.5, (a1.Y + a2.Y) * 0.5);
+            list.AddText(
+                list.AddStyle(DisplayStyle::Text(Windows::UI::ColorHelper::FromArgb(220, 40, 40, 40))
+                    .WithPriority(DisplayLabelPriority::Dimension)),
+                mid, std::move(text), 6.0f, -10.0f);
 
             //  lock
             if (dim.IsLocked())
             {
-                session.DrawText(
-                    L"??",
-                    mid.X - 14.0f,
-                    mid.Y - 14.0f,
-                    Windows::UI::ColorHelper::FromArgb(180, 120, 120, 120));
+                list.AddText(
+                    list.AddStyle(DisplayStyle::Text(Windows::UI::ColorHelper::FromArgb(180, 120, 120, 120))
+                        .WithPriority(DisplayLabelPriority::Always)),
+                    mid, L"??", -14.0f, -14.0f);
             }
 
             // CAD- (    )
@@ -346,18 +327,15 @@ namespace winrt::estimate1
                 WorldPoint h1w, hmw, h2w;
                 dim.GetHandlePoints(h1w, hmw, h2w);
 
-                DrawHandle(session, camera.WorldToScreen(h1w), color,
-                    hoverThis && m_hoverHandle == DimensionHandle::Start);
-                DrawHandle(session, camera.WorldToScreen(hmw), color,
-                    hoverThis && m_hoverHandle == DimensionHandle::Middle);
-                DrawHandle(session, camera.WorldToScreen(h2w), color,
-                    hoverThis && m_hoverHandle == DimensionHandle::End);
+                AddHandle(list, h1w, color, hoverThis && m_hoverHandle == DimensionHandle::Start);
+                AddHandle(list, hmw, color, hoverThis && m_hoverHandle == DimensionHandle::Middle);
+                AddHandle(list, h2w, color, hoverThis && m_hoverHandle == DimensionHandle::End);
             }
         }
 
-        void DrawHandle(
-            const Microsoft::Graphics::Canvas::CanvasDrawingSession& session,
-            const ScreenPoint& at,
+        void AddHandle(
+            DisplayList& list,
+            const WorldPoint& at,
             Windows::UI::Color color,
             bool isHot = false)
         {
@@ -366,81 +344,34 @@ namespace winrt::estimate1
                 ? Windows::UI::ColorHelper::FromArgb(255, 255, 240, 200)
                 : Windows::UI::ColorHelper::FromArgb(230, 255, 255, 255);
 
-            session.FillRectangle(
-                Windows::Foundation::Rect(at.X - size / 2, at.Y - size / 2, size, size),
-                fill);
-            session.DrawRectangle(
-                Windows::Foundation::Rect(at.X - size / 2, at.Y - size / 2, size, size),
-                color,
-                isHot ? 2.0f : 1.5f);
+            list.AddMarker(list.AddStyle(DisplayStyle::Fill(fill)), at, MarkerShape::Square, size, true);
+            list.AddMarker(list.AddStyle(DisplayStyle::Stroke(color, isHot ? 2.0f : 1.5f)), at, MarkerShape::Square, size);
         }
 
-        void DrawTick(
-            const Microsoft::Graphics::Canvas::CanvasDrawingSession& session,
-            const ScreenPoint& at,
-            float dirX, //   
-            float dirY, 
+        void AddTick(
+            DisplayList& list,
+            const WorldPoint& at,
+            const WorldPoint& direction, //   
             Windows::UI::Color color,
             DimensionTickType type = DimensionTickType::Tick)
         {
             if (type == DimensionTickType::Arrow)
             {
-                //  .    at.
-                //  (dirX, dirY) -    .
-                //      -(dirX, dirY).
-                
-                float arrowLen = 12.0f; //  
-                float arrowWidth = 4.0f; //   
-
-                //  
-                float baseX = at.X - dirX * arrowLen;
-                float baseY = at.Y - dirY * arrowLen;
-
-                //     
-                float perpX = -dirY;
-                float perpY = dirX;
-
-                //  
-                float p1x = baseX + perpX * arrowWidth;
-                float p1y = baseY + perpY * arrowWidth;
-                float p2x = baseX - perpX * arrowWidth;
-                float p2y = baseY - perpY * arrowWidth;
-
-                //   
-                //  GeometryBuilder      ( FillTriangle  session)
-                //   FillGeometry   
-                
-                auto builder = Microsoft::Graphics::Canvas::Geometry::CanvasPathBuilder(session);
-                builder.BeginFigure(Windows::Foundation::Numerics::float2(at.X, at.Y));
-                builder.AddLine(Windows::Foundation::Numerics::float2(p1x, p1y));
-                builder.AddLine(Windows::Foundation::Numerics::float2(p2x, p2y));
-                builder.EndFigure(Microsoft::Graphics::Canvas::Geometry::CanvasFigureLoop::Closed);
-                
-                auto geometry = Microsoft::Graphics::Canvas::Geometry::CanvasGeometry::CreatePath(builder);
-                session.FillGeometry(geometry, color);
+                //   12 px,    at
+                list.AddMarker(list.AddStyle(DisplayStyle::Fill(color)), at, MarkerShape::Arrow, 12.0f, true, direction);
             }
             else if (type == DimensionTickType::Dot)
             {
-                session.FillCircle(
-                    Windows::Foundation::Numerics::float2(at.X, at.Y),
-                    3.0f, color);
+                list.AddMarker(list.AddStyle(DisplayStyle::Fill(color)), at, MarkerShape::Disc, 6.0f, true);
             }
             else // Tick default
             {
                 //  :    45 
-                float tickLen = 5.0f;
-                
-                //     (45 )
-                // (1, -1)
-                float tx = 1.0f / 1.414f;
-                float ty = -1.0f / 1.414f;
-                
-                session.DrawLine(
-                    Windows::Foundation::Numerics::float2(at.X - tx * tickLen, at.Y - ty * tickLen),
-                    Windows::Foundation::Numerics::float2(at.X + tx * tickLen, at.Y + ty * tickLen),
-                    color,
-                    2.0f);
+                list.AddMarker(list.AddStyle(DisplayStyle::Stroke(color, 2.0f)), at, MarkerShape::Tick, 10.0f);
             }
         }
+
+        DisplayList m_scratch;
+        DisplayListRenderer m_backend;
     };
 }
@@ -0,0 +1,758 @@
+#pragma once
+
+#include "pch.h"
+#include "Camera.h"
+#include "GeometryKernels.h"
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <atomic>
+
+namespace winrt::estimate1
+{
+    // =================================================================
+    // DISPLAY LIST - retained drawing commands between renderers and Win2D
+    // =================================================================
+    // Renderers describe what to draw as typed primitive batches in
+    // world coordinates (mm) with a style id; a backend replays the
+    // list (DisplayListRenderer for Win2D). Nothing here touches a
+    // drawing session, so a list can be built, kept between frames,
+    // compared, culled by its command bounds and benchmarked without
+    // a device.
+    //
+    // Consecutive primitives of one type and style share a command, up
+    // to MaxBatchPoints points and MaxBatchExtent mm on a side, so a
+    // backend issues one geometry per batch instead of one call per
+    // line, while each batch stays small enough for its bounds to be
+    // useful for culling. Renderers of many small elements emit them in
+    // SpatialOrderKey order so that neighbours share batches.
+    //
+    // Sizes that do not scale with zoom (handles, ticks, label text)
+    // are markers and text: anchored at a world point, sized in pixels.
+    //
+    // Points are floats relative to the list's origin, a double world
+    // point on a OriginGrid raster taken from the first point added, so
+    // a georeferenced underlay 10 km from the project origin keeps
+    // sub-millimetre points; plans near the origin store their world
+    // coordinates as they are. Command and list bounds stay in world mm
+    // (a float is within a millimetre there, which culling and batching
+    // do not notice).
+    // =================================================================
+
+    struct DisplayPoint
+    {
+        float X{ 0.0f };
+        float Y{ 0.0f };
+    };
+
+    // World-space box; empty until extended
+    struct DisplayBounds
+    {
+        float MinX{ (std::numeric_limits<float>::max)() };
+        float MinY{ (std::numeric_limits<float>::max)() };
+        float MaxX{ std::numeric_limits<float>::lowest() };
+        float MaxY{ std::numeric_limits<float>::lowest() };
+
+        bool IsEmpty() const { return MinX > MaxX; }
+
+        void Extend(float x, float y)
+        {
+            MinX = (std::min)(MinX, x); MinY = (std::min)(MinY, y);
+            MaxX = (std::max)(MaxX, x); MaxY = (std::max)(MaxY, y);
+        }
+
+        void Extend(const DisplayBounds& other)
+        {
+            if (other.IsEmpty())
+                return;
+            Extend(other.MinX, other.MinY);
+            Extend(other.MaxX, other.MaxY);
+        }
+
+        bool Intersects(const DisplayBounds& other) const
+        {
+            return !IsEmpty() && !other.IsEmpty()
+                && MinX <= other.MaxX && other.MinX <= MaxX
+                && MinY <= other.MaxY && other.MinY <= MaxY;
+        }
+    };
+
+    enum class DisplayFont : uint8_t
+    {
+        Default,            // the session's default format
+        Sans,               // Segoe UI
+        Mono                // Consolas
+    };
+
+    enum class DisplayTextAlign : uint8_t
+    {
+        TopLeft,            // anchor is the top-left corner
+        TopCenter,          // anchor is the middle of the top edge
+        Center              // anchor is the middle of the text block
+    };
+
+    // Order in which labels claim screen space when they are
+    // decluttered: a label overlapping one placed before it is hidden
+    enum class DisplayLabelPriority : uint8_t
+    {
+        Always,             // drawn regardless, claims no space
+        Dimension,          // dimension values
+        RoomName,           // room numbers and names
+        RoomArea,           // room area and perimeter
+        Underlay,           // DXF and IFC text
+        Other
+    };
+
+    struct DisplayStyle
+    {
+        Windows::UI::Color Color{ 255, 0, 0, 0 };
+        float Width{ 1.0f };                    // stroke width, px or mm
+        bool WorldWidth{ false };               // Width in mm: scales with zoom
+        bool MiterJoin{ false };
+        bool Dotted{ false };
+        DisplayFont Font{ DisplayFont::Default };
+        DisplayTextAlign Align{ DisplayTextAlign::TopLeft };
+        bool WorldFont{ false };                // FontSize in mm, clamped on screen
+        float FontSize{ 0.0f };                 // px; 0 with Default font: session default
+        DisplayLabelPriority Priority{ DisplayLabelPriority::Other };
+
+        static DisplayStyle Stroke(Windows::UI::Color color, float widthPx)
+        {
+            DisplayStyle style;
+            style.Color = color;
+            style.Width = widthPx;
+            return style;
+        }
+
+        static DisplayStyle WorldStroke(Windows::UI::Color color, float widthMm, bool miter = false)
+        {
+            DisplayStyle style = Stroke(color, widthMm);
+            style.WorldWidth = true;
+            style.MiterJoin = miter;
+            return style;
+        }
+
+        static DisplayStyle Fill(Windows::UI::Color color)
+        {
+            return Stroke(color, 0.0f);
+        }
+
+        static DisplayStyle Text(Windows::UI::Color color, float sizePx = 0.0f,
+            DisplayFont font = DisplayFont::Default, DisplayTextAlign align = DisplayTextAlign::TopLeft)
+        {
+            DisplayStyle style = Stroke(color, 0.0f);
+            style.FontSize = sizePx;
+            style.Font = font;
+            style.Align = align;
+            return style;
+        }
+
+        DisplayStyle WithPriority(DisplayLabelPriority priority) const
+        {
+            DisplayStyle style = *this;
+            style.Priority = priority;
+            return style;
+        }
+
+        bool operator==(const DisplayStyle& other) const
+        {
+            return Color.A == other.Color.A && Color.R == other.Color.R
+                && Color.G == other.Color.G && Color.B == other.Color.B
+                && Width == other.Width && WorldWidth == other.WorldWidth
+                && MiterJoin == other.MiterJoin && Dotted == other.Dotted
+                && Font == other.Font && Align == other.Align
+                && WorldFont == other.WorldFont && FontSize == other.FontSize
+                && Priority == other.Priority;
+        }
+    };
+
+    enum class DisplayPrimitive : uint8_t
+    {
+        Lines,              // point pairs, stroked
+        Polylines,          // runs of points, stroked, open or closed
+        Polygons,           // runs of points, filled
+        Circles,            // centers with a world radius, stroked
+        Discs,              // centers with a world radius, filled
+        Markers,            // pixel-sized symbols at world points
+        Text                // strings at world points
+    };
+
+    enum class MarkerShape : uint8_t
+    {
+        Square,
+        Disc,
+        Cross,
+        Tick,               // 45 degree architectural tick
+        Arrow               // tip at the anchor, pointing along the direction
+    };
+
+    struct DisplayMarker
+    {
+        MarkerShape Shape{ MarkerShape::Square };
+        bool Filled{ false };
+        float Size{ 6.0f };                     // px
+        float DirX{ 1.0f };                     // unit direction, for arrows
+        float DirY{ 0.0f };
+    };
+
+    struct DisplayText
+    {
+        uint32_t String{ 0 };                   // index into the string table
+        float OffsetX{ 0.0f };                  // px from the anchor
+        float OffsetY{ 0.0f };
+    };
+
+    struct DisplayCommand
+    {
+        DisplayPrimitive Type{ DisplayPrimitive::Lines };
+        uint16_t Style{ 0 };
+        uint32_t FirstPoint{ 0 };
+        uint32_t PointCount{ 0 };
+        uint32_t FirstItem{ 0 };                // run, radius, marker or text
+        uint32_t ItemCount{ 0 };
+        DisplayBounds Bounds;
+
+        // Lines, runs, circles, markers or strings in the batch
+        uint32_t GetPrimitiveCount() const
+        {
+            return Type == DisplayPrimitive::Lines ? PointCount / 2 : ItemCount;
+        }
+    };
+
+    class DisplayList
+    {
+    public:
+        static constexpr uint32_t MaxBatchPoints = 512;
+        static constexpr float MaxBatchExtent = 10000.0f;   // mm
+        static constexpr uint32_t ClosedRun = 0x80000000u;  // flag in a run length
+        static constexpr double OriginGrid = 1000000.0;     // mm, raster of the point origin
+
+        void Clear()
+        {
+            m_styles.clear();
+            m_commands.clear();
+            m_points.clear();
+            m_runs.clear();
+            m_radii.clear();
+            m_markers.clear();
+            m_texts.clear();
+            m_strings.clear();
+            m_bounds = DisplayBounds{};
+            m_origin = WorldPoint(0, 0);
+            m_version = 0;
+        }
+
+        bool IsEmpty() const { return m_commands.empty(); }
+
+        // Id of an equal style, added if new
+        uint16_t AddStyle(const DisplayStyle& style)
+        {
+            for (size_t i = m_styles.size(); i-- > 0;)
+            {
+                if (m_styles[i] == style)
+                    return static_cast<uint16_t>(i);
+            }
+            m_styles.push_back(style);
+            m_version = 0;
+            return static_cast<uint16_t>(m_styles.size() - 1);
+        }
+
+        // ------------------------------------------------------------
+        // Primitives
+        // ------------------------------------------------------------
+
+        void AddLine(uint16_t style, const WorldPoint& a, const WorldPoint& b)
+        {
+            DisplayBounds extent;
+            extent.Extend(static_cast<float>(a.X), static_cast<float>(a.Y));
+            extent.Extend(static_cast<float>(b.X), static_cast<float>(b.Y));
+            DisplayCommand& command = Batch(DisplayPrimitive::Lines, style, 2, extent);
+            Push(command, a);
+            Push(command, b);
+        }
+
+        void AddPolyline(uint16_t style, const WorldPoint* points, size_t count, bool closed)
+        {
+            if (count < 2)
+                return;
+            AddRun(DisplayPrimitive::Polylines, style, points, count, closed);
+        }
+
+        void AddPolyline(uint16_t style, const std::vector<WorldPoint>& points, bool closed)
+        {
+            AddPolyline(style, points.data(), points.size(), closed);
+        }
+
+        void AddPolygon(uint16_t style, const WorldPoint* points, size_t count)
+        {
+            if (count < 3)
+                return;
+            AddRun(DisplayPrimitive::Polygons, style, points, count, true);
+        }
+
+        void AddPolygon(uint16_t style, const std::vector<WorldPoint>& points)
+        {
+            AddPolygon(style, points.data(), points.size());
+        }
+
+        void AddCircle(uint16_t style, const WorldPoint& center, double radius)
+        {
+            AddRound(DisplayPrimitive::Circles, style, center, radius);
+        }
+
+        void AddDisc(uint16_t style, const WorldPoint& center, double radius)
+        {
+            AddRound(DisplayPrimitive::Discs, style, center, radius);
+        }
+
+        void AddMarker(uint16_t style, const WorldPoint& at, MarkerShape shape, float sizePx,
+            bool filled = false, const WorldPoint& direction = WorldPoint(1, 0))
+        {
+            DisplayCommand& command = Batch(DisplayPrimitive::Markers, style, 1, PointBounds(at));
+            Push(command, at);
+            m_markers.push_back({ shape, filled, sizePx,
+                static_cast<float>(direction.X), static_cast<float>(direction.Y) });
+            ++command.ItemCount;
+        }
+
+        void AddText(uint16_t style, const WorldPoint& at, std::wstring text,
+            float offsetXPx = 0.0f, float offsetYPx = 0.0f)
+        {
+            if (text.empty())
+                return;
+            DisplayCommand& command = Batch(DisplayPrimitive::Text, style, 1, PointBounds(at));
+            Push(command, at);
+            m_texts.push_back({ static_cast<uint32_t>(m_strings.size()), offsetXPx, offsetYPx });
+            m_strings.push_back(std::move(text));
+            ++command.ItemCount;
+        }
+
+        // Copies another list's commands after this one's, remapping
+        // its styles
+        void Append(const DisplayList& other)
+        {
+            std::vector<uint16_t> styleMap(other.m_styles.size());
+            for (size_t i = 0; i < other.m_styles.size(); ++i)
+                styleMap[i] = AddStyle(other.m_styles[i]);
+
+            if (m_points.empty())
+                m_origin = other.m_origin;
+            uint32_t pointBase = static_cast<uint32_t>(m_points.size());
+            uint32_t stringBase = static_cast<uint32_t>(m_strings.size());
+            for (DisplayCommand command : other.m_commands)
+            {
+                command.Style = styleMap[command.Style];
+                command.FirstPoint += pointBase;
+                command.FirstItem += static_cast<uint32_t>(ItemBase(command.Type));
+                m_commands.push_back(command);
+            }
+
+            if (other.m_origin.X == m_origin.X && other.m_origin.Y == m_origin.Y)
+            {
+                m_points.insert(m_points.end(), other.m_points.begin(), other.m_points.end());
+            }
+            else
+            {
+                for (const DisplayPoint& point : other.m_points)
+                    m_points.push_back(ToLocal(other.ToWorld(point)));
+            }
+            m_runs.insert(m_runs.end(), other.m_runs.begin(), other.m_runs.end());
+            m_radii.insert(m_radii.end(), other.m_radii.begin(), other.m_radii.end());
+            m_markers.insert(m_markers.end(), other.m_markers.begin(), other.m_markers.end());
+            for (DisplayText text : other.m_texts)
+            {
+                text.String += stringBase;
+                m_texts.push_back(text);
+            }
+            m_strings.insert(m_strings.end(), other.m_strings.begin(), other.m_strings.end());
+            m_bounds.Extend(other.m_bounds);
+            m_version = 0;
+        }
+
+        // ------------------------------------------------------------
+        // Reading, for backends
+        // ------------------------------------------------------------
+
+        const std::vector<DisplayCommand>& GetCommands() const { return m_commands; }
+        const std::vector<DisplayStyle>& GetStyles() const { return m_styles; }
+        const DisplayStyle& GetStyle(uint16_t id) const { return m_styles[id]; }
+        const DisplayBounds& GetBounds() const { return m_bounds; }
+
+        // Points are relative to GetOrigin
+        const DisplayPoint* GetPoints(const DisplayCommand& command) const { return m_points.data() + command.FirstPoint; }
+        const WorldPoint& GetOrigin() const { return m_origin; }
+        WorldPoint ToWorld(const DisplayPoint& point) const
+        {
+            return WorldPoint(m_origin.X + point.X, m_origin.Y + point.Y);
+        }
+        float GetRadius(const DisplayCommand& command, uint32_t i) const { return m_radii[command.FirstItem + i]; }
+        const DisplayMarker& GetMarker(const DisplayCommand& command, uint32_t i) const { return m_markers[command.FirstItem + i]; }
+        const std::wstring& GetText(const DisplayCommand& command, uint32_t i) const { return m_strings[m_texts[command.FirstItem + i].String]; }
+        const DisplayText& GetTextItem(const DisplayCommand& command, uint32_t i) const { return m_texts[command.FirstItem + i]; }
+
+        // fn(points, count, closed) for each figure of a path command:
+        // every pair of a Lines batch, every run of the others
+        template <typename Fn>
+        void ForEachFigure(const DisplayCommand& command, Fn&& fn) const
+        {
+            const DisplayPoint* points = GetPoints(command);
+            if (command.Type == DisplayPrimitive::Lines)
+            {
+                for (uint32_t i = 0; i + 1 < command.PointCount; i += 2)
+                    fn(points + i, 2u, false);
+                return;
+            }
+
+            for (uint32_t r = 0; r < command.ItemCount; ++r)
+            {
+                uint32_t run = m_runs[command.FirstItem + r];
+                uint32_t count = run & ~ClosedRun;
+                fn(points, count, (run & ClosedRun) != 0);
+                points += count;
+            }
+        }
+
+        size_t GetCommandCount() const { return m_commands.size(); }
+        size_t GetPointCount() const { return m_points.size(); }
+        size_t GetTextCount() const { return m_texts.size(); }
+        size_t GetStyleCount() const { return m_styles.size(); }
+
+        size_t GetMemoryUsage() const
+        {
+            size_t bytes = m_styles.capacity() * sizeof(DisplayStyle)
+                + m_commands.capacity() * sizeof(DisplayCommand)
+                + m_points.capacity() * sizeof(DisplayPoint)
+                + m_runs.capacity() * sizeof(uint32_t)
+                + m_radii.capacity() * sizeof(float)
+                + m_markers.capacity() * sizeof(DisplayMarker)
+                + m_texts.capacity() * sizeof(DisplayText);
+            for (const auto& s : m_strings)
+                bytes += sizeof(std::wstring) + s.capacity() * sizeof(wchar_t);
+            return bytes;
+        }
+
+        // Stamp that changes whenever the list does and is never shared
+        // by two lists, so a backend can keep what it derived from a list
+        // for as long as the stamp holds
+        uint64_t GetVersion() const
+        {
+            if (m_version == 0)
+                m_version = ++s_lastVersion;
+            return m_version;
+        }
+
+        // Content hash: equal lists hash equal, so a frame can compare
+        // against the last one instead of keeping a copy
+        uint64_t ComputeHash() const
+        {
+            uint64_t hash = 14695981039346656037ull;
+            auto mix = [&hash](const void* data, size_t size) {
+                const auto* bytes = static_cast<const uint8_t*>(data);
+                for (size_t i = 0; i < size; ++i)
+                    hash = (hash ^ bytes[i]) * 1099511628211ull;
+            };
+
+            mix(&m_origin.X, sizeof(m_origin.X));
+            mix(&m_origin.Y, sizeof(m_origin.Y));
+
+            for (const auto& s : m_styles)
+            {
+                mix(&s.Color, sizeof(s.Color));
+                mix(&s.Width, sizeof(s.Width));
+                uint8_t flags[] = { s.WorldWidth, s.MiterJoin, s.Dotted,
+                    static_cast<uint8_t>(s.Font), static_cast<uint8_t>(s.Align), s.WorldFont,
+                    static_cast<uint8_t>(s.Priority) };
+                mix(flags, sizeof(flags));
+                mix(&s.FontSize, sizeof(s.FontSize));
+            }
+            for (const auto& c : m_commands)
+            {
+                uint32_t header[] = { static_cast<uint32_t>(c.Type), c.Style, c.PointCount, c.ItemCount };
+                mix(header, sizeof(header));
+            }
+            mix(m_points.data(), m_points.size() * sizeof(DisplayPoint));
+            mix(m_runs.data(), m_runs.size() * sizeof(uint32_t));
+            mix(m_radii.data(), m_radii.size() * sizeof(float));
+            for (const auto& m : m_markers)
+            {
+                uint8_t head[] = { static_cast<uint8_t>(m.Shape), m.Filled };
+                mix(head, sizeof(head));
+                float values[] = { m.Size, m.DirX, m.DirY };
+                mix(values, sizeof(values));
+            }
+            for (const auto& t : m_texts)
+            {
+                const std::wstring& s = m_strings[t.String];
+                mix(s.data(), s.size() * sizeof(wchar_t));
+                float offsets[] = { t.OffsetX, t.OffsetY };
+                mix(offsets, sizeof(offsets));
+            }
+            return hash;
+        }
+
+    private:
+        // The open command for this type and style, or a new one if
+        // the primitive (points, extent) would make it too long or too wide
+        DisplayCommand& Batch(DisplayPrimitive type, uint16_t style, size_t points, const DisplayBounds& extent)
+        {
+            m_version = 0;
+            if (!m_commands.empty())
+            {
+                DisplayCommand& last = m_commands.back();
+                if (last.Type == type && last.Style == style && last.PointCount + points <= MaxBatchPoints)
+                {
+                    DisplayBounds merged = last.Bounds;
+                    merged.Extend(extent);
+                    if (merged.MaxX - merged.MinX <= MaxBatchExtent && merged.MaxY - merged.MinY <= MaxBatchExtent)
+                        return last;
+                }
+            }
+
+            DisplayCommand command;
+            command.Type = type;
+            command.Style = style;
+            command.FirstPoint = static_cast<uint32_t>(m_points.size());
+            command.FirstItem = static_cast<uint32_t>(ItemBase(type));
+            m_commands.push_back(command);
+            return m_commands.back();
+        }
+
+        size_t ItemBase(DisplayPrimitive type) const
+        {
+            switch (type)
+            {
+            case DisplayPrimitive::Polylines:
+            case DisplayPrimitive::Polygons: return m_runs.size();
+            case DisplayPrimitive::Circles:
+            case DisplayPrimitive::Discs:    return m_radii.size();
+            case DisplayPrimitive::Markers:  return m_markers.size();
+            case DisplayPrimitive::Text:     return m_texts.size();
+            default:                         return 0;
+            }
+        }
+
+        static DisplayBounds PointBounds(const WorldPoint& p)
+        {
+            DisplayBounds bounds;
+            bounds.Extend(static_cast<float>(p.X), static_cast<float>(p.Y));
+            return bounds;
+        }
+
+        void Push(DisplayCommand& command, const WorldPoint& p)
+        {
+            if (m_points.empty())
+            {
+                m_origin = WorldPoint(std::round(p.X / OriginGrid) * OriginGrid,
+                                      std::round(p.Y / OriginGrid) * OriginGrid);
+            }
+            m_points.push_back(ToLocal(p));
+            ++command.PointCount;
+            command.Bounds.Extend(static_cast<float>(p.X), static_cast<float>(p.Y));
+            m_bounds.Extend(static_cast<float>(p.X), static_cast<float>(p.Y));
+        }
+
+        DisplayPoint ToLocal(const WorldPoint& p) const
+        {
+            return DisplayPoint{ static_cast<float>(p.X - m_origin.X), static_cast<float>(p.Y - m_origin.Y) };
+        }
+
+        void AddRun(DisplayPrimitive type, uint16_t style, const WorldPoint* points, size_t count, bool closed)
+        {
+            DisplayBounds extent;
+            for (size_t i = 0; i < count; ++i)
+                extent.Extend(static_cast<float>(points[i].X), static_cast<float>(points[i].Y));
+            DisplayCommand& command = Batch(type, style, count, extent);
+            for (size_t i = 0; i < count; ++i)
+                Push(command, points[i]);
+            m_runs.push_back(static_cast<uint32_t>(count) | (closed ? ClosedRun : 0u));
+            ++command.ItemCount;
+        }
+
+        void AddRound(DisplayPrimitive type, uint16_t style, const WorldPoint& center, double radius)
+        {
+            if (radius <= 0.0)
+                return;
+            DisplayBounds round;
+            round.Extend(static_cast<float>(center.X - radius), static_cast<float>(center.Y - radius));
+            round.Extend(static_cast<float>(center.X + radius), static_cast<float>(center.Y + radius));
+
+            DisplayCommand& command = Batch(type, style, 1, round);
+            Push(command, center);
+            m_radii.push_back(static_cast<float>(radius));
+            ++command.ItemCount;
+            command.Bounds.Extend(round);
+            m_bounds.Extend(round);
+        }
+
+        std::vector<DisplayStyle> m_styles;
+        std::vector<DisplayCommand> m_commands;
+        std::vector<DisplayPoint> m_points;     // relative to m_origin
+        WorldPoint m_origin{ 0, 0 };
+        std::vector<uint32_t> m_runs;           // point counts, ClosedRun flag
+        std::vector<float> m_radii;
+        std::vector<DisplayMarker> m_markers;
+        std::vector<DisplayText> m_texts;
+        std::vector<std::wstring> m_strings;
+        DisplayBounds m_bounds;
+
+        mutable uint64_t m_version{ 0 };        // 0 until asked after a change
+        static inline std::atomic<uint64_t> s_lastVersion{ 0 };
+    };
+
+    // =================================================================
+    // Commands of one list bucketed by bounds in a uniform grid, so a
+    // backend replays only the batches that meet the view. Bounds are
+    // grown by half the stroke width of world-width styles. Short lists
+    // are scanned instead; commands spanning many cells are kept aside
+    // and always tested. Rebuild after the list changes.
+    // =================================================================
+
+    class DisplayCommandIndex
+    {
+    public:
+        void Build(const DisplayList& list)
+        {
+            const auto& commands = list.GetCommands();
+            m_bounds.resize(commands.size());
+            m_offsets.clear();
+            m_ids.clear();
+            m_large.clear();
+            m_cols = m_rows = 0;
+            m_primitiveCount = 0;
+
+            DisplayBounds all;
+            for (size_t i = 0; i < commands.size(); ++i)
+            {
+                const DisplayCommand& command = commands[i];
+                const DisplayStyle& style = list.GetStyle(command.Style);
+                float grow = style.WorldWidth ? style.Width / 2.0f : 0.0f;
+                DisplayBounds& bounds = m_bounds[i];
+                bounds = command.Bounds;
+                if (!bounds.IsEmpty())
+                {
+                    bounds.MinX -= grow; bounds.MinY -= grow;
+                    bounds.MaxX += grow; bounds.MaxY += grow;
+                }
+                all.Extend(bounds);
+                m_primitiveCount += command.GetPrimitiveCount();
+            }
+            if (commands.size() <= LinearCommands || all.IsEmpty())
+                return;
+
+            // About one cell per command
+            m_minX = all.MinX;
+            m_minY = all.MinY;
+            float width = (std::max)(all.MaxX - all.MinX, 1.0f);
+            float height = (std::max)(all.MaxY - all.MinY, 1.0f);
+            float cellSize = std::sqrt(width * height / static_cast<float>(commands.size()));
+            m_cols = std::clamp(static_cast<int>(std::ceil(width / cellSize)), 1, MaxCellsPerSide);
+            m_rows = std::clamp(static_cast<int>(std::ceil(height / cellSize)), 1, MaxCellsPerSide);
+            m_cellSize = (std::max)(width / m_cols, height / m_rows);
+
+            // Counting pass, prefix sums, then the filling pass
+            m_offsets.assign(static_cast<size_t>(m_cols) * m_rows + 1, 0);
+            for (uint32_t i = 0; i < m_bounds.size(); ++i)
+            {
+                if (!IsLarge(m_bounds[i]))
+                    ForEachCell(m_bounds[i], [&](size_t cell) { ++m_offsets[cell + 1]; });
+                else if (!m_bounds[i].IsEmpty())
+                    m_large.push_back(i);
+            }
+            for (size_t c = 1; c < m_offsets.size(); ++c)
+                m_offsets[c] += m_offsets[c - 1];
+
+            m_ids.resize(m_offsets.back());
+            std::vector<uint32_t> fill(m_offsets.begin(), m_offsets.end() - 1);
+            for (uint32_t i = 0; i < m_bounds.size(); ++i)
+            {
+                if (!IsLarge(m_bounds[i]))
+                    ForEachCell(m_bounds[i], [&](size_t cell) { m_ids[fill[cell]++] = i; });
+            }
+        }
+
+        // Ids of the commands meeting box, in list order
+        void Query(const DisplayBounds& box, std::vector<uint32_t>& out) const
+        {
+            out.clear();
+            if (m_cols == 0)
+            {
+                for (uint32_t i = 0; i < m_bounds.size(); ++i)
+                {
+                    if (m_bounds[i].Intersects(box))
+                        out.push_back(i);
+                }
+                return;
+            }
+
+            DisplayBounds clipped = box;
+            clipped.MinX = (std::max)(clipped.MinX, m_minX);
+            clipped.MinY = (std::max)(clipped.MinY, m_minY);
+            clipped.MaxX = (std::min)(clipped.MaxX, m_minX + m_cols * m_cellSize);
+            clipped.MaxY = (std::min)(clipped.MaxY, m_minY + m_rows * m_cellSize);
+            if (!clipped.IsEmpty() && clipped.MinY <= clipped.MaxY)
+            {
+                ForEachCell(clipped, [&](size_t cell) {
+                    for (uint32_t k = m_offsets[cell]; k < m_offsets[cell + 1]; ++k)
+                    {
+                        if (m_bounds[m_ids[k]].Intersects(box))
+                            out.push_back(m_ids[k]);
+                    }
+                });
+            }
+            for (uint32_t i : m_large)
+            {
+                if (m_bounds[i].Intersects(box))
+                    out.push_back(i);
+            }
+
+            // A command spanning several cells was found once per cell
+            std::sort(out.begin(), out.end());
+            out.erase(std::unique(out.begin(), out.end()), out.end());
+        }
+
+        size_t GetCommandCount() const { return m_bounds.size(); }
+        size_t GetPrimitiveCount() const { return m_primitiveCount; }
+        bool IsGridded() const { return m_cols != 0; }
+
+    private:
+        static constexpr size_t LinearCommands = 64;
+        static constexpr int MaxCellsPerSide = 1024;
+        static constexpr int LargeCells = 16;
+
+        int ColOf(float x) const { return std::clamp(static_cast<int>(std::floor((x - m_minX) / m_cellSize)), 0, m_cols - 1); }
+        int RowOf(float y) const { return std::clamp(static_cast<int>(std::floor((y - m_minY) / m_cellSize)), 0, m_rows - 1); }
+
+        bool IsLarge(const DisplayBounds& bounds) const
+        {
+            if (bounds.IsEmpty())
+                return true;
+            return (ColOf(bounds.MaxX) - ColOf(bounds.MinX) + 1) * (RowOf(bounds.MaxY) - RowOf(bounds.MinY) + 1) > LargeCells;
+        }
+
+        template <typename Fn>
+        void ForEachCell(const DisplayBounds& bounds, Fn&& fn) const
+        {
+            int c0 = ColOf(bounds.MinX), c1 = ColOf(bounds.MaxX);
+            int r0 = RowOf(bounds.MinY), r1 = RowOf(bounds.MaxY);
+            for (int r = r0; r <= r1; ++r)
+                for (int c = c0; c <= c1; ++c)
+                    fn(static_cast<size_t>(r) * m_cols + c);
+        }
+
+        std::vector<DisplayBounds> m_bounds;    // by command, grown by stroke widths
+        size_t m_primitiveCount{ 0 };
+
+        // Grid: ids of cell c are m_ids[m_offsets[c] .. m_offsets[c + 1])
+        float m_minX{ 0.0f };
+        float m_minY{ 0.0f };
+        float m_cellSize{ 1.0f };
+        int m_cols{ 0 };
+        int m_rows{ 0 };
+        std::vector<uint32_t> m_offsets;
+        std::vector<uint32_t> m_ids;
+        std::vector<uint32_t> m_large;          // spanning many cells, or empty
+    };
+}
@@ -0,0 +1,488 @@
+#pragma once
+
+#include "pch.h"
+#include "Camera.h"
+#include "DisplayList.h"
+#include "TextLayoutCache.h"
+#include "LabelDeclutter.h"
+#include <unordered_map>
+#include <vector>
+#include <algorithm>
+#include <winrt/Microsoft.Graphics.Canvas.h>
+#include <winrt/Microsoft.Graphics.Canvas.Geometry.h>
+#include <winrt/Microsoft.Graphics.Canvas.Text.h>
+
+namespace winrt::estimate1
+{
+    // =================================================================
+    // DISPLAY LIST RENDERER - Win2D backend for DisplayList
+    // =================================================================
+    // Path batches are drawn as one geometry each under the camera's
+    // world transform, so world widths scale with zoom and pixel widths
+    // are divided by it. The list's origin and the camera offset are
+    // added in double before the transform is made, as the sum is what
+    // stays small on screen. Markers and text are drawn untransformed at
+    // their anchor's screen position. Stroke styles are created once;
+    // text formats and laid-out strings come from TextLayoutCache.
+    //
+    // Path geometries are kept per list and reused while the list's
+    // version holds and the device is the same, so a list kept between
+    // frames (the walls of a static plan) costs only the draw calls.
+    // The few most recently drawn lists are remembered.
+    //
+    // Each kept list also has a DisplayCommandIndex. Draw replays only
+    // the batches meeting the camera's visible bounds plus a margin that
+    // leaves room for pixel-sized markers and text, so the cost of a
+    // frame follows what is on screen (or on a tile), not the plan size.
+    //
+    // PlaceLabels declutters the text of a set of lists for a frame:
+    // labels are offered to a LabelDeclutter grid by style priority and
+    // Draw skips the ones that lost their place, before laying them out.
+    // Placement needs no drawing session, only the camera; a new device
+    // drops the kept paths but not the index or the placed labels.
+    // =================================================================
+
+    // Which primitives a Draw call replays: geometry scales with zoom
+    // and can be cached as raster, annotations are sized in pixels
+    enum class DisplayPass
+    {
+        All,
+        Geometry,           // lines, polylines, polygons, circles, discs
+        Annotations         // markers and text
+    };
+
+    // What Draw calls replayed and skipped since the last ResetStats.
+    // A list drawn in two passes counts its culled batches twice.
+    struct DisplayCullStats
+    {
+        size_t CommandsDrawn{ 0 };
+        size_t CommandsCulled{ 0 };
+        size_t PrimitivesDrawn{ 0 };
+        size_t PrimitivesCulled{ 0 };
+        size_t LabelsHidden{ 0 };               // dropped by PlaceLabels
+    };
+
+    class DisplayListRenderer
+    {
+    public:
+        void Draw(
+            const Microsoft::Graphics::Canvas::CanvasDrawingSession& session,
+            const Camera& camera,
+            const DisplayList& list,
+            DisplayPass pass = DisplayPass::All)
+        {
+            if (list.IsEmpty())
+                return;
+
+            auto screenTransform = session.Transform();
+            auto worldTransform = WorldTransform(camera, list.GetOrigin()) * screenTransform;
+            float zoom = static_cast<float>(camera.GetZoom());
+            UseDevice(session);
+            GeometryEntry& geometries = GetGeometries(list);
+
+            geometries.Index.Query(CullBounds(camera), m_visible);
+            const auto& commands = list.GetCommands();
+            size_t visiblePrimitives = 0;
+            for (uint32_t id : m_visible)
+            {
+                const DisplayCommand& command = commands[id];
+                visiblePrimitives += command.GetPrimitiveCount();
+                bool annotation = command.Type == DisplayPrimitive::Markers || command.Type == DisplayPrimitive::Text;
+                if ((pass == DisplayPass::Geometry && annotation) || (pass == DisplayPass::Annotations && !annotation))
+                    continue;
+
+                ++m_stats.CommandsDrawn;
+                m_stats.PrimitivesDrawn += command.GetPrimitiveCount();
+
+                const DisplayStyle& style = list.GetStyle(command.Style);
+                switch (command.Type)
+                {
+                case DisplayPrimitive::Lines:
+                case DisplayPrimitive::Polylines:
+                case DisplayPrimitive::Polygons:
+                {
+                    session.Transform(worldTransform);
+                    auto& geometry = geometries.Paths[id];
+                    if (!geometry)
+                    {
+                        geometry = BuildGeometry(session, list, command);
+                        ++m_geometriesBuilt;
+                    }
+                    if (command.Type == DisplayPrimitive::Polygons)
+                        session.FillGeometry(geometry, style.Color);
+                    else
+                        session.DrawGeometry(geometry, style.Color, WorldWidth(style, zoom), GetStrokeStyle(style));
+                    break;
+                }
+                case DisplayPrimitive::Circles:
+                case DisplayPrimitive::Discs:
+                {
+                    session.Transform(worldTransform);
+                    const DisplayPoint* centers = list.GetPoints(command);
+                    for (uint32_t i = 0; i < command.ItemCount; ++i)
+                    {
+                        Windows::Foundation::Numerics::float2 center(centers[i].X, centers[i].Y);
+                        float radius = list.GetRadius(command, i);
+                        if (command.Type == DisplayPrimitive::Discs)
+                            session.FillCircle(center, radius, style.Color);
+                        else
+                            session.DrawCircle(center, radius, style.Color, WorldWidth(style, zoom), GetStrokeStyle(style));
+                    }
+                    break;
+                }
+                case DisplayPrimitive::Markers:
+                    session.Transform(screenTransform);
+                    DrawMarkers(session, camera, list, command, style);
+                    break;
+                case DisplayPrimitive::Text:
+                    session.Transform(screenTransform);
+                    DrawTexts(session, camera, list, command, style,
+                        geometries.LabelFrame == m_labelFrame ? geometries.LabelShown.data() : nullptr);
+                    break;
+                }
+            }
+
+            m_stats.CommandsCulled += commands.size() - m_visible.size();
+            m_stats.PrimitivesCulled += geometries.Index.GetPrimitiveCount() - visiblePrimitives;
+            session.Transform(screenTransform);
+        }
+
+        // Decides which labels of the lists are drawn until the next
+        // call: the text in view is offered to the declutter grid by
+        // style priority, then in list and command order. Lists not
+        // passed here draw all of their labels.
+        void PlaceLabels(const Camera& camera, std::initializer_list<const DisplayList*> lists)
+        {
+            ++m_labelFrame;
+            m_declutter.Begin(camera.GetCanvasWidth(), camera.GetCanvasHeight());
+            m_candidates.clear();
+
+            DisplayBounds cullBounds = CullBounds(camera);
+            for (const DisplayList* list : lists)
+            {
+                if (list->IsEmpty())
+                    continue;
+
+                GeometryEntry& geometries = GetGeometries(*list);
+                geometries.LabelFrame = m_labelFrame;
+                geometries.LabelShown.assign(list->GetTextCount(), 0);
+
+                geometries.Index.Query(cullBounds, m_visible);
+                const auto& commands = list->GetCommands();
+                for (uint32_t id : m_visible)
+                {
+                    const DisplayCommand& command = commands[id];
+                    if (command.Type != DisplayPrimitive::Text)
+                        continue;
+
+                    const DisplayStyle& style = list->GetStyle(command.Style);
+                    float size = TextSizePx(style, camera.GetZoom());
+                    const DisplayPoint* anchors = list->GetPoints(command);
+                    for (uint32_t i = 0; i < command.ItemCount; ++i)
+                    {
+                        ScreenPoint at = LabelAnchor(camera, list->ToWorld(anchors[i]), list->GetTextItem(command, i));
+                        m_candidates.push_back({ &geometries, command.FirstItem + i, style.Priority,
+                            LabelDeclutter::EstimateBox(list->GetText(command, i), size, style.Align, at.X, at.Y) });
+                    }
+                }
+            }
+
+            std::stable_sort(m_candidates.begin(), m_candidates.end(),
+                [](const LabelCandidate& a, const LabelCandidate& b) { return a.Priority < b.Priority; });
+            for (const LabelCandidate& candidate : m_candidates)
+            {
+                if (candidate.Priority == DisplayLabelPriority::Always || m_declutter.TryPlace(candidate.Box))
+                    candidate.Geometries->LabelShown[candidate.Item] = 1;
+            }
+        }
+
+        const LabelDeclutter& GetDeclutter() const { return m_declutter; }
+
+        // Whether Draw shows a text item of the list: true unless the
+        // last PlaceLabels call included the list and dropped the label
+        bool IsLabelShown(const DisplayList& list, uint32_t textItem) const
+        {
+            auto found = m_geometries.find(&list);
+            if (found == m_geometries.end() || found->second.LabelFrame != m_labelFrame
+                || found->second.Version != list.GetVersion())
+                return true;
+            return found->second.LabelShown[textItem] != 0;
+        }
+
+        const DisplayCullStats& GetCullStats() const { return m_stats; }
+        void ResetCullStats() { m_stats = DisplayCullStats{}; }
+
+        // World box Draw replays for a camera: the visible bounds grown by
+        // CullMarginPx on every side
+        static DisplayBounds CullBounds(const Camera& camera)
+        {
+            WorldPoint topLeft, bottomRight;
+            camera.GetVisibleBounds(topLeft, bottomRight);
+            float margin = static_cast<float>(CullMarginPx / camera.GetZoom());
+            DisplayBounds bounds;
+            bounds.Extend(static_cast<float>(topLeft.X) - margin, static_cast<float>(topLeft.Y) - margin);
+            bounds.Extend(static_cast<float>(bottomRight.X) + margin, static_cast<float>(bottomRight.Y) + margin);
+            return bounds;
+        }
+
+        // Path geometries created since construction, for diagnostics
+        size_t GetGeometriesBuilt() const { return m_geometriesBuilt; }
+
+        // Drops the kept geometries, e.g. after the device was lost
+        void ClearGeometryCache() { m_geometries.clear(); }
+
+        // Points relative to origin (mm) to screen (px) for a camera
+        static Windows::Foundation::Numerics::float3x2 WorldTransform(const Camera& camera, const WorldPoint& origin = WorldPoint(0, 0))
+        {
+            WorldPoint shift = TransformShift(camera, origin);
+            float zoom = static_cast<float>(camera.GetZoom());
+            return Windows::Foundation::Numerics::make_float3x2_translation(
+                       static_cast<float>(shift.X), static_cast<float>(shift.Y)) *
+                   Windows::Foundation::Numerics::make_float3x2_scale(zoom) *
+                   Windows::Foundation::Numerics::make_float3x2_translation(
+                       camera.GetCanvasWidth() / 2.0f, camera.GetCanvasHeight() / 2.0f);
+        }
+
+        // Where WorldTransform puts a point of a list, in the same float
+        // steps, to compare against Camera::WorldToScreen
+        static ScreenPoint TransformPoint(const Camera& camera, const DisplayList& list, const DisplayPoint& point)
+        {
+            WorldPoint shift = TransformShift(camera, list.GetOrigin());
+            float zoom = static_cast<float>(camera.GetZoom());
+            return ScreenPoint(
+                (point.X + static_cast<float>(shift.X)) * zoom + camera.GetCanvasWidth() / 2.0f,
+                (point.Y + static_cast<float>(shift.Y)) * zoom + camera.GetCanvasHeight() / 2.0f);
+        }
+
+    private:
+        struct GeometryEntry
+        {
+            uint64_t Version{ 0 };
+            uint64_t LastUsed{ 0 };
+            std::vector<Microsoft::Graphics::Canvas::Geometry::CanvasGeometry> Paths;   // by command, null until built
+            DisplayCommandIndex Index;
+            uint64_t LabelFrame{ 0 };               // PlaceLabels call LabelShown is from
+            std::vector<uint8_t> LabelShown;        // by text item
+        };
+
+        struct LabelCandidate
+        {
+            GeometryEntry* Geometries{ nullptr };
+            uint32_t Item{ 0 };
+            DisplayLabelPriority Priority{ DisplayLabelPriority::Other };
+            DisplayBounds Box;
+        };
+
+        // Translation of the world transform: origin and camera offset,
+        // summed in double
+        static WorldPoint TransformShift(const Camera& camera, const WorldPoint& origin)
+        {
+            return WorldPoint(origin.X + camera.GetOffset().X, origin.Y + camera.GetOffset().Y);
+        }
+
+        // Paths belong to a device: a new one empties them, keeping the
+        // command indexes and label placement
+        void UseDevice(const Microsoft::Graphics::Canvas::CanvasDrawingSession& session)
+        {
+            auto device = session.Device();
+            if (device == m_device)
+                return;
+            for (auto& entry : m_geometries)
+                entry.second.Paths.assign(entry.second.Paths.size(), nullptr);
+            m_device = device;
+        }
+
+        // Geometries kept for this list, emptied if it changed since
+        GeometryEntry& GetGeometries(const DisplayList& list)
+        {
+            auto found = m_geometries.find(&list);
+            if (found == m_geometries.end() && m_geometries.size() >= MaxCachedLists)
+            {
+                auto oldest = std::min_element(m_geometries.begin(), m_geometries.end(),
+                    [](const auto& a, const auto& b) { return a.second.LastUsed < b.second.LastUsed; });
+                m_geometries.erase(oldest);
+            }
+
+            GeometryEntry& entry = m_geometries[&list];
+            entry.LastUsed = ++m_drawCount;
+            if (entry.Version != list.GetVersion())
+            {
+                entry.Version = list.GetVersion();
+                entry.Paths.assign(list.GetCommandCount(), nullptr);
+                entry.Index.Build(list);
+                entry.LabelFrame = 0;
+            }
+            return entry;
+        }
+
+        static float WorldWidth(const DisplayStyle& style, float zoom)
+        {
+            return style.WorldWidth ? style.Width : style.Width / zoom;
+        }
+
+        static Microsoft::Graphics::Canvas::Geometry::CanvasGeometry BuildGeometry(
+            const Microsoft::Graphics::Canvas::CanvasDrawingSession& session,
+            const DisplayList& list,
+            const DisplayCommand& command)
+        {
+            using namespace Microsoft::Graphics::Canvas::Geometry;
+
+            CanvasPathBuilder builder(session);
+            list.ForEachFigure(command, [&](const DisplayPoint* points, uint32_t count, bool closed) {
+                builder.BeginFigure(Windows::Foundation::Numerics::float2(points[0].X, points[0].Y));
+                for (uint32_t i = 1; i < count; ++i)
+                    builder.AddLine(Windows::Foundation::Numerics::float2(points[i].X, points[i].Y));
+                builder.EndFigure(closed ? CanvasFigureLoop::Closed : CanvasFigureLoop::Open);
+            });
+            return CanvasGeometry::CreatePath(builder);
+        }
+
+        void DrawMarkers(
+            const Microsoft::Graphics::Canvas::CanvasDrawingSession& session,
+            const Camera& camera,
+            const DisplayList& list,
+            const DisplayCommand& command,
+            const DisplayStyle& style)
+        {
+            using Windows::Foundation::Numerics::float2;
+
+            const DisplayPoint* anchors = list.GetPoints(command);
+            for (uint32_t i = 0; i < command.ItemCount; ++i)
+            {
+                const DisplayMarker& marker = list.GetMarker(command, i);
+                ScreenPoint at = camera.WorldToScreen(list.ToWorld(anchors[i]));
+                float half = marker.Size / 2.0f;
+
+                switch (marker.Shape)
+                {
+                case MarkerShape::Square:
+                {
+                    Windows::Foundation::Rect rect(at.X - half, at.Y - half, marker.Size, marker.Size);
+                    if (marker.Filled)
+                        session.FillRectangle(rect, style.Color);
+                    else
+                        session.DrawRectangle(rect, style.Color, style.Width);
+                    break;
+                }
+                case MarkerShape::Disc:
+                    if (marker.Filled)
+                        session.FillCircle(float2(at.X, at.Y), half, style.Color);
+                    else
+                        session.DrawCircle(float2(at.X, at.Y), half, style.Color, style.Width);
+                    break;
+                case MarkerShape::Cross:
+                    session.DrawLine(at.X - half, at.Y, at.X + half, at.Y, style.Color, style.Width);
+                    session.DrawLine(at.X, at.Y - half, at.X, at.Y + half, style.Color, style.Width);
+                    break;
+                case MarkerShape::Tick:
+                {
+                    float d = half / 1.414f;
+                    session.DrawLine(at.X - d, at.Y + d, at.X + d, at.Y - d, style.Color, style.Width);
+                    break;
+                }
+                case MarkerShape::Arrow:
+                {
+                    using namespace Microsoft::Graphics::Canvas::Geometry;
+
+                    float baseX = at.X - marker.DirX * marker.Size;
+                    float baseY = at.Y - marker.DirY * marker.Size;
+                    float wing = marker.Size / 3.0f;
+                    CanvasPathBuilder builder(session);
+                    builder.BeginFigure(float2(at.X, at.Y));
+                    builder.AddLine(float2(baseX - marker.DirY * wing, baseY + marker.DirX * wing));
+                    builder.AddLine(float2(baseX + marker.DirY * wing, baseY - marker.DirX * wing));
+                    builder.EndFigure(CanvasFigureLoop::Closed);
+                    session.FillGeometry(CanvasGeometry::CreatePath(builder), style.Color);
+                    break;
+                }
+                }
+            }
+        }
+
+        void DrawTexts(
+            const Microsoft::Graphics::Canvas::CanvasDrawingSession& session,
+            const Camera& camera,
+            const DisplayList& list,
+            const DisplayCommand& command,
+            const DisplayStyle& style,
+            const uint8_t* shown)
+        {
+            TextLayoutCache& cache = TextLayoutCache::Shared();
+            const DisplayPoint* anchors = list.GetPoints(command);
+            float size = TextSizePx(style, camera.GetZoom());
+            bool boxed = style.Align == DisplayTextAlign::Center;
+            float boxWidth = boxed ? CenterBoxWidth : 0.0f;
+            float boxHeight = boxed ? CenterBoxHeight : 0.0f;
+
+            for (uint32_t i = 0; i < command.ItemCount; ++i)
+            {
+                if (shown && !shown[command.FirstItem + i])
+                {
+                    ++m_stats.LabelsHidden;
+                    continue;
+                }
+
+                ScreenPoint at = LabelAnchor(camera, list.ToWorld(anchors[i]), list.GetTextItem(command, i));
+                float x = at.X - boxWidth / 2;
+                float y = at.Y - boxHeight / 2;
+
+                auto layout = cache.GetLayout(session, list.GetText(command, i), style.Font, size, style.Align, boxWidth, boxHeight);
+                session.DrawTextLayout(layout, x, y, style.Color);
+            }
+        }
+
+        // Screen point a label's alignment refers to
+        static ScreenPoint LabelAnchor(const Camera& camera, const WorldPoint& anchor, const DisplayText& item)
+        {
+            ScreenPoint at = camera.WorldToScreen(anchor);
+            return ScreenPoint(at.X + item.OffsetX, at.Y + item.OffsetY);
+        }
+
+        // Font size on screen; world sizes follow zoom in whole pixels,
+        // within readable limits. 0 is the session default.
+        static float TextSizePx(const DisplayStyle& style, double zoom)
+        {
+            if (!style.WorldFont)
+                return style.FontSize;
+            return std::clamp(std::round(static_cast<float>(style.FontSize * zoom)), MinWorldFontPx, MaxWorldFontPx);
+        }
+
+        Microsoft::Graphics::Canvas::Geometry::CanvasStrokeStyle GetStrokeStyle(const DisplayStyle& style)
+        {
+            using namespace Microsoft::Graphics::Canvas::Geometry;
+
+            size_t index = (style.MiterJoin ? 1 : 0) | (style.Dotted ? 2 : 0);
+            if (!m_strokeStyles[index])
+            {
+                CanvasStrokeStyle strokeStyle;
+                if (style.MiterJoin)
+                    strokeStyle.LineJoin(CanvasLineJoin::Miter);
+                if (style.Dotted)
+                    strokeStyle.DashStyle(CanvasDashStyle::Dot);
+                m_strokeStyles[index] = strokeStyle;
+            }
+            return m_strokeStyles[index];
+        }
+
+        static constexpr float MinWorldFontPx = 6.0f;
+        static constexpr float MaxWorldFontPx = 72.0f;
+        static constexpr float CenterBoxWidth = 300.0f;
+        static constexpr float CenterBoxHeight = 200.0f;
+        static constexpr size_t MaxCachedLists = 32;    // every list drawn in a frame, with headroom for tiles and previews
+        static constexpr double CullMarginPx = 160.0;    // half a centered text box, and then some
+
+        Microsoft::Graphics::Canvas::Geometry::CanvasStrokeStyle m_strokeStyles[4]{ nullptr, nullptr, nullptr, nullptr };
+
+        Microsoft::Graphics::Canvas::CanvasDevice m_device{ nullptr };
+        std::unordered_map<const DisplayList*, GeometryEntry> m_geometries;
+        uint64_t m_drawCount{ 0 };
+        size_t m_geometriesBuilt{ 0 };
+
+        DisplayCullStats m_stats;
+        std::vector<uint32_t> m_visible;        // scratch, ids of the commands in view
+
+        LabelDeclutter m_declutter;
+        std::vector<LabelCandidate> m_candidates;   // scratch
+        uint64_t m_labelFrame{ 0 };
+    };
+}
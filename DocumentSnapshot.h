@@ -0,0 +1,250 @@
+#pragma once
+
+#include "pch.h"
+#include "Models.h"
+#include "Opening.h"
+#include "Room.h"
+#include "Zone.h"
+#include "Structure.h"
+#include "WallStore.h"
+#include "WallJoinGraph.h"
+#include <vector>
+#include <memory>
+#include <unordered_map>
+
+namespace winrt::estimate1
+{
+    // =================================================================
+    // DOCUMENT SNAPSHOT - immutable view for background work
+    // =================================================================
+    // Estimation, export and room detection can run on a worker thread
+    // against a snapshot while the UI keeps editing the live document.
+    //
+    // Elements are held as shared_ptr<const T> copies. SnapshotCache
+    // keeps the copy of every element from the previous snapshot and
+    // reuses it while the element's revision is unchanged, so a new
+    // snapshot after a small edit copies only the edited elements; the
+    // rest is shared with earlier snapshots still in use by workers.
+    //
+    // Rooms and zones are derived data and are copied each time. The
+    // wall join graph is shared with the document until its next patch.
+    // Wall types and materials are shared, not copied: they are edited
+    // only from modal dialogs, never while a background task runs.
+    // =================================================================
+
+    class DocumentSnapshot
+    {
+    public:
+        uint64_t GetRevision() const { return m_revision; }
+
+        const std::vector<std::shared_ptr<const Wall>>& GetWalls() const { return m_walls; }
+        const WallHotData& GetWallHotData() const { return m_wallHot; }
+
+        const std::vector<std::shared_ptr<const Door>>& GetDoors() const { return m_doors; }
+        const std::vector<std::shared_ptr<const Window>>& GetWindows() const { return m_windows; }
+
+        const std::vector<std::shared_ptr<const Column>>& GetColumns() const { return m_columns; }
+        const std::vector<std::shared_ptr<const Slab>>& GetSlabs() const { return m_slabs; }
+        const std::vector<std::shared_ptr<const Beam>>& GetBeams() const { return m_beams; }
+
+        const std::vector<std::shared_ptr<const Room>>& GetRooms() const { return m_rooms; }
+        const std::vector<std::shared_ptr<Zone>>& GetAutoZones() const { return m_autoZones; }
+
+        const WallJoinGraph& GetWallJoinGraph() const
+        {
+            static const WallJoinGraph empty;
+            return m_joinGraph ? *m_joinGraph : empty;
+        }
+
+    private:
+        friend class SnapshotCache;
+
+        uint64_t m_revision{ 0 };
+
+        std::vector<std::shared_ptr<const Wall>> m_walls;
+        WallHotData m_wallHot;
+        std::vector<std::shared_ptr<const Door>> m_doors;
+        std::vector<std::shared_ptr<const Window>> m_windows;
+        std::vector<std::shared_ptr<const Column>> m_columns;
+        std::vector<std::shared_ptr<const Slab>> m_slabs;
+        std::vector<std::shared_ptr<const Beam>> m_beams;
+
+        std::vector<std::shared_ptr<const Room>> m_rooms;
+        std::vector<std::shared_ptr<Zone>> m_autoZones;    // resolved to the copies in m_rooms
+        std::shared_ptr<const WallJoinGraph> m_joinGraph;
+    };
+
+    // Copies of one element kind, reused while the source is unchanged
+    template <typename T>
+    class SharedCopyCache
+    {
+    public:
+        std::shared_ptr<const T> Get(const T& source, uint64_t revision)
+        {
+            Entry& entry = m_entries[source.GetId()];
+            if (!entry.Copy || entry.Revision != revision)
+            {
+                entry.Copy = std::make_shared<const T>(source);
+                entry.Revision = revision;
+                ++m_copies;
+            }
+            entry.Epoch = m_epoch;
+            return entry.Copy;
+        }
+
+        // Call after each snapshot: forget elements that no longer exist
+        void EndSnapshot()
+        {
+            for (auto it = m_entries.begin(); it != m_entries.end();)
+            {
+                if (it->second.Epoch != m_epoch)
+                    it = m_entries.erase(it);
+                else
+                    ++it;
+            }
+            ++m_epoch;
+        }
+
+        size_t GetCopyCount() const { return m_copies; }
+        void Clear() { m_entries.clear(); }
+
+    private:
+        struct Entry
+        {
+            std::shared_ptr<const T> Copy;
+            uint64_t Revision{ 0 };
+            uint64_t Epoch{ 0 };
+        };
+
+        std::unordered_map<uint64_t, Entry> m_entries;
+        uint64_t m_epoch{ 0 };
+        size_t m_copies{ 0 };
+    };
+
+    class SnapshotCache
+    {
+    public:
+        struct Sources
+        {
+            uint64_t Revision{ 0 };
+            const WallStore* Walls{ nullptr };
+            const std::vector<std::shared_ptr<Door>>* Doors{ nullptr };
+            const std::vector<std::shared_ptr<Window>>* Windows{ nullptr };
+            const std::vector<std::shared_ptr<Column>>* Columns{ nullptr };
+            const std::vector<std::shared_ptr<Slab>>* Slabs{ nullptr };
+            const std::vector<std::shared_ptr<Beam>>* Beams{ nullptr };
+            const std::vector<std::shared_ptr<Room>>* Rooms{ nullptr };
+            const std::vector<std::shared_ptr<Zone>>* AutoZones{ nullptr };
+            std::shared_ptr<const WallJoinGraph> JoinGraph;
+        };
+
+        std::shared_ptr<const DocumentSnapshot> Build(const Sources& src)
+        {
+            auto snapshot = std::make_shared<DocumentSnapshot>();
+            snapshot->m_revision = src.Revision;
+            snapshot->m_joinGraph = src.JoinGraph;
+
+            if (src.Walls)
+            {
+                snapshot->m_walls.reserve(src.Walls->Size());
+                for (const auto& wall : *src.Walls)
+                {
+                    // Geometry setters bump their own counter, the rest bump Element's
+                    uint64_t revision = wall->GetRevision() + wall->GetGeometryRevision();
+                    snapshot->m_walls.push_back(m_walls.Get(*wall, revision));
+                }
+                snapshot->m_wallHot = src.Walls->Hot();
+            }
+
+            CopyAll(src.Doors, m_doors, snapshot->m_doors);
+            CopyAll(src.Windows, m_windows, snapshot->m_windows);
+            CopyAll(src.Columns, m_columns, snapshot->m_columns);
+            CopyAll(src.Slabs, m_slabs, snapshot->m_slabs);
+            CopyAll(src.Beams, m_beams, snapshot->m_beams);
+
+            if (src.Rooms)
+            {
+                std::vector<std::shared_ptr<Room>> rooms;
+                rooms.reserve(src.Rooms->size());
+                for (const auto& room : *src.Rooms)
+                {
+                    if (!room) continue;
+                    auto copy = std::make_shared<Room>(*room);
+                    copy->GetNetAreaSqM();    // fill the lazy net quantities before sharing
+                    rooms.push_back(copy);
+                }
+                snapshot->m_rooms.assign(rooms.begin(), rooms.end());
+
+                if (src.AutoZones)
+                {
+                    for (const auto& zone : *src.AutoZones)
+                    {
+                        if (!zone) continue;
+                        auto copy = std::make_shared<Zone>(*zone);
+                        copy->UpdateRoomCache(rooms);
+                        copy->GetTotalAreaSqM();    // fill the lazy totals before sharing across threads
+                        snapshot->m_autoZones.push_back(copy);
+                    }
+                }
+            }
+
+            // Only the kinds this snapshot copied: a walls-only snapshot (the
+            // room job's) must not expire the other kinds' shared copies
+            EndSnapshot(src.Walls, m_walls);
+            EndSnapshot(src.Doors, m_doors);
+            EndSnapshot(src.Windows, m_windows);
+            EndSnapshot(src.Columns, m_columns);
+            EndSnapshot(src.Slabs, m_slabs);
+            EndSnapshot(src.Beams, m_beams);
+
+            return snapshot;
+        }
+
+        // Element copies made so far; a snapshot after a one-wall edit adds one
+        size_t GetCopyCount() const
+        {
+            return m_walls.GetCopyCount() + m_doors.GetCopyCount() + m_windows.GetCopyCount() +
+                   m_columns.GetCopyCount() + m_slabs.GetCopyCount() + m_beams.GetCopyCount();
+        }
+
+        void Clear()
+        {
+            m_walls.Clear();
+            m_doors.Clear();
+            m_windows.Clear();
+            m_columns.Clear();
+            m_slabs.Clear();
+            m_beams.Clear();
+        }
+
+    private:
+        template <typename Source, typename T>
+        static void EndSnapshot(const Source* source, SharedCopyCache<T>& cache)
+        {
+            if (source)
+                cache.EndSnapshot();
+        }
+
+        template <typename T>
+        static void CopyAll(const std::vector<std::shared_ptr<T>>* source,
+                            SharedCopyCache<T>& cache,
+                            std::vector<std::shared_ptr<const T>>& out)
+        {
+            if (!source)
+                return;
+            out.reserve(source->size());
+            for (const auto& element : *source)
+            {
+                if (element)
+                    out.push_back(cache.Get(*element, element->GetRevision()));
+            }
+        }
+
+        SharedCopyCache<Wall> m_walls;
+        SharedCopyCache<Door> m_doors;
+        SharedCopyCache<Window> m_windows;
+        SharedCopyCache<Column> m_columns;
+        SharedCopyCache<Slab> m_slabs;
+        SharedCopyCache<Beam> m_beams;
+    };
+}
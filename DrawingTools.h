@@ -4,141 +4,119 @@
 #include "Element.h"  // Includes Models.h which defines WallAttachmentMode
 #include "Camera.h"
 #include "Layer.h"
+#include "SnapEngine.h"
 #include "WallAttachmentSystem.h"  // R-WALL: Полное определение для ToLocationLineMode()
 #include <functional>
 #include <cmath>
 
 namespace winrt::estimate1
 {
-    // ��������� �������� (snap)
+    // Результат привязки (snap)
     struct SnapResult
     {
         bool hasSnap{ false };
         WorldPoint point{ 0, 0 };
-        std::wstring snapType{ L"" }; // "endpoint", "midpoint", "grid", "perpendicular"
+        std::wstring snapType{ L"" }; // "endpoint", "intersection", "midpoint", "grid", ...
+        SnapKind kind{ SnapKind::Grid };
+        const SnapProvider* provider{ nullptr };
     };
 
-    // �������� ��������
+    // Менеджер привязки: настройки поверх SnapEngine. Концы, пересечения
+    // и середины стен, сетка; остальные источники (грани стен, подложки)
+    // добавляются через AddProvider.
     class SnapManager
     {
     public:
-        SnapManager() = default;
+        SnapManager()
+        {
+            m_nodes = m_engine.AddProvider(std::make_unique<WallNodeSnapProvider>());
+            m_midpoints = m_engine.AddProvider(std::make_unique<WallMidpointSnapProvider>());
+            m_grid = m_engine.AddProvider(std::make_unique<GridSnapProvider>());
+            m_grid->SetEnabled(false);
+        }
 
-        // ��������� ��������
-        void SetGridSnapEnabled(bool enabled) { m_gridSnapEnabled = enabled; }
-        bool IsGridSnapEnabled() const { return m_gridSnapEnabled; }
+        // Настройки привязки
+        void SetGridSnapEnabled(bool enabled) { m_grid->SetEnabled(enabled); }
+        bool IsGridSnapEnabled() const { return m_grid->IsEnabled(); }
 
-        void SetEndpointSnapEnabled(bool enabled) { m_endpointSnapEnabled = enabled; }
-        bool IsEndpointSnapEnabled() const { return m_endpointSnapEnabled; }
+        // Концы и пересечения осей стен
+        void SetEndpointSnapEnabled(bool enabled) { m_nodes->SetEnabled(enabled); }
+        bool IsEndpointSnapEnabled() const { return m_nodes->IsEnabled(); }
 
-        void SetMidpointSnapEnabled(bool enabled) { m_midpointSnapEnabled = enabled; }
-        bool IsMidpointSnapEnabled() const { return m_midpointSnapEnabled; }
+        void SetMidpointSnapEnabled(bool enabled) { m_midpoints->SetEnabled(enabled); }
+        bool IsMidpointSnapEnabled() const { return m_midpoints->IsEnabled(); }
 
         void SetSnapTolerance(double tolerance) { m_snapTolerance = tolerance; }
         double GetSnapTolerance() const { return m_snapTolerance; }
 
-        void SetGridSpacing(double spacing) { m_gridSpacing = spacing; }
-        double GetGridSpacing() const { return m_gridSpacing; }
+        void SetGridSpacing(double spacing) { m_grid->SetSpacing(spacing); }
+        double GetGridSpacing() const { return m_grid->GetSpacing(); }
+
+        // Время на один запрос (на кадр), 0 - без ограничения
+        void SetQueryBudget(std::chrono::microseconds budget) { m_engine.SetBudget(budget); }
+
+        template <typename T>
+        T* AddProvider(std::unique_ptr<T> provider) { return m_engine.AddProvider(std::move(provider)); }
+
+        SnapEngine& GetEngine() { return m_engine; }
 
-        // ����� ����� ��������
+        // Поиск точки привязки
         SnapResult FindSnap(
             const WorldPoint& cursorWorld,
             const DocumentModel& document,
             const LayerManager& layerManager,
             const Camera& camera)
         {
-            SnapResult result;
-            double bestDistance = m_snapTolerance;
-
-            // ����������� ������ �� �������� � ������� �������
-            double worldTolerance = m_snapTolerance / camera.GetZoom();
-
-            // 1. �������� � �������� ������ ����
-            if (m_endpointSnapEnabled)
-            {
-                for (const auto& wall : document.GetWalls())
-                {
-                    if (!layerManager.IsWorkStateVisible(wall->GetWorkState()))
-                        continue;
-
-                    // ��������� �����
-                    double distStart = cursorWorld.Distance(wall->GetStartPoint());
-                    if (distStart < worldTolerance && distStart < bestDistance)
-                    {
-                        bestDistance = distStart;
-                        result.hasSnap = true;
-                        result.point = wall->GetStartPoint();
-                        result.snapType = L"endpoint";
-                    }
-
-                    // �������� �����
-                    double distEnd = cursorWorld.Distance(wall->GetEndPoint());
-                    if (distEnd < worldTolerance && distEnd < bestDistance)
-                    {
-                        bestDistance = distEnd;
-                        result.hasSnap = true;
-                        result.point = wall->GetEndPoint();
-                        result.snapType = L"endpoint";
-                    }
-                }
-            }
-
-            // 2. �������� � ��������� ����
-            if (m_midpointSnapEnabled && !result.hasSnap)
-            {
-                for (const auto& wall : document.GetWalls())
-                {
-                    if (!layerManager.IsWorkStateVisible(wall->GetWorkState()))
-                        continue;
-
-                    WorldPoint midpoint(
-                        (wall->GetStartPoint().X + wall->GetEndPoint().X) / 2,
-                        (wall->GetStartPoint().Y + wall->GetEndPoint().Y) / 2
-                    );
+            return FindSnap(MakeQuery(cursorWorld, document, layerManager, camera));
+        }
 
-                    double distMid = cursorWorld.Distance(midpoint);
-                    if (distMid < worldTolerance && distMid < bestDistance)
-                    {
-                        bestDistance = distMid;
-                        result.hasSnap = true;
-                        result.point = midpoint;
-                        result.snapType = L"midpoint";
-                    }
-                }
-            }
+        SnapResult FindSnap(const SnapQuery& query)
+        {
+            SnapEngineResult found = m_engine.Find(query);
 
-            // 3. �������� � �����
-            if (m_gridSnapEnabled && !result.hasSnap)
+            SnapResult result;
+            if (found.HasSnap())
             {
-                WorldPoint gridPoint = SnapToGrid(cursorWorld);
-                double distGrid = cursorWorld.Distance(gridPoint);
-                
-                if (distGrid < worldTolerance)
-                {
-                    result.hasSnap = true;
-                    result.point = gridPoint;
-                    result.snapType = L"grid";
-                }
+                const SnapHit& best = found.Hits.Best();
+                result.hasSnap = true;
+                result.point = best.Point;
+                result.kind = best.Kind;
+                result.snapType = GetSnapKindName(best.Kind);
+                result.provider = best.Provider;
             }
-
             return result;
         }
 
-        // �������� ����� � �����
+        // Запрос с текущим допуском; вызывающий может дополнить его
+        // (точка старта, грани стен)
+        SnapQuery MakeQuery(
+            const WorldPoint& cursorWorld,
+            const DocumentModel& document,
+            const LayerManager& layerManager,
+            const Camera& camera) const
+        {
+            SnapQuery query;
+            query.Cursor = cursorWorld;
+            query.Zoom = camera.GetZoom();
+            // Переводим допуск из пикселей в мировые единицы
+            query.Tolerance = m_snapTolerance / camera.GetZoom();
+            query.Document = &document;
+            query.Layers = &layerManager;
+            return query;
+        }
+
+        // Привязка точки к сетке
         WorldPoint SnapToGrid(const WorldPoint& point) const
         {
-            return WorldPoint(
-                std::round(point.X / m_gridSpacing) * m_gridSpacing,
-                std::round(point.Y / m_gridSpacing) * m_gridSpacing
-            );
+            return m_grid->SnapToGrid(point);
         }
 
     private:
-        bool m_gridSnapEnabled{ false };
-        bool m_endpointSnapEnabled{ true };
-        bool m_midpointSnapEnabled{ true };
-        double m_snapTolerance{ 15.0 };    // ������ � ��������
-        double m_gridSpacing{ 100.0 };      // ��� ����� � ��
+        SnapEngine m_engine;
+        WallNodeSnapProvider* m_nodes{ nullptr };
+        WallMidpointSnapProvider* m_midpoints{ nullptr };
+        GridSnapProvider* m_grid{ nullptr };
+        double m_snapTolerance{ 15.0 };    // допуск в пикселях
     };
 
     // ��������� ����������� ��������� ����
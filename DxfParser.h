@@ -42,6 +42,7 @@ namespace winrt::estimate1
         std::wstring LayerName{ L"0" };
         int ColorIndex{ 256 };  // 256 = ByLayer
         double Thickness{ 0.0 };
+        size_t FileIndex{ 0 };  // position among the file's imported entities, in file order
 
         virtual ~DxfEntity() = default;
     };
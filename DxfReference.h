@@ -2,6 +2,9 @@
 
 #include "pch.h"
 #include "DxfParser.h"
+#include "ReferenceSnapIndex.h"
+#include "GeometryKernels.h"
+#include <algorithm>
 #include <memory>
 #include <string>
 #include <vector>
@@ -47,37 +50,51 @@ namespace winrt::estimate1
 
         // 
         const std::wstring& GetName() const { return m_name; }
-        void SetName(const std::wstring& name) { m_name = name; }
+        void SetName(const std::wstring& name) { m_name = name; ++m_revision; }
 
         // 
         bool IsVisible() const { return m_isVisible; }
-        void SetVisible(bool visible) { m_isVisible = visible; }
+        void SetVisible(bool visible) { m_isVisible = visible; ++m_revision; }
 
         //  (0-255)
         uint8_t GetOpacity() const { return m_opacity; }
-        void SetOpacity(uint8_t opacity) { m_opacity = opacity; }
+        void SetOpacity(uint8_t opacity) { m_opacity = opacity; ++m_revision; }
 
         //  (  )
         Windows::UI::Color GetColor() const { return m_color; }
-        void SetColor(Windows::UI::Color color) { m_color = color; }
+        void SetColor(Windows::UI::Color color) { m_color = color; ++m_revision; }
 
         //    DXF
         bool UseOriginalColors() const { return m_useOriginalColors; }
-        void SetUseOriginalColors(bool use) { m_useOriginalColors = use; }
+        void SetUseOriginalColors(bool use) { m_useOriginalColors = use; ++m_revision; }
 
         //  
         float GetLineWidth() const { return m_lineWidth; }
-        void SetLineWidth(float width) { m_lineWidth = width; }
+        void SetLineWidth(float width) { m_lineWidth = width; ++m_revision; }
 
         // 
         const std::vector<std::unique_ptr<DxfEntity>>& GetEntities() const { return m_entities; }
 
         //    DxfDocument
+        // Entities are kept grouped by DrawCellSize cell of their first
+        // point and, within a cell, by type and color, so the display
+        // list batches neighbours of one style and can cull the batches
         void TakeEntities(std::vector<std::unique_ptr<DxfEntity>>& entities)
         {
             m_entities = std::move(entities);
+            for (size_t i = 0; i < m_entities.size(); ++i)
+            {
+                if (m_entities[i])
+                    m_entities[i]->FileIndex = i;
+            }
+            SortSpatially();
+            BuildSnapIndex();
+            ++m_revision;
         }
 
+        // Line work for object snaps, built with the entities
+        const ReferenceSnapIndex& GetSnapIndex() const { return m_snapIndex; }
+
         // 
         const WorldPoint& GetMinBounds() const { return m_minBounds; }
         const WorldPoint& GetMaxBounds() const { return m_maxBounds; }
@@ -86,6 +103,7 @@ namespace winrt::estimate1
         {
             m_minBounds = minPt;
             m_maxBounds = maxPt;
+            ++m_revision;
         }
 
         //  
@@ -93,16 +111,131 @@ namespace winrt::estimate1
 
         //    
         const std::wstring& GetSourcePath() const { return m_sourcePath; }
-        void SetSourcePath(const std::wstring& path) { m_sourcePath = path; }
+        void SetSourcePath(const std::wstring& path) { m_sourcePath = path; ++m_revision; }
 
         // M6:  
         const std::wstring& GetFilePath() const { return m_sourcePath; }
         double GetScale() const { return m_scale; }
-        void SetScale(double scale) { m_scale = scale; }
+        void SetScale(double scale) { m_scale = scale; ++m_revision; }
         const WorldPoint& GetOffset() const { return m_offset; }
-        void SetOffset(const WorldPoint& offset) { m_offset = offset; }
+        void SetOffset(const WorldPoint& offset) { m_offset = offset; ++m_revision; }
+
+        // Changes with every edit of the layer, for caches of its drawing
+        uint64_t GetRevision() const { return m_revision; }
 
     private:
+        static constexpr double DrawCellSize = 5000.0;      // mm
+
+        static WorldPoint AnchorOf(const DxfEntity& entity)
+        {
+            switch (entity.Type)
+            {
+            case DxfEntityType::Line:
+                return static_cast<const DxfLine&>(entity).Start;
+            case DxfEntityType::Polyline:
+            case DxfEntityType::LWPolyline:
+            {
+                const auto& poly = static_cast<const DxfPolyline&>(entity);
+                return poly.Vertices.empty() ? WorldPoint(0, 0) : poly.Vertices.front().Point;
+            }
+            case DxfEntityType::Circle:
+                return static_cast<const DxfCircle&>(entity).Center;
+            case DxfEntityType::Arc:
+                return static_cast<const DxfArc&>(entity).Center;
+            case DxfEntityType::Text:
+            case DxfEntityType::MText:
+                return static_cast<const DxfText&>(entity).Position;
+            default:
+                return WorldPoint(0, 0);
+            }
+        }
+
+        void SortSpatially()
+        {
+            struct Entry
+            {
+                uint64_t Cell;
+                int Type;
+                int Color;
+                size_t Index;
+
+                bool operator<(const Entry& other) const
+                {
+                    if (Cell != other.Cell) return Cell < other.Cell;
+                    if (Type != other.Type) return Type < other.Type;
+                    return Color < other.Color;
+                }
+            };
+
+            std::vector<Entry> order;
+            order.reserve(m_entities.size());
+            for (size_t i = 0; i < m_entities.size(); ++i)
+            {
+                const DxfEntity* entity = m_entities[i].get();
+                if (entity)
+                    order.push_back({ SpatialOrderKey(AnchorOf(*entity), DrawCellSize),
+                        static_cast<int>(entity->Type), entity->ColorIndex, i });
+            }
+            std::stable_sort(order.begin(), order.end());
+
+            std::vector<std::unique_ptr<DxfEntity>> sorted;
+            sorted.reserve(order.size());
+            for (const auto& entry : order)
+                sorted.push_back(std::move(m_entities[entry.Index]));
+            m_entities = std::move(sorted);
+        }
+
+        void BuildSnapIndex()
+        {
+            constexpr double PI = 3.14159265358979323846;
+
+            m_snapIndex.Clear();
+            for (size_t e = 0; e < m_entities.size(); ++e)
+            {
+                const auto& entity = m_entities[e];
+                m_snapIndex.BeginEntity(entity->FileIndex + 1);
+                switch (entity->Type)
+                {
+                case DxfEntityType::Line:
+                {
+                    const auto& line = static_cast<const DxfLine&>(*entity);
+                    m_snapIndex.AddSegment(line.Start, line.End);
+                    break;
+                }
+                case DxfEntityType::Polyline:
+                case DxfEntityType::LWPolyline:
+                {
+                    const auto& poly = static_cast<const DxfPolyline&>(*entity);
+                    size_t n = poly.Vertices.size();
+                    size_t edges = poly.IsClosed && n > 2 ? n : n - 1;
+                    for (size_t i = 0; n >= 2 && i < edges; ++i)
+                    {
+                        const DxfVertex& v = poly.Vertices[i];
+                        m_snapIndex.AddBulge(v.Point, poly.Vertices[(i + 1) % n].Point, v.Bulge);
+                    }
+                    break;
+                }
+                case DxfEntityType::Circle:
+                {
+                    const auto& circle = static_cast<const DxfCircle&>(*entity);
+                    m_snapIndex.AddArc(circle.Center, circle.Radius, 0.0, 2.0 * PI);
+                    break;
+                }
+                case DxfEntityType::Arc:
+                {
+                    const auto& arc = static_cast<const DxfArc&>(*entity);
+                    double sweep = std::fmod(arc.EndAngle - arc.StartAngle + 720.0, 360.0);
+                    m_snapIndex.AddArc(arc.Center, arc.Radius, arc.StartAngle * PI / 180.0,
+                                       (sweep == 0.0 ? 360.0 : sweep) * PI / 180.0);
+                    break;
+                }
+                default:
+                    break;
+                }
+            }
+            m_snapIndex.Finish();
+        }
+
         std::wstring m_name;
         std::wstring m_sourcePath;
 
@@ -115,8 +248,11 @@ namespace winrt::estimate1
         WorldPoint m_offset{ 0, 0 };
 
         std::vector<std::unique_ptr<DxfEntity>> m_entities;
+        ReferenceSnapIndex m_snapIndex;
         WorldPoint m_minBounds{ 0, 0 };
         WorldPoint m_maxBounds{ 0, 0 };
+
+        uint64_t m_revision{ 0 };
     };
 
     // ============================================================================
@@ -204,6 +340,7 @@ namespace winrt::estimate1
             if (index >= m_layers.size())
                 return false;
 
+            m_removedRevisions += m_layers[index]->GetRevision() + 1;
             m_layers.erase(m_layers.begin() + index);
             return true;
         }
@@ -211,9 +348,21 @@ namespace winrt::estimate1
         //   
         void Clear()
         {
+            for (const auto& layer : m_layers)
+                m_removedRevisions += layer->GetRevision() + 1;
             m_layers.clear();
         }
 
+        // Changes whenever a layer is added, removed or edited: a removed
+        // layer leaves its revision plus one behind, so the sum only grows
+        uint64_t GetRevision() const
+        {
+            uint64_t revision = m_removedRevisions;
+            for (const auto& layer : m_layers)
+                revision += layer->GetRevision();
+            return revision;
+        }
+
         //  
         size_t GetLayerCount() const { return m_layers.size(); }
 
@@ -252,5 +401,6 @@ namespace winrt::estimate1
 
     private:
         std::vector<std::unique_ptr<DxfReferenceLayer>> m_layers;
+        uint64_t m_removedRevisions{ 0 };
     };
 }
@@ -3,6 +3,8 @@
 #include "pch.h"
 #include "Camera.h"
 #include "DxfReference.h"
+#include "DisplayList.h"
+#include <array>
 #include <cmath>
 
 namespace winrt::estimate1
@@ -33,25 +35,23 @@ namespace winrt::estimate1
             }
         }
 
-        //   DXF-
-        static void Draw(
-            Microsoft::Graphics::Canvas::CanvasDrawingSession const& session,
-            const Camera& camera,
+        //    DXF-   
+        static void Build(
+            DisplayList& list,
             const DxfReferenceManager& manager)
         {
             for (const auto& layer : manager.GetLayers())
             {
                 if (layer && layer->IsVisible())
                 {
-                    DrawLayer(session, camera, *layer);
+                    BuildLayer(list, *layer);
                 }
             }
         }
 
-        //   
-        static void DrawLayer(
-            Microsoft::Graphics::Canvas::CanvasDrawingSession const& session,
-            const Camera& camera,
+        //  
+        static void BuildLayer(
+            DisplayList& list,
             const DxfReferenceLayer& layer)
         {
             auto baseColor = layer.GetColor();
@@ -59,40 +59,54 @@ namespace winrt::estimate1
             float lineWidth = layer.GetLineWidth();
             bool useOriginalColors = layer.UseOriginalColors();
 
+            //   :   ( 0)   ACI 1-9
+            std::array<int, 10> strokeStyles;
+            strokeStyles.fill(-1);
+            std::vector<WorldPoint> points;
+
             for (const auto& entity : layer.GetEntities())
             {
                 if (!entity)
                     continue;
 
                 //  
-                Windows::UI::Color color = baseColor;
+                size_t colorSlot = 0;
+                if (useOriginalColors && entity->ColorIndex >= 1 && entity->ColorIndex <= 9)
+                    colorSlot = static_cast<size_t>(entity->ColorIndex);
+
+                Windows::UI::Color color = colorSlot ? GetColorByIndex(entity->ColorIndex, baseColor) : baseColor;
                 color.A = alpha;
 
-                if (useOriginalColors && entity->ColorIndex != 256)
-                {
-                    color = GetColorByIndex(entity->ColorIndex, baseColor);
-                    color.A = alpha;
-                }
+                int& styleId = strokeStyles[colorSlot];
+                if (styleId < 0)
+                    styleId = list.AddStyle(DisplayStyle::Stroke(color, lineWidth));
+                uint16_t style = static_cast<uint16_t>(styleId);
 
                 //   
                 switch (entity->Type)
                 {
                 case DxfEntityType::Line:
-                    DrawLine(session, camera, static_cast<const DxfLine&>(*entity), color, lineWidth);
+                {
+                    const auto& line = static_cast<const DxfLine&>(*entity);
+                    list.AddLine(style, line.Start, line.End);
                     break;
+                }
                 case DxfEntityType::LWPolyline:
                 case DxfEntityType::Polyline:
-                    DrawPolyline(session, camera, static_cast<const DxfPolyline&>(*entity), color, lineWidth);
+                    AddPolyline(list, style, static_cast<const DxfPolyline&>(*entity), points);
                     break;
                 case DxfEntityType::Circle:
-                    DrawCircle(session, camera, static_cast<const DxfCircle&>(*entity), color, lineWidth);
+                {
+                    const auto& circle = static_cast<const DxfCircle&>(*entity);
+                    list.AddCircle(style, circle.Center, circle.Radius);
                     break;
+                }
                 case DxfEntityType::Arc:
-                    DrawArc(session, camera, static_cast<const DxfArc&>(*entity), color, lineWidth);
+                    AddArc(list, style, static_cast<const DxfArc&>(*entity), points);
                     break;
                 case DxfEntityType::Text:
                 case DxfEntityType::MText:
-                    DrawText(session, camera, static_cast<const DxfText&>(*entity), color);
+                    AddText(list, color, static_cast<const DxfText&>(*entity));
                     break;
                 default:
                     break;
@@ -101,96 +115,50 @@ namespace winrt::estimate1
         }
 
     private:
-        //  
-        static void DrawLine(
-            Microsoft::Graphics::Canvas::CanvasDrawingSession const& session,
-            const Camera& camera,
-            const DxfLine& line,
-            Windows::UI::Color color,
-            float lineWidth)
-        {
-            auto p1 = camera.WorldToScreen(line.Start);
-            auto p2 = camera.WorldToScreen(line.End);
-
-            session.DrawLine(
-                static_cast<float>(p1.X), static_cast<float>(p1.Y),
-                static_cast<float>(p2.X), static_cast<float>(p2.Y),
-                color, lineWidth);
-        }
-
-        //  
-        static void DrawPolyline(
-            Microsoft::Graphics::Canvas::CanvasDrawingSession const& session,
-            const Camera& camera,
+        //   :   (bulge)   
+        static void AddPolyline(
+            DisplayList& list,
+            uint16_t style,
             const DxfPolyline& poly,
-            Windows::UI::Color color,
-            float lineWidth)
+            std::vector<WorldPoint>& points)
         {
             if (poly.Vertices.size() < 2)
                 return;
 
-            //  
-            for (size_t i = 0; i < poly.Vertices.size() - 1; ++i)
+            points.clear();
+            points.push_back(poly.Vertices.front().Point);
+            for (size_t i = 0; i + 1 < poly.Vertices.size(); ++i)
             {
-                const auto& v1 = poly.Vertices[i];
-                const auto& v2 = poly.Vertices[i + 1];
-
-                auto p1 = camera.WorldToScreen(v1.Point);
-                auto p2 = camera.WorldToScreen(v2.Point);
-
-                if (std::abs(v1.Bulge) < 0.0001)
-                {
-                    //  
-                    session.DrawLine(
-                        static_cast<float>(p1.X), static_cast<float>(p1.Y),
-                        static_cast<float>(p2.X), static_cast<float>(p2.Y),
-                        color, lineWidth);
-                }
-                else
-                {
-                    //   (bulge)
-                    DrawBulgeArc(session, camera, v1.Point, v2.Point, v1.Bulge, color, lineWidth);
-                }
+                AppendSegment(points, poly.Vertices[i].Point, poly.Vertices[i + 1].Point, poly.Vertices[i].Bulge);
             }
 
-            // ,  
-            if (poly.IsClosed && poly.Vertices.size() >= 2)
+            // ,  ;     
+            bool closed = poly.IsClosed;
+            if (closed && std::abs(poly.Vertices.back().Bulge) >= 0.0001)
             {
-                const auto& vLast = poly.Vertices.back();
-                const auto& vFirst = poly.Vertices.front();
-
-                auto pLast = camera.WorldToScreen(vLast.Point);
-                auto pFirst = camera.WorldToScreen(vFirst.Point);
-
-                if (std::abs(vLast.Bulge) < 0.0001)
-                {
-                    session.DrawLine(
-                        static_cast<float>(pLast.X), static_cast<float>(pLast.Y),
-                        static_cast<float>(pFirst.X), static_cast<float>(pFirst.Y),
-                        color, lineWidth);
-                }
-                else
-                {
-                    DrawBulgeArc(session, camera, vLast.Point, vFirst.Point, vLast.Bulge, color, lineWidth);
-                }
+                AppendSegment(points, poly.Vertices.back().Point, poly.Vertices.front().Point, poly.Vertices.back().Bulge);
             }
+
+            list.AddPolyline(style, points, closed);
         }
 
-        //    bulge
-        static void DrawBulgeArc(
-            Microsoft::Graphics::Canvas::CanvasDrawingSession const& session,
-            const Camera& camera,
+        //    start:        bulge
+        static void AppendSegment(
+            std::vector<WorldPoint>& points,
             const WorldPoint& start,
             const WorldPoint& end,
-            double bulge,
-            Windows::UI::Color color,
-            float lineWidth)
+            double bulge)
         {
+            if (std::abs(bulge) < 0.0001)
+            {
+                //  
+                points.push_back(end);
+                return;
+            }
+
             //  = tan(/4)
             //   =  ,  =  
 
-            constexpr double PI = 3.14159265358979323846;
-
             double dx = end.X - start.X;
             double dy = end.Y - start.Y;
             double chordLen = std::sqrt(dx * dx + dy * dy);
@@ -223,65 +191,30 @@ namespace winrt::estimate1
             double centerX = midX + perpX * dist;
             double centerY = midY + perpY * dist;
 
-            //    
+            //  
             double startAngle = std::atan2(start.Y - centerY, start.X - centerX);
-            double endAngle = std::atan2(end.Y - centerY, end.X - centerX);
 
             //    
             int segments = static_cast<int>(std::abs(theta) / (PI / 18.0));  // ~10  
             segments = (std::max)(segments, 8);
 
             double angleStep = theta / segments;
-
-            WorldPoint prevPt = start;
             for (int i = 1; i <= segments; ++i)
             {
                 double angle = startAngle + angleStep * i;
-                WorldPoint pt{
+                points.push_back(WorldPoint(
                     centerX + radius * std::cos(angle),
-                    centerY + radius * std::sin(angle)
-                };
-
-                auto screenPrev = camera.WorldToScreen(prevPt);
-                auto screenCur = camera.WorldToScreen(pt);
-
-                session.DrawLine(
-                    static_cast<float>(screenPrev.X), static_cast<float>(screenPrev.Y),
-                    static_cast<float>(screenCur.X), static_cast<float>(screenCur.Y),
-                    color, lineWidth);
-
-                prevPt = pt;
+                    centerY + radius * std::sin(angle)));
             }
         }
 
-        //  
-        static void DrawCircle(
-            Microsoft::Graphics::Canvas::CanvasDrawingSession const& session,
-            const Camera& camera,
-            const DxfCircle& circle,
-            Windows::UI::Color color,
-            float lineWidth)
-        {
-            auto center = camera.WorldToScreen(circle.Center);
-            float screenRadius = static_cast<float>(circle.Radius * camera.GetZoom());
-
-            session.DrawCircle(
-                static_cast<float>(center.X),
-                static_cast<float>(center.Y),
-                screenRadius,
-                color, lineWidth);
-        }
-
-        //  
-        static void DrawArc(
-            Microsoft::Graphics::Canvas::CanvasDrawingSession const& session,
-            const Camera& camera,
+        // 
+        static void AddArc(
+            DisplayList& list,
+            uint16_t style,
             const DxfArc& arc,
-            Windows::UI::Color color,
-            float lineWidth)
+            std::vector<WorldPoint>& points)
         {
-            constexpr double PI = 3.14159265358979323846;
-
             //    
             double startRad = arc.StartAngle * PI / 180.0;
             double endRad = arc.EndAngle * PI / 180.0;
@@ -298,62 +231,36 @@ namespace winrt::estimate1
 
             double angleStep = sweepAngle / segments;
 
-            WorldPoint prevPt{
-                arc.Center.X + arc.Radius * std::cos(startRad),
-                arc.Center.Y + arc.Radius * std::sin(startRad)
-            };
-
-            for (int i = 1; i <= segments; ++i)
+            points.clear();
+            for (int i = 0; i <= segments; ++i)
             {
                 double angle = startRad + angleStep * i;
-                WorldPoint pt{
+                points.push_back(WorldPoint(
                     arc.Center.X + arc.Radius * std::cos(angle),
-                    arc.Center.Y + arc.Radius * std::sin(angle)
-                };
-
-                auto screenPrev = camera.WorldToScreen(prevPt);
-                auto screenCur = camera.WorldToScreen(pt);
-
-                session.DrawLine(
-                    static_cast<float>(screenPrev.X), static_cast<float>(screenPrev.Y),
-                    static_cast<float>(screenCur.X), static_cast<float>(screenCur.Y),
-                    color, lineWidth);
-
-                prevPt = pt;
+                    arc.Center.Y + arc.Radius * std::sin(angle)));
             }
+
+            list.AddPolyline(style, points, false);
         }
 
-        //  
-        static void DrawText(
-            Microsoft::Graphics::Canvas::CanvasDrawingSession const& session,
-            const Camera& camera,
-            const DxfText& text,
-            Windows::UI::Color color)
+        // :   ,    6  72 px
+        static void AddText(
+            DisplayList& list,
+            Windows::UI::Color color,
+            const DxfText& text)
         {
             if (text.Content.empty())
                 return;
 
-            auto pos = camera.WorldToScreen(text.Position);
-            float fontSize = static_cast<float>(text.Height * camera.GetZoom());
+            DisplayStyle style = DisplayStyle::Text(color, static_cast<float>(text.Height), DisplayFont::Mono);
+            style.WorldFont = true;
+            style.Priority = DisplayLabelPriority::Underlay;
 
-            //     
-            fontSize = (std::max)(fontSize, 6.0f);
-            fontSize = (std::min)(fontSize, 72.0f);
-
-            //   
-            auto textFormat = Microsoft::Graphics::Canvas::Text::CanvasTextFormat();
-            textFormat.FontSize(fontSize);
-            textFormat.FontFamily(L"Consolas");
-
-            //  
             // DXF Y- ,         
             //    
-            session.DrawText(
-                winrt::hstring(text.Content),
-                static_cast<float>(pos.X),
-                static_cast<float>(pos.Y),
-                color,
-                textFormat);
+            list.AddText(list.AddStyle(style), text.Position, text.Content);
         }
+
+        static constexpr double PI = 3.14159265358979323846;
     };
 }
@@ -10,10 +10,19 @@
 #include "RoomDetector.h"
 #include "Zone.h"
 #include "Structure.h"
+#include "WallStore.h"
+#include "WallGraph.h"
+#include "WallJoinIndex.h"
+#include "WallJoinGraph.h"
+#include "RoomWorker.h"
+#include "ChangeJournal.h"
+#include "DocumentSnapshot.h"
+#include "Level.h"
 #include <vector>
 #include <memory>
 #include <algorithm>
 #include <unordered_map>
+#include <unordered_set>
 
 namespace winrt::estimate1
 {
@@ -23,19 +32,206 @@ namespace winrt::estimate1
     public:
         DocumentModel()
         {
+            ResetLevels();
             InitializeDefaults();
         }
 
+        // Per-document id source. Element-creating methods bind it for their
+        // duration; the UI thread binds it for tools, workers reserve blocks.
+        IdAllocator& GetIdAllocator() { return m_idAllocator; }
+
+        // Document revision and change history for derived caches
+        // (see ChangeJournal.h). Walls edited directly through Wall* are
+        // journaled on the next SyncWallEdits().
+        const ChangeJournal& GetJournal() const { return m_journal; }
+        ChangeJournal& GetJournal() { return m_journal; }
+        uint64_t GetRevision() const { return m_journal.GetRevision(); }
+        uint64_t GetElementRevision(uint64_t id) const { return m_journal.GetElementRevision(id); }
+        ChangeSet GetChangesSince(uint64_t revision) const { return m_journal.GetChangesSince(revision); }
+        ChangeSet GetChangesSince(uint64_t revision, JournalElementKind kind) const { return m_journal.GetChangesSince(revision, kind); }
+
+        // Immutable view of the active level for worker threads. Unchanged
+        // elements are shared with the previous snapshot, so this is cheap
+        // after small edits.
+        std::shared_ptr<const DocumentSnapshot> CreateSnapshot()
+        {
+            SyncWallEdits();
+            FinishRoomWork();
+
+            SnapshotCache::Sources src;
+            src.Revision = m_journal.GetRevision();
+            src.Walls = &m_walls;
+            src.Doors = &m_doors;
+            src.Windows = &m_windows;
+            src.Columns = &m_columns;
+            src.Slabs = &m_slabs;
+            src.Beams = &m_beams;
+            src.Rooms = &m_rooms;
+            src.AutoZones = &m_zoneManager.GetAutoZones();
+            GetWallJoinGraph();
+            src.JoinGraph = m_joinGraph;
+            return m_snapshotCache.Build(src);
+        }
+
+        // Element copies the active level's snapshots have made so far
+        size_t GetSnapshotCopyCount() const { return m_snapshotCache.GetCopyCount(); }
+
+        // =====================================================================
+        // Levels (see Level.h). Everything else in this class works on the
+        // active level; parked levels are only reachable through here.
+        // =====================================================================
+
+        const std::vector<Level>& GetLevels() const { return m_levels; }
+        size_t GetLevelCount() const { return m_levels.size(); }
+        size_t GetActiveLevelIndex() const { return m_activeLevel; }
+        const Level& GetActiveLevel() const { return m_levels[m_activeLevel]; }
+        Level& GetActiveLevel() { return m_levels[m_activeLevel]; }
+
+        Level* GetLevel(uint64_t levelId)
+        {
+            size_t index = FindLevelIndex(levelId);
+            return index < m_levels.size() ? &m_levels[index] : nullptr;
+        }
+
+        // Add a level on top of the highest one; it is not activated
+        uint64_t AddLevel(const std::wstring& name = L"", double height = 3000.0)
+        {
+            IdAllocatorScope idScope(m_idAllocator);
+
+            double elevation = 0.0;
+            for (const auto& level : m_levels)
+                elevation = (std::max)(elevation, level.GetElevation() + level.GetHeight());
+
+            std::wstring levelName = name.empty() ? L"Level " + std::to_wstring(m_levels.size() + 1) : name;
+            m_levels.emplace_back(levelName, elevation, height);
+            m_levelData.emplace_back();
+            return m_levels.back().GetId();
+        }
+
+        // The active level and the last remaining level cannot be removed
+        bool RemoveLevel(uint64_t levelId)
+        {
+            size_t index = FindLevelIndex(levelId);
+            if (index >= m_levels.size() || index == m_activeLevel || m_levels.size() == 1)
+                return false;
+
+            m_levels.erase(m_levels.begin() + index);
+            m_levelData.erase(m_levelData.begin() + index);
+            if (index < m_activeLevel)
+                --m_activeLevel;
+            return true;
+        }
+
+        // Park the active level and load another. Derived caches see a
+        // journal reset, since every visible element changes.
+        bool SetActiveLevel(uint64_t levelId)
+        {
+            size_t index = FindLevelIndex(levelId);
+            if (index >= m_levels.size())
+                return false;
+            if (index == m_activeLevel)
+                return true;
+
+            ClearSelection();
+            CancelRoomWork();
+            ActivateLevelIndex(index);
+            m_journal.RecordReset();
+            return true;
+        }
+
+        // Snapshot of any level. Parked levels are read from their partition
+        // and keep their own copy cache, so repeated calls stay cheap.
+        std::shared_ptr<const DocumentSnapshot> CreateLevelSnapshot(uint64_t levelId)
+        {
+            size_t index = FindLevelIndex(levelId);
+            if (index >= m_levels.size())
+                return nullptr;
+            if (index == m_activeLevel)
+                return CreateSnapshot();
+
+            LevelPartition& part = m_levelData[index];
+            if (part.Walls.Sync() > 0)
+                part.JoinGraph.reset();
+
+            SnapshotCache::Sources src;
+            src.Revision = m_journal.GetRevision();
+            src.Walls = &part.Walls;
+            src.Doors = &part.Doors;
+            src.Windows = &part.Windows;
+            src.Columns = &part.Columns;
+            src.Slabs = &part.Slabs;
+            src.Beams = &part.Beams;
+            src.Rooms = &part.Rooms;
+            src.AutoZones = &part.Zones.GetAutoZones();
+
+            // Parked walls have no journal of their own: joins are detected
+            // once and kept until the level is activated or its walls move
+            if (!part.JoinGraph)
+            {
+                auto joinGraph = std::make_shared<WallJoinGraph>();
+                joinGraph->Rebuild(part.Walls, WallJoinIndex(part.Walls.Objects()));
+                part.JoinGraph = joinGraph;
+            }
+            src.JoinGraph = part.JoinGraph;
+            return part.Snapshots.Build(src);
+        }
+
+        std::vector<std::shared_ptr<const DocumentSnapshot>> CreateAllLevelSnapshots()
+        {
+            std::vector<std::shared_ptr<const DocumentSnapshot>> snapshots;
+            snapshots.reserve(m_levels.size());
+            for (const auto& level : m_levels)
+                snapshots.push_back(CreateLevelSnapshot(level.GetId()));
+            return snapshots;
+        }
+
+        // Run fn(level) with each level active in turn, then restore the
+        // original one. For save and batch jobs that use the per-level API.
+        // The journal is shared by all levels, so the wall graph, join index
+        // and join graph are dropped on every switch and rebuilt for the
+        // level in view on first use. If fn edited anything, those edits
+        // were journaled under ids of another level: the journal is then
+        // reset after the restore so the original level's caches rebuild.
+        template <typename Func>
+        void ForEachLevel(Func&& fn)
+        {
+            FinishRoomWork();
+            size_t original = m_activeLevel;
+            Element* selected = m_selectedElement;
+            uint64_t revision = m_journal.GetRevision();
+            for (size_t i = 0; i < m_levels.size(); ++i)
+            {
+                ActivateLevelIndex(i);
+                fn(m_levels[i]);
+                FinishRoomWork();   // a job for this level must not land on the next one
+            }
+            ActivateLevelIndex(original);
+            if (m_journal.GetRevision() != revision)
+                m_journal.RecordReset();
+            m_selectedElement = IsElementAlive(selected) ? selected : nullptr;
+        }
+
+        // Pick up geometry edits made without NotifyWallChanged (undo
+        // commands, tools writing Wall* directly). Returns walls refreshed.
+        size_t SyncWallEdits()
+        {
+            return m_walls.Sync([this](uint64_t id) {
+                m_journal.RecordModified(id, JournalElementKind::Wall);
+            });
+        }
+
         // M3.5: ����������� �� ��������� ���������/���������� �����.
         // ������ ������ ������������ ����������� ������� (���������� ��� ������� �����).
         void NotifyWallChanged(uint64_t wallId)
         {
-            (void)wallId;
+            m_walls.RefreshById(wallId);
+            m_journal.RecordModified(wallId, JournalElementKind::Wall);
             RebuildAutoDimensions();
         }
 
         void InitializeDefaults()
         {
+            IdAllocatorScope idScope(m_idAllocator);
             m_materials.clear();
             m_wallTypes.clear();
             m_doorTypes.clear();
@@ -129,6 +325,7 @@ namespace winrt::estimate1
         // ���������� �����
         Wall* AddWall(const WorldPoint& start, const WorldPoint& end, double thickness = 150.0)
         {
+            IdAllocatorScope idScope(m_idAllocator);
             auto wall = std::make_unique<Wall>(start, end, thickness);
             // ���� ���� ��������� ��� �����, ��������� ���.
             if (auto t = GetDefaultWallType())
@@ -136,7 +333,8 @@ namespace winrt::estimate1
                 wall->SetType(t);
             }
             Wall* ptr = wall.get();
-            m_walls.push_back(std::move(wall));
+            m_walls.Insert(std::move(wall));
+            m_journal.RecordAdded(ptr->GetId(), JournalElementKind::Wall);
 
             // M3.5: ������������� ����������� ����� ���������� �����.
             RebuildAutoDimensions();
@@ -146,16 +344,16 @@ namespace winrt::estimate1
         // �������� �����
         bool RemoveWall(uint64_t id)
         {
-            auto it = std::find_if(m_walls.begin(), m_walls.end(),
-                [id](const std::unique_ptr<Wall>& w) { return w->GetId() == id; });
+            WallHandle handle = m_walls.FindHandle(id);
             
-            if (it != m_walls.end())
+            if (Wall* wall = m_walls.Get(handle))
             {
                 // ���� ������� ��������� ������� � �������� �����, ����� �� �������� ������� ���������
-                if (m_selectedElement == it->get())
+                if (m_selectedElement == wall)
                     m_selectedElement = nullptr;
 
-                m_walls.erase(it);
+                m_walls.Erase(handle);
+                m_journal.RecordRemoved(id, JournalElementKind::Wall);
                 RebuildAutoDimensions();
                 return true;
             }
@@ -168,6 +366,8 @@ namespace winrt::estimate1
             Wall* original = GetWall(wallId);
             if (!original) return false;
 
+            IdAllocatorScope idScope(m_idAllocator);
+
             WorldPoint start = original->GetStartPoint();
             WorldPoint end = original->GetEndPoint();
 
@@ -183,17 +383,15 @@ namespace winrt::estimate1
             w2->SetHeight(original->GetHeight());
 
             // ������� ������ (��� rebuild ����)
-            auto it = std::find_if(m_walls.begin(), m_walls.end(),
-                [wallId](const std::unique_ptr<Wall>& w) { return w->GetId() == wallId; });
-            if (it != m_walls.end())
-            {
-                if (m_selectedElement == it->get()) m_selectedElement = nullptr;
-                m_walls.erase(it);
-            }
+            if (m_selectedElement == original) m_selectedElement = nullptr;
+            m_walls.EraseById(wallId);
+            m_journal.RecordRemoved(wallId, JournalElementKind::Wall);
 
             // ��������� �����
-            m_walls.push_back(std::move(w1));
-            m_walls.push_back(std::move(w2));
+            m_journal.RecordAdded(w1->GetId(), JournalElementKind::Wall);
+            m_journal.RecordAdded(w2->GetId(), JournalElementKind::Wall);
+            m_walls.Insert(std::move(w1));
+            m_walls.Insert(std::move(w2));
 
             RebuildAutoDimensions();
             return true;
@@ -215,25 +413,111 @@ namespace winrt::estimate1
         // ��������� ����� �� ID
         Wall* GetWall(uint64_t id)
         {
-            auto it = std::find_if(m_walls.begin(), m_walls.end(),
-                [id](const std::unique_ptr<Wall>& w) { return w->GetId() == id; });
-            
-            return (it != m_walls.end()) ? it->get() : nullptr;
+            return m_walls.FindById(id);
         }
 
         // ��������� ���� ����
-        const std::vector<std::unique_ptr<Wall>>& GetWalls() const { return m_walls; }
+        const std::vector<std::unique_ptr<Wall>>& GetWalls() const { return m_walls.Objects(); }
+
+        // Stable handles and dense geometry arrays (see WallStore.h)
+        WallHandle GetWallHandle(uint64_t id) const { return m_walls.FindHandle(id); }
+        Wall* GetWall(WallHandle handle) const { return m_walls.Get(handle); }
+        const WallHotData& GetWallHotData() const { return m_walls.Hot(); }
+        const WallStore& GetWallStore() const { return m_walls; }
+
+        // Welded vertex graph of the wall axes (see WallGraph.h) shared by
+        // room detection, joins and snapping. Rebuilt only after wall
+        // changes; direct Wall* edits count once SyncWallEdits() has run.
+        const WallGraph& GetWallGraph() const
+        {
+            uint64_t revision = m_journal.GetRevision();
+            if (m_wallGraphValid && m_wallGraphRevision == revision)
+                return m_wallGraph;
+
+            if (!m_wallGraphValid || !m_journal.GetChangesSince(m_wallGraphRevision, JournalElementKind::Wall).Empty())
+            {
+                m_wallGraph = WallGraph::Build(m_walls.Hot());
+                m_wallGraphValid = true;
+            }
+            m_wallGraphRevision = revision;
+            return m_wallGraph;
+        }
+
+        // Join candidate grid over the walls (see WallJoinIndex.h) for the
+        // index overloads of the join systems. Patched with the walls
+        // changed since the last call; rebuilt after a journal reset.
+        const WallJoinIndex& GetWallJoinIndex() const
+        {
+            uint64_t revision = m_journal.GetRevision();
+            if (m_joinIndexValid && m_joinIndexRevision == revision)
+                return m_joinIndex;
+
+            ChangeSet changes;
+            if (m_joinIndexValid)
+                changes = m_journal.GetChangesSince(m_joinIndexRevision, JournalElementKind::Wall);
+
+            if (!m_joinIndexValid || changes.IsFullReset)
+            {
+                m_joinIndex.Build(m_walls.Objects());
+                m_joinIndexValid = true;
+            }
+            else
+            {
+                for (uint64_t id : changes.Removed)
+                    m_joinIndex.Remove(id);
+                for (const auto* ids : { &changes.Added, &changes.Modified })
+                {
+                    for (uint64_t id : *ids)
+                    {
+                        if (const Wall* wall = m_walls.FindById(id))
+                            m_joinIndex.Update(*wall);
+                    }
+                }
+            }
+            m_joinIndexRevision = revision;
+            return m_joinIndex;
+        }
+
+        // Joins and mitred outlines of every wall (see WallJoinGraph.h).
+        // Only walls near an edit are re-detected. Snapshots share the
+        // graph; it is copied before patching while one still holds it.
+        const WallJoinGraph& GetWallJoinGraph() const
+        {
+            uint64_t revision = m_journal.GetRevision();
+            if (m_joinGraph && m_joinGraphRevision == revision)
+                return *m_joinGraph;
+
+            const WallJoinIndex& index = GetWallJoinIndex();
+            if (!m_joinGraph)
+            {
+                m_joinGraph = std::make_shared<WallJoinGraph>();
+                m_joinGraph->Rebuild(m_walls, index);
+            }
+            else
+            {
+                ChangeSet changes = m_journal.GetChangesSince(m_joinGraphRevision, JournalElementKind::Wall);
+                if (!changes.Empty())
+                {
+                    if (m_joinGraph.use_count() > 1)
+                        m_joinGraph = changes.IsFullReset ? std::make_shared<WallJoinGraph>()
+                                                          : std::make_shared<WallJoinGraph>(*m_joinGraph);
+                    m_joinGraph->Update(m_walls, index, changes);
+                }
+            }
+            m_joinGraphRevision = revision;
+            return *m_joinGraph;
+        }
 
         // ��������� (R5)
         const std::vector<std::shared_ptr<Room>>& GetRooms() const { return m_rooms; }
 
                 // ���������� ����
-                size_t GetWallCount() const { return m_walls.size(); }
+                size_t GetWallCount() const { return m_walls.Size(); }
 
                 // ������� ������
                 void Clear()
                 {
-                    m_walls.clear();
+                    m_walls.Clear();
                     m_dimensions.clear();
                     m_manualDimensions.clear();
                     m_dimensionChains.clear();
@@ -241,6 +525,9 @@ namespace winrt::estimate1
                     m_doors.clear();
                     m_windows.clear();
                     m_selectedElement = nullptr;
+                    CancelRoomWork();
+                    ResetLevels();
+                    m_journal.RecordReset();
                 }
 
                 // ������� (����)
@@ -252,11 +539,13 @@ namespace winrt::estimate1
                 // �������� ������ ������
                 Dimension* AddManualDimension(const WorldPoint& p1, const WorldPoint& p2, double offset = 200.0)
                 {
+                    IdAllocatorScope idScope(m_idAllocator);
                     auto dim = std::make_unique<Dimension>(p1, p2);
                     dim->SetOffset(offset);
                     dim->SetLocked(true);
                     Dimension* ptr = dim.get();
                     m_manualDimensions.push_back(std::move(dim));
+                    m_journal.RecordAdded(ptr->GetId(), JournalElementKind::Dimension);
                     return ptr;
                 }
 
@@ -271,6 +560,7 @@ namespace winrt::estimate1
                 if (m_selectedElement == it->get())
                     m_selectedElement = nullptr;
 
+                        m_journal.RecordRemoved(id, JournalElementKind::Dimension);
                         m_manualDimensions.erase(it);
                         return true;
                     }
@@ -282,6 +572,7 @@ namespace winrt::estimate1
 
                 DimensionChain* AddDimensionChain()
                 {
+                    IdAllocatorScope idScope(m_idAllocator);
                     auto chain = std::make_unique<DimensionChain>();
                     DimensionChain* ptr = chain.get();
                     m_dimensionChains.push_back(std::move(chain));
@@ -319,6 +610,8 @@ namespace winrt::estimate1
                     if (!m_autoDimensionsEnabled)
                         return;
 
+                    IdAllocatorScope idScope(m_idAllocator);
+
                     // ��������� ��������� ��������������� �������� (offset)
                     struct LockedState
                     {
@@ -526,15 +819,15 @@ namespace winrt::estimate1
                     }
 
                     // ��������� ����� � �������� ������� (������ ����)
-                    for (auto it = m_walls.rbegin(); it != m_walls.rend(); ++it)
+                    // Batched pass over the axes (GeometryKernels.h), topmost hit first
+                    SyncWallEdits();
+                    const WallHotData& hot = m_walls.Hot();
+                    std::vector<uint32_t> wallHits;
+                    GeometryKernels::CollectWithin(point, hot.Segments(), hot.Thickness.data(), tolerance, wallHits);
+                    for (auto it = wallHits.rbegin(); it != wallHits.rend(); ++it)
                     {
-                        Wall* wall = it->get();
-                
-                        // ��������� ��������� ����
-                        if (!layerManager.IsWorkStateVisible(wall->GetWorkState()))
-                            continue;
-
-                        if (wall->HitTest(point, tolerance))
+                        Wall* wall = m_walls.Objects()[*it].get();
+                        if (layerManager.IsWorkStateVisible(wall->GetWorkState()))
                             return wall;
                     }
 
@@ -641,7 +934,19 @@ namespace winrt::estimate1
                     if (wall && wall->GetType() && wall->GetType()->GetName() == name)
                     {
                         wall->ClearType();
+                        m_walls.RefreshById(wall->GetId());
+                        m_journal.RecordModified(wall->GetId(), JournalElementKind::Wall);
+                    }
+                }
+                // Parked levels share the type list
+                for (auto& part : m_levelData)
+                {
+                    for (auto& wall : part.Walls)
+                    {
+                        if (wall && wall->GetType() && wall->GetType()->GetName() == name)
+                            wall->ClearType();
                     }
+                    part.Walls.Sync();
                 }
                 m_wallTypes.erase(it);
                 return true;
@@ -710,6 +1015,7 @@ namespace winrt::estimate1
             if (!door) return nullptr;
             Door* ptr = door.get();
             m_doors.push_back(door);
+            m_journal.RecordAdded(door->GetId(), JournalElementKind::Door);
             
             // �������� ��� �������
             if (Wall* hostWall = GetWall(door->GetHostWallId()))
@@ -731,6 +1037,7 @@ namespace winrt::estimate1
                 if (m_selectedElement == it->get())
                     m_selectedElement = nullptr;
                 m_doors.erase(it);
+                m_journal.RecordRemoved(id, JournalElementKind::Door);
                 return true;
             }
             return false;
@@ -769,6 +1076,7 @@ namespace winrt::estimate1
             if (!window) return nullptr;
             Window* ptr = window.get();
             m_windows.push_back(window);
+            m_journal.RecordAdded(window->GetId(), JournalElementKind::Window);
             
             // �������� ��� �������
             if (Wall* hostWall = GetWall(window->GetHostWallId()))
@@ -790,6 +1098,7 @@ namespace winrt::estimate1
                 if (m_selectedElement == it->get())
                     m_selectedElement = nullptr;
                 m_windows.erase(it);
+                m_journal.RecordRemoved(id, JournalElementKind::Window);
                 return true;
             }
             return false;
@@ -873,12 +1182,20 @@ namespace winrt::estimate1
         {
             m_doors.erase(
                 std::remove_if(m_doors.begin(), m_doors.end(),
-                    [wallId](const std::shared_ptr<Door>& d) { return d && d->GetHostWallId() == wallId; }),
+                    [this, wallId](const std::shared_ptr<Door>& d) {
+                        if (!d || d->GetHostWallId() != wallId) return false;
+                        m_journal.RecordRemoved(d->GetId(), JournalElementKind::Door);
+                        return true;
+                    }),
                 m_doors.end()
             );
             m_windows.erase(
                 std::remove_if(m_windows.begin(), m_windows.end(),
-                    [wallId](const std::shared_ptr<Window>& w) { return w && w->GetHostWallId() == wallId; }),
+                    [this, wallId](const std::shared_ptr<Window>& w) {
+                        if (!w || w->GetHostWallId() != wallId) return false;
+                        m_journal.RecordRemoved(w->GetId(), JournalElementKind::Window);
+                        return true;
+                    }),
                 m_windows.end()
             );
         }
@@ -889,11 +1206,183 @@ namespace winrt::estimate1
 
         void RebuildRooms()
         {
-            m_rooms = RoomDetector::DetectRooms(m_walls);
-            // R5.5: ������������ ���� ����� ���������� ���������
-            RebuildZones();
+            IdAllocatorScope idScope(m_idAllocator);
+            // Walls edited directly (undo commands) are picked up here
+            SyncWallEdits();
+
+            // Only faces around walls changed since the last pass are re-traced;
+            // untouched rooms keep their ids, names and numbers
+            ChangeSet changes = m_journal.GetChangesSince(m_roomsRevision, JournalElementKind::Wall);
+            if (changes.Empty())
+            {
+                m_roomsRevision = m_journal.GetRevision();
+                return;
+            }
+
+            std::vector<uint64_t> changed;
+            changed.reserve(changes.Count());
+            changed.insert(changed.end(), changes.Added.begin(), changes.Added.end());
+            changed.insert(changed.end(), changes.Removed.begin(), changes.Removed.end());
+            changed.insert(changed.end(), changes.Modified.begin(), changes.Modified.end());
+
+            // Edits go to the worker; a reset (load, level switch) is applied
+            // at once so the new document never shows the old rooms
+            if (m_backgroundRooms && !changes.IsFullReset)
+            {
+                SubmitRoomJob(std::move(changed));
+                return;
+            }
+
+            m_roomsRevision = m_journal.GetRevision();
+            CancelRoomWork();
+
+            RoomUpdate update = RoomDetector::Recompute(GetWallGraph(), m_rooms, changed,
+                changes.IsFullReset, RoomDetector::BuildWallFaceTable(m_walls));
+            OnRoomsUpdated(update, changes.IsFullReset);
+        }
+
+        // =====================================================================
+        // Background rooms (see RoomWorker.h). Off by default: RebuildRooms
+        // then runs synchronously, which is what tests and batch jobs want.
+        // =====================================================================
+
+        void EnableBackgroundRooms(bool enabled)
+        {
+            if (!enabled)
+                FinishRoomWork();
+            m_backgroundRooms = enabled;
+        }
+
+        bool IsBackgroundRoomsEnabled() const { return m_backgroundRooms; }
+
+        // Called on the worker thread when a result is ready; the handler
+        // should post ApplyCompletedRooms to the UI thread
+        void SetRoomsCompletedHandler(RoomWorker::CompletionHandler handler)
+        {
+            m_roomWorker.SetOnCompleted(std::move(handler));
+        }
+
+        bool IsRoomWorkPending() const
+        {
+            return m_roomWorker.IsBusy() || m_roomsSubmittedRevision > m_roomsRevision;
+        }
+
+        // Take the newest finished result and merge it into m_rooms. Rooms
+        // that survive keep their objects (and so selection, names and
+        // user edits); only their geometry is replaced. Returns true if
+        // the rooms changed.
+        bool ApplyCompletedRooms()
+        {
+            std::optional<RoomJobResult> result = m_roomWorker.TakeResult();
+            if (!result || result->Revision <= m_roomsRevision)
+                return false;
+
+            std::unordered_map<uint64_t, std::shared_ptr<Room>> live;
+            live.reserve(m_rooms.size());
+            for (const auto& room : m_rooms)
+                live[room->GetId()] = room;
+
+            std::unordered_set<uint64_t> modifiedIds;
+            for (const auto& room : result->Update.Modified)
+                modifiedIds.insert(room->GetId());
+
+            RoomUpdate update;
+            update.Removed = result->Update.Removed;
+
+            std::vector<std::shared_ptr<Room>> rooms;
+            rooms.reserve(result->Rooms.size());
+            for (const auto& room : result->Rooms)
+            {
+                auto it = live.find(room->GetId());
+                if (it == live.end())
+                {
+                    rooms.push_back(room);
+                    update.Added.push_back(room);
+                    continue;
+                }
+
+                const auto& target = it->second;
+                if (modifiedIds.count(room->GetId()))
+                {
+                    target->SetContour(room->GetContour());
+                    target->SetBoundaries(room->GetBoundaries());
+                    if (room->HasNetContour())
+                        target->SetNetContour(room->GetNetContour());
+                    update.Modified.push_back(target);
+                }
+                rooms.push_back(target);
+            }
+
+            m_rooms = std::move(rooms);
+            m_roomsRevision = result->Revision;
+            OnRoomsUpdated(update, false);
+            return true;
+        }
+
+        // Wait for the worker and apply its result (save, export, snapshots)
+        void FinishRoomWork()
+        {
+            if (m_roomsSubmittedRevision <= m_roomsRevision)
+                return;
+            m_roomWorker.WaitIdle();
+            ApplyCompletedRooms();
+        }
+
+    private:
+        // Queued and running jobs are dropped; their results are never applied
+        void CancelRoomWork()
+        {
+            m_roomWorker.Cancel();
+            m_roomsSubmittedRevision = m_roomsRevision;
+        }
+
+        void SubmitRoomJob(std::vector<uint64_t> changed)
+        {
+            uint64_t revision = m_journal.GetRevision();
+            if (revision == m_roomsSubmittedRevision)
+                return;     // already queued or running
+
+            // The worker gets a walls-only snapshot and builds the graph and
+            // face table itself; only walls and rooms edited since the last
+            // job are copied here. The live rooms stay on screen meanwhile.
+            // Changes are taken from the applied state, so a job that replaces
+            // an unfinished one still covers its edits.
+            SnapshotCache::Sources src;
+            src.Revision = revision;
+            src.Walls = &m_walls;
+
+            RoomJob job;
+            job.Revision = revision;
+            job.Walls = m_snapshotCache.Build(src);
+            job.Rooms.reserve(m_rooms.size());
+            for (const auto& room : m_rooms)
+            {
+                auto copy = m_roomJobCopies.Get(*room, room->GetRevision());
+                copy->GetNetAreaSqM();    // fill the lazy net quantities before sharing
+                job.Rooms.push_back(std::move(copy));
+            }
+            m_roomJobCopies.EndSnapshot();
+            job.ChangedWalls = std::move(changed);
+            job.Ids = &m_idAllocator;
+
+            m_roomsSubmittedRevision = revision;
+            m_roomWorker.Submit(std::move(job));
         }
 
+        void OnRoomsUpdated(const RoomUpdate& update, bool fullReset)
+        {
+            // A removed room may have been selected
+            if (m_selectedElement && !IsElementAlive(m_selectedElement))
+                m_selectedElement = nullptr;
+
+            // R5.5: zones follow the rooms
+            if (fullReset)
+                RebuildZones();
+            else
+                m_zoneManager.ApplyRoomChanges(update.Added, update.Removed, update.Modified);
+        }
+
+    public:
         // =====================================================================
         // R5.5: ����
         // =====================================================================
@@ -922,37 +1411,116 @@ namespace winrt::estimate1
 
         void AddColumn(std::shared_ptr<Column> column)
         {
-            if (column) m_columns.push_back(column);
+            if (!column) return;
+            m_columns.push_back(column);
+            m_journal.RecordAdded(column->GetId(), JournalElementKind::Column);
         }
 
         const std::vector<std::shared_ptr<Column>>& GetColumns() const { return m_columns; }
         
         void AddSlab(std::shared_ptr<Slab> slab)
         {
-            if (slab) m_slabs.push_back(slab);
+            if (!slab) return;
+            m_slabs.push_back(slab);
+            m_journal.RecordAdded(slab->GetId(), JournalElementKind::Slab);
         }
 
         const std::vector<std::shared_ptr<Slab>>& GetSlabs() const { return m_slabs; }
 
         void AddBeam(std::shared_ptr<Beam> beam)
         {
-            if (beam) m_beams.push_back(beam);
+            if (!beam) return;
+            m_beams.push_back(beam);
+            m_journal.RecordAdded(beam->GetId(), JournalElementKind::Beam);
         }
 
         const std::vector<std::shared_ptr<Beam>>& GetBeams() const { return m_beams; }
 
         void RemoveStructuralElements()
         {
+            for (const auto& c : m_columns) m_journal.RecordRemoved(c->GetId(), JournalElementKind::Column);
+            for (const auto& s : m_slabs) m_journal.RecordRemoved(s->GetId(), JournalElementKind::Slab);
+            for (const auto& b : m_beams) m_journal.RecordRemoved(b->GetId(), JournalElementKind::Beam);
             m_columns.clear();
             m_slabs.clear();
             m_beams.clear();
         }
 
             private:
-                std::vector<std::unique_ptr<Wall>> m_walls;
+                size_t FindLevelIndex(uint64_t levelId) const
+                {
+                    for (size_t i = 0; i < m_levels.size(); ++i)
+                        if (m_levels[i].GetId() == levelId) return i;
+                    return m_levels.size();
+                }
+
+                // Swap the active members with a partition
+                void SwapPartition(LevelPartition& part)
+                {
+                    std::swap(m_walls, part.Walls);
+                    std::swap(m_dimensions, part.Dimensions);
+                    std::swap(m_manualDimensions, part.ManualDimensions);
+                    std::swap(m_dimensionChains, part.DimensionChains);
+                    std::swap(m_rooms, part.Rooms);
+                    std::swap(m_zoneManager, part.Zones);
+                    std::swap(m_doors, part.Doors);
+                    std::swap(m_windows, part.Windows);
+                    std::swap(m_columns, part.Columns);
+                    std::swap(m_slabs, part.Slabs);
+                    std::swap(m_beams, part.Beams);
+                    std::swap(m_loadedAutoDimensionStates, part.LoadedAutoDimensionStates);
+                    std::swap(m_snapshotCache, part.Snapshots);
+                    part.JoinGraph.reset();
+                }
+
+                // The active level's slot in m_levelData is always empty
+                void ActivateLevelIndex(size_t index)
+                {
+                    if (index == m_activeLevel)
+                        return;
+                    SwapPartition(m_levelData[m_activeLevel]);
+                    m_activeLevel = index;
+                    SwapPartition(m_levelData[m_activeLevel]);
+                    m_selectedElement = nullptr;
+
+                    // Derived from the walls that were active until now
+                    m_wallGraphValid = false;
+                    m_joinIndexValid = false;
+                    m_joinGraph.reset();
+                }
+
+                // Drop parked levels and start over with one level
+                void ResetLevels()
+                {
+                    IdAllocatorScope idScope(m_idAllocator);
+                    m_levels.clear();
+                    m_levelData.clear();
+                    m_levels.emplace_back(L"Level 1", 0.0, 3000.0);
+                    m_levelData.emplace_back();
+                    m_activeLevel = 0;
+                }
+
+                IdAllocator m_idAllocator;
+                WallStore m_walls;
+                ChangeJournal m_journal;
+                SnapshotCache m_snapshotCache;
+                mutable WallGraph m_wallGraph;
+                mutable uint64_t m_wallGraphRevision{ 0 };
+                mutable bool m_wallGraphValid{ false };
+                mutable WallJoinIndex m_joinIndex;
+                mutable uint64_t m_joinIndexRevision{ 0 };
+                mutable bool m_joinIndexValid{ false };
+                mutable std::shared_ptr<WallJoinGraph> m_joinGraph;
+                mutable uint64_t m_joinGraphRevision{ 0 };
+
+                // Levels; m_levelData[i] holds level i unless it is active
+                std::vector<Level> m_levels;
+                std::vector<LevelPartition> m_levelData;
+                size_t m_activeLevel{ 0 };
                 std::vector<std::unique_ptr<Dimension>> m_dimensions;         // �����������
                 std::vector<std::unique_ptr<Dimension>> m_manualDimensions;   // ������ �������
                 std::vector<std::unique_ptr<DimensionChain>> m_dimensionChains;
+                uint64_t m_roomsRevision{ 0 };                                // journal revision m_rooms reflects
                 std::vector<std::shared_ptr<Room>> m_rooms;                   // R5: ���������
                 ZoneManager m_zoneManager;                                    // R5.5: ����
                 Element* m_selectedElement{ nullptr };
@@ -976,6 +1544,12 @@ namespace winrt::estimate1
                 // ����������� ��������� ������������ �� ����� (offset �� �����)
                 std::unordered_map<uint64_t, double> m_loadedAutoDimensionStates;
 
+                // Background room detection; declared last so the worker
+                // thread stops before the members it reads are destroyed
+                bool m_backgroundRooms{ false };
+                uint64_t m_roomsSubmittedRevision{ 0 };
+                SharedCopyCache<Room> m_roomJobCopies;
+                RoomWorker m_roomWorker;
             };
         }
 
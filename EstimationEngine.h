@@ -9,6 +9,7 @@
 #include <string>
 #include <algorithm>
 #include <cmath>
+#include <future>
 
 namespace winrt::estimate1
 {
@@ -107,6 +108,13 @@ namespace winrt::estimate1
         std::wstring Author;
     };
 
+    // Per-level estimates of a multi-storey project and their sum
+    struct MultiLevelEstimate
+    {
+        std::vector<EstimationResult> Levels;     // same order as the snapshots
+        EstimationResult Total;
+    };
+
     // ============================================================================
     // Estimation Settings   
     // ============================================================================
@@ -150,8 +158,10 @@ namespace winrt::estimate1
         EstimationEngine() = default;
 
         //   
+        // Document is DocumentModel, or DocumentSnapshot on a worker thread
+        template <typename Document>
         EstimationResult Calculate(
-            const DocumentModel& document,
+            const Document& document,
             const EstimationSettings& settings = {})
         {
             EstimationResult result;
@@ -175,8 +185,59 @@ namespace winrt::estimate1
             return result;
         }
 
+        // Estimate each level on its own thread, then add up the wall and
+        // zone summaries into a project total. Snapshots come from
+        // DocumentModel::CreateAllLevelSnapshots().
+        MultiLevelEstimate CalculateLevels(
+            const std::vector<std::shared_ptr<const DocumentSnapshot>>& levels,
+            const EstimationSettings& settings = {})
+        {
+            MultiLevelEstimate estimate;
+
+            std::vector<std::future<EstimationResult>> pending;
+            pending.reserve(levels.size());
+            for (const auto& level : levels)
+            {
+                pending.push_back(std::async(std::launch::async, [level, settings]() {
+                    EstimationEngine engine;
+                    return level ? engine.Calculate(*level, settings) : EstimationResult{};
+                }));
+            }
+            for (auto& f : pending)
+                estimate.Levels.push_back(f.get());
+
+            EstimationResult& total = estimate.Total;
+            total.CalculationDate = GetCurrentDateString();
+            for (const auto& level : estimate.Levels)
+            {
+                Accumulate(total.ExistingWalls, level.ExistingWalls);
+                Accumulate(total.DemolitionWalls, level.DemolitionWalls);
+                Accumulate(total.NewWalls, level.NewWalls);
+                total.ZoneSummaries.insert(total.ZoneSummaries.end(),
+                    level.ZoneSummaries.begin(), level.ZoneSummaries.end());
+            }
+
+            if (!levels.empty() && levels.front())
+                GenerateEstimateItems(*levels.front(), total, settings);
+            CalculateTotals(total, settings);
+
+            return estimate;
+        }
+
+        // Whole-project estimate from CreateAllLevelSnapshots(): a single
+        // level is estimated directly, several through CalculateLevels
+        EstimationResult CalculateProject(
+            const std::vector<std::shared_ptr<const DocumentSnapshot>>& levels,
+            const EstimationSettings& settings = {})
+        {
+            if (levels.size() == 1 && levels.front())
+                return Calculate(*levels.front(), settings);
+            return CalculateLevels(levels, settings).Total;
+        }
+
         // R5.5:    
-        std::vector<ZoneQuantitySummary> GetZoneSummaries(const DocumentModel& document)
+        template <typename Document>
+        std::vector<ZoneQuantitySummary> GetZoneSummaries(const Document& document)
         {
             std::vector<ZoneQuantitySummary> summaries;
             
@@ -206,8 +267,9 @@ namespace winrt::estimate1
         }
 
         //    
+        template <typename Document>
         WallQuantitySummary GetWallSummary(
-            const DocumentModel& document,
+            const Document& document,
             WorkStateNative workState)
         {
             WallQuantitySummary summary;
@@ -252,9 +314,22 @@ namespace winrt::estimate1
         }
 
     private:
+        static void Accumulate(WallQuantitySummary& into, const WallQuantitySummary& from)
+        {
+            into.TotalLength += from.TotalLength;
+            into.TotalArea += from.TotalArea;
+            into.TotalVolume += from.TotalVolume;
+            into.WallCount += from.WallCount;
+            for (const auto& [k, v] : from.LengthByType) into.LengthByType[k] += v;
+            for (const auto& [k, v] : from.AreaByType) into.AreaByType[k] += v;
+            for (const auto& [k, v] : from.AreaByMaterial) into.AreaByMaterial[k] += v;
+            for (const auto& [k, v] : from.VolumeByMaterial) into.VolumeByMaterial[k] += v;
+        }
+
         //   
+        template <typename Document>
         void CalculateWallQuantities(
-            const DocumentModel& document,
+            const Document& document,
             EstimationResult& result,
             const EstimationSettings& settings)
         {
@@ -264,8 +339,9 @@ namespace winrt::estimate1
         }
 
         //   
+        template <typename Document>
         void GenerateEstimateItems(
-            const DocumentModel& document,
+            const Document& document,
             EstimationResult& result,
             const EstimationSettings& settings)
         {
@@ -458,8 +534,9 @@ namespace winrt::estimate1
         }
 
         // R5.5:    
+        template <typename Document>
         void CalculateZoneQuantities(
-            const DocumentModel& document,
+            const Document& document,
             EstimationResult& result,
             [[maybe_unused]] const EstimationSettings& settings)
         {
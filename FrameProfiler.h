@@ -0,0 +1,432 @@
+#pragma once
+
+#include "pch.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace winrt::estimate1
+{
+    // =================================================================
+    // FRAME PROFILER - frame times and named scopes per frame
+    // =================================================================
+    // BeginFrame/EndFrame bracket a canvas frame; ProfileScope times a
+    // named block inside it (a renderer call) or between frames (a snap
+    // query in a pointer handler, which counts towards the next frame).
+    // Each EndFrame keeps the frame time in a rolling window of
+    // HistoryFrames and folds the time of every scope into its
+    // per-frame statistics.
+    //
+    // Every frame and scope is also kept as a trace event in a ring of
+    // MaxEvents, exported as Chrome trace-event JSON (chrome://tracing,
+    // Perfetto). Nothing here touches Win2D, so the benchmark runner
+    // records into the same profiler headless.
+    //
+    // Disabled (the default), a scope costs one branch. Shared() is the
+    // instance the window and benchmarks use, from the UI thread only.
+    // =================================================================
+
+    class FrameProfiler
+    {
+    public:
+        static constexpr size_t HistoryFrames = 240;
+        static constexpr size_t MaxEvents = 65536;
+        static constexpr size_t HistogramBuckets = 8;
+
+        // Upper bounds (ms) of the frame-time histogram buckets
+        static constexpr std::array<double, HistogramBuckets> BucketLimitsMs{
+            2.0, 4.0, 8.0, 16.7, 33.3, 50.0, 100.0, std::numeric_limits<double>::infinity() };
+
+        struct ScopeStats
+        {
+            std::wstring Name;
+            double LastMs{ 0.0 };               // total in the last frame
+            double AverageMs{ 0.0 };            // smoothed over frames
+            double MaxMs{ 0.0 };                // largest frame total since Clear
+            uint32_t LastCalls{ 0 };            // times entered in the last frame
+        };
+
+        struct FrameStats
+        {
+            size_t Frames{ 0 };                 // in the window
+            double LastMs{ 0.0 };
+            double AverageMs{ 0.0 };
+            double P50Ms{ 0.0 };
+            double P95Ms{ 0.0 };
+            double MaxMs{ 0.0 };
+            std::array<size_t, HistogramBuckets> Histogram{};
+        };
+
+        FrameProfiler()
+            : m_epoch(std::chrono::steady_clock::now())
+        {
+            Intern(L"Frame");
+        }
+
+        static FrameProfiler& Shared()
+        {
+            static FrameProfiler profiler;
+            return profiler;
+        }
+
+        void SetEnabled(bool enabled) { m_enabled = enabled; }
+        bool IsEnabled() const { return m_enabled; }
+
+        // ------------------------------------------------------------
+        // Recording
+        // ------------------------------------------------------------
+
+        void BeginFrame()
+        {
+            if (!m_enabled)
+                return;
+            m_frameStart = NowNs();
+            m_inFrame = true;
+        }
+
+        void EndFrame()
+        {
+            if (!m_inFrame)
+                return;
+            m_inFrame = false;
+
+            uint64_t end = NowNs();
+            Record(FrameName, m_frameStart, end - m_frameStart);
+
+            double frameMs = ToMs(end - m_frameStart);
+            if (m_history.size() < HistoryFrames)
+                m_history.push_back(frameMs);
+            else
+                m_history[m_frames % HistoryFrames] = frameMs;
+            m_lastFrameMs = frameMs;
+            ++m_frames;
+
+            for (ScopeEntry& scope : m_scopes)
+            {
+                double ms = ToMs(scope.CurrentNs);
+                scope.Stats.LastMs = ms;
+                scope.Stats.LastCalls = scope.CurrentCalls;
+                scope.Stats.AverageMs = scope.Sampled ? scope.Stats.AverageMs + (ms - scope.Stats.AverageMs) * Smoothing : ms;
+                scope.Stats.MaxMs = (std::max)(scope.Stats.MaxMs, ms);
+                scope.Sampled = true;
+                scope.CurrentNs = 0;
+                scope.CurrentCalls = 0;
+            }
+        }
+
+        void BeginScope(const wchar_t* name)
+        {
+            m_open.push_back({ Intern(name), NowNs() });
+        }
+
+        void EndScope()
+        {
+            if (m_open.empty())
+                return;
+            OpenScope open = m_open.back();
+            m_open.pop_back();
+
+            uint64_t duration = NowNs() - open.StartNs;
+            Record(open.Name, open.StartNs, duration);
+            ScopeEntry& scope = m_scopes[open.Name];
+            scope.CurrentNs += duration;
+            ++scope.CurrentCalls;
+        }
+
+        // Forgets frames, scopes and events; the enabled state is kept
+        void Clear()
+        {
+            m_history.clear();
+            m_events.clear();
+            m_open.clear();
+            m_eventCount = 0;
+            m_frames = 0;
+            m_lastFrameMs = 0.0;
+            m_inFrame = false;
+            for (ScopeEntry& scope : m_scopes)
+            {
+                scope.Stats = ScopeStats{ scope.Stats.Name };
+                scope.CurrentNs = 0;
+                scope.CurrentCalls = 0;
+                scope.Sampled = false;
+            }
+        }
+
+        // ------------------------------------------------------------
+        // Statistics
+        // ------------------------------------------------------------
+
+        FrameStats GetFrameStats() const
+        {
+            FrameStats stats;
+            stats.Frames = m_history.size();
+            if (m_history.empty())
+                return stats;
+
+            std::vector<double> sorted(m_history);
+            std::sort(sorted.begin(), sorted.end());
+            double sum = 0.0;
+            for (double ms : sorted)
+            {
+                sum += ms;
+                size_t bucket = 0;
+                while (ms > BucketLimitsMs[bucket])
+                    ++bucket;
+                ++stats.Histogram[bucket];
+            }
+
+            stats.LastMs = m_lastFrameMs;
+            stats.AverageMs = sum / static_cast<double>(sorted.size());
+            stats.P50Ms = sorted[(sorted.size() - 1) / 2];
+            stats.P95Ms = sorted[(sorted.size() - 1) * 95 / 100];
+            stats.MaxMs = sorted.back();
+            return stats;
+        }
+
+        // Scopes seen since Clear, the most expensive in the last frame first
+        std::vector<ScopeStats> GetScopeStats() const
+        {
+            std::vector<ScopeStats> result;
+            for (size_t i = FrameName + 1; i < m_scopes.size(); ++i)
+            {
+                if (m_scopes[i].Sampled)
+                    result.push_back(m_scopes[i].Stats);
+            }
+            std::stable_sort(result.begin(), result.end(),
+                [](const ScopeStats& a, const ScopeStats& b) { return a.LastMs > b.LastMs; });
+            return result;
+        }
+
+        size_t GetFrameCount() const { return m_frames; }
+        size_t GetEventCount() const { return m_events.size(); }
+
+        // ------------------------------------------------------------
+        // Chrome trace export
+        // ------------------------------------------------------------
+
+        // The kept events as complete ("X") trace events, oldest first;
+        // times are microseconds since the profiler was created
+        std::string ExportChromeTrace() const
+        {
+            std::string json;
+            json.reserve(64 + m_events.size() * 96);
+            json += "{\"traceEvents\":[";
+
+            size_t first = m_events.size() < MaxEvents ? 0 : m_eventCount % MaxEvents;
+            char number[64];
+            for (size_t i = 0; i < m_events.size(); ++i)
+            {
+                const Event& event = m_events[(first + i) % m_events.size()];
+                json += i == 0 ? "\n" : ",\n";
+                json += "{\"name\":";
+                AppendJsonString(json, m_scopes[event.Name].Stats.Name);
+                json += event.Name == FrameName ? ",\"cat\":\"frame\"" : ",\"cat\":\"scope\"";
+                std::snprintf(number, sizeof(number), ",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f",
+                    static_cast<double>(event.StartNs) / 1000.0, static_cast<double>(event.DurationNs) / 1000.0);
+                json += number;
+                json += ",\"pid\":1,\"tid\":1}";
+            }
+
+            json += "\n],\"displayTimeUnit\":\"ms\"}\n";
+            return json;
+        }
+
+        bool SaveChromeTrace(const std::wstring& filePath) const
+        {
+            std::ofstream file(std::filesystem::path(filePath), std::ios::binary);
+            if (!file)
+                return false;
+            std::string json = ExportChromeTrace();
+            file.write(json.data(), static_cast<std::streamsize>(json.size()));
+            return static_cast<bool>(file);
+        }
+
+        // Appends a string as a quoted JSON string in UTF-8
+        static void AppendJsonString(std::string& out, const std::wstring& text)
+        {
+            out += '"';
+            for (size_t i = 0; i < text.size(); ++i)
+            {
+                uint32_t c = static_cast<uint32_t>(text[i]);
+                if (c >= 0xD800 && c < 0xDC00 && i + 1 < text.size())
+                {
+                    uint32_t low = static_cast<uint32_t>(text[i + 1]);
+                    if (low >= 0xDC00 && low < 0xE000)
+                    {
+                        c = 0x10000 + ((c - 0xD800) << 10) + (low - 0xDC00);
+                        ++i;
+                    }
+                }
+
+                if (c == '"' || c == '\\')
+                {
+                    out += '\\';
+                    out += static_cast<char>(c);
+                }
+                else if (c < 0x20)
+                {
+                    char escaped[8];
+                    std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                    out += escaped;
+                }
+                else if (c < 0x80)
+                {
+                    out += static_cast<char>(c);
+                }
+                else if (c < 0x800)
+                {
+                    out += static_cast<char>(0xC0 | (c >> 6));
+                    out += static_cast<char>(0x80 | (c & 0x3F));
+                }
+                else if (c < 0x10000)
+                {
+                    out += static_cast<char>(0xE0 | (c >> 12));
+                    out += static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+                    out += static_cast<char>(0x80 | (c & 0x3F));
+                }
+                else
+                {
+                    out += static_cast<char>(0xF0 | (c >> 18));
+                    out += static_cast<char>(0x80 | ((c >> 12) & 0x3F));
+                    out += static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+                    out += static_cast<char>(0x80 | (c & 0x3F));
+                }
+            }
+            out += '"';
+        }
+
+    private:
+        static constexpr uint32_t FrameName = 0;
+        static constexpr double Smoothing = 0.1;        // weight of the newest frame in AverageMs
+
+        struct Event
+        {
+            uint32_t Name{ 0 };
+            uint64_t StartNs{ 0 };
+            uint64_t DurationNs{ 0 };
+        };
+
+        struct OpenScope
+        {
+            uint32_t Name{ 0 };
+            uint64_t StartNs{ 0 };
+        };
+
+        struct ScopeEntry
+        {
+            ScopeStats Stats;
+            uint64_t CurrentNs{ 0 };            // this frame so far
+            uint32_t CurrentCalls{ 0 };
+            bool Sampled{ false };              // has been through an EndFrame
+        };
+
+        uint64_t NowNs() const
+        {
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - m_epoch).count());
+        }
+
+        static double ToMs(uint64_t ns) { return static_cast<double>(ns) / 1.0e6; }
+
+        // Id of a scope name. Names are usually literals, so the pointer
+        // is looked up first and confirmed against the kept name.
+        uint32_t Intern(const wchar_t* name)
+        {
+            auto known = m_pointers.find(name);
+            if (known != m_pointers.end() && m_scopes[known->second].Stats.Name.compare(name) == 0)
+                return known->second;
+
+            m_probe.assign(name);
+            auto it = m_names.find(m_probe);
+            if (it != m_names.end())
+            {
+                m_pointers[name] = it->second;
+                return it->second;
+            }
+
+            uint32_t id = static_cast<uint32_t>(m_scopes.size());
+            m_names.emplace(m_probe, id);
+            m_pointers[name] = id;
+            m_scopes.push_back({});
+            m_scopes.back().Stats.Name = m_probe;
+            return id;
+        }
+
+        void Record(uint32_t name, uint64_t start, uint64_t duration)
+        {
+            Event event{ name, start, duration };
+            if (m_events.size() < MaxEvents)
+                m_events.push_back(event);
+            else
+                m_events[m_eventCount % MaxEvents] = event;
+            ++m_eventCount;
+        }
+
+        bool m_enabled{ false };
+        bool m_inFrame{ false };
+        std::chrono::steady_clock::time_point m_epoch;
+        uint64_t m_frameStart{ 0 };
+
+        std::unordered_map<std::wstring, uint32_t> m_names;
+        std::unordered_map<const wchar_t*, uint32_t> m_pointers;
+        std::vector<ScopeEntry> m_scopes;           // by name id; 0 is the frame
+        std::wstring m_probe;                       // lookup key, reused so a known name does not allocate
+        std::vector<OpenScope> m_open;
+
+        std::vector<Event> m_events;                // ring of MaxEvents
+        size_t m_eventCount{ 0 };
+        std::vector<double> m_history;              // frame times (ms), ring of HistoryFrames
+        size_t m_frames{ 0 };
+        double m_lastFrameMs{ 0.0 };
+    };
+
+    // Times the enclosing block into a profiler, if it is enabled
+    class ProfileScope
+    {
+    public:
+        explicit ProfileScope(const wchar_t* name, FrameProfiler& profiler = FrameProfiler::Shared())
+            : m_profiler(profiler.IsEnabled() ? &profiler : nullptr)
+        {
+            if (m_profiler)
+                m_profiler->BeginScope(name);
+        }
+
+        ~ProfileScope()
+        {
+            if (m_profiler)
+                m_profiler->EndScope();
+        }
+
+        ProfileScope(const ProfileScope&) = delete;
+        ProfileScope& operator=(const ProfileScope&) = delete;
+
+    private:
+        FrameProfiler* m_profiler;
+    };
+
+    // Brackets the enclosing block as a frame of a profiler
+    class ProfileFrame
+    {
+    public:
+        explicit ProfileFrame(FrameProfiler& profiler = FrameProfiler::Shared())
+            : m_profiler(profiler)
+        {
+            m_profiler.BeginFrame();
+        }
+
+        ~ProfileFrame() { m_profiler.EndFrame(); }
+
+        ProfileFrame(const ProfileFrame&) = delete;
+        ProfileFrame& operator=(const ProfileFrame&) = delete;
+
+    private:
+        FrameProfiler& m_profiler;
+    };
+}
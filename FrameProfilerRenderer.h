@@ -0,0 +1,108 @@
+#pragma once
+
+#include "pch.h"
+#include "FrameProfiler.h"
+#include "TextLayoutCache.h"
+#include <algorithm>
+#include <cstdio>
+#include <winrt/Microsoft.Graphics.Canvas.h>
+#include <winrt/Microsoft.Graphics.Canvas.Text.h>
+
+namespace winrt::estimate1
+{
+    // =================================================================
+    // FRAME PROFILER RENDERER - on-canvas overlay of FrameProfiler
+    // =================================================================
+    // A panel with the frame time of the rolling window (last, average,
+    // median, 95th percentile, max), the frame-time histogram as bars
+    // and the most expensive scopes of the last frame. Its numbers
+    // change every frame, so lines are drawn with a cached format
+    // rather than kept as layouts.
+    // =================================================================
+
+    class FrameProfilerRenderer
+    {
+    public:
+        static constexpr size_t MaxScopes = 12;
+
+        static void Draw(
+            const Microsoft::Graphics::Canvas::CanvasDrawingSession& session,
+            const FrameProfiler& profiler,
+            float x, float y)
+        {
+            FrameProfiler::FrameStats frame = profiler.GetFrameStats();
+            std::vector<FrameProfiler::ScopeStats> scopes = profiler.GetScopeStats();
+            size_t scopeLines = (std::min)(scopes.size(), MaxScopes);
+
+            float height = Padding * 2 + LinePx * (2 + scopeLines) + HistogramPx + LinePx;
+            session.FillRoundedRectangle(
+                Windows::Foundation::Rect(x, y, PanelWidth, height),
+                4.0f, 4.0f,
+                Windows::UI::ColorHelper::FromArgb(200, 20, 22, 26));
+
+            auto format = TextLayoutCache::Shared().GetFormat(DisplayFont::Mono, FontPx);
+            Windows::UI::Color textColor = Windows::UI::ColorHelper::FromArgb(255, 220, 220, 220);
+            Windows::UI::Color dimColor = Windows::UI::ColorHelper::FromArgb(255, 150, 150, 150);
+            float left = x + Padding;
+            float line = y + Padding;
+
+            wchar_t text[128];
+            swprintf_s(text, L"Frame %6.2f ms  avg %.2f  p50 %.2f  p95 %.2f  max %.2f",
+                frame.LastMs, frame.AverageMs, frame.P50Ms, frame.P95Ms, frame.MaxMs);
+            session.DrawText(text, left, line, FrameColor(frame.P95Ms), format);
+            line += LinePx;
+
+            // Histogram of the window, one bar per bucket
+            size_t tallest = 1;
+            for (size_t count : frame.Histogram)
+                tallest = (std::max)(tallest, count);
+            float barWidth = (PanelWidth - Padding * 2) / FrameProfiler::HistogramBuckets;
+            for (size_t i = 0; i < FrameProfiler::HistogramBuckets; ++i)
+            {
+                float barHeight = HistogramPx * static_cast<float>(frame.Histogram[i]) / static_cast<float>(tallest);
+                double limit = i + 1 < FrameProfiler::HistogramBuckets
+                    ? FrameProfiler::BucketLimitsMs[i] : FrameProfiler::BucketLimitsMs[i - 1] * 2;
+                session.FillRectangle(
+                    Windows::Foundation::Rect(left + barWidth * i + 1.0f, line + HistogramPx - barHeight, barWidth - 2.0f, barHeight),
+                    FrameColor(limit));
+
+                if (i + 1 < FrameProfiler::HistogramBuckets)
+                    swprintf_s(text, L"<%.0f", FrameProfiler::BucketLimitsMs[i]);
+                else
+                    swprintf_s(text, L">%.0f", FrameProfiler::BucketLimitsMs[i - 1]);
+                session.DrawText(text, left + barWidth * i + 2.0f, line + HistogramPx, dimColor, format);
+            }
+            line += HistogramPx + LinePx;
+
+            swprintf_s(text, L"%-18s %8s %8s %8s %5s", L"Scope", L"last", L"avg", L"max", L"calls");
+            session.DrawText(text, left, line, dimColor, format);
+            line += LinePx;
+
+            for (size_t i = 0; i < scopeLines; ++i)
+            {
+                const FrameProfiler::ScopeStats& scope = scopes[i];
+                swprintf_s(text, L"%-18.18s %8.3f %8.3f %8.3f %5u",
+                    scope.Name.c_str(), scope.LastMs, scope.AverageMs, scope.MaxMs, scope.LastCalls);
+                session.DrawText(text, left, line, textColor, format);
+                line += LinePx;
+            }
+        }
+
+    private:
+        // Green within a 60 Hz frame, amber within 30 Hz, red beyond
+        static Windows::UI::Color FrameColor(double ms)
+        {
+            if (ms <= 16.7)
+                return Windows::UI::ColorHelper::FromArgb(255, 110, 200, 120);
+            if (ms <= 33.3)
+                return Windows::UI::ColorHelper::FromArgb(255, 230, 180, 80);
+            return Windows::UI::ColorHelper::FromArgb(255, 230, 90, 80);
+        }
+
+        static constexpr float FontPx = 11.0f;
+        static constexpr float LinePx = 15.0f;
+        static constexpr float Padding = 8.0f;
+        static constexpr float PanelWidth = 420.0f;
+        static constexpr float HistogramPx = 40.0f;
+    };
+}
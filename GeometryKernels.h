@@ -0,0 +1,298 @@
+#pragma once
+
+#include "Camera.h"
+#include <vector>
+#include <algorithm>
+#include <limits>
+#include <cstdint>
+#include <cmath>
+
+// SSE2 is part of every x64 target and of the MSVC Win32 default. AVX is
+// picked at run time on x64, so the build needs no /arch switch. ARM64
+// uses the scalar loop.
+#if defined(_M_X64) || defined(__x86_64__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define GEOMETRY_KERNELS_SSE2 1
+#include <immintrin.h>
+#endif
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define GEOMETRY_KERNELS_AVX 1
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define GEOMETRY_KERNELS_AVX_TARGET
+#else
+#define GEOMETRY_KERNELS_AVX_TARGET __attribute__((target("avx")))
+#endif
+#endif
+
+namespace winrt::estimate1
+{
+    // =================================================================
+    // GEOMETRY KERNELS - point/segment primitives, scalar and batched
+    // =================================================================
+    // One home for the segment helpers the join systems, walls and
+    // structure elements used to carry their own copies of.
+    //
+    // The batched kernels test one query point against segments packed
+    // as separate X/Y arrays (WallHotData::Segments()), two or four at a
+    // time with SSE2 or AVX. Hit testing and wall snapping call them.
+    // =================================================================
+
+    // Segments i = 0..Count-1 from (AX[i], AY[i]) to (BX[i], BY[i])
+    struct SegmentSpan
+    {
+        const double* AX{ nullptr };
+        const double* AY{ nullptr };
+        const double* BX{ nullptr };
+        const double* BY{ nullptr };
+        size_t Count{ 0 };
+    };
+
+    // Position of p along a Z curve over square cells (1 m by default):
+    // sorting by it puts elements next to their neighbours (display
+    // list batches, imported underlays)
+    inline uint64_t SpatialOrderKey(const WorldPoint& p, double cellSize = 1000.0)
+    {
+        auto cell = [cellSize](double v) {
+            double c = std::floor(v / cellSize) + 2147483648.0;
+            return static_cast<uint64_t>(std::clamp(c, 0.0, 4294967295.0));
+        };
+        auto spread = [](uint64_t v) {
+            v = (v | (v << 16)) & 0x0000FFFF0000FFFFull;
+            v = (v | (v << 8)) & 0x00FF00FF00FF00FFull;
+            v = (v | (v << 4)) & 0x0F0F0F0F0F0F0F0Full;
+            v = (v | (v << 2)) & 0x3333333333333333ull;
+            v = (v | (v << 1)) & 0x5555555555555555ull;
+            return v;
+        };
+        return spread(cell(p.X)) | (spread(cell(p.Y)) << 1);
+    }
+
+    class GeometryKernels
+    {
+    public:
+        static constexpr size_t NotFound = static_cast<size_t>(-1);
+
+        // ---------------------------------------------------------------
+        // Scalar
+        // ---------------------------------------------------------------
+
+        // Squared distance from p to segment ab and the clamped projection parameter
+        static double DistanceSqToSegment(double px, double py, double ax, double ay, double bx, double by, double& t)
+        {
+            double dx = bx - ax, dy = by - ay;
+            double qx = px - ax, qy = py - ay;
+            double len2 = dx * dx + dy * dy;
+            t = len2 > DegenerateLengthSq ? (qx * dx + qy * dy) / len2 : 0.0;
+            t = (std::min)((std::max)(t, 0.0), 1.0);
+            double ex = qx - t * dx, ey = qy - t * dy;
+            return ex * ex + ey * ey;
+        }
+
+        static double DistancePointToSegment(const WorldPoint& p, const WorldPoint& a, const WorldPoint& b)
+        {
+            double t;
+            return std::sqrt(DistanceSqToSegment(p.X, p.Y, a.X, a.Y, b.X, b.Y, t));
+        }
+
+        static double DistancePointToSegment(const WorldPoint& p, const WorldPoint& a, const WorldPoint& b,
+                                             double& t, WorldPoint& projection)
+        {
+            double d2 = DistanceSqToSegment(p.X, p.Y, a.X, a.Y, b.X, b.Y, t);
+            projection = WorldPoint(a.X + (b.X - a.X) * t, a.Y + (b.Y - a.Y) * t);
+            return std::sqrt(d2);
+        }
+
+        // Crossing of the infinite lines p1p2 and p3p4; t1/t2 are the
+        // parameters along each (0..1 = on the segment). False if parallel
+        // or closer to it than parallelSine, the sine of the angle between
+        // them, so the test means the same for short and long walls.
+        static bool LineIntersection(const WorldPoint& p1, const WorldPoint& p2,
+                                     const WorldPoint& p3, const WorldPoint& p4,
+                                     WorldPoint& intersection, double& t1, double& t2,
+                                     double parallelSine = 1e-10)
+        {
+            double denom = (p1.X - p2.X) * (p3.Y - p4.Y) - (p1.Y - p2.Y) * (p3.X - p4.X);
+            if (std::abs(denom) <= parallelSine * p1.Distance(p2) * p3.Distance(p4))
+                return false;
+
+            t1 = ((p1.X - p3.X) * (p3.Y - p4.Y) - (p1.Y - p3.Y) * (p3.X - p4.X)) / denom;
+            t2 = -((p1.X - p2.X) * (p1.Y - p3.Y) - (p1.Y - p2.Y) * (p1.X - p3.X)) / denom;
+
+            intersection.X = p1.X + t1 * (p2.X - p1.X);
+            intersection.Y = p1.Y + t1 * (p2.Y - p1.Y);
+            return true;
+        }
+
+        // ---------------------------------------------------------------
+        // Batched: one point against a SegmentSpan
+        // ---------------------------------------------------------------
+
+        // out[i] = squared distance from p to segment i
+        static void DistanceSqToSegments(const WorldPoint& p, const SegmentSpan& s, double* out)
+        {
+            size_t i = 0;
+#if GEOMETRY_KERNELS_AVX
+            if (HasAvx())
+                i = DistanceSqAvx(p.X, p.Y, s, out);
+#endif
+#if GEOMETRY_KERNELS_SSE2
+            i = DistanceSqSse2(p.X, p.Y, s, i, out);
+#endif
+            for (; i < s.Count; ++i)
+            {
+                double t;
+                out[i] = DistanceSqToSegment(p.X, p.Y, s.AX[i], s.AY[i], s.BX[i], s.BY[i], t);
+            }
+        }
+
+        // Indices, ascending, of segments within widths[i] / 2 + tolerance
+        // of p, i.e. bands of that width around each segment (walls:
+        // widths = thickness). widths may be null for bare segments.
+        static void CollectWithin(const WorldPoint& p, const SegmentSpan& s, const double* widths,
+                                  double tolerance, std::vector<uint32_t>& out)
+        {
+            ForEachChunk(p, s, [&](size_t first, const double* d2, size_t n) {
+                for (size_t k = 0; k < n; ++k)
+                {
+                    double r = (widths ? widths[first + k] / 2.0 : 0.0) + tolerance;
+                    if (d2[k] <= r * r)
+                        out.push_back(static_cast<uint32_t>(first + k));
+                }
+            });
+        }
+
+        // Index of the segment nearest to p within maxDistance, NotFound if none
+        static size_t NearestSegment(const WorldPoint& p, const SegmentSpan& s, double maxDistance, double& distance)
+        {
+            size_t best = NotFound;
+            double bestD2 = maxDistance * maxDistance;
+            ForEachChunk(p, s, [&](size_t first, const double* d2, size_t n) {
+                for (size_t k = 0; k < n; ++k)
+                {
+                    if (d2[k] <= bestD2)
+                    {
+                        bestD2 = d2[k];
+                        best = first + k;
+                    }
+                }
+            });
+            distance = best != NotFound ? std::sqrt(bestD2) : std::numeric_limits<double>::infinity();
+            return best;
+        }
+
+        // Which batched path DistanceSqToSegments takes on this machine
+        static const wchar_t* GetInstructionSetName()
+        {
+#if GEOMETRY_KERNELS_AVX
+            if (HasAvx())
+                return L"AVX";
+#endif
+#if GEOMETRY_KERNELS_SSE2
+            return L"SSE2";
+#else
+            return L"Scalar";
+#endif
+        }
+
+    private:
+        static constexpr double DegenerateLengthSq = 1e-10;
+        static constexpr size_t ChunkSize = 256;
+
+        // fn(first, d2, n) over stack-sized chunks of squared distances
+        template <typename Fn>
+        static void ForEachChunk(const WorldPoint& p, const SegmentSpan& s, Fn&& fn)
+        {
+            double d2[ChunkSize];
+            for (size_t first = 0; first < s.Count; first += ChunkSize)
+            {
+                size_t n = (std::min)(ChunkSize, s.Count - first);
+                SegmentSpan chunk{ s.AX + first, s.AY + first, s.BX + first, s.BY + first, n };
+                DistanceSqToSegments(p, chunk, d2);
+                fn(first, d2, n);
+            }
+        }
+
+#if GEOMETRY_KERNELS_SSE2
+        // Two segments per step from index i; returns where the scalar tail starts
+        static size_t DistanceSqSse2(double px, double py, const SegmentSpan& s, size_t i, double* out)
+        {
+            const __m128d qx0 = _mm_set1_pd(px), qy0 = _mm_set1_pd(py);
+            const __m128d zero = _mm_setzero_pd(), one = _mm_set1_pd(1.0);
+            const __m128d eps = _mm_set1_pd(DegenerateLengthSq);
+
+            for (; i + 2 <= s.Count; i += 2)
+            {
+                __m128d ax = _mm_loadu_pd(s.AX + i), ay = _mm_loadu_pd(s.AY + i);
+                __m128d dx = _mm_sub_pd(_mm_loadu_pd(s.BX + i), ax);
+                __m128d dy = _mm_sub_pd(_mm_loadu_pd(s.BY + i), ay);
+                __m128d qx = _mm_sub_pd(qx0, ax), qy = _mm_sub_pd(qy0, ay);
+
+                __m128d len2 = _mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy));
+                __m128d dot = _mm_add_pd(_mm_mul_pd(qx, dx), _mm_mul_pd(qy, dy));
+                // Degenerate segments: t = 0 (the and also clears 0/0)
+                __m128d t = _mm_and_pd(_mm_div_pd(dot, len2), _mm_cmpgt_pd(len2, eps));
+                t = _mm_min_pd(_mm_max_pd(t, zero), one);
+
+                __m128d ex = _mm_sub_pd(qx, _mm_mul_pd(t, dx));
+                __m128d ey = _mm_sub_pd(qy, _mm_mul_pd(t, dy));
+                _mm_storeu_pd(out + i, _mm_add_pd(_mm_mul_pd(ex, ex), _mm_mul_pd(ey, ey)));
+            }
+            return i;
+        }
+#endif
+
+#if GEOMETRY_KERNELS_AVX
+        static bool HasAvx()
+        {
+            static const bool available = DetectAvx();
+            return available;
+        }
+
+        static bool DetectAvx()
+        {
+#if defined(_MSC_VER) && !defined(__clang__)
+            // CPU support plus OS-saved YMM state (OSXSAVE, XCR0 bits 1-2)
+            int info[4];
+            __cpuid(info, 1);
+            bool osxsave = (info[2] & (1 << 27)) != 0;
+            bool avx = (info[2] & (1 << 28)) != 0;
+            return osxsave && avx && (_xgetbv(0) & 0x6) == 0x6;
+#else
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx");
+#endif
+        }
+
+        // Four segments per step; returns how many were done
+        GEOMETRY_KERNELS_AVX_TARGET
+        static size_t DistanceSqAvx(double px, double py, const SegmentSpan& s, double* out)
+        {
+            const __m256d qx0 = _mm256_set1_pd(px), qy0 = _mm256_set1_pd(py);
+            const __m256d zero = _mm256_setzero_pd(), one = _mm256_set1_pd(1.0);
+            const __m256d eps = _mm256_set1_pd(DegenerateLengthSq);
+
+            size_t i = 0;
+            for (; i + 4 <= s.Count; i += 4)
+            {
+                __m256d ax = _mm256_loadu_pd(s.AX + i), ay = _mm256_loadu_pd(s.AY + i);
+                __m256d dx = _mm256_sub_pd(_mm256_loadu_pd(s.BX + i), ax);
+                __m256d dy = _mm256_sub_pd(_mm256_loadu_pd(s.BY + i), ay);
+                __m256d qx = _mm256_sub_pd(qx0, ax), qy = _mm256_sub_pd(qy0, ay);
+
+                __m256d len2 = _mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy));
+                __m256d dot = _mm256_add_pd(_mm256_mul_pd(qx, dx), _mm256_mul_pd(qy, dy));
+                __m256d t = _mm256_and_pd(_mm256_div_pd(dot, len2), _mm256_cmp_pd(len2, eps, _CMP_GT_OQ));
+                t = _mm256_min_pd(_mm256_max_pd(t, zero), one);
+
+                __m256d ex = _mm256_sub_pd(qx, _mm256_mul_pd(t, dx));
+                __m256d ey = _mm256_sub_pd(qy, _mm256_mul_pd(t, dy));
+                _mm256_storeu_pd(out + i, _mm256_add_pd(_mm256_mul_pd(ex, ex), _mm256_mul_pd(ey, ey)));
+            }
+            // The SSE2 tail follows: avoid the AVX-to-SSE transition penalty
+            _mm256_zeroupper();
+            return i;
+        }
+#endif
+    };
+}
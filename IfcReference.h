@@ -2,6 +2,7 @@
 
 #include "pch.h"
 #include "IfcParser.h"
+#include "ReferenceSnapIndex.h"
 #include <memory>
 #include <string>
 #include <vector>
@@ -55,43 +56,43 @@ namespace winrt::estimate1
 
         // 
         const std::wstring& GetName() const { return m_name; }
-        void SetName(const std::wstring& name) { m_name = name; }
+        void SetName(const std::wstring& name) { m_name = name; ++m_revision; }
 
         // 
         bool IsVisible() const { return m_isVisible; }
-        void SetVisible(bool visible) { m_isVisible = visible; }
+        void SetVisible(bool visible) { m_isVisible = visible; ++m_revision; }
 
         //  (0-255)
         uint8_t GetOpacity() const { return m_opacity; }
-        void SetOpacity(uint8_t opacity) { m_opacity = opacity; }
+        void SetOpacity(uint8_t opacity) { m_opacity = opacity; ++m_revision; }
 
         //   
         Windows::UI::Color GetWallColor() const { return m_wallColor; }
-        void SetWallColor(Windows::UI::Color color) { m_wallColor = color; }
+        void SetWallColor(Windows::UI::Color color) { m_wallColor = color; ++m_revision; }
 
         //   
         Windows::UI::Color GetDoorColor() const { return m_doorColor; }
-        void SetDoorColor(Windows::UI::Color color) { m_doorColor = color; }
+        void SetDoorColor(Windows::UI::Color color) { m_doorColor = color; ++m_revision; }
 
         //   
         Windows::UI::Color GetWindowColor() const { return m_windowColor; }
-        void SetWindowColor(Windows::UI::Color color) { m_windowColor = color; }
+        void SetWindowColor(Windows::UI::Color color) { m_windowColor = color; ++m_revision; }
 
         //   
         Windows::UI::Color GetSpaceColor() const { return m_spaceColor; }
-        void SetSpaceColor(Windows::UI::Color color) { m_spaceColor = color; }
+        void SetSpaceColor(Windows::UI::Color color) { m_spaceColor = color; ++m_revision; }
 
         //  
         float GetLineWidth() const { return m_lineWidth; }
-        void SetLineWidth(float width) { m_lineWidth = width; }
+        void SetLineWidth(float width) { m_lineWidth = width; ++m_revision; }
 
         //  
         bool GetShowNames() const { return m_showNames; }
-        void SetShowNames(bool show) { m_showNames = show; }
+        void SetShowNames(bool show) { m_showNames = show; ++m_revision; }
 
         //  
         bool GetShowSpaces() const { return m_showSpaces; }
-        void SetShowSpaces(bool show) { m_showSpaces = show; }
+        void SetShowSpaces(bool show) { m_showSpaces = show; ++m_revision; }
 
         //  IFC
         IfcDocument* GetDocument() { return m_document.get(); }
@@ -100,8 +101,13 @@ namespace winrt::estimate1
         void TakeDocument(std::unique_ptr<IfcDocument> doc)
         {
             m_document = std::move(doc);
+            BuildSnapIndex();
+            ++m_revision;
         }
 
+        // Wall, space and slab outlines for object snaps, built with the document
+        const ReferenceSnapIndex& GetSnapIndex() const { return m_snapIndex; }
+
         // 
         WorldPoint GetMinBounds() const 
         { 
@@ -162,14 +168,14 @@ namespace winrt::estimate1
 
         //    
         const std::wstring& GetSourcePath() const { return m_sourcePath; }
-        void SetSourcePath(const std::wstring& path) { m_sourcePath = path; }
+        void SetSourcePath(const std::wstring& path) { m_sourcePath = path; ++m_revision; }
 
         // M6:  
         const std::wstring& GetFilePath() const { return m_sourcePath; }
         double GetScale() const { return m_scale; }
-        void SetScale(double scale) { m_scale = scale; }
+        void SetScale(double scale) { m_scale = scale; ++m_revision; }
         const WorldPoint& GetOffset() const { return m_offset; }
-        void SetOffset(const WorldPoint& offset) { m_offset = offset; }
+        void SetOffset(const WorldPoint& offset) { m_offset = offset; ++m_revision; }
 
         //  IFC
         std::wstring GetSchema() const 
@@ -190,7 +196,50 @@ namespace winrt::estimate1
             return m_document ? m_document->Storeys : empty;
         }
 
+        // Changes with every edit of the layer, for caches of its drawing
+        uint64_t GetRevision() const { return m_revision; }
+
     private:
+        void BuildSnapIndex()
+        {
+            m_snapIndex.Clear();
+            if (m_document)
+            {
+                std::vector<WorldPoint> points;
+                auto addContours = [&](const std::vector<IfcPolyline>& contours) {
+                    for (const auto& contour : contours)
+                    {
+                        points.clear();
+                        for (const auto& p : contour.Points)
+                            points.emplace_back(p.X, p.Y);
+                        m_snapIndex.AddPolyline(points, contour.IsClosed);
+                    }
+                };
+
+                for (const auto& wall : m_document->Walls)
+                {
+                    m_snapIndex.BeginEntity(wall->Id);
+                    if (!wall->Contours.empty())
+                        addContours(wall->Contours);
+                    else if (wall->StartPoint.X != 0 || wall->StartPoint.Y != 0 ||
+                             wall->EndPoint.X != 0 || wall->EndPoint.Y != 0)
+                        m_snapIndex.AddSegment(WorldPoint(wall->StartPoint.X, wall->StartPoint.Y),
+                                               WorldPoint(wall->EndPoint.X, wall->EndPoint.Y));
+                }
+                for (const auto& space : m_document->Spaces)
+                {
+                    m_snapIndex.BeginEntity(space->Id);
+                    addContours(space->BoundaryContours);
+                }
+                for (const auto& slab : m_document->Slabs)
+                {
+                    m_snapIndex.BeginEntity(slab->Id);
+                    addContours(slab->Contours);
+                }
+            }
+            m_snapIndex.Finish();
+        }
+
         std::wstring m_name;
         std::wstring m_sourcePath;
 
@@ -209,6 +258,9 @@ namespace winrt::estimate1
         WorldPoint m_offset{ 0, 0 };
 
         std::unique_ptr<IfcDocument> m_document;
+        ReferenceSnapIndex m_snapIndex;
+
+        uint64_t m_revision{ 0 };
     };
 
     // ============================================================================
@@ -316,6 +368,7 @@ namespace winrt::estimate1
             if (index >= m_layers.size())
                 return false;
 
+            m_removedRevisions += m_layers[index]->GetRevision() + 1;
             m_layers.erase(m_layers.begin() + index);
             return true;
         }
@@ -323,9 +376,21 @@ namespace winrt::estimate1
         //   
         void Clear()
         {
+            for (const auto& layer : m_layers)
+                m_removedRevisions += layer->GetRevision() + 1;
             m_layers.clear();
         }
 
+        // Changes whenever a layer is added, removed or edited: a removed
+        // layer leaves its revision plus one behind, so the sum only grows
+        uint64_t GetRevision() const
+        {
+            uint64_t revision = m_removedRevisions;
+            for (const auto& layer : m_layers)
+                revision += layer->GetRevision();
+            return revision;
+        }
+
         //  
         size_t GetLayerCount() const { return m_layers.size(); }
 
@@ -334,5 +399,6 @@ namespace winrt::estimate1
 
     private:
         std::vector<std::unique_ptr<IfcReferenceLayer>> m_layers;
+        uint64_t m_removedRevisions{ 0 };
     };
 }
@@ -3,9 +3,8 @@
 #include "pch.h"
 #include "Camera.h"
 #include "IfcReference.h"
-#include <winrt/Microsoft.Graphics.Canvas.h>
-#include <winrt/Microsoft.Graphics.Canvas.Geometry.h>
-#include <winrt/Microsoft.Graphics.Canvas.Text.h>
+#include "DisplayList.h"
+#include <array>
 
 namespace winrt::estimate1
 {
@@ -16,25 +15,23 @@ namespace winrt::estimate1
     class IfcReferenceRenderer
     {
     public:
-        //   IFC-
-        static void Draw(
-            Microsoft::Graphics::Canvas::CanvasDrawingSession const& session,
-            const Camera& camera,
+        //    IFC-   
+        static void Build(
+            DisplayList& list,
             const IfcReferenceManager& manager)
         {
             for (const auto& layer : manager.GetLayers())
             {
                 if (layer && layer->IsVisible())
                 {
-                    DrawLayer(session, camera, *layer);
+                    BuildLayer(list, *layer);
                 }
             }
         }
 
-        //    IFC
-        static void DrawLayer(
-            Microsoft::Graphics::Canvas::CanvasDrawingSession const& session,
-            const Camera& camera,
+        //   IFC
+        static void BuildLayer(
+            DisplayList& list,
             const IfcReferenceLayer& layer)
         {
             const IfcDocument* doc = layer.GetDocument();
@@ -47,25 +44,25 @@ namespace winrt::estimate1
             //   ( )
             if (layer.GetShowSpaces())
             {
-                DrawSpaces(session, camera, *doc, layer, opacity);
+                AddSpaces(list, *doc, layer, opacity);
             }
 
             //    ( )
-            DrawSlabs(session, camera, *doc, layer, opacity);
+            AddSlabs(list, *doc, opacity);
 
             //  
-            DrawWalls(session, camera, *doc, layer, opacity, lineWidth);
+            AddWalls(list, *doc, layer, opacity, lineWidth);
 
             //  
-            DrawDoors(session, camera, *doc, layer, opacity, lineWidth);
+            AddDoors(list, *doc, layer, opacity, lineWidth);
 
             //  
-            DrawWindows(session, camera, *doc, layer, opacity, lineWidth);
+            AddWindows(list, *doc, layer, opacity, lineWidth);
 
             //   
             if (layer.GetShowNames() && layer.GetShowSpaces())
             {
-                DrawSpaceNames(session, camera, *doc, layer, opacity);
+                AddSpaceNames(list, *doc, opacity);
             }
         }
 
@@ -74,9 +71,8 @@ namespace winrt::estimate1
         //  
         // ============================================================
         
-        static void DrawWalls(
-            Microsoft::Graphics::Canvas::CanvasDrawingSession const& session,
-            const Camera& camera,
+        static void AddWalls(
+            DisplayList& list,
             const IfcDocument& doc,
             const IfcReferenceLayer& layer,
             uint8_t opacity,
@@ -84,6 +80,8 @@ namespace winrt::estimate1
         {
             Windows::UI::Color wallColor = layer.GetWallColor();
             wallColor.A = static_cast<uint8_t>((wallColor.A * opacity) / 255);
+            uint16_t contourStyle = list.AddStyle(DisplayStyle::Stroke(wallColor, lineWidth));
+            uint16_t axisStyle = list.AddStyle(DisplayStyle::Stroke(wallColor, lineWidth * 2.0f));
 
             for (const auto& wall : doc.Walls)
             {
@@ -95,22 +93,16 @@ namespace winrt::estimate1
                 {
                     for (const auto& contour : wall->Contours)
                     {
-                        DrawPolyline(session, camera, contour.Points, contour.IsClosed, 
-                                    wallColor, lineWidth);
+                        AddPolyline(list, contourStyle, contour.Points, contour.IsClosed);
                     }
                 }
                 //    
                 else if (wall->StartPoint.X != 0 || wall->StartPoint.Y != 0 ||
                          wall->EndPoint.X != 0 || wall->EndPoint.Y != 0)
                 {
-                    ScreenPoint sp1 = camera.WorldToScreen(WorldPoint(wall->StartPoint.X, wall->StartPoint.Y));
-                    ScreenPoint sp2 = camera.WorldToScreen(WorldPoint(wall->EndPoint.X, wall->EndPoint.Y));
-                    
-                    session.DrawLine(
-                        Windows::Foundation::Numerics::float2(sp1.X, sp1.Y),
-                        Windows::Foundation::Numerics::float2(sp2.X, sp2.Y),
-                        wallColor,
-                        lineWidth * 2.0f);
+                    list.AddLine(axisStyle,
+                        WorldPoint(wall->StartPoint.X, wall->StartPoint.Y),
+                        WorldPoint(wall->EndPoint.X, wall->EndPoint.Y));
                 }
             }
         }
@@ -119,9 +111,8 @@ namespace winrt::estimate1
         //  
         // ============================================================
         
-        static void DrawDoors(
-            Microsoft::Graphics::Canvas::CanvasDrawingSession const& session,
-            const Camera& camera,
+        static void AddDoors(
+            DisplayList& list,
             const IfcDocument& doc,
             const IfcReferenceLayer& layer,
             uint8_t opacity,
@@ -129,43 +120,30 @@ namespace winrt::estimate1
         {
             Windows::UI::Color doorColor = layer.GetDoorColor();
             doorColor.A = static_cast<uint8_t>((doorColor.A * opacity) / 255);
+            Windows::UI::Color fillColor = doorColor;
+            fillColor.A = static_cast<uint8_t>(fillColor.A / 3);
+            uint16_t fill = list.AddStyle(DisplayStyle::Fill(fillColor));
+            uint16_t stroke = list.AddStyle(DisplayStyle::Stroke(doorColor, lineWidth));
 
             for (const auto& door : doc.Doors)
             {
                 if (!door)
                     continue;
 
-                //      
+                //     
+                WorldPoint pos(door->Position.X, door->Position.Y);
                 double halfWidth = door->Width / 2.0;
                 double halfHeight = door->Height / 2.0;
+                auto rect = AxisRect(pos, halfWidth, halfHeight);
 
-                ScreenPoint pos = camera.WorldToScreen(
-                    WorldPoint(door->Position.X, door->Position.Y));
-
-                float screenHalfWidth = static_cast<float>(halfWidth * camera.GetZoom());
-                float screenHalfHeight = static_cast<float>(halfHeight * camera.GetZoom());
-
-                //     
-                Windows::Foundation::Rect doorRect(
-                    pos.X - screenHalfWidth,
-                    pos.Y - screenHalfHeight,
-                    screenHalfWidth * 2,
-                    screenHalfHeight * 2);
-
-                // 
-                Windows::UI::Color fillColor = doorColor;
-                fillColor.A = static_cast<uint8_t>(fillColor.A / 3);
-                session.FillRectangle(doorRect, fillColor);
-
-                // 
-                session.DrawRectangle(doorRect, doorColor, lineWidth);
+                //   
+                list.AddPolygon(fill, rect.data(), rect.size());
+                list.AddPolyline(stroke, rect.data(), rect.size(), true);
 
                 //    ()
                 if (door->Width > 0)
                 {
-                    float arcRadius = screenHalfWidth;
-                    //   90
-                    DrawArc90(session, pos, arcRadius, doorColor, lineWidth);
+                    AddArc90(list, stroke, pos, halfWidth);
                 }
             }
         }
@@ -174,9 +152,8 @@ namespace winrt::estimate1
         //  
         // ============================================================
         
-        static void DrawWindows(
-            Microsoft::Graphics::Canvas::CanvasDrawingSession const& session,
-            const Camera& camera,
+        static void AddWindows(
+            DisplayList& list,
             const IfcDocument& doc,
             const IfcReferenceLayer& layer,
             uint8_t opacity,
@@ -184,41 +161,29 @@ namespace winrt::estimate1
         {
             Windows::UI::Color windowColor = layer.GetWindowColor();
             windowColor.A = static_cast<uint8_t>((windowColor.A * opacity) / 255);
+            Windows::UI::Color glassColor = windowColor;
+            glassColor.A = static_cast<uint8_t>(glassColor.A / 2);
+            uint16_t fill = list.AddStyle(DisplayStyle::Fill(glassColor));
+            uint16_t stroke = list.AddStyle(DisplayStyle::Stroke(windowColor, lineWidth));
+
+            const double thickness = 100.0; //   
 
             for (const auto& window : doc.Windows)
             {
                 if (!window)
                     continue;
 
-                double halfWidth = window->Width / 2.0;
-
-                ScreenPoint pos = camera.WorldToScreen(
-                    WorldPoint(window->Position.X, window->Position.Y));
+                //      
+                WorldPoint pos(window->Position.X, window->Position.Y);
+                auto rect = AxisRect(pos, window->Width / 2.0, thickness / 2);
 
-                float screenHalfWidth = static_cast<float>(halfWidth * camera.GetZoom());
-                float thickness = static_cast<float>(100.0 * camera.GetZoom()); //   
-
-                //       ()
-                Windows::Foundation::Rect windowRect(
-                    pos.X - screenHalfWidth,
-                    pos.Y - thickness / 2,
-                    screenHalfWidth * 2,
-                    thickness);
-
-                //  (  )
-                Windows::UI::Color glassColor = windowColor;
-                glassColor.A = static_cast<uint8_t>(glassColor.A / 2);
-                session.FillRectangle(windowRect, glassColor);
-
-                // 
-                session.DrawRectangle(windowRect, windowColor, lineWidth);
+                list.AddPolygon(fill, rect.data(), rect.size());
+                list.AddPolyline(stroke, rect.data(), rect.size(), true);
 
                 //   ()
-                session.DrawLine(
-                    Windows::Foundation::Numerics::float2(pos.X, pos.Y - thickness / 2),
-                    Windows::Foundation::Numerics::float2(pos.X, pos.Y + thickness / 2),
-                    windowColor,
-                    lineWidth);
+                list.AddLine(stroke,
+                    WorldPoint(pos.X, pos.Y - thickness / 2),
+                    WorldPoint(pos.X, pos.Y + thickness / 2));
             }
         }
 
@@ -226,16 +191,17 @@ namespace winrt::estimate1
         //  
         // ============================================================
         
-        static void DrawSpaces(
-            Microsoft::Graphics::Canvas::CanvasDrawingSession const& session,
-            const Camera& camera,
+        static void AddSpaces(
+            DisplayList& list,
             const IfcDocument& doc,
             const IfcReferenceLayer& layer,
             uint8_t opacity)
         {
             Windows::UI::Color spaceColor = layer.GetSpaceColor();
             spaceColor.A = static_cast<uint8_t>((spaceColor.A * opacity) / 255 / 4); //   
+            uint16_t fill = list.AddStyle(DisplayStyle::Fill(spaceColor));
 
+            std::vector<WorldPoint> points;
             for (const auto& space : doc.Spaces)
             {
                 if (!space)
@@ -246,26 +212,8 @@ namespace winrt::estimate1
                     if (contour.Points.size() < 3)
                         continue;
 
-                    //    
-                    auto device = session.Device();
-                    
-                    Microsoft::Graphics::Canvas::Geometry::CanvasPathBuilder pathBuilder(device);
-                    
-                    ScreenPoint first = camera.WorldToScreen(
-                        WorldPoint(contour.Points[0].X, contour.Points[0].Y));
-                    pathBuilder.BeginFigure(first.X, first.Y);
-
-                    for (size_t i = 1; i < contour.Points.size(); ++i)
-                    {
-                        ScreenPoint pt = camera.WorldToScreen(
-                            WorldPoint(contour.Points[i].X, contour.Points[i].Y));
-                        pathBuilder.AddLine(pt.X, pt.Y);
-                    }
-
-                    pathBuilder.EndFigure(Microsoft::Graphics::Canvas::Geometry::CanvasFigureLoop::Closed);
-                    
-                    auto geometry = Microsoft::Graphics::Canvas::Geometry::CanvasGeometry::CreatePath(pathBuilder);
-                    session.FillGeometry(geometry, spaceColor);
+                    ToWorld(contour.Points, points);
+                    list.AddPolygon(fill, points);
                 }
             }
         }
@@ -274,15 +222,16 @@ namespace winrt::estimate1
         //   
         // ============================================================
         
-        static void DrawSpaceNames(
-            Microsoft::Graphics::Canvas::CanvasDrawingSession const& session,
-            const Camera& camera,
+        static void AddSpaceNames(
+            DisplayList& list,
             const IfcDocument& doc,
-            const IfcReferenceLayer& layer,
             uint8_t opacity)
         {
             Windows::UI::Color textColor = Windows::UI::ColorHelper::FromArgb(
                 static_cast<uint8_t>(200 * opacity / 255), 60, 60, 60);
+            uint16_t style = list.AddStyle(DisplayStyle::Text(
+                textColor, 12.0f, DisplayFont::Default, DisplayTextAlign::TopCenter)
+                .WithPriority(DisplayLabelPriority::Underlay));
 
             for (const auto& space : doc.Spaces)
             {
@@ -291,7 +240,6 @@ namespace winrt::estimate1
 
                 //   
                 WorldPoint center = CalculateContourCenter(space->BoundaryContours);
-                ScreenPoint screenCenter = camera.WorldToScreen(center);
 
                 //  
                 std::wstring displayText = space->Name;
@@ -302,16 +250,7 @@ namespace winrt::estimate1
                     displayText += areaText;
                 }
 
-                //  
-                auto textFormat = Microsoft::Graphics::Canvas::Text::CanvasTextFormat();
-                textFormat.FontSize(12.0f);
-                textFormat.HorizontalAlignment(Microsoft::Graphics::Canvas::Text::CanvasHorizontalAlignment::Center);
-
-                session.DrawText(
-                    winrt::hstring(displayText),
-                    screenCenter.X, screenCenter.Y,
-                    textColor,
-                    textFormat);
+                list.AddText(style, center, std::move(displayText));
             }
         }
 
@@ -319,15 +258,14 @@ namespace winrt::estimate1
         //  
         // ============================================================
         
-        static void DrawSlabs(
-            Microsoft::Graphics::Canvas::CanvasDrawingSession const& session,
-            const Camera& camera,
+        static void AddSlabs(
+            DisplayList& list,
             const IfcDocument& doc,
-            const IfcReferenceLayer& layer,
             uint8_t opacity)
         {
             Windows::UI::Color slabColor = Windows::UI::ColorHelper::FromArgb(
                 static_cast<uint8_t>(80 * opacity / 255), 150, 150, 150);
+            uint16_t stroke = list.AddStyle(DisplayStyle::Stroke(slabColor, 0.5f));
 
             for (const auto& slab : doc.Slabs)
             {
@@ -336,8 +274,7 @@ namespace winrt::estimate1
 
                 for (const auto& contour : slab->Contours)
                 {
-                    DrawPolyline(session, camera, contour.Points, contour.IsClosed,
-                                slabColor, 0.5f);
+                    AddPolyline(list, stroke, contour.Points, contour.IsClosed);
                 }
             }
         }
@@ -346,75 +283,53 @@ namespace winrt::estimate1
         //  
         // ============================================================
 
-        static void DrawPolyline(
-            Microsoft::Graphics::Canvas::CanvasDrawingSession const& session,
-            const Camera& camera,
+        static void ToWorld(const std::vector<IfcPoint2D>& points, std::vector<WorldPoint>& out)
+        {
+            out.clear();
+            for (const auto& p : points)
+                out.push_back(WorldPoint(p.X, p.Y));
+        }
+
+        static void AddPolyline(
+            DisplayList& list,
+            uint16_t style,
             const std::vector<IfcPoint2D>& points,
-            bool isClosed,
-            Windows::UI::Color color,
-            float lineWidth)
+            bool isClosed)
         {
             if (points.size() < 2)
                 return;
 
-            for (size_t i = 0; i < points.size() - 1; ++i)
-            {
-                ScreenPoint sp1 = camera.WorldToScreen(WorldPoint(points[i].X, points[i].Y));
-                ScreenPoint sp2 = camera.WorldToScreen(WorldPoint(points[i + 1].X, points[i + 1].Y));
-
-                session.DrawLine(
-                    Windows::Foundation::Numerics::float2(sp1.X, sp1.Y),
-                    Windows::Foundation::Numerics::float2(sp2.X, sp2.Y),
-                    color,
-                    lineWidth);
-            }
+            std::vector<WorldPoint> world;
+            ToWorld(points, world);
+            list.AddPolyline(style, world, isClosed && points.size() > 2);
+        }
 
-            // ,  
-            if (isClosed && points.size() > 2)
-            {
-                ScreenPoint sp1 = camera.WorldToScreen(
-                    WorldPoint(points.back().X, points.back().Y));
-                ScreenPoint sp2 = camera.WorldToScreen(
-                    WorldPoint(points.front().X, points.front().Y));
-
-                session.DrawLine(
-                    Windows::Foundation::Numerics::float2(sp1.X, sp1.Y),
-                    Windows::Foundation::Numerics::float2(sp2.X, sp2.Y),
-                    color,
-                    lineWidth);
-            }
+        static std::array<WorldPoint, 4> AxisRect(const WorldPoint& center, double halfWidth, double halfHeight)
+        {
+            return {
+                WorldPoint(center.X - halfWidth, center.Y - halfHeight),
+                WorldPoint(center.X + halfWidth, center.Y - halfHeight),
+                WorldPoint(center.X + halfWidth, center.Y + halfHeight),
+                WorldPoint(center.X - halfWidth, center.Y + halfHeight) };
         }
 
-        static void DrawArc90(
-            Microsoft::Graphics::Canvas::CanvasDrawingSession const& session,
-            ScreenPoint center,
-            float radius,
-            Windows::UI::Color color,
-            float lineWidth)
+        static void AddArc90(
+            DisplayList& list,
+            uint16_t style,
+            const WorldPoint& center,
+            double radius)
         {
             //   90 ( )
             const int segments = 8;
-            const float startAngle = 0.0f;
-            const float endAngle = 3.14159f / 2.0f; // 90
-
-            float prevX = center.X + radius * std::cos(startAngle);
-            float prevY = center.Y + radius * std::sin(startAngle);
+            const double endAngle = 3.14159 / 2.0; // 90
 
-            for (int i = 1; i <= segments; ++i)
+            std::array<WorldPoint, segments + 1> points;
+            for (int i = 0; i <= segments; ++i)
             {
-                float angle = startAngle + (endAngle - startAngle) * i / segments;
-                float x = center.X + radius * std::cos(angle);
-                float y = center.Y + radius * std::sin(angle);
-
-                session.DrawLine(
-                    Windows::Foundation::Numerics::float2(prevX, prevY),
-                    Windows::Foundation::Numerics::float2(x, y),
-                    color,
-                    lineWidth);
-
-                prevX = x;
-                prevY = y;
+                double angle = endAngle * i / segments;
+                points[i] = WorldPoint(center.X + radius * std::cos(angle), center.Y + radius * std::sin(angle));
             }
+            list.AddPolyline(style, points.data(), points.size(), false);
         }
 
         static WorldPoint CalculateContourCenter(const std::vector<IfcPolyline>& contours)
@@ -0,0 +1,158 @@
+#pragma once
+
+#include "pch.h"
+#include "DisplayList.h"
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+namespace winrt::estimate1
+{
+    // =================================================================
+    // LABEL DECLUTTER - screen-space collision culling of labels
+    // =================================================================
+    // Labels are offered in priority order; each one is placed if its
+    // box overlaps no box placed before it and rejected otherwise, so
+    // dense plans keep their dimensions and room names readable and
+    // drop the underlay text that would collide with them.
+    //
+    // Placed boxes are bucketed in a uniform grid of CellPx pixels over
+    // the canvas, so a test looks at the few boxes sharing its cells,
+    // not at every label placed. Boxes are estimated from the string
+    // and font size (EstimateBox), never laid out, so a rejected label
+    // costs no DirectWrite work at all.
+    // =================================================================
+
+    class LabelDeclutter
+    {
+    public:
+        static constexpr float CellPx = 64.0f;
+        static constexpr float GapPx = 2.0f;                // kept between labels
+        static constexpr float DefaultFontPx = 20.0f;       // CanvasTextFormat's default size
+        static constexpr float CharWidthEm = 0.55f;         // average advance, in font sizes
+        static constexpr float LineHeightEm = 1.3f;
+
+        // Starts a frame on a canvas of the given size, forgetting the
+        // labels placed before
+        void Begin(float widthPx, float heightPx)
+        {
+            for (uint32_t cell : m_touched)
+                m_cells[cell].clear();
+            m_touched.clear();
+            m_boxes.clear();
+            m_placed = 0;
+            m_rejected = 0;
+
+            m_width = (std::max)(widthPx, 1.0f);
+            m_height = (std::max)(heightPx, 1.0f);
+            m_columns = static_cast<int>(std::ceil(m_width / CellPx));
+            m_rows = static_cast<int>(std::ceil(m_height / CellPx));
+            size_t count = static_cast<size_t>(m_columns) * m_rows;
+            if (m_cells.size() < count)
+                m_cells.resize(count);
+        }
+
+        // Places a label box (px) unless it is off the canvas or overlaps
+        // a label placed earlier in the frame
+        bool TryPlace(const DisplayBounds& box)
+        {
+            if (box.IsEmpty() || box.MaxX < 0.0f || box.MaxY < 0.0f || box.MinX > m_width || box.MinY > m_height)
+            {
+                ++m_rejected;
+                return false;
+            }
+
+            int x0, y0, x1, y1;
+            CellRange(box, x0, y0, x1, y1);
+            for (int y = y0; y <= y1; ++y)
+            {
+                for (int x = x0; x <= x1; ++x)
+                {
+                    for (uint32_t placed : m_cells[static_cast<size_t>(y) * m_columns + x])
+                    {
+                        if (m_boxes[placed].Intersects(box))
+                        {
+                            ++m_rejected;
+                            return false;
+                        }
+                    }
+                }
+            }
+
+            uint32_t id = static_cast<uint32_t>(m_boxes.size());
+            m_boxes.push_back(box);
+            for (int y = y0; y <= y1; ++y)
+            {
+                for (int x = x0; x <= x1; ++x)
+                {
+                    uint32_t cell = static_cast<uint32_t>(y * m_columns + x);
+                    if (m_cells[cell].empty())
+                        m_touched.push_back(cell);
+                    m_cells[cell].push_back(id);
+                }
+            }
+            ++m_placed;
+            return true;
+        }
+
+        // Screen box of a string drawn at (x, y) with the given size and
+        // alignment, from its line count and longest line, grown by GapPx
+        static DisplayBounds EstimateBox(const std::wstring& text, float sizePx, DisplayTextAlign align, float x, float y)
+        {
+            size_t lines = 1;
+            size_t longest = 0;
+            size_t current = 0;
+            for (wchar_t c : text)
+            {
+                if (c == L'\n')
+                {
+                    ++lines;
+                    longest = (std::max)(longest, current);
+                    current = 0;
+                }
+                else
+                {
+                    ++current;
+                }
+            }
+            longest = (std::max)(longest, current);
+
+            float size = sizePx > 0.0f ? sizePx : DefaultFontPx;
+            float width = static_cast<float>(longest) * size * CharWidthEm;
+            float height = static_cast<float>(lines) * size * LineHeightEm;
+
+            float left = align == DisplayTextAlign::TopLeft ? x : x - width / 2;
+            float top = align == DisplayTextAlign::Center ? y - height / 2 : y;
+            DisplayBounds box;
+            box.Extend(left - GapPx, top - GapPx);
+            box.Extend(left + width + GapPx, top + height + GapPx);
+            return box;
+        }
+
+        size_t GetPlacedCount() const { return m_placed; }
+        size_t GetRejectedCount() const { return m_rejected; }
+
+    private:
+        void CellRange(const DisplayBounds& box, int& x0, int& y0, int& x1, int& y1) const
+        {
+            auto clampCell = [](float v, int count) {
+                return std::clamp(static_cast<int>(std::floor(v / CellPx)), 0, count - 1);
+            };
+            x0 = clampCell(box.MinX, m_columns);
+            x1 = clampCell(box.MaxX, m_columns);
+            y0 = clampCell(box.MinY, m_rows);
+            y1 = clampCell(box.MaxY, m_rows);
+        }
+
+        std::vector<std::vector<uint32_t>> m_cells;     // ids of the boxes touching each cell
+        std::vector<uint32_t> m_touched;                // cells with boxes, cleared by Begin
+        std::vector<DisplayBounds> m_boxes;
+        float m_width{ 1.0f };
+        float m_height{ 1.0f };
+        int m_columns{ 1 };
+        int m_rows{ 1 };
+        size_t m_placed{ 0 };
+        size_t m_rejected{ 0 };
+    };
+}
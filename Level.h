@@ -0,0 +1,85 @@
+#pragma once
+
+#include "pch.h"
+#include "Models.h"
+#include "Dimension.h"
+#include "Opening.h"
+#include "Room.h"
+#include "Zone.h"
+#include "Structure.h"
+#include "WallStore.h"
+#include "DocumentSnapshot.h"
+#include <vector>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+namespace winrt::estimate1
+{
+    // =================================================================
+    // LEVELS - storeys of a multi-floor project
+    // =================================================================
+    // DocumentModel works on one active level: its members hold that
+    // level's walls, openings, rooms, structure and dimensions, and all
+    // existing accessors, hit testing, rendering and room detection see
+    // only them. Other levels are parked in a LevelPartition and are not
+    // indexed; switching levels swaps the partitions in O(1).
+    // =================================================================
+
+    class Level
+    {
+    public:
+        Level() : m_id(IdGenerator::Next()) {}
+
+        Level(const std::wstring& name, double elevation, double height)
+            : m_id(IdGenerator::Next())
+            , m_name(name)
+            , m_elevation(elevation)
+            , m_height(height)
+        {
+        }
+
+        uint64_t GetId() const { return m_id; }
+
+        const std::wstring& GetName() const { return m_name; }
+        void SetName(const std::wstring& name) { m_name = name; }
+
+        // Floor elevation above project zero (mm)
+        double GetElevation() const { return m_elevation; }
+        void SetElevation(double elevation) { m_elevation = elevation; }
+
+        // Floor-to-floor height (mm)
+        double GetHeight() const { return m_height; }
+        void SetHeight(double height) { m_height = (std::max)(0.0, height); }
+
+    private:
+        uint64_t m_id;
+        std::wstring m_name;
+        double m_elevation{ 0.0 };
+        double m_height{ 3000.0 };
+    };
+
+    // Element data of one level. Field names mirror the DocumentModel
+    // members they are swapped with.
+    struct LevelPartition
+    {
+        WallStore Walls;
+        std::vector<std::unique_ptr<Dimension>> Dimensions;
+        std::vector<std::unique_ptr<Dimension>> ManualDimensions;
+        std::vector<std::unique_ptr<DimensionChain>> DimensionChains;
+        std::vector<std::shared_ptr<Room>> Rooms;
+        ZoneManager Zones;
+        std::vector<std::shared_ptr<Door>> Doors;
+        std::vector<std::shared_ptr<Window>> Windows;
+        std::vector<std::shared_ptr<Column>> Columns;
+        std::vector<std::shared_ptr<Slab>> Slabs;
+        std::vector<std::shared_ptr<Beam>> Beams;
+        std::unordered_map<uint64_t, double> LoadedAutoDimensionStates;
+        SnapshotCache Snapshots;
+        std::shared_ptr<const WallJoinGraph> JoinGraph;     // joins of the parked walls, built on demand
+
+        LevelPartition() = default;
+        LevelPartition(LevelPartition&&) = default;
+        LevelPartition& operator=(LevelPartition&&) = default;
+    };
+}
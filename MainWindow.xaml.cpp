@@ -42,6 +42,28 @@ namespace winrt::estimate1::implementation
             InvalidateCanvas();
         });
 
+        // Wall faces and alignment answer the wall tool's snap queries
+        m_wallPlaneSnaps = m_snapManager.AddProvider(std::make_unique<WallPlaneSnapProvider>(m_wallSnapSystem));
+
+        // Object snaps on visible DXF/IFC underlays, for every tool
+        m_snapManager.AddProvider(std::make_unique<ReferenceSnapProvider>(m_dxfManager, m_ifcManager));
+
+        // Rooms are re-detected on a worker after wall edits; the canvas keeps
+        // the previous rooms until the result is merged on the UI thread
+        m_document.EnableBackgroundRooms(true);
+        m_document.SetRoomsCompletedHandler([weak = get_weak(), queue = DispatcherQueue()]() {
+            queue.TryEnqueue([weak]() {
+                if (auto self = weak.get())
+                {
+                    if (self->m_document.ApplyCompletedRooms())
+                    {
+                        self->UpdateSelectedElementUI();
+                        self->InvalidateCanvas();
+                    }
+                }
+            });
+        });
+
         // Настраиваем WallTool для обновления UI при создании стены
             m_wallTool.SetOnWallCreated([this](Wall* wall) {
                 (void)wall;
@@ -251,6 +273,50 @@ namespace winrt::estimate1::implementation
         }
     }
 
+    // PageUp on the top level adds a new storey above it
+    void MainWindow::SwitchLevel(int direction)
+    {
+        size_t index = m_document.GetActiveLevelIndex();
+        if (direction > 0)
+        {
+            if (index + 1 >= m_document.GetLevelCount())
+            {
+                m_document.AddLevel();
+                m_viewModel.HasUnsavedChanges(true);
+            }
+            ++index;
+        }
+        else
+        {
+            if (index == 0)
+                return;
+            --index;
+        }
+
+        m_wallTool.Cancel();
+        m_hoverWallId = 0;
+        // Undo commands refer to elements of the level they were made on
+        m_undoManager.Clear();
+
+        m_document.SetActiveLevel(m_document.GetLevels()[index].GetId());
+
+        UpdateSelectedElementUI();
+        UpdateLevelUI();
+        InvalidateCanvas();
+    }
+
+    void MainWindow::UpdateLevelUI()
+    {
+        if (!LevelStatusText())
+            return;
+
+        const Level& level = m_document.GetActiveLevel();
+        std::wstringstream ss;
+        ss << L"Уровень: " << level.GetName() << L" (" << std::showpos
+           << static_cast<int>(std::round(level.GetElevation())) << L")";
+        LevelStatusText().Text(winrt::hstring(ss.str()));
+    }
+
     void MainWindow::UpdateScaleUI()
     {
         if (!ScaleStatusText())
@@ -456,6 +522,61 @@ namespace winrt::estimate1::implementation
         }
     }
 
+    namespace
+    {
+        void MixKey(uint64_t& key, uint64_t value)
+        {
+            key = (key ^ value) * 1099511628211ull;
+        }
+
+        template <typename Elements>
+        void MixElementsKey(uint64_t& key, const Elements& elements)
+        {
+            MixKey(key, elements.size());
+            for (const auto& element : elements)
+            {
+                MixKey(key, element->GetId());
+                MixKey(key, element->GetRevision());
+            }
+        }
+    }
+
+    // Ключ содержимого плиток: всё, от чего зависит статичный план, кроме камеры.
+    // Стены и подложки сведены к версиям их списков; перекрытия, проёмы,
+    // колонны и балки - к ключам, по которым пересобираются их списки.
+    // Выделение и наведение рисуются живьём и в ключ не входят.
+    uint64_t MainWindow::ComputePlanContentKey() const
+    {
+        uint64_t key = 14695981039346656037ull;
+        MixKey(key, m_wallRenderer.GetWallList().GetVersion());
+        MixKey(key, m_underlayList.GetVersion());
+        MixKey(key, m_slabListKey);
+        MixKey(key, m_planListKey);
+        return key;
+    }
+
+    // Перекрытия: ревизии элементов
+    uint64_t MainWindow::ComputeSlabListKey() const
+    {
+        uint64_t key = 14695981039346656037ull;
+        MixElementsKey(key, m_document.GetSlabs());
+        return key;
+    }
+
+    // Проёмы, колонны и балки: ревизии элементов и документа (проёмы стоят
+    // по стенам-хозяевам, их правки видны в ревизии документа)
+    uint64_t MainWindow::ComputePlanListKey() const
+    {
+        uint64_t key = 14695981039346656037ull;
+        MixKey(key, m_document.GetRevision());
+        MixKey(key, m_wallRenderer.GetWallList().GetVersion());
+        MixElementsKey(key, m_document.GetDoors());
+        MixElementsKey(key, m_document.GetWindows());
+        MixElementsKey(key, m_document.GetColumns());
+        MixElementsKey(key, m_document.GetBeams());
+        return key;
+    }
+
     // Обработчик отрисовки холста Win2D
     void MainWindow::OnCanvasDraw(
         [[maybe_unused]] CanvasControl const& sender,
@@ -463,28 +584,44 @@ namespace winrt::estimate1::implementation
     {
         auto session = args.DrawingSession();
 
-        // Очищаем холст тёмным фоном
-        session.Clear(Windows::UI::ColorHelper::FromArgb(255, 31, 35, 41));
+        // Время кадра и его проходов: оверлей F3, трасса F4
+        ProfileFrame profileFrame;
 
-        // M5: Рисуем DXF-подложки (под сеткой или над — зависит от предпочтений)
-        DxfReferenceRenderer::Draw(session, m_camera, m_dxfManager);
+        // Счётчики отсечения (нарисовано/отброшено) считаются за кадр
+        m_displayListRenderer.ResetCullStats();
+        // Кэш раскладок текста вытесняет давно не использованные подписи
+        TextLayoutCache::Shared().BeginFrame();
 
-        // M5.5: Рисуем IFC-подложки
-        IfcReferenceRenderer::Draw(session, m_camera, m_ifcManager);
+        // Очищаем холст тёмным фоном
+        session.Clear(Windows::UI::ColorHelper::FromArgb(255, 31, 35, 41));
 
-        // Рисуем сетку
+        // Рисуем сетку (живьём, под кэшированным планом)
         if (m_showGrid)
         {
+            ProfileScope scope(L"Grid");
             m_gridRenderer.Draw(args, m_camera);
         }
 
-        // R6.2: Рисуем перекрытия (между помещениями и стенами)
+        // M5: DXF- и IFC-подложки; список пересобирается только при изменении слоёв
+        uint64_t underlayRevision = m_dxfManager.GetRevision() * 1099511628211ull + m_ifcManager.GetRevision();
+        if (underlayRevision != m_underlayRevision)
         {
-            uint64_t hoverSlabId = (m_viewModel.CurrentTool() == DrawingTool::Select) ? m_hoverWallId : 0; // Temporarily reusing simple hover or check real hover logic
-            // Actually need separate hover var for slab, or generic hover var. 
-            // Reuse m_hoverWallId logic if generic, but m_hoverWallId is specific.
-            // Let's rely on selection highlight mostly, or implement GetHoverElement in OnPointerMoved.
-            StructureRenderer::DrawSlabs(session, m_camera, m_document.GetSlabs(), 0);
+            ProfileScope scope(L"Underlay build");
+            m_underlayList.Clear();
+            DxfReferenceRenderer::Build(m_underlayList, m_dxfManager);
+            IfcReferenceRenderer::Build(m_underlayList, m_ifcManager);
+            m_underlayRevision = underlayRevision;
+        }
+
+        // R6.2: Перекрытия (между подложками и стенами); список и его
+        // геометрия живут, пока перекрытия не изменились
+        uint64_t slabListKey = ComputeSlabListKey();
+        if (slabListKey != m_slabListKey)
+        {
+            ProfileScope scope(L"Slabs build");
+            m_slabList.Clear();
+            StructureRenderer::BuildSlabs(m_slabList, m_document.GetSlabs(), 0);
+            m_slabListKey = slabListKey;
         }
 
         // Рисуем стены
@@ -494,44 +631,103 @@ namespace winrt::estimate1::implementation
         {
              effectiveHoverId = m_trimExtendTool.GetBoundaryID();
         }
-        // R-VIEW: Pass ViewSettings for Revit-like lineweight behavior
-        m_wallRenderer.Draw(session, m_camera, m_document, m_layerManager, effectiveHoverId, m_viewSettings);
+        {
+            ProfileScope scope(L"Walls update");
+            // Journal walls edited directly (undo) before the renderer keys on them
+            m_document.SyncWallEdits();
+            // R-VIEW: Pass ViewSettings for Revit-like lineweight behavior
+            m_wallRenderer.Update(m_document, m_layerManager, effectiveHoverId, m_viewSettings);
+        }
 
-        // R4: Рисуем двери и окна (поверх стен)
+        // R4: Двери и окна (поверх стен)
+        uint64_t selectedId = 0;
+        if (auto sel = m_document.GetSelectedElement())
+        {
+            selectedId = sel->GetId();
+        }
+        // Пиксельные отступы проёмов считаются при масштабе октавы плиток:
+        // план растрируется в плитки, которые живут при других зумах.
+        // Список пересобирается только при смене октавы или элементов.
+        double planScale = RasterTileCache::ScaleOf(RasterTileCache::OctaveOf(m_camera.GetZoom()));
+        uint64_t planListKey = ComputePlanListKey();
+        if (planListKey != m_planListKey || planScale != m_planListScale)
+        {
+            ProfileScope scope(L"Plan build");
+            m_planList.Clear();
+            m_openingRenderer.Build(m_planList, planScale, m_document);
+
+            // R6.1: Колонны (поверх стен)
+            StructureRenderer::BuildColumns(m_planList, m_document.GetColumns(), 0);
+
+            // R6.5: Балки (поверх стен)
+            StructureRenderer::BuildBeams(m_planList, m_document.GetBeams(), 0);
+            m_planListKey = planListKey;
+            m_planListScale = planScale;
+        }
+
+        // Выделение и наведение рисуются живьём поверх плиток
+        m_planHighlightList.Clear();
+        StructureRenderer::BuildSlabs(m_planHighlightList, m_document.GetSlabs(), 0, true);
+        m_openingRenderer.BuildHighlights(m_planHighlightList, planScale, m_document, selectedId, m_hoverOpeningId);
+        StructureRenderer::BuildColumns(m_planHighlightList, m_document.GetColumns(), 0, true);
+        StructureRenderer::BuildBeams(m_planHighlightList, m_document.GetBeams(), 0, true);
+
+        // Статичный план: подложки, перекрытия, стены, проёмы, колонны и
+        // балки. Геометрия берётся из растровых плиток кэша, пока план не
+        // изменился; надписи и маркеры рисуются поверх живьём.
+        auto drawPlan = [this](Microsoft::Graphics::Canvas::CanvasDrawingSession const& ds, Camera const& camera, DisplayPass pass)
         {
-            // Преобразуем unique_ptr стены в shared_ptr для рендерера (временный вектор)
-            std::vector<std::shared_ptr<Wall>> wallsForRender;
-            for (const auto& w : m_document.GetWalls())
             {
-                if (w) wallsForRender.push_back(std::shared_ptr<Wall>(w.get(), [](Wall*){}));
+                ProfileScope scope(L"Underlay draw");
+                m_displayListRenderer.Draw(ds, camera, m_underlayList, pass);
             }
-            
-            uint64_t selectedId = 0;
-            if (auto sel = m_document.GetSelectedElement())
             {
-                selectedId = sel->GetId();
+                ProfileScope scope(L"Slabs draw");
+                m_displayListRenderer.Draw(ds, camera, m_slabList, pass);
             }
-            
-            m_openingRenderer.DrawDoors(
-                DrawingCanvas(), session, m_camera,
-                m_document.GetDoors(), wallsForRender,
-                selectedId, m_hoverOpeningId);
-                
-            m_openingRenderer.DrawWindows(
-                DrawingCanvas(), session, m_camera,
-                m_document.GetWindows(), wallsForRender,
-                selectedId, m_hoverOpeningId);
+            {
+                ProfileScope scope(L"Walls draw");
+                m_displayListRenderer.Draw(ds, camera, m_wallRenderer.GetWallList(), pass);
+            }
+            {
+                ProfileScope scope(L"Plan draw");
+                m_displayListRenderer.Draw(ds, camera, m_planList, pass);
+            }
+        };
+
+        uint64_t contentKey = ComputePlanContentKey();
+        bool fromTiles = false;
+        {
+            ProfileScope scope(L"Tiles");
+            fromTiles = m_tileCache.Draw(session, m_camera, contentKey,
+                [&drawPlan](Microsoft::Graphics::Canvas::CanvasDrawingSession const& ds, Camera const& camera) { drawPlan(ds, camera, DisplayPass::Geometry); });
         }
+        // Надписи подложек и плана разрежаются по приоритету стиля до
+        // раскладки текста: перекрытая подпись не рисуется. Помещения и
+        // размеры на холсте пока не выводятся и в разрежении не участвуют.
+        {
+            ProfileScope scope(L"Label placement");
+            m_displayListRenderer.PlaceLabels(m_camera, { &m_underlayList, &m_planList });
+        }
+        drawPlan(session, m_camera, fromTiles ? DisplayPass::Annotations : DisplayPass::All);
 
-        // R6.1: Колонны (поверх стен)
-        StructureRenderer::DrawColumns(session, m_camera, m_document.GetColumns(), 0);
+        // Подсветка выбранных и наведённых элементов меняется с каждым движением мыши
+        {
+            ProfileScope scope(L"Highlights draw");
+            m_displayListRenderer.Draw(session, m_camera, m_planHighlightList);
+            m_displayListRenderer.Draw(session, m_camera, m_wallRenderer.GetHighlightList());
+        }
 
-        // R6.5: Балки (поверх стен)
-        StructureRenderer::DrawBeams(session, m_camera, m_document.GetBeams(), 0);
+        // Недостающие плитки дорисовываются в следующих кадрах
+        if (m_tileCache.HasPendingTiles())
+        {
+            InvalidateCanvas();
+        }
 
         // Рисуем превью стены (при активном инструменте)
         if (m_viewModel.CurrentTool() == DrawingTool::Wall)
         {
+            ProfileScope scope(L"Tool preview");
             auto layer = session.CreateLayer(0.7f);
             
             WorldPoint startPos, endPos;
@@ -565,6 +761,7 @@ namespace winrt::estimate1::implementation
         // R4: Рисуем превью двери (при активном инструменте)
         if (m_viewModel.CurrentTool() == DrawingTool::Door)
         {
+            ProfileScope scope(L"Tool preview");
             auto layer = session.CreateLayer(0.7f);
             auto hit = m_doorTool.GetPreviewHit();
             
@@ -596,6 +793,7 @@ namespace winrt::estimate1::implementation
         // R4: Рисуем превью окна (при активном инструменте)
         if (m_viewModel.CurrentTool() == DrawingTool::Window)
         {
+            ProfileScope scope(L"Tool preview");
             auto layer = session.CreateLayer(0.7f);
             auto hit = m_windowTool.GetPreviewHit();
             
@@ -627,17 +825,21 @@ namespace winrt::estimate1::implementation
         // R6: Превью колонны
         if (m_viewModel.CurrentTool() == DrawingTool::Column && m_columnTool.m_previewColumn)
         {
+             ProfileScope scope(L"Tool preview");
              auto layer = session.CreateLayer(0.7f);
              std::vector<std::shared_ptr<Column>> preview = { 
                  std::shared_ptr<Column>(m_columnTool.m_previewColumn.get(), [](Column*){})
              };
-             StructureRenderer::DrawColumns(session, m_camera, preview, 0);
+             m_previewList.Clear();
+             StructureRenderer::BuildColumns(m_previewList, preview, 0);
+             m_displayListRenderer.Draw(session, m_camera, m_previewList);
              layer.Close();
         }
 
         // R6: Превью перекрытия
         if (m_viewModel.CurrentTool() == DrawingTool::Slab)
         {
+            ProfileScope scope(L"Tool preview");
             auto layer = session.CreateLayer(0.7f);
             if (m_slabTool.IsActive())
             {
@@ -667,6 +869,7 @@ namespace winrt::estimate1::implementation
         // R6.5: Превью балки
         if (m_viewModel.CurrentTool() == DrawingTool::Beam)
         {
+            ProfileScope scope(L"Tool preview");
             auto layer = session.CreateLayer(0.7f);
             WorldPoint startPos, endPos;
             if (m_beamTool.IsDrawing())
@@ -686,7 +889,9 @@ namespace winrt::estimate1::implementation
             beam->SetWidth(m_beamTool.GetWidth());
             
             std::vector<std::shared_ptr<Beam>> preview = { beam };
-            StructureRenderer::DrawBeams(session, m_camera, preview, 0);
+            m_previewList.Clear();
+            StructureRenderer::BuildBeams(m_previewList, preview, 0);
+            m_displayListRenderer.Draw(session, m_camera, m_previewList);
             layer.Close();
         }
 
@@ -712,6 +917,13 @@ namespace winrt::estimate1::implementation
                 canvasWidth - 180.0f, 10.0f);
         }
 
+        // Оверлей профилировщика: окно последних кадров и дорогие проходы
+        if (m_showProfiler)
+        {
+            ProfileScope scope(L"Profiler overlay");
+            FrameProfilerRenderer::Draw(session, FrameProfiler::Shared(), 10.0f, 10.0f);
+        }
+
         // R-VIEW: Debug overlay for view settings (bottom-left corner)
         // Shows current view scale, zoom, and thin lines state for debugging
         #ifdef _DEBUG
@@ -1051,7 +1263,7 @@ namespace winrt::estimate1::implementation
                     swprintf_s(info, L"Помещение %ls: %ls (%.2f м²)", 
                         room->GetNumber().c_str(),
                         room->GetName().c_str(),
-                        room->GetAreaSqM());
+                        room->GetNetAreaSqM());
                     SelectedElementInfo().Text(info);
                     
                     WallPropertiesPanel().Visibility(Microsoft::UI::Xaml::Visibility::Collapsed);
@@ -1225,19 +1437,18 @@ namespace winrt::estimate1::implementation
             // M9: Hover над стенами (для инструмента Select)
             if (m_viewModel.CurrentTool() == DrawingTool::Select)
             {
+                ProfileScope scope(L"Hit test");
                 uint64_t newHoverWallId = 0;
                 uint64_t newHoverRoomId = 0;
                 double hitTolerance = 5.0 / m_camera.GetZoom();
                 
-                // Сначала проверяем стены (приоритет)
-                for (const auto& wall : m_document.GetWalls())
-                {
-                    if (wall && wall->HitTest(worldPos, hitTolerance))
-                    {
-                        newHoverWallId = wall->GetId();
-                        break;
-                    }
-                }
+                // Сначала проверяем стены (приоритет): один пакетный проход по осям
+                m_document.SyncWallEdits();
+                const WallHotData& hot = m_document.GetWallHotData();
+                std::vector<uint32_t> wallHits;
+                GeometryKernels::CollectWithin(worldPos, hot.Segments(), hot.Thickness.data(), hitTolerance, wallHits);
+                if (!wallHits.empty())
+                    newHoverWallId = hot.Ids[wallHits.front()];
                 
                 // R5.2: Если не попали в стену, проверяем помещения
                 if (newHoverWallId == 0)
@@ -1271,10 +1482,6 @@ namespace winrt::estimate1::implementation
             // Обновляем привязку и превью для инструмента стены
             if (m_viewModel.CurrentTool() == DrawingTool::Wall)
             {
-                // Ищем точку привязки (базовая)
-                m_currentSnap = m_snapManager.FindSnap(
-                    worldPos, m_document, m_layerManager, m_camera);
-
                 // M5.6: Расширенная привязка к стенам с учетом выравнивания (Alignment)
                 std::optional<WorldPoint> startPoint;
                 if (m_wallTool.GetState() != WallToolState::Idle)
@@ -1282,8 +1489,20 @@ namespace winrt::estimate1::implementation
                     startPoint = m_wallTool.GetStartPoint();
                 }
 
-                m_currentWallSnap = m_wallSnapSystem.FindBestSnap(
-                    worldPos, startPoint, m_document.GetWalls(), m_camera.GetZoom());
+                // One query: faces and alignment first, as the wall tool has
+                // always preferred them, then wall ends and crossings,
+                // midpoints, grid
+                {
+                    ProfileScope scope(L"Snap");
+                    m_document.SyncWallEdits();
+                    SnapQuery query = m_snapManager.MakeQuery(worldPos, m_document, m_layerManager, m_camera);
+                    query.StartPoint = startPoint;
+                    query.WallPlanes = true;
+                    query.Preferred = m_wallPlaneSnaps;
+                    m_currentSnap = m_snapManager.FindSnap(query);
+                    m_currentWallSnap = m_currentSnap.provider == m_wallPlaneSnaps
+                        ? m_wallPlaneSnaps->GetCandidate() : WallSnapCandidate{};
+                }
                 
                 // Обновляем индикатор режима в статусной строке
                 if (SnapIndicatorText())
@@ -1308,6 +1527,7 @@ namespace winrt::estimate1::implementation
             // R4: Обновляем превью для инструмента двери
             else if (m_viewModel.CurrentTool() == DrawingTool::Door)
             {
+                ProfileScope scope(L"Opening hit test");
                 // Преобразуем unique_ptr в shared_ptr для инструмента
                 std::vector<std::shared_ptr<Wall>> wallsForTool;
                 for (const auto& w : m_document.GetWalls())
@@ -1320,6 +1540,7 @@ namespace winrt::estimate1::implementation
             // R4: Обновляем превью для инструмента окна
             else if (m_viewModel.CurrentTool() == DrawingTool::Window)
             {
+                ProfileScope scope(L"Opening hit test");
                 std::vector<std::shared_ptr<Wall>> wallsForTool;
                 for (const auto& w : m_document.GetWalls())
                 {
@@ -1340,21 +1561,30 @@ namespace winrt::estimate1::implementation
             }
             else if (m_viewModel.CurrentTool() == DrawingTool::Column)
             {
-                m_currentSnap = m_snapManager.FindSnap(worldPos, m_document, m_layerManager, m_camera);
+                {
+                    ProfileScope scope(L"Snap");
+                    m_currentSnap = m_snapManager.FindSnap(worldPos, m_document, m_layerManager, m_camera);
+                }
                 WorldPoint pos = m_currentSnap.hasSnap ? m_currentSnap.point : worldPos;
                 m_columnTool.UpdatePreview(pos);
                 InvalidateCanvas();
             }
             else if (m_viewModel.CurrentTool() == DrawingTool::Slab)
             {
-                m_currentSnap = m_snapManager.FindSnap(worldPos, m_document, m_layerManager, m_camera);
+                {
+                    ProfileScope scope(L"Snap");
+                    m_currentSnap = m_snapManager.FindSnap(worldPos, m_document, m_layerManager, m_camera);
+                }
                 WorldPoint pos = m_currentSnap.hasSnap ? m_currentSnap.point : worldPos;
                 m_slabTool.OnMouseMove(pos);
                 InvalidateCanvas();
             }
             else if (m_viewModel.CurrentTool() == DrawingTool::Beam)
             {
-                m_currentSnap = m_snapManager.FindSnap(worldPos, m_document, m_layerManager, m_camera);
+                {
+                    ProfileScope scope(L"Snap");
+                    m_currentSnap = m_snapManager.FindSnap(worldPos, m_document, m_layerManager, m_camera);
+                }
                 WorldPoint pos = m_currentSnap.hasSnap ? m_currentSnap.point : worldPos;
                 m_beamTool.OnMouseMove(pos);
                 InvalidateCanvas();
@@ -1547,47 +1777,68 @@ namespace winrt::estimate1::implementation
             {
                 bool currentState = m_viewSettings.IsThinLinesEnabled();
                 m_viewSettings.SetThinLinesEnabled(!currentState);
-                m_wallRenderer.InvalidateCache();
                 InvalidateCanvas();
                 e.Handled(true);
             }
+            // PageUp / PageDown - уровень выше / ниже
+            else if (key == Windows::System::VirtualKey::PageUp)
+            {
+                SwitchLevel(+1);
+                e.Handled(true);
+            }
+            else if (key == Windows::System::VirtualKey::PageDown)
+            {
+                SwitchLevel(-1);
+                e.Handled(true);
+            }
             // R-VIEW: Number keys 1-5 - View Scale presets (debug/testing)
             // 1 = 1:20, 2 = 1:50, 3 = 1:100, 4 = 1:200, 5 = 1:500
             else if (key == Windows::System::VirtualKey::Number1)
             {
                 m_viewSettings.SetViewScaleDenominator(20);
-                m_wallRenderer.InvalidateCache();
                 InvalidateCanvas();
                 e.Handled(true);
             }
             else if (key == Windows::System::VirtualKey::Number2)
             {
                 m_viewSettings.SetViewScaleDenominator(50);
-                m_wallRenderer.InvalidateCache();
                 InvalidateCanvas();
                 e.Handled(true);
             }
             else if (key == Windows::System::VirtualKey::Number3)
             {
                 m_viewSettings.SetViewScaleDenominator(100);
-                m_wallRenderer.InvalidateCache();
                 InvalidateCanvas();
                 e.Handled(true);
             }
             else if (key == Windows::System::VirtualKey::Number4)
             {
                 m_viewSettings.SetViewScaleDenominator(200);
-                m_wallRenderer.InvalidateCache();
                 InvalidateCanvas();
                 e.Handled(true);
             }
             else if (key == Windows::System::VirtualKey::Number5)
             {
                 m_viewSettings.SetViewScaleDenominator(500);
-                m_wallRenderer.InvalidateCache();
                 InvalidateCanvas();
                 e.Handled(true);
             }
+            // F3 - оверлей профилировщика кадров (включает запись)
+            else if (key == Windows::System::VirtualKey::F3)
+            {
+                m_showProfiler = !m_showProfiler;
+                FrameProfiler::Shared().SetEnabled(m_showProfiler);
+                if (m_showProfiler)
+                    FrameProfiler::Shared().Clear();
+                InvalidateCanvas();
+                e.Handled(true);
+            }
+            // F4 - экспорт записанных кадров в Chrome trace JSON
+            else if (key == Windows::System::VirtualKey::F4)
+            {
+                ExportFrameTraceAsync();
+                e.Handled(true);
+            }
         }
 
         // ============================================================================
@@ -2244,6 +2495,7 @@ namespace winrt::estimate1::implementation
         // Сбрасываем выделение
         m_document.ClearSelection();
         UpdateSelectedElementUI();
+        UpdateLevelUI();
         
         // Обновляем состояние
         m_viewModel.HasUnsavedChanges(false);
@@ -2466,6 +2718,7 @@ namespace winrt::estimate1::implementation
             RebuildWallTypeCombo();
             SyncLayerCheckboxes();
             UpdateSelectedElementUI();
+            UpdateLevelUI();
             InvalidateCanvas();
         }
         else
@@ -2774,6 +3027,9 @@ namespace winrt::estimate1::implementation
 
         // Обновляем UI после закрытия
         RebuildWallTypeCombo();
+        // Слои типов правятся на месте, ревизии стен не меняются:
+        // сбрасываем кэш геометрии стен (и вместе с ним плитки плана)
+        m_wallRenderer.InvalidateCache();
         m_viewModel.HasUnsavedChanges(true);
         InvalidateCanvas();
     }
@@ -3094,7 +3350,7 @@ namespace winrt::estimate1::implementation
         settings.IncludeNew = true;
         settings.GroupByWallType = true;
 
-        EstimationResult result = engine.Calculate(m_document, settings);
+        EstimationResult result = engine.CalculateProject(m_document.CreateAllLevelSnapshots(), settings);
         result.ProjectName = m_projectMetadata.Name;
 
         // Проверяем наличие данных
@@ -3160,10 +3416,6 @@ namespace winrt::estimate1::implementation
         settings.GroupByWallType = groupByTypeCheck.IsChecked().Value();
         settings.GroupByMaterial = groupByMaterialCheck.IsChecked().Value();
 
-        // Пересчитываем с новыми настройками
-        result = engine.Calculate(m_document, settings);
-        result.ProjectName = m_projectMetadata.Name;
-
         // Получаем HWND
         HWND hwnd{ nullptr };
         auto windowNative = this->try_as<IWindowNative>();
@@ -3188,9 +3440,19 @@ namespace winrt::estimate1::implementation
 
         std::wstring filePath = file.Path().c_str();
 
-        // Экспорт
+        // Пересчёт с новыми настройками и экспорт в фоне по снимку документа;
+        // UI продолжает работать, пока пишется файл
+        auto snapshots = m_document.CreateAllLevelSnapshots();
+        auto projectName = m_projectMetadata.Name;
+        winrt::apartment_context uiThread;
+        co_await winrt::resume_background();
+
+        result = engine.CalculateProject(snapshots, settings);
+        result.ProjectName = projectName;
         bool success = ExcelExporter::Export(result, filePath);
 
+        co_await uiThread;
+
         // Результат
         ContentDialog resultDialog;
         resultDialog.XamlRoot(xamlRoot);
@@ -3222,7 +3484,7 @@ namespace winrt::estimate1::implementation
             // Расчёт сметы
             EstimationEngine engine;
             EstimationSettings settings;
-            EstimationResult result = engine.Calculate(m_document, settings);
+            EstimationResult result = engine.CalculateProject(m_document.CreateAllLevelSnapshots(), settings);
             result.ProjectName = m_projectMetadata.Name;
 
             if (result.Items.empty())
@@ -3296,7 +3558,7 @@ namespace winrt::estimate1::implementation
             // Расчёт сметы
             EstimationEngine engine;
             EstimationSettings settings;
-            EstimationResult result = engine.Calculate(m_document, settings);
+            EstimationResult result = engine.CalculateProject(m_document.CreateAllLevelSnapshots(), settings);
 
             // Форматируем сводку
             std::wstring summary = EstimationFormatter::FormatSummary(result);
@@ -3519,9 +3781,15 @@ namespace winrt::estimate1::implementation
             }
         }
 
-        // Экспорт
+        // Экспорт в фоне по снимку документа
+        auto snapshot = m_document.CreateSnapshot();
+        winrt::apartment_context uiThread;
+        co_await winrt::resume_background();
+
         PlanPdfExporter exporter;
-        bool success = exporter.Export(m_document, exportDimensions, settings, filePath);
+        bool success = exporter.Export(*snapshot, exportDimensions, settings, filePath);
+
+        co_await uiThread;
 
         // Результат
         ContentDialog resultDialog;
@@ -3542,6 +3810,58 @@ namespace winrt::estimate1::implementation
         co_await resultDialog.ShowAsync();
     }
 
+    // =========================================================================
+    // Профилировщик кадров: экспорт трассы
+    // =========================================================================
+
+    winrt::Windows::Foundation::IAsyncAction MainWindow::ExportFrameTraceAsync()
+    {
+        auto xamlRoot = Content().XamlRoot();
+        if (!xamlRoot) co_return;
+
+        if (FrameProfiler::Shared().GetEventCount() == 0)
+        {
+            ContentDialog emptyDialog;
+            emptyDialog.XamlRoot(xamlRoot);
+            emptyDialog.Title(winrt::box_value(L"Трасса пуста"));
+            emptyDialog.Content(winrt::box_value(L"Включите профилировщик (F3) и подвигайте план."));
+            emptyDialog.CloseButtonText(L"OK");
+            co_await emptyDialog.ShowAsync();
+            co_return;
+        }
+
+        // Получаем HWND
+        HWND hwnd{ nullptr };
+        auto windowNative = this->try_as<IWindowNative>();
+        if (windowNative)
+        {
+            windowNative->get_WindowHandle(&hwnd);
+        }
+
+        Windows::Storage::Pickers::FileSavePicker picker;
+        if (hwnd)
+        {
+            auto init = picker.as<IInitializeWithWindow>();
+            if (init) init->Initialize(hwnd);
+        }
+        picker.SuggestedStartLocation(Windows::Storage::Pickers::PickerLocationId::DocumentsLibrary);
+        picker.SuggestedFileName(L"frames");
+        picker.FileTypeChoices().Insert(L"Chrome trace JSON", winrt::single_threaded_vector<winrt::hstring>({ L".json" }));
+
+        auto file = co_await picker.PickSaveFileAsync();
+        if (!file) co_return;
+
+        if (!FrameProfiler::Shared().SaveChromeTrace(file.Path().c_str()))
+        {
+            ContentDialog errorDialog;
+            errorDialog.XamlRoot(xamlRoot);
+            errorDialog.Title(winrt::box_value(L"Ошибка экспорта"));
+            errorDialog.Content(winrt::box_value(L"Не удалось создать файл."));
+            errorDialog.CloseButtonText(L"OK");
+            co_await errorDialog.ShowAsync();
+        }
+    }
+
     // =========================================================================
     // M9.5: Тесты
     // =========================================================================
@@ -3550,45 +3870,51 @@ namespace winrt::estimate1::implementation
         [[maybe_unused]] Windows::Foundation::IInspectable const& sender,
         [[maybe_unused]] Microsoft::UI::Xaml::RoutedEventArgs const& e)
     {
-        // Запускаем тесты
+        RunTestsAsync();
+    }
+
+    winrt::Windows::Foundation::IAsyncAction MainWindow::RunTestsAsync()
+    {
+        auto xamlRoot = Content().XamlRoot();
+        if (!xamlRoot) co_return;
+
+        // Тесты быстрые и проверяют распределитель Id окна - в UI-потоке.
+        // Бенчмарки на больших планах идут секундами - в фоне, окно не замирает.
         auto results = tests::RunAllTests();
-        
+
+        winrt::apartment_context uiThread;
+        co_await winrt::resume_background();
+        auto benchResults = benchmarks::RunAllBenchmarks();
+        co_await uiThread;
+
         // Показываем результаты в диалоге
-        auto showAsync = [this, results]() -> winrt::Windows::Foundation::IAsyncAction
-        {
-            auto xamlRoot = Content().XamlRoot();
-            if (!xamlRoot) co_return;
+        TextBlock resultsText;
+        resultsText.Text(winrt::hstring(results.GetSummary() + L"\n" + benchResults.GetSummary()));
+        resultsText.FontFamily(Microsoft::UI::Xaml::Media::FontFamily(L"Consolas"));
+        resultsText.FontSize(12);
+        resultsText.IsTextSelectionEnabled(true);
 
-            // Создаём текстовый блок с результатами
-            TextBlock resultsText;
-            resultsText.Text(winrt::hstring(results.GetSummary()));
-            resultsText.FontFamily(Microsoft::UI::Xaml::Media::FontFamily(L"Consolas"));
-            resultsText.FontSize(12);
-            resultsText.IsTextSelectionEnabled(true);
+        ScrollViewer scrollViewer;
+        scrollViewer.Content(resultsText);
+        scrollViewer.MaxHeight(400);
+        scrollViewer.HorizontalScrollBarVisibility(Microsoft::UI::Xaml::Controls::ScrollBarVisibility::Auto);
 
-            ScrollViewer scrollViewer;
-            scrollViewer.Content(resultsText);
-            scrollViewer.MaxHeight(400);
-            scrollViewer.HorizontalScrollBarVisibility(Microsoft::UI::Xaml::Controls::ScrollBarVisibility::Auto);
+        ContentDialog dialog;
+        dialog.XamlRoot(xamlRoot);
 
-            ContentDialog dialog;
-            dialog.XamlRoot(xamlRoot);
-            
-            if (results.TotalFailed == 0)
-            {
-                dialog.Title(winrt::box_value(L"? Все тесты пройдены"));
-            }
-            else
-            {
-                dialog.Title(winrt::box_value(L"? Есть ошибки в тестах"));
-            }
-            
-            dialog.Content(scrollViewer);
-            dialog.CloseButtonText(L"Закрыть");
+        if (results.TotalFailed == 0)
+        {
+            dialog.Title(winrt::box_value(L"? Все тесты пройдены"));
+        }
+        else
+        {
+            dialog.Title(winrt::box_value(L"? Есть ошибки в тестах"));
+        }
 
-            co_await dialog.ShowAsync();
-        };
-        showAsync();
+        dialog.Content(scrollViewer);
+        dialog.CloseButtonText(L"Закрыть");
+
+        co_await dialog.ShowAsync();
     }
 
     void MainWindow::OnAboutClick(
@@ -3692,9 +4018,6 @@ namespace winrt::estimate1::implementation
         // Update the toggle button visual state if it exists
         // (The XAML binding will handle this if using a ToggleButton)
 
-        // Invalidate geometry cache since line weights changed
-        m_wallRenderer.InvalidateCache();
-
         // Redraw
         InvalidateCanvas();
     }
@@ -3727,9 +4050,6 @@ namespace winrt::estimate1::implementation
 
         m_viewSettings.SetViewScaleDenominator(viewScaleDenom);
 
-        // Invalidate geometry cache since line weights changed
-        m_wallRenderer.InvalidateCache();
-
         // Redraw
         InvalidateCanvas();
     }
@@ -7,12 +7,17 @@
 #include "Layer.h"
 #include "Element.h"
 #include "WallRenderer.h"
+#include "DisplayListRenderer.h"
+#include "RasterTileCache.h"
+#include "FrameProfiler.h"
+#include "FrameProfilerRenderer.h"
 #include "ViewSettings.h"
 #include "DrawingTools.h"
 #include "DxfReference.h"
 #include "DxfReferenceRenderer.h"
 #include "IfcReference.h"
 #include "IfcReferenceRenderer.h"
+#include "ReferenceSnapProvider.h"
 #include "WallSnapSystem.h"
 #include "WallSnapRenderer.h"
 #include "ProjectSerializer.h"
@@ -22,6 +27,7 @@
 #include "ExcelExporter.h"
 #include "PdfExporter.h"
 #include "Tests.h"
+#include "Benchmarks.h"
 #include "OpeningRenderer.h"
 #include "OpeningTools.h"
 #include "EditTools.h"
@@ -126,6 +132,10 @@ namespace winrt::estimate1::implementation
 
             void UpdateScaleUI();
 
+            // Levels: PageUp / PageDown move between storeys
+            void SwitchLevel(int direction);
+            void UpdateLevelUI();
+
             // R-VIEW: Thin Lines toggle (Revit-like)
             void OnThinLinesToggleClick(
                 Windows::Foundation::IInspectable const& sender,
@@ -220,6 +230,8 @@ namespace winrt::estimate1::implementation
                 Windows::Foundation::IInspectable const& sender,
                 Microsoft::UI::Xaml::RoutedEventArgs const& e);
 
+            winrt::Windows::Foundation::IAsyncAction RunTestsAsync();
+
             void OnAboutClick(
                 Windows::Foundation::IInspectable const& sender,
                 Microsoft::UI::Xaml::RoutedEventArgs const& e);
@@ -240,6 +252,13 @@ namespace winrt::estimate1::implementation
         // ����������� ������
         void InvalidateCanvas();
 
+        // What the cached plan tiles depend on besides the camera
+        uint64_t ComputePlanContentKey() const;
+        // What the slab and plan lists are built from, zoom aside; they
+        // are rebuilt only when these change
+        uint64_t ComputeSlabListKey() const;
+        uint64_t ComputePlanListKey() const;
+
         // ���������� ��������� ���� ��� ����� ����
         void UpdateLayerVisibility();
 
@@ -274,9 +293,33 @@ namespace winrt::estimate1::implementation
         // ������ ���������
         DocumentModel m_document;
 
+        // Elements created on the UI thread (tools, dialogs) take ids from the document
+        IdAllocatorScope m_idScope{ m_document.GetIdAllocator() };
+
         // �������� ����
         WallRenderer m_wallRenderer;
 
+        // Display lists and their Win2D backend. The underlay, slab and
+        // plan lists are rebuilt only when what they show changes, so the
+        // backend keeps their geometry and command index between frames;
+        // the highlight and preview lists are rebuilt each frame.
+        DisplayList m_underlayList;
+        uint64_t m_underlayRevision{ ~0ull };
+        DisplayList m_slabList;
+        uint64_t m_slabListKey{ ~0ull };
+        DisplayList m_planList;
+        uint64_t m_planListKey{ ~0ull };
+        double m_planListScale{ 0.0 };          // tile octave scale of the opening insets
+        DisplayList m_planHighlightList;        // selected and hovered openings and structure, drawn live
+        DisplayList m_previewList;
+        DisplayListRenderer m_displayListRenderer;
+
+        // Static plan content as tiles, composited while panning and zooming
+        RasterTileCache m_tileCache;
+
+        // Frame profiler overlay (F3); F4 exports the trace
+        bool m_showProfiler{ false };
+
         // �����������
         WallTool m_wallTool;
         SelectTool m_selectTool;
@@ -317,6 +360,7 @@ namespace winrt::estimate1::implementation
             // M5.6: ������� �������� ����
             WallSnapSystem m_wallSnapSystem;
             WallSnapCandidate m_currentWallSnap;
+            WallPlaneSnapProvider* m_wallPlaneSnaps{ nullptr };    // owned by m_snapManager
 
             // R-WALL: ������� ����� �������� ����
             WallAttachmentMode m_currentAttachmentMode{ WallAttachmentMode::Core };
@@ -347,6 +391,7 @@ namespace winrt::estimate1::implementation
             winrt::Windows::Foundation::IAsyncAction SaveProjectAsync(bool saveAs);
             winrt::Windows::Foundation::IAsyncAction OpenProjectAsync();
             winrt::Windows::Foundation::IAsyncAction ConfirmNewProjectAsync();
+            winrt::Windows::Foundation::IAsyncAction ExportFrameTraceAsync();
         };
 }
 
@@ -2,23 +2,194 @@
 
 #include "pch.h"
 #include "Camera.h"
+#include "GeometryKernels.h"
 #include "Layer.h"
 #include "WallType.h"
 #include <vector>
 #include <memory>
 #include <algorithm>
 #include <cmath>
+#include <atomic>
+#include <unordered_map>
+#include <unordered_set>
 
 namespace winrt::estimate1
 {
+    // Contiguous range of ids reserved by a worker thread.
+    // Consumed without synchronization by the thread that owns it.
+    struct IdBlock
+    {
+        uint64_t First{ 0 };
+        uint64_t Count{ 0 };
+        uint64_t Used{ 0 };
+
+        bool IsExhausted() const { return Used >= Count; }
+        uint64_t Remaining() const { return Count - Used; }
+        uint64_t Next() { return First + Used++; }
+    };
+
+    // Thread-safe id source. Each DocumentModel owns one; worker threads
+    // reserve blocks so parallel builders do not contend on the counter.
+    class IdAllocator
+    {
+    public:
+        IdAllocator() = default;
+        IdAllocator(const IdAllocator&) = delete;
+        IdAllocator& operator=(const IdAllocator&) = delete;
+
+        uint64_t Next()
+        {
+            return m_last.fetch_add(1, std::memory_order_relaxed) + 1;
+        }
+
+        IdBlock ReserveBlock(uint64_t count)
+        {
+            IdBlock block;
+            block.First = m_last.fetch_add(count, std::memory_order_relaxed) + 1;
+            block.Count = count;
+            return block;
+        }
+
+        // Guarantee that future ids are greater than id
+        void EnsureAbove(uint64_t id)
+        {
+            uint64_t last = m_last.load(std::memory_order_relaxed);
+            while (last < id && !m_last.compare_exchange_weak(last, id, std::memory_order_relaxed))
+            {
+            }
+        }
+
+        uint64_t GetLast() const { return m_last.load(std::memory_order_relaxed); }
+
+    private:
+        std::atomic<uint64_t> m_last{ 0 };
+    };
+
+    // Entry point used by element constructors. The id comes from, in order:
+    // the block bound to this thread, the allocator bound to this thread,
+    // or the process-wide default allocator.
     class IdGenerator
     {
     public:
         static uint64_t Next()
         {
-            static uint64_t counter = 0;
-            return ++counter;
+            if (t_block && !t_block->IsExhausted())
+                return t_block->Next();
+            return Current().Next();
         }
+
+        static IdAllocator& Current() { return t_allocator ? *t_allocator : Default(); }
+
+        static IdAllocator& Default()
+        {
+            static IdAllocator allocator;
+            return allocator;
+        }
+
+    private:
+        friend class IdAllocatorScope;
+        friend class IdBlockScope;
+
+        static inline thread_local IdAllocator* t_allocator{ nullptr };
+        static inline thread_local IdBlock* t_block{ nullptr };
+    };
+
+    // Binds an allocator to the current thread for the lifetime of the scope
+    class IdAllocatorScope
+    {
+    public:
+        explicit IdAllocatorScope(IdAllocator& allocator)
+            : m_previous(IdGenerator::t_allocator)
+        {
+            IdGenerator::t_allocator = &allocator;
+        }
+
+        ~IdAllocatorScope() { IdGenerator::t_allocator = m_previous; }
+
+        IdAllocatorScope(const IdAllocatorScope&) = delete;
+        IdAllocatorScope& operator=(const IdAllocatorScope&) = delete;
+
+    private:
+        IdAllocator* m_previous;
+    };
+
+    // Binds a reserved block to the current thread (worker-side builders).
+    // When the block runs out, ids fall back to the bound allocator.
+    class IdBlockScope
+    {
+    public:
+        explicit IdBlockScope(IdBlock& block)
+            : m_previous(IdGenerator::t_block)
+        {
+            IdGenerator::t_block = &block;
+        }
+
+        ~IdBlockScope() { IdGenerator::t_block = m_previous; }
+
+        IdBlockScope(const IdBlockScope&) = delete;
+        IdBlockScope& operator=(const IdBlockScope&) = delete;
+
+    private:
+        IdBlock* m_previous;
+    };
+
+    // Maps ids from a file or clipboard to ids allocated in the target document.
+    // Reserve() hands out one contiguous block in ascending order of the old ids,
+    // so the same input always produces the same mapping and relative order.
+    class IdRemapper
+    {
+    public:
+        void Reserve(IdAllocator& allocator, std::vector<uint64_t> oldIds)
+        {
+            std::sort(oldIds.begin(), oldIds.end());
+            oldIds.erase(std::unique(oldIds.begin(), oldIds.end()), oldIds.end());
+            oldIds.erase(std::remove_if(oldIds.begin(), oldIds.end(),
+                [this](uint64_t id) { return id == 0 || m_map.count(id) != 0; }), oldIds.end());
+
+            IdBlock block = allocator.ReserveBlock(oldIds.size());
+            for (uint64_t oldId : oldIds)
+                m_map[oldId] = block.Next();
+        }
+
+        // Record that an element loaded with oldId was created as newId
+        void Assign(uint64_t oldId, uint64_t newId)
+        {
+            if (oldId != 0)
+                m_map[oldId] = newId;
+        }
+
+        // New id for oldId, or 0 when the id is unknown
+        uint64_t Map(uint64_t oldId) const
+        {
+            auto it = m_map.find(oldId);
+            return it != m_map.end() ? it->second : 0;
+        }
+
+        // One-id block for creating the element that replaces oldId
+        // under an IdBlockScope; empty when oldId was not reserved
+        IdBlock BlockFor(uint64_t oldId) const
+        {
+            IdBlock block;
+            block.First = Map(oldId);
+            block.Count = block.First != 0 ? 1 : 0;
+            return block;
+        }
+
+        // BlockFor() the first time oldId is claimed during this load; empty
+        // on any repeat, so a duplicated id - within one list or across
+        // levels - gets a fresh id instead of a second copy of the mapped one
+        IdBlock ClaimBlock(uint64_t oldId)
+        {
+            return m_claimed.insert(oldId).second ? BlockFor(oldId) : IdBlock{};
+        }
+
+        bool Contains(uint64_t oldId) const { return m_map.count(oldId) != 0; }
+        size_t Size() const { return m_map.size(); }
+        void Clear() { m_map.clear(); m_claimed.clear(); }
+
+    private:
+        std::unordered_map<uint64_t, uint64_t> m_map;
+        std::unordered_set<uint64_t> m_claimed;
     };
 
     class Element
@@ -34,10 +205,14 @@ namespace winrt::estimate1
         uint64_t GetId() const { return m_id; }
 
         std::wstring GetName() const { return m_name; }
-        void SetName(const std::wstring& name) { m_name = name; }
+        void SetName(const std::wstring& name) { m_name = name; Touch(); }
 
         WorkStateNative GetWorkState() const { return m_workState; }
-        void SetWorkState(WorkStateNative state) { m_workState = state; }
+        void SetWorkState(WorkStateNative state) { m_workState = state; Touch(); }
+
+        // Incremented by setters of persistent properties (not selection).
+        // Snapshots reuse their copy of an element while it is unchanged.
+        uint64_t GetRevision() const { return m_revision; }
 
         bool IsSelected() const { return m_isSelected; }
         void SetSelected(bool selected) { m_isSelected = selected; }
@@ -47,10 +222,13 @@ namespace winrt::estimate1
         virtual void GetBounds(WorldPoint& minPoint, WorldPoint& maxPoint) const = 0;
 
     protected:
+        void Touch() { ++m_revision; }
+
         uint64_t m_id;
         std::wstring m_name{ L"" };
         WorkStateNative m_workState{ WorkStateNative::Existing };
         bool m_isSelected{ false };
+        uint64_t m_revision{ 0 };
     };
 
     enum class LocationLineMode
@@ -85,16 +263,17 @@ namespace winrt::estimate1
         }
 
         WorldPoint GetStartPoint() const { return m_startPoint; }
-        void SetStartPoint(const WorldPoint& point) { m_startPoint = point; }
+        void SetStartPoint(const WorldPoint& point) { m_startPoint = point; ++m_geometryRevision; }
 
         WorldPoint GetEndPoint() const { return m_endPoint; }
-        void SetEndPoint(const WorldPoint& point) { m_endPoint = point; }
+        void SetEndPoint(const WorldPoint& point) { m_endPoint = point; ++m_geometryRevision; }
 
         double GetThickness() const { return m_thickness; }
         void SetThickness(double thickness)
         {
             m_thickness = std::clamp(thickness, 50.0, 1000.0);
             m_type = nullptr;
+            ++m_geometryRevision;
         }
 
         std::shared_ptr<WallType> GetType() const { return m_type; }
@@ -102,12 +281,14 @@ namespace winrt::estimate1
         {
             m_type = std::move(type);
             SyncThicknessFromType();
+            ++m_geometryRevision;
         }
 
         // �������� ����� �� ���� (��� ��������� �������)
         void ClearType()
         {
             m_type = nullptr;
+            ++m_geometryRevision;
         }
 
         void SyncThicknessFromType()
@@ -121,16 +302,20 @@ namespace winrt::estimate1
         }
 
         double GetHeight() const { return m_height; }
-        void SetHeight(double height) { m_height = height; }
+        void SetHeight(double height) { m_height = height; ++m_geometryRevision; }
 
         LocationLineMode GetLocationLineMode() const { return m_locationLineMode; }
-        void SetLocationLineMode(LocationLineMode mode) { m_locationLineMode = mode; }
+        void SetLocationLineMode(LocationLineMode mode) { m_locationLineMode = mode; ++m_geometryRevision; }
 
         bool IsJoinAllowedAtStart() const { return m_allowJoinStart; }
-        void SetJoinAllowedAtStart(bool allow) { m_allowJoinStart = allow; }
+        void SetJoinAllowedAtStart(bool allow) { m_allowJoinStart = allow; ++m_geometryRevision; }
 
         bool IsJoinAllowedAtEnd() const { return m_allowJoinEnd; }
-        void SetJoinAllowedAtEnd(bool allow) { m_allowJoinEnd = allow; }
+        void SetJoinAllowedAtEnd(bool allow) { m_allowJoinEnd = allow; ++m_geometryRevision; }
+
+        // Incremented by every setter that changes geometry or joins.
+        // WallStore compares it to keep its hot arrays in sync.
+        uint64_t GetGeometryRevision() const { return m_geometryRevision; }
 
         double GetLength() const { return m_startPoint.Distance(m_endPoint); }
         double GetArea() const { return GetLength() * m_height; }
@@ -159,9 +344,9 @@ namespace winrt::estimate1
             return WorldPoint(-dir.Y, dir.X);
         }
 
-        void GetCornerPoints(WorldPoint& p1, WorldPoint& p2, WorldPoint& p3, WorldPoint& p4) const
+        // Shift of the wall body centre from the axis along GetPerpendicular()
+        double GetLocationLineOffset() const
         {
-            WorldPoint perp = GetPerpendicular();
             double halfThickness = m_thickness / 2.0;
 
             double coreThickness = m_type ? m_type->GetCoreThickness() : m_thickness;
@@ -190,6 +375,23 @@ namespace winrt::estimate1
                 offset = -(coreThickness / 2.0 + finishThickness);
                 break;
             }
+            return offset;
+        }
+
+        // Signed distances of the two wall faces from the axis along
+        // GetPerpendicular(): left face first, right face second
+        void GetFaceOffsets(double& left, double& right) const
+        {
+            double offset = GetLocationLineOffset();
+            left = offset + m_thickness / 2.0;
+            right = offset - m_thickness / 2.0;
+        }
+
+        void GetCornerPoints(WorldPoint& p1, WorldPoint& p2, WorldPoint& p3, WorldPoint& p4) const
+        {
+            WorldPoint perp = GetPerpendicular();
+            double halfThickness = m_thickness / 2.0;
+            double offset = GetLocationLineOffset();
 
             WorldPoint startOffset(m_startPoint.X + perp.X * offset, m_startPoint.Y + perp.Y * offset);
             WorldPoint endOffset(m_endPoint.X + perp.X * offset, m_endPoint.Y + perp.Y * offset);
@@ -222,18 +424,7 @@ namespace winrt::estimate1
     private:
         double DistanceToSegment(const WorldPoint& point) const
         {
-            double dx = m_endPoint.X - m_startPoint.X;
-            double dy = m_endPoint.Y - m_startPoint.Y;
-            double lengthSq = dx * dx + dy * dy;
-
-            if (lengthSq < 0.0001)
-                return point.Distance(m_startPoint);
-
-            double t = ((point.X - m_startPoint.X) * dx + (point.Y - m_startPoint.Y) * dy) / lengthSq;
-            t = std::clamp(t, 0.0, 1.0);
-
-            WorldPoint closest(m_startPoint.X + t * dx, m_startPoint.Y + t * dy);
-            return point.Distance(closest);
+            return GeometryKernels::DistancePointToSegment(point, m_startPoint, m_endPoint);
         }
 
         WorldPoint m_startPoint{ 0, 0 };
@@ -244,5 +435,6 @@ namespace winrt::estimate1
         LocationLineMode m_locationLineMode{ LocationLineMode::WallCenterline };
         bool m_allowJoinStart{ true };
         bool m_allowJoinEnd{ true };
+        uint64_t m_geometryRevision{ 0 };
     };
 }
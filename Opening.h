@@ -41,28 +41,28 @@ namespace winrt::estimate1
 
         // ID -
         uint64_t GetHostWallId() const { return m_hostWallId; }
-        void SetHostWallId(uint64_t id) { m_hostWallId = id; }
+        void SetHostWallId(uint64_t id) { m_hostWallId = id; Touch(); }
 
         //    (0.0 = , 1.0 = )
         double GetPositionOnWall() const { return m_positionOnWall; }
-        void SetPositionOnWall(double pos) { m_positionOnWall = std::clamp(pos, 0.0, 1.0); }
+        void SetPositionOnWall(double pos) { m_positionOnWall = std::clamp(pos, 0.0, 1.0); Touch(); }
 
         //   ()
         double GetWidth() const { return m_width; }
-        void SetWidth(double w) { m_width = (std::max)(100.0, w); }
+        void SetWidth(double w) { m_width = (std::max)(100.0, w); Touch(); }
 
         //   ()
         double GetHeight() const { return m_height; }
-        void SetHeight(double h) { m_height = (std::max)(100.0, h); }
+        void SetHeight(double h) { m_height = (std::max)(100.0, h); Touch(); }
 
         //    ()     
         double GetSillHeight() const { return m_sillHeight; }
-        void SetSillHeight(double h) { m_sillHeight = (std::max)(0.0, h); }
+        void SetSillHeight(double h) { m_sillHeight = (std::max)(0.0, h); Touch(); }
 
         //  ()
         bool IsFlipped() const { return m_flipped; }
-        void SetFlipped(bool f) { m_flipped = f; }
-        void ToggleFlip() { m_flipped = !m_flipped; }
+        void SetFlipped(bool f) { m_flipped = f; Touch(); }
+        void ToggleFlip() { m_flipped = !m_flipped; Touch(); }
 
         //     
         WorldPoint GetCenterPoint(const Wall& hostWall) const
@@ -142,15 +142,15 @@ namespace winrt::estimate1
 
         //  
         DoorSwingType GetSwingType() const { return m_swingType; }
-        void SetSwingType(DoorSwingType type) { m_swingType = type; }
+        void SetSwingType(DoorSwingType type) { m_swingType = type; Touch(); }
 
         //   ( )
         double GetSwingAngle() const { return m_swingAngle; }
-        void SetSwingAngle(double angle) { m_swingAngle = std::clamp(angle, 0.0, 180.0); }
+        void SetSwingAngle(double angle) { m_swingAngle = std::clamp(angle, 0.0, 180.0); Touch(); }
 
         //   ()
         double GetLeafThickness() const { return m_leafThickness; }
-        void SetLeafThickness(double t) { m_leafThickness = t; }
+        void SetLeafThickness(double t) { m_leafThickness = t; Touch(); }
 
         // : ?
         bool IsDouble() const
@@ -194,6 +194,7 @@ namespace winrt::estimate1
         //    hit test
         void UpdateCachedPosition(const Wall& hostWall)
         {
+            Touch();
             m_cachedCenter = GetCenterPoint(hostWall);
         }
 
@@ -235,15 +236,15 @@ namespace winrt::estimate1
 
         //  
         WindowType GetWindowType() const { return m_windowType; }
-        void SetWindowType(WindowType type) { m_windowType = type; }
+        void SetWindowType(WindowType type) { m_windowType = type; Touch(); }
 
         //   ()
         double GetFrameDepth() const { return m_frameDepth; }
-        void SetFrameDepth(double d) { m_frameDepth = d; }
+        void SetFrameDepth(double d) { m_frameDepth = d; Touch(); }
 
         //   ()
         double GetFrameWidth() const { return m_frameWidth; }
-        void SetFrameWidth(double w) { m_frameWidth = w; }
+        void SetFrameWidth(double w) { m_frameWidth = w; Touch(); }
 
         //  
         int GetPaneCount() const
@@ -285,6 +286,7 @@ namespace winrt::estimate1
         //    hit test
         void UpdateCachedPosition(const Wall& hostWall)
         {
+            Touch();
             m_cachedCenter = GetCenterPoint(hostWall);
         }
 
@@ -3,6 +3,9 @@
 #include "pch.h"
 #include "Opening.h"
 #include "Camera.h"
+#include "Element.h"
+#include "DisplayList.h"
+#include <array>
 
 namespace winrt::estimate1
 {
@@ -15,212 +18,117 @@ namespace winrt::estimate1
     public:
         OpeningRenderer() = default;
 
-        //   
-        void DrawDoors(
-            Microsoft::Graphics::Canvas::UI::Xaml::CanvasControl const& canvas,
-            Microsoft::Graphics::Canvas::CanvasDrawingSession const& ds,
-            Camera& camera,
-            const std::vector<std::shared_ptr<Door>>& doors,
-            const std::vector<std::shared_ptr<Wall>>& walls,
-            uint64_t selectedId = 0,
-            uint64_t hoverId = 0)
+        //        , 
+        //   .    (, 
+        //  )      scale (./):
+        //     ,    
+        // ,     .
+        void Build(
+            DisplayList& list,
+            double scale,
+            const DocumentModel& document)
         {
-            for (const auto& door : doors)
-            {
-                //  -
-                Wall* hostWall = nullptr;
-                for (const auto& wall : walls)
-                {
-                    if (wall->GetId() == door->GetHostWallId())
-                    {
-                        hostWall = wall.get();
-                        break;
-                    }
-                }
-
-                if (hostWall)
-                {
-                    bool isSelected = (door->GetId() == selectedId);
-                    bool isHovered = (door->GetId() == hoverId);
-                    DrawDoor(ds, camera, *door, *hostWall, isSelected, isHovered);
-                }
-            }
+            BuildOpenings(list, scale, document, 0, 0, false);
         }
 
-        //   
-        void DrawWindows(
-            Microsoft::Graphics::Canvas::UI::Xaml::CanvasControl const& canvas,
-            Microsoft::Graphics::Canvas::CanvasDrawingSession const& ds,
-            Camera& camera,
-            const std::vector<std::shared_ptr<Window>>& windows,
-            const std::vector<std::shared_ptr<Wall>>& walls,
-            uint64_t selectedId = 0,
-            uint64_t hoverId = 0)
+        //      :  ,
+        //      
+        void BuildHighlights(
+            DisplayList& list,
+            double scale,
+            const DocumentModel& document,
+            uint64_t selectedId,
+            uint64_t hoverId)
         {
-            for (const auto& window : windows)
-            {
-                //  -
-                Wall* hostWall = nullptr;
-                for (const auto& wall : walls)
-                {
-                    if (wall->GetId() == window->GetHostWallId())
-                    {
-                        hostWall = wall.get();
-                        break;
-                    }
-                }
-
-                if (hostWall)
-                {
-                    bool isSelected = (window->GetId() == selectedId);
-                    bool isHovered = (window->GetId() == hoverId);
-                    DrawWindow(ds, camera, *window, *hostWall, isSelected, isHovered);
-                }
-            }
+            if (selectedId != 0 || hoverId != 0)
+                BuildOpenings(list, scale, document, selectedId, hoverId, true);
         }
 
-        //   
-        void DrawDoor(
-            Microsoft::Graphics::Canvas::CanvasDrawingSession const& ds,
-            Camera& camera,
+        //  ; pixel -    
+        void BuildDoor(
+            DisplayList& list,
+            double pixel,
             const Door& door,
             const Wall& hostWall,
             bool isSelected = false,
             bool isHovered = false)
         {
             using namespace Windows::UI;
-            using namespace Microsoft::Graphics::Canvas::Geometry;
 
             //    
-            WorldPoint center = door.GetCenterPoint(hostWall);
-            WorldPoint dir = door.GetWallDirection(hostWall);
-            WorldPoint normal = door.GetWallNormal(hostWall);
+            OpeningFrame frame(door.GetCenterPoint(hostWall), door.GetWallDirection(hostWall));
 
             double width = door.GetWidth();
             double halfW = width / 2;
             double thickness = hostWall.GetThickness();
 
-            //    
-            ScreenPoint screenCenter = camera.WorldToScreen(center);
-            float screenWidth = static_cast<float>(width * camera.GetZoom());
-            float screenThickness = static_cast<float>(thickness * camera.GetZoom());
-            float screenHalfW = screenWidth / 2;
-
-            //  
-            double angle = std::atan2(dir.Y, dir.X);
-
             // 
             Color fillColor = isHovered ? Colors::LightCyan() : Colors::White();
             Color strokeColor = isSelected ? Colors::Blue() : Colors::Black();
             float strokeWidth = isSelected ? 2.0f : 1.0f;
 
-            //     
-            auto transform = ds.Transform();
-            
-            //   
-            auto translateToCenter = Windows::Foundation::Numerics::make_float3x2_translation(
-                screenCenter.X, screenCenter.Y);
-            auto rotate = Windows::Foundation::Numerics::make_float3x2_rotation(
-                static_cast<float>(angle));
-            auto translateBack = Windows::Foundation::Numerics::make_float3x2_translation(
-                -screenCenter.X, -screenCenter.Y);
-
-            ds.Transform(transform * translateToCenter * rotate * translateBack);
-
             //   (   ""  )
-            Windows::Foundation::Rect openingRect(
-                screenCenter.X - screenHalfW,
-                screenCenter.Y - screenThickness / 2,
-                screenWidth,
-                screenThickness
-            );
-            ds.FillRectangle(openingRect, fillColor);
-            ds.DrawRectangle(openingRect, strokeColor, strokeWidth);
+            auto openingRect = frame.Rect(-halfW, -thickness / 2, halfW, thickness / 2);
+            list.AddPolygon(list.AddStyle(DisplayStyle::Fill(fillColor)), openingRect.data(), 4);
+            list.AddPolyline(list.AddStyle(DisplayStyle::Stroke(strokeColor, strokeWidth)), openingRect.data(), 4, true);
 
-            //  
-            float leafWidth = screenWidth - 4;  //   
-            float leafThick = 4.0f;
+            //   (  )
+            double inset = 2 * pixel;
+            double leafWidth = width - 2 * inset;
 
             //      
             bool isLeft = door.IsLeftHanded();
             bool isOutward = door.IsOutward();
-            float hingeSide = isLeft ? -screenHalfW + 2 : screenHalfW - 2;
-            float openSide = isLeft ? screenHalfW - 2 : -screenHalfW + 2;
-            float swingDir = (isOutward != door.IsFlipped()) ? 1.0f : -1.0f;
+            double hingeSide = isLeft ? -halfW + inset : halfW - inset;
+            double swingDir = (isOutward != door.IsFlipped()) ? 1.0 : -1.0;
 
             //  
-            float hingeX = screenCenter.X + hingeSide;
-            float hingeY = screenCenter.Y + swingDir * screenThickness / 2;
+            double hingeX = hingeSide;
+            double hingeY = swingDir * thickness / 2;
 
             //  
             double swingAngle = door.GetSwingAngle() * 3.14159265 / 180.0;
             if (!isLeft) swingAngle = -swingAngle;
 
             //   (  )
-            float leafX1 = screenCenter.X - screenHalfW + 2;
-            float leafX2 = screenCenter.X + screenHalfW - 2;
-            float leafY = screenCenter.Y + swingDir * screenThickness / 2;
-            
-            ds.DrawLine(leafX1, leafY, leafX2, leafY, strokeColor, strokeWidth + 1);
+            list.AddLine(list.AddStyle(DisplayStyle::Stroke(strokeColor, strokeWidth + 1)),
+                frame.At(-halfW + inset, hingeY), frame.At(halfW - inset, hingeY));
 
             //  
-            float arcRadius = leafWidth;
-            float startAngle = swingDir > 0 ? 0 : (float)M_PI;
-            float sweepAngle = (float)(swingAngle);
+            double arcRadius = leafWidth;
+            double startAngle = swingDir > 0 ? 0 : M_PI;
 
-            if (arcRadius > 5)
+            if (arcRadius > 5 * pixel)
             {
                 //   
-                int segments = 16;
-                float arcCenterX = hingeX;
-                float arcCenterY = hingeY;
-
-                std::vector<Windows::Foundation::Numerics::float2> arcPoints;
+                const int segments = 16;
+                std::vector<WorldPoint> arcPoints;
+                arcPoints.reserve(segments + 1);
                 for (int i = 0; i <= segments; ++i)
                 {
-                    float t = (float)i / segments;
-                    float a = startAngle + sweepAngle * t;
-                    float x = arcCenterX + arcRadius * std::cos(a);
-                    float y = arcCenterY - arcRadius * std::sin(a) * swingDir;
-                    arcPoints.push_back({ x, y });
-                }
-
-                for (size_t i = 1; i < arcPoints.size(); ++i)
-                {
-                    ds.DrawLine(
-                        arcPoints[i - 1].x, arcPoints[i - 1].y,
-                        arcPoints[i].x, arcPoints[i].y,
-                        Colors::Gray(), 0.5f
-                    );
+                    double a = startAngle + swingAngle * i / segments;
+                    arcPoints.push_back(frame.At(
+                        hingeX + arcRadius * std::cos(a),
+                        hingeY - arcRadius * std::sin(a) * swingDir));
                 }
+                list.AddPolyline(list.AddStyle(DisplayStyle::Stroke(Colors::Gray(), 0.5f)), arcPoints, false);
 
                 //   
-                if (arcPoints.size() > 1)
-                {
-                    ds.DrawLine(
-                        hingeX, hingeY,
-                        arcPoints.back().x, arcPoints.back().y,
-                        Colors::Gray(), 1.0f
-                    );
-                }
+                list.AddLine(list.AddStyle(DisplayStyle::Stroke(Colors::Gray(), 1.0f)),
+                    frame.At(hingeX, hingeY), arcPoints.back());
             }
 
-            //  
-            ds.Transform(transform);
-
             //  
             if (isSelected)
             {
-                DrawSelectionHandle(ds, screenCenter.X - screenHalfW, screenCenter.Y);
-                DrawSelectionHandle(ds, screenCenter.X + screenHalfW, screenCenter.Y);
-                DrawSelectionHandle(ds, screenCenter.X, screenCenter.Y);
+                AddSelectionHandles(list, frame, halfW);
             }
         }
 
-        //   
-        void DrawWindow(
-            Microsoft::Graphics::Canvas::CanvasDrawingSession const& ds,
-            Camera& camera,
+        //  ; pixel -    
+        void BuildWindow(
+            DisplayList& list,
+            double pixel,
             const Window& window,
             const Wall& hostWall,
             bool isSelected = false,
@@ -229,25 +137,13 @@ namespace winrt::estimate1
             using namespace Windows::UI;
 
             //    
-            WorldPoint center = window.GetCenterPoint(hostWall);
-            WorldPoint dir = window.GetWallDirection(hostWall);
-            WorldPoint normal = window.GetWallNormal(hostWall);
+            OpeningFrame frame(window.GetCenterPoint(hostWall), window.GetWallDirection(hostWall));
 
             double width = window.GetWidth();
             double halfW = width / 2;
             double thickness = hostWall.GetThickness();
             double frameWidth = window.GetFrameWidth();
 
-            //    
-            ScreenPoint screenCenter = camera.WorldToScreen(center);
-            float screenWidth = static_cast<float>(width * camera.GetZoom());
-            float screenThickness = static_cast<float>(thickness * camera.GetZoom());
-            float screenFrame = static_cast<float>(frameWidth * camera.GetZoom());
-            float screenHalfW = screenWidth / 2;
-
-            //  
-            double angle = std::atan2(dir.Y, dir.X);
-
             // 
             Color fillColor = isHovered ? Color{ 200, 200, 220, 255 } : Color{ 230, 240, 255, 255 };
             Color frameColor = Colors::DarkGray();
@@ -255,87 +151,45 @@ namespace winrt::estimate1
             Color strokeColor = isSelected ? Colors::Blue() : Colors::Black();
             float strokeWidth = isSelected ? 2.0f : 1.0f;
 
-            //  
-            auto transform = ds.Transform();
-            
-            //  
-            auto translateToCenter = Windows::Foundation::Numerics::make_float3x2_translation(
-                screenCenter.X, screenCenter.Y);
-            auto rotate = Windows::Foundation::Numerics::make_float3x2_rotation(
-                static_cast<float>(angle));
-            auto translateBack = Windows::Foundation::Numerics::make_float3x2_translation(
-                -screenCenter.X, -screenCenter.Y);
-
-            ds.Transform(transform * translateToCenter * rotate * translateBack);
-
             //   ()
-            Windows::Foundation::Rect openingRect(
-                screenCenter.X - screenHalfW,
-                screenCenter.Y - screenThickness / 2,
-                screenWidth,
-                screenThickness
-            );
-            ds.FillRectangle(openingRect, fillColor);
-            ds.DrawRectangle(openingRect, strokeColor, strokeWidth);
+            auto openingRect = frame.Rect(-halfW, -thickness / 2, halfW, thickness / 2);
+            list.AddPolygon(list.AddStyle(DisplayStyle::Fill(fillColor)), openingRect.data(), 4);
+            list.AddPolyline(list.AddStyle(DisplayStyle::Stroke(strokeColor, strokeWidth)), openingRect.data(), 4, true);
 
             //  
-            float innerMargin = (std::min)(screenFrame, screenWidth * 0.1f);
-            Windows::Foundation::Rect glassRect(
-                screenCenter.X - screenHalfW + innerMargin,
-                screenCenter.Y - screenThickness / 2 + innerMargin * 0.5f,
-                screenWidth - 2 * innerMargin,
-                screenThickness - innerMargin
-            );
+            double innerMargin = (std::min)(frameWidth, width * 0.1);
+            double glassHalfW = halfW - innerMargin;
+            double glassHalfT = thickness / 2 - innerMargin * 0.5;
 
-            if (glassRect.Width > 0 && glassRect.Height > 0)
+            if (glassHalfW > 0 && glassHalfT > 0)
             {
-                ds.FillRectangle(glassRect, glassColor);
-                ds.DrawRectangle(glassRect, frameColor, 1.0f);
+                auto glassRect = frame.Rect(-glassHalfW, -glassHalfT, glassHalfW, glassHalfT);
+                list.AddPolygon(list.AddStyle(DisplayStyle::Fill(glassColor)), glassRect.data(), 4);
+                list.AddPolyline(list.AddStyle(DisplayStyle::Stroke(frameColor, 1.0f)), glassRect.data(), 4, true);
             }
 
             //  ( )   
             int panes = window.GetPaneCount();
-            if (panes >= 2 && screenWidth > 20)
+            if (panes >= 2 && width > 20 * pixel)
             {
-                float paneWidth = (screenWidth - 2 * innerMargin) / panes;
+                uint16_t mullion = list.AddStyle(DisplayStyle::Stroke(frameColor, 2.0f));
+                double paneWidth = (width - 2 * innerMargin) / panes;
                 for (int i = 1; i < panes; ++i)
                 {
-                    float divX = screenCenter.X - screenHalfW + innerMargin + paneWidth * i;
-                    ds.DrawLine(
-                        divX, screenCenter.Y - screenThickness / 2 + innerMargin * 0.5f,
-                        divX, screenCenter.Y + screenThickness / 2 - innerMargin * 0.5f,
-                        frameColor, 2.0f
-                    );
+                    double divX = -halfW + innerMargin + paneWidth * i;
+                    list.AddLine(mullion, frame.At(divX, -glassHalfT), frame.At(divX, glassHalfT));
                 }
             }
 
             //    ( )
-            float glassLineY1 = screenCenter.Y - 1;
-            float glassLineY2 = screenCenter.Y + 1;
-            ds.DrawLine(
-                screenCenter.X - screenHalfW + innerMargin,
-                glassLineY1,
-                screenCenter.X + screenHalfW - innerMargin,
-                glassLineY1,
-                Colors::LightBlue(), 1.0f
-            );
-            ds.DrawLine(
-                screenCenter.X - screenHalfW + innerMargin,
-                glassLineY2,
-                screenCenter.X + screenHalfW - innerMargin,
-                glassLineY2,
-                Colors::LightBlue(), 1.0f
-            );
-
-            //  
-            ds.Transform(transform);
+            uint16_t glassLine = list.AddStyle(DisplayStyle::Stroke(Colors::LightBlue(), 1.0f));
+            list.AddLine(glassLine, frame.At(-glassHalfW, -pixel), frame.At(glassHalfW, -pixel));
+            list.AddLine(glassLine, frame.At(-glassHalfW, pixel), frame.At(glassHalfW, pixel));
 
             //  
             if (isSelected)
             {
-                DrawSelectionHandle(ds, screenCenter.X - screenHalfW, screenCenter.Y);
-                DrawSelectionHandle(ds, screenCenter.X + screenHalfW, screenCenter.Y);
-                DrawSelectionHandle(ds, screenCenter.X, screenCenter.Y);
+                AddSelectionHandles(list, frame, halfW);
             }
         }
 
@@ -448,21 +302,72 @@ namespace winrt::estimate1
         }
 
     private:
-        void DrawSelectionHandle(
-            Microsoft::Graphics::Canvas::CanvasDrawingSession const& ds,
-            float x, float y)
+        //  ,      (highlightsOnly)
+        void BuildOpenings(
+            DisplayList& list,
+            double scale,
+            const DocumentModel& document,
+            uint64_t selectedId,
+            uint64_t hoverId,
+            bool highlightsOnly)
+        {
+            const WallStore& walls = document.GetWallStore();
+            double pixel = 1.0 / scale;
+
+            for (const auto& door : document.GetDoors())
+            {
+                bool isSelected = (door->GetId() == selectedId);
+                bool isHovered = (door->GetId() == hoverId);
+                if (highlightsOnly && !isSelected && !isHovered)
+                    continue;
+                if (const Wall* hostWall = walls.FindById(door->GetHostWallId()))
+                    BuildDoor(list, pixel, *door, *hostWall, isSelected, isHovered);
+            }
+
+            for (const auto& window : document.GetWindows())
+            {
+                bool isSelected = (window->GetId() == selectedId);
+                bool isHovered = (window->GetId() == hoverId);
+                if (highlightsOnly && !isSelected && !isHovered)
+                    continue;
+                if (const Wall* hostWall = walls.FindById(window->GetHostWallId()))
+                    BuildWindow(list, pixel, *window, *hostWall, isSelected, isHovered);
+            }
+        }
+
+        //  : X  , Y  ,    
+        struct OpeningFrame
+        {
+            OpeningFrame(const WorldPoint& center, const WorldPoint& direction)
+                : Center(center), Dir(direction)
+            {
+            }
+
+            WorldPoint At(double x, double y) const
+            {
+                return WorldPoint(
+                    Center.X + Dir.X * x - Dir.Y * y,
+                    Center.Y + Dir.Y * x + Dir.X * y);
+            }
+
+            std::array<WorldPoint, 4> Rect(double x0, double y0, double x1, double y1) const
+            {
+                return { At(x0, y0), At(x1, y0), At(x1, y1), At(x0, y1) };
+            }
+
+            WorldPoint Center;
+            WorldPoint Dir;
+        };
+
+        void AddSelectionHandles(DisplayList& list, const OpeningFrame& frame, double halfW)
         {
             const float size = 6.0f;
-            ds.FillRectangle(
-                x - size / 2, y - size / 2,
-                size, size,
-                Windows::UI::Colors::White()
-            );
-            ds.DrawRectangle(
-                x - size / 2, y - size / 2,
-                size, size,
-                Windows::UI::Colors::Blue(), 1.0f
-            );
+            uint16_t fill = list.AddStyle(DisplayStyle::Fill(Windows::UI::Colors::White()));
+            uint16_t outline = list.AddStyle(DisplayStyle::Stroke(Windows::UI::Colors::Blue(), 1.0f));
+            for (double x : { -halfW, halfW, 0.0 })
+                list.AddMarker(fill, frame.At(x, 0), MarkerShape::Square, size, true);
+            for (double x : { -halfW, halfW, 0.0 })
+                list.AddMarker(outline, frame.At(x, 0), MarkerShape::Square, size);
         }
     };
 }
@@ -352,8 +352,10 @@ namespace winrt::estimate1
     class PlanPdfExporter
     {
     public:
+        // Document is DocumentModel, or DocumentSnapshot on a worker thread
+        template <typename Document>
         bool Export(
-            const DocumentModel& document,
+            const Document& document,
             const std::vector<Dimension>& dimensions,
             const PdfExportSettings& settings,
             const std::wstring& filePath)
@@ -459,20 +461,34 @@ namespace winrt::estimate1
                         break;
                     }
 
-                    //    
-                    WorldPoint p1, p2, p3, p4;
-                    wall->GetCornerPoints(p1, p2, p3, p4);
-
-                    auto [x1, y1] = modelToPdf(p1);
-                    auto [x2, y2] = modelToPdf(p2);
-                    auto [x3, y3] = modelToPdf(p3);
-                    auto [x4, y4] = modelToPdf(p4);
-
-                    //   
-                    pdf.MoveTo(x1, y1);
-                    pdf.LineTo(x2, y2);
-                    pdf.LineTo(x3, y3);
-                    pdf.LineTo(x4, y4);
+                    //       (WallJoinGraph),
+                    //   -    
+                    const auto& contour = document.GetWallJoinGraph().GetContour(wall->GetId());
+                    if (contour.size() >= 3)
+                    {
+                        auto [x0, y0] = modelToPdf(contour[0]);
+                        pdf.MoveTo(x0, y0);
+                        for (size_t i = 1; i < contour.size(); ++i)
+                        {
+                            auto [x, y] = modelToPdf(contour[i]);
+                            pdf.LineTo(x, y);
+                        }
+                    }
+                    else
+                    {
+                        WorldPoint p1, p2, p3, p4;
+                        wall->GetCornerPoints(p1, p2, p3, p4);
+
+                        auto [x1, y1] = modelToPdf(p1);
+                        auto [x2, y2] = modelToPdf(p2);
+                        auto [x3, y3] = modelToPdf(p3);
+                        auto [x4, y4] = modelToPdf(p4);
+
+                        pdf.MoveTo(x1, y1);
+                        pdf.LineTo(x2, y2);
+                        pdf.LineTo(x3, y3);
+                        pdf.LineTo(x4, y4);
+                    }
                     pdf.ClosePath();
                     pdf.FillAndStroke();
 
@@ -582,8 +598,9 @@ namespace winrt::estimate1
         }
 
     private:
+        template <typename Document>
         void CalculateModelBounds(
-            const DocumentModel& document,
+            const Document& document,
             WorldPoint& minPt,
             WorldPoint& maxPt)
         {
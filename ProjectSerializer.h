@@ -55,7 +55,7 @@ namespace winrt::estimate1
             const ProjectMetadata& metadata,
             const Camera& camera,
             const LayerManager& layerManager,
-            const DocumentModel& document,
+            DocumentModel& document,
             const DxfReferenceManager* dxfManager = nullptr,
             const IfcReferenceManager* ifcManager = nullptr)
         {
@@ -84,22 +84,31 @@ namespace winrt::estimate1
                 // ������� ����� ����
                 root["wallTypes"] = SerializeWallTypes(document.GetWallTypes());
 
-                // �������� (�����)
-                root["elements"] = SerializeElements(document);
-
-                // �������
-                root["dimensions"] = SerializeDimensions(document);
-
-                // R5.2: ��������� (��������� ���������������� ������)
-                root["rooms"] = SerializeRooms(document);
-
-                // R5.5: ���������������� ����
-                root["customZones"] = SerializeCustomZones(document);
+                // Levels. The first level's content goes into the top-level
+                // keys, so files without "levels" load as a single level;
+                // the other levels carry theirs in "levels"[i]["content"].
+                nlohmann::json levels = nlohmann::json::array();
+                size_t activeLevel = document.GetActiveLevelIndex();
+                size_t levelIndex = 0;
+                document.ForEachLevel([&](const Level& level) {
+                    nlohmann::json lj = nlohmann::json::object();
+                    lj["name"] = level.GetName();
+                    lj["elevation"] = level.GetElevation();
+                    lj["height"] = level.GetHeight();
 
-                // R6.7: �����������
-                root["columns"] = SerializeColumns(document);
-                root["slabs"] = SerializeSlabs(document);
-                root["beams"] = SerializeBeams(document);
+                    if (levelIndex == 0)
+                        WriteLevelContent(root, document);
+                    else
+                    {
+                        nlohmann::json content = nlohmann::json::object();
+                        WriteLevelContent(content, document);
+                        lj["content"] = content;
+                    }
+                    levels.push_back(lj);
+                    ++levelIndex;
+                });
+                root["levels"] = levels;
+                root["activeLevel"] = static_cast<int>(activeLevel);
 
                 // DXF �������� (���� ����)
                 if (dxfManager && dxfManager->HasLayers())
@@ -220,6 +229,10 @@ namespace winrt::estimate1
                     DeserializeMaterials(root["materials"], outDocument, materialMap);
                 }
 
+                // Ids stored in the file are never reused: every loaded element
+                // gets a fresh id and references are translated through idRemap
+                IdRemapper idRemap;
+
                 // ��������� ���� ����
                 std::map<std::wstring, std::shared_ptr<WallType>> wallTypeMap;
                 if (root.contains("wallTypes"))
@@ -230,13 +243,13 @@ namespace winrt::estimate1
                 // ��������� �������� (�����)
                 if (root.contains("elements"))
                 {
-                    DeserializeElements(root["elements"], outDocument, wallTypeMap);
+                    DeserializeElements(root["elements"], outDocument, wallTypeMap, idRemap);
                 }
 
                 // ��������� �������
                 if (root.contains("dimensions"))
                 {
-                    DeserializeDimensions(root["dimensions"], outDocument);
+                    DeserializeDimensions(root["dimensions"], outDocument, idRemap);
                 }
 
                 // ��������� DXF ��������
@@ -263,13 +276,13 @@ namespace winrt::estimate1
                 // R5.2: ��������� ���������������� ������ ��������� ����� ����������
                 if (root.contains("rooms"))
                 {
-                    DeserializeRooms(root["rooms"], outDocument);
+                    DeserializeRooms(root["rooms"], outDocument, idRemap);
                 }
 
                 // R5.5: ��������� ���������������� ����
                 if (root.contains("customZones"))
                 {
-                    DeserializeCustomZones(root["customZones"], outDocument);
+                    DeserializeCustomZones(root["customZones"], outDocument, idRemap);
                 }
 
                 // R6.7: �����������
@@ -286,6 +299,12 @@ namespace winrt::estimate1
                     DeserializeBeams(root["beams"], outDocument);
                 }
 
+                // Levels: the top-level content above is the first level
+                if (root.contains("levels"))
+                {
+                    DeserializeLevels(root, outDocument, wallTypeMap, idRemap);
+                }
+
                 result.Success = true;
             }
             catch (const std::exception& ex)
@@ -392,6 +411,86 @@ namespace winrt::estimate1
             return arr;
         }
 
+        // Content of the active level: walls, dimensions, rooms, zones, structure
+        static void WriteLevelContent(nlohmann::json& j, const DocumentModel& document)
+        {
+            j["elements"] = SerializeElements(document);
+            j["dimensions"] = SerializeDimensions(document);
+
+            // R5.2: ��������� (��������� ���������������� ������)
+            j["rooms"] = SerializeRooms(document);
+
+            // R5.5: ���������������� ����
+            j["customZones"] = SerializeCustomZones(document);
+
+            // R6.7: �����������
+            j["columns"] = SerializeColumns(document);
+            j["slabs"] = SerializeSlabs(document);
+            j["beams"] = SerializeBeams(document);
+        }
+
+        // Same order as the top-level load: walls, dimensions, rooms, structure
+        static void ReadLevelContent(
+            const nlohmann::json& j,
+            DocumentModel& document,
+            const std::map<std::wstring, std::shared_ptr<WallType>>& wallTypeMap,
+            IdRemapper& idRemap)
+        {
+            if (j.contains("elements"))
+                DeserializeElements(j["elements"], document, wallTypeMap, idRemap);
+            if (j.contains("dimensions"))
+                DeserializeDimensions(j["dimensions"], document, idRemap);
+
+            document.RebuildAutoDimensions();
+
+            if (j.contains("rooms"))
+                DeserializeRooms(j["rooms"], document, idRemap);
+            if (j.contains("customZones"))
+                DeserializeCustomZones(j["customZones"], document, idRemap);
+            if (j.contains("columns"))
+                DeserializeColumns(j["columns"], document);
+            if (j.contains("slabs"))
+                DeserializeSlabs(j["slabs"], document);
+            if (j.contains("beams"))
+                DeserializeBeams(j["beams"], document);
+        }
+
+        // Called after the first level was loaded from the top-level keys
+        static void DeserializeLevels(
+            const nlohmann::json& root,
+            DocumentModel& document,
+            const std::map<std::wstring, std::shared_ptr<WallType>>& wallTypeMap,
+            IdRemapper& idRemap)
+        {
+            const nlohmann::json& levels = root["levels"];
+            for (size_t i = 0; i < levels.size(); ++i)
+            {
+                const nlohmann::json& lj = levels[i];
+                Level* level = nullptr;
+                if (i == 0)
+                {
+                    level = &document.GetActiveLevel();
+                }
+                else
+                {
+                    uint64_t id = document.AddLevel();
+                    document.SetActiveLevel(id);
+                    level = document.GetLevel(id);
+                }
+
+                if (lj.contains("name")) level->SetName(lj["name"].get_wstring());
+                if (lj.contains("height")) level->SetHeight(lj["height"].get_double());
+                if (lj.contains("elevation")) level->SetElevation(lj["elevation"].get_double());
+
+                if (i > 0 && lj.contains("content"))
+                    ReadLevelContent(lj["content"], document, wallTypeMap, idRemap);
+            }
+
+            size_t active = root.contains("activeLevel") ? static_cast<size_t>(root["activeLevel"].get_int()) : 0;
+            if (active < document.GetLevelCount())
+                document.SetActiveLevel(document.GetLevels()[active].GetId());
+        }
+
         static nlohmann::json SerializeElements(const DocumentModel& document)
         {
             nlohmann::json elements = nlohmann::json::object();
@@ -529,6 +628,7 @@ namespace winrt::estimate1
                 if (!room) continue;
                 
                 nlohmann::json j = nlohmann::json::object();
+                j["id"] = room->GetId();
                 
                 // ������������� (��������� �������� ��� ������������� ��� ��������)
                 WorldPoint centroid = room->GetLabelPoint();
@@ -792,15 +892,29 @@ namespace winrt::estimate1
         static void DeserializeElements(
             const nlohmann::json& elements,
             DocumentModel& document,
-            const std::map<std::wstring, std::shared_ptr<WallType>>& wallTypeMap)
+            const std::map<std::wstring, std::shared_ptr<WallType>>& wallTypeMap,
+            IdRemapper& idRemap)
         {
             if (!elements.contains("walls")) return;
             
             const auto& wallsArr = elements["walls"];
             if (!wallsArr.is_array()) return;
+
+            // Deterministic ids: one block, assigned in ascending order of the saved ids
+            std::vector<uint64_t> savedIds;
+            for (const auto& j : wallsArr)
+            {
+                if (j.contains("id"))
+                    savedIds.push_back(j["id"].get_uint64());
+            }
+            idRemap.Reserve(document.GetIdAllocator(), savedIds);
             
             for (const auto& j : wallsArr)
             {
+                uint64_t savedId = j.contains("id") ? j["id"].get_uint64() : 0;
+                IdBlock idBlock = idRemap.ClaimBlock(savedId);
+                IdBlockScope idScope(idBlock);
+
                 double startX = j.contains("startX") ? j["startX"].get_double() : 0.0;
                 double startY = j.contains("startY") ? j["startY"].get_double() : 0.0;
                 double endX = j.contains("endX") ? j["endX"].get_double() : 0.0;
@@ -838,7 +952,7 @@ namespace winrt::estimate1
             }
         }
 
-        static void DeserializeDimensions(const nlohmann::json& dims, DocumentModel& document)
+        static void DeserializeDimensions(const nlohmann::json& dims, DocumentModel& document, const IdRemapper& idRemap)
         {
             // ��������� ������ �������
             if (dims.contains("manual") && dims["manual"].is_array())
@@ -873,7 +987,9 @@ namespace winrt::estimate1
                 {
                     if (!j.contains("ownerWallId"))
                         continue;
-                    uint64_t wallId = j["ownerWallId"].get_uint64();
+                    uint64_t wallId = idRemap.Map(j["ownerWallId"].get_uint64());
+                    if (wallId == 0)
+                        continue;
                     double offset = j.contains("offset") ? j["offset"].get_double() : 0.0;
                     document.LoadAutoDimensionState(wallId, offset);
                 }
@@ -966,7 +1082,7 @@ namespace winrt::estimate1
         }
 
         // R5.2: �������������� ��������� (��������� ���������������� ������ � �������������������)
-        static void DeserializeRooms(const nlohmann::json& arr, DocumentModel& document)
+        static void DeserializeRooms(const nlohmann::json& arr, DocumentModel& document, IdRemapper& idRemap)
         {
             if (!arr.is_array()) return;
             
@@ -1000,6 +1116,9 @@ namespace winrt::estimate1
                 
                 if (!bestMatch)
                     continue;
+
+                if (j.contains("id"))
+                    idRemap.Assign(j["id"].get_uint64(), bestMatch->GetId());
                 
                 // ��������� ����������� ������
                 if (j.contains("number"))
@@ -1035,7 +1154,7 @@ namespace winrt::estimate1
         }
 
         // R5.5: �������������� ���������������� ���
-        static void DeserializeCustomZones(const nlohmann::json& arr, DocumentModel& document)
+        static void DeserializeCustomZones(const nlohmann::json& arr, DocumentModel& document, const IdRemapper& idRemap)
         {
             if (!arr.is_array()) return;
             
@@ -1063,8 +1182,9 @@ namespace winrt::estimate1
                 {
                     for (const auto& idVal : j["roomIds"])
                     {
-                        uint64_t roomId = idVal.get_uint64();
-                        zone->AddRoomById(roomId);
+                        uint64_t roomId = idRemap.Map(idVal.get_uint64());
+                        if (roomId != 0)
+                            zone->AddRoomById(roomId);
                     }
                     // ��������� ��� ���������
                     zone->UpdateRoomCache(document.GetRooms());
@@ -0,0 +1,408 @@
+#pragma once
+
+#include "pch.h"
+#include "Camera.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+#include <winrt/Microsoft.Graphics.Canvas.h>
+
+namespace winrt::estimate1
+{
+    // =================================================================
+    // RASTER TILE CACHE - static plan content as offscreen tiles
+    // =================================================================
+    // Content that did not change since the last frame (underlays,
+    // slabs, walls, openings, structure) is rasterized into square
+    // tiles of TileSizePx pixels and composited instead of redrawn
+    // while the user pans and zooms. Overlays (previews, snaps, hover,
+    // pixel-sized annotations) stay live.
+    //
+    // Tiles belong to a zoom octave: octave k is rendered at 2^k px per
+    // mm, the first octave at or above the camera zoom, so a tile is
+    // never magnified and at most halved on screen. While the tiles of
+    // a new octave are missing, a complete set from a neighbouring
+    // octave is composited scaled, and if there is none the caller
+    // draws live for that frame.
+    //
+    // Tile sizes are in DIPs, like the camera's; targets are created at
+    // the session's DPI, so on a scaled display a tile has as many
+    // device pixels as the screen area it covers and composites 1:1.
+    //
+    // The caller passes a content key (document and reference
+    // revisions and whatever else the content depends on). A new key
+    // drops every tile and frames are drawn live until the key has
+    // held for a frame, so dragging an element never pays for tiles.
+    // Then a few tiles are rendered per frame, visible ones first and
+    // a ring around the view next, and HasPendingTiles() asks for
+    // another frame until the view is covered.
+    // =================================================================
+
+    struct RasterTileKey
+    {
+        int Octave{ 0 };
+        int X{ 0 };
+        int Y{ 0 };
+
+        bool operator==(const RasterTileKey& other) const
+        {
+            return Octave == other.Octave && X == other.X && Y == other.Y;
+        }
+    };
+
+    struct RasterTileKeyHash
+    {
+        size_t operator()(const RasterTileKey& key) const
+        {
+            uint64_t packed = (static_cast<uint64_t>(static_cast<uint32_t>(key.X)) << 32)
+                ^ static_cast<uint32_t>(key.Y) ^ (static_cast<uint64_t>(key.Octave + 64) << 56);
+            return std::hash<uint64_t>()(packed);
+        }
+    };
+
+    // What one frame does with the cache
+    struct RasterTileFrame
+    {
+        bool UseTiles{ false };                 // composite instead of drawing live
+        int Octave{ 0 };                        // of the composited tiles
+        std::vector<RasterTileKey> Composite;   // tiles covering the view
+        std::vector<RasterTileKey> Render;      // tiles to rasterize first
+    };
+
+    class RasterTileCache
+    {
+    public:
+        static constexpr int TileSizePx = 512;
+        static constexpr size_t MaxTiles = 96;             // about 96 MB of 32-bit pixels at 96 DPI
+        static constexpr size_t MaxRenderedPerFrame = 4;
+        static constexpr int MarginTiles = 1;
+
+        using DrawContent = std::function<void(
+            const Microsoft::Graphics::Canvas::CanvasDrawingSession&, const Camera&)>;
+
+        // ------------------------------------------------------------
+        // Tile grid
+        // ------------------------------------------------------------
+
+        static int OctaveOf(double zoom)
+        {
+            int octave = static_cast<int>(std::ceil(std::log2(zoom) - 1e-9));
+            int highest = static_cast<int>(std::floor(std::log2(Camera::GetMaxZoom())));
+            int lowest = static_cast<int>(std::ceil(std::log2(Camera::GetMinZoom())));
+            return std::clamp(octave, lowest, highest);
+        }
+
+        static double ScaleOf(int octave) { return std::ldexp(1.0, octave); }
+
+        // Side of a tile of this octave in mm
+        static double TileWorldSize(int octave) { return TileSizePx / ScaleOf(octave); }
+
+        static WorldPoint TileOrigin(const RasterTileKey& key)
+        {
+            double size = TileWorldSize(key.Octave);
+            return WorldPoint(key.X * size, key.Y * size);
+        }
+
+        // Tiles of an octave covering the camera's view, grown by margin
+        // tiles on every side, nearest to the view center first
+        static void CollectTiles(const Camera& camera, int octave, int margin, std::vector<RasterTileKey>& out)
+        {
+            out.clear();
+            WorldPoint topLeft, bottomRight;
+            camera.GetVisibleBounds(topLeft, bottomRight);
+            double size = TileWorldSize(octave);
+            int x0 = static_cast<int>(std::floor((std::min)(topLeft.X, bottomRight.X) / size)) - margin;
+            int x1 = static_cast<int>(std::floor((std::max)(topLeft.X, bottomRight.X) / size)) + margin;
+            int y0 = static_cast<int>(std::floor((std::min)(topLeft.Y, bottomRight.Y) / size)) - margin;
+            int y1 = static_cast<int>(std::floor((std::max)(topLeft.Y, bottomRight.Y) / size)) + margin;
+
+            for (int y = y0; y <= y1; ++y)
+                for (int x = x0; x <= x1; ++x)
+                    out.push_back(RasterTileKey{ octave, x, y });
+
+            double cx = (x0 + x1) / 2.0, cy = (y0 + y1) / 2.0;
+            std::stable_sort(out.begin(), out.end(), [cx, cy](const RasterTileKey& a, const RasterTileKey& b) {
+                return std::abs(a.X - cx) + std::abs(a.Y - cy) < std::abs(b.X - cx) + std::abs(b.Y - cy);
+            });
+        }
+
+        // Camera that draws a tile's world square onto a TileSizePx target
+        static Camera TileCamera(const RasterTileKey& key)
+        {
+            double scale = ScaleOf(key.Octave);
+            WorldPoint origin = TileOrigin(key);
+            Camera camera;
+            camera.SetCanvasSize(static_cast<float>(TileSizePx), static_cast<float>(TileSizePx));
+            camera.SetZoom(scale);
+            camera.SetOffset(-origin.X - TileSizePx / (2.0 * scale), -origin.Y - TileSizePx / (2.0 * scale));
+            return camera;
+        }
+
+        // ------------------------------------------------------------
+        // Frame
+        // ------------------------------------------------------------
+
+        // Decides this frame without touching the device: drops tiles
+        // for a new content key, picks the tiles to render within the
+        // budget (reserving their slots) and the set to composite
+        RasterTileFrame Plan(const Camera& camera, uint64_t contentKey)
+        {
+            RasterTileFrame frame;
+            ++m_frame;
+            m_pending = false;
+
+            if (!m_enabled)
+                return frame;
+
+            if (contentKey != m_contentKey)
+            {
+                ClearTiles();
+                m_contentKey = contentKey;
+                m_stableFrames = 0;
+                m_pending = true;
+                return frame;
+            }
+            if (++m_stableFrames < SettleFrames)
+            {
+                m_pending = true;
+                return frame;
+            }
+
+            int octave = OctaveOf(camera.GetZoom());
+            CollectTiles(camera, octave, 0, m_visible);
+            CollectTiles(camera, octave, MarginTiles, m_wanted);
+
+            // Visible tiles first, then the ring around the view
+            size_t missingVisible = 0;
+            for (const auto& key : m_visible)
+            {
+                if (Touch(key))
+                    continue;
+                if (frame.Render.size() < MaxRenderedPerFrame)
+                    frame.Render.push_back(key);
+                else
+                    ++missingVisible;
+            }
+            for (const auto& key : m_wanted)
+            {
+                if (Touch(key) || Contains(frame.Render, key))
+                    continue;
+                if (missingVisible == 0 && frame.Render.size() < MaxRenderedPerFrame)
+                    frame.Render.push_back(key);
+                else
+                    m_pending = true;
+            }
+            if (missingVisible > 0)
+                m_pending = true;
+
+            for (const auto& key : frame.Render)
+                Reserve(key);
+
+            if (missingVisible == 0)
+            {
+                frame.UseTiles = true;
+                frame.Octave = octave;
+                frame.Composite = m_visible;
+                return frame;
+            }
+
+            // Sharper octave first, then the coarser one
+            for (int other : { octave + 1, octave - 1 })
+            {
+                CollectTiles(camera, other, 0, m_fallback);
+                bool complete = std::all_of(m_fallback.begin(), m_fallback.end(),
+                    [this](const RasterTileKey& key) { return m_tiles.count(key) != 0; });
+                if (complete && !m_fallback.empty())
+                {
+                    for (const auto& key : m_fallback)
+                        Touch(key);
+                    frame.UseTiles = true;
+                    frame.Octave = other;
+                    frame.Composite = m_fallback;
+                    return frame;
+                }
+            }
+            return frame;
+        }
+
+        // Composites the content for the camera, rendering missing tiles
+        // with drawContent. False if the caller must draw it live.
+        bool Draw(
+            const Microsoft::Graphics::Canvas::CanvasDrawingSession& session,
+            const Camera& camera,
+            uint64_t contentKey,
+            const DrawContent& drawContent)
+        {
+            auto device = session.Device();
+            float dpi = session.Dpi();
+            if (device != m_device || dpi != m_dpi)
+            {
+                ClearTiles();
+                m_spare.clear();
+                m_device = device;
+                m_dpi = dpi;
+            }
+
+            RasterTileFrame frame = Plan(camera, contentKey);
+            m_renderedLastFrame = 0;
+            for (const auto& key : frame.Render)
+            {
+                RenderTile(key, drawContent);
+                ++m_renderedLastFrame;
+            }
+
+            if (!frame.UseTiles)
+                return false;
+
+            double size = TileWorldSize(frame.Octave) * camera.GetZoom();
+            float pixelsPerDip = m_dpi / 96.0f;
+            auto snap = [pixelsPerDip](double dips) { return std::floor(static_cast<float>(dips) * pixelsPerDip) / pixelsPerDip; };
+            for (const auto& key : frame.Composite)
+            {
+                auto it = m_tiles.find(key);
+                if (it == m_tiles.end() || !it->second.Target)
+                    return false;
+
+                ScreenPoint at = camera.WorldToScreen(TileOrigin(key));
+                // Whole device pixels and a shared edge, so no seams show between tiles
+                float x0 = snap(at.X), y0 = snap(at.Y);
+                float x1 = snap(at.X + size), y1 = snap(at.Y + size);
+                session.DrawImage(it->second.Target,
+                    Windows::Foundation::Rect(x0, y0, x1 - x0, y1 - y0),
+                    Windows::Foundation::Rect(0, 0, static_cast<float>(TileSizePx), static_cast<float>(TileSizePx)));
+            }
+            return true;
+        }
+
+        // True while tiles for the current view are still missing; the
+        // caller redraws once more to render them
+        bool HasPendingTiles() const { return m_pending; }
+
+        void SetEnabled(bool enabled)
+        {
+            m_enabled = enabled;
+            if (!enabled)
+                ClearTiles();
+        }
+        bool IsEnabled() const { return m_enabled; }
+
+        void Clear()
+        {
+            ClearTiles();
+            m_spare.clear();
+            m_contentKey = 0;
+            m_stableFrames = 0;
+        }
+
+        size_t GetTileCount() const { return m_tiles.size(); }
+        size_t GetRenderedLastFrame() const { return m_renderedLastFrame; }
+        bool HasTile(const RasterTileKey& key) const { return m_tiles.count(key) != 0; }
+
+        size_t GetMemoryUsage() const
+        {
+            double pixelsPerDip = m_dpi / 96.0;
+            double side = std::ceil(TileSizePx * pixelsPerDip);
+            return (m_tiles.size() + m_spare.size()) * static_cast<size_t>(side * side) * 4;
+        }
+
+    private:
+        static constexpr int SettleFrames = 2;
+
+        struct Tile
+        {
+            Microsoft::Graphics::Canvas::CanvasRenderTarget Target{ nullptr };
+            uint64_t LastUsed{ 0 };
+        };
+
+        static bool Contains(const std::vector<RasterTileKey>& keys, const RasterTileKey& key)
+        {
+            return std::find(keys.begin(), keys.end(), key) != keys.end();
+        }
+
+        // Marks a tile used this frame; false if there is none
+        bool Touch(const RasterTileKey& key)
+        {
+            auto it = m_tiles.find(key);
+            if (it == m_tiles.end())
+                return false;
+            it->second.LastUsed = m_frame;
+            return true;
+        }
+
+        // Slot for a tile about to be rendered, evicting the least
+        // recently used tile not needed this frame
+        void Reserve(const RasterTileKey& key)
+        {
+            if (m_tiles.size() >= MaxTiles)
+            {
+                auto oldest = m_tiles.end();
+                for (auto it = m_tiles.begin(); it != m_tiles.end(); ++it)
+                {
+                    if (it->second.LastUsed != m_frame && (oldest == m_tiles.end() || it->second.LastUsed < oldest->second.LastUsed))
+                        oldest = it;
+                }
+                if (oldest != m_tiles.end())
+                {
+                    if (oldest->second.Target)
+                        m_spare.push_back(oldest->second.Target);
+                    m_tiles.erase(oldest);
+                }
+            }
+
+            Tile& tile = m_tiles[key];
+            tile.LastUsed = m_frame;
+        }
+
+        void RenderTile(const RasterTileKey& key, const DrawContent& drawContent)
+        {
+            Tile& tile = m_tiles[key];
+            if (!tile.Target)
+            {
+                if (!m_spare.empty())
+                {
+                    tile.Target = m_spare.back();
+                    m_spare.pop_back();
+                }
+                else
+                {
+                    tile.Target = Microsoft::Graphics::Canvas::CanvasRenderTarget(
+                        m_device, static_cast<float>(TileSizePx), static_cast<float>(TileSizePx), m_dpi);
+                }
+            }
+
+            auto session = tile.Target.CreateDrawingSession();
+            session.Clear(Windows::UI::Colors::Transparent());
+            drawContent(session, TileCamera(key));
+            session.Close();
+        }
+
+        void ClearTiles()
+        {
+            for (auto& entry : m_tiles)
+            {
+                if (entry.second.Target && m_spare.size() < MaxTiles)
+                    m_spare.push_back(entry.second.Target);
+            }
+            m_tiles.clear();
+        }
+
+        std::unordered_map<RasterTileKey, Tile, RasterTileKeyHash> m_tiles;
+        std::vector<Microsoft::Graphics::Canvas::CanvasRenderTarget> m_spare;   // targets of dropped tiles, reused
+        Microsoft::Graphics::Canvas::CanvasDevice m_device{ nullptr };
+        float m_dpi{ 96.0f };                   // of the tile targets
+
+        uint64_t m_contentKey{ 0 };
+        int m_stableFrames{ 0 };
+        uint64_t m_frame{ 0 };
+        bool m_pending{ false };
+        bool m_enabled{ true };
+        size_t m_renderedLastFrame{ 0 };
+
+        // Scratch, kept to avoid allocating per frame
+        std::vector<RasterTileKey> m_visible;
+        std::vector<RasterTileKey> m_wanted;
+        std::vector<RasterTileKey> m_fallback;
+    };
+}
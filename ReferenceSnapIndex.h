@@ -0,0 +1,319 @@
+#pragma once
+
+#include "pch.h"
+#include "Camera.h"
+#include "GeometryKernels.h"
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace winrt::estimate1
+{
+    // =================================================================
+    // REFERENCE SNAP INDEX - line work of an imported underlay
+    // =================================================================
+    // DXF and IFC underlays are flattened once, at import, into plain
+    // segments: arcs and circles become chords no more than a
+    // millimetre off the curve. A segment remembers which of its ends
+    // are real vertices of the drawing (not chord joints) and whether
+    // its midpoint is the midpoint of a drawn line. Segments are added
+    // entity by entity; the entity of a segment is found from a short
+    // table of where each entity's segments start.
+    //
+    // The segments are bucketed in a uniform grid stored as one array
+    // of cell offsets and one of segment ids (no per-cell vectors), so
+    // a multi-million segment reference costs a few bytes per segment
+    // beyond the coordinates and a query reads only the cells around
+    // the cursor. The grid is immutable: layers are re-imported, never
+    // edited.
+    // =================================================================
+
+    class ReferenceSnapIndex
+    {
+    public:
+        enum SegmentFlags : uint8_t
+        {
+            StartIsVertex = 1,
+            EndIsVertex = 2,
+            HasMidpoint = 4,        // a straight drawn edge, not a chord
+        };
+
+        // ------------------------------------------------------------
+        // Building
+        // ------------------------------------------------------------
+
+        void Clear()
+        {
+            m_ax.clear(); m_ay.clear(); m_bx.clear(); m_by.clear();
+            m_flags.clear();
+            m_entityStarts.clear();
+            m_entityIds.clear();
+            m_offsets.clear();
+            m_ids.clear();
+            m_seen.clear();
+            m_cols = m_rows = 0;
+        }
+
+        // Segments added from here on belong to this entity (1 + the DXF
+        // entity's position in file order, kept through the spatial sort;
+        // the IFC STEP id); 0 for none
+        void BeginEntity(uint64_t id)
+        {
+            m_entityStarts.push_back(Size());
+            m_entityIds.push_back(id);
+        }
+
+        void AddSegment(const WorldPoint& a, const WorldPoint& b, uint8_t flags = StartIsVertex | EndIsVertex | HasMidpoint)
+        {
+            m_ax.push_back(a.X); m_ay.push_back(a.Y);
+            m_bx.push_back(b.X); m_by.push_back(b.Y);
+            m_flags.push_back(flags);
+        }
+
+        void AddPolyline(const std::vector<WorldPoint>& points, bool closed)
+        {
+            for (size_t i = 0; i + 1 < points.size(); ++i)
+                AddSegment(points[i], points[i + 1]);
+            if (closed && points.size() > 2)
+                AddSegment(points.back(), points.front());
+        }
+
+        // Counter-clockwise arc; its two ends are vertices unless it is
+        // a full circle
+        void AddArc(const WorldPoint& center, double radius, double startAngle, double sweep)
+        {
+            if (radius <= 0.0 || sweep == 0.0)
+                return;
+
+            bool full = std::abs(sweep) >= 2.0 * Pi - 1e-9;
+            int count = ChordCount(radius, std::abs(sweep));
+            WorldPoint prev = PointOnArc(center, radius, startAngle);
+            for (int i = 1; i <= count; ++i)
+            {
+                WorldPoint next = PointOnArc(center, radius, startAngle + sweep * i / count);
+                uint8_t flags = 0;
+                if (!full && i == 1) flags |= StartIsVertex;
+                if (!full && i == count) flags |= EndIsVertex;
+                AddSegment(prev, next, flags);
+                prev = next;
+            }
+        }
+
+        // Arc from a to b with a DXF bulge: tan(sweep / 4), positive
+        // counter-clockwise
+        void AddBulge(const WorldPoint& a, const WorldPoint& b, double bulge)
+        {
+            double dx = b.X - a.X, dy = b.Y - a.Y;
+            double chord = std::sqrt(dx * dx + dy * dy);
+            if (std::abs(bulge) < 1e-4 || chord < 1e-3)
+            {
+                AddSegment(a, b);
+                return;
+            }
+
+            double sweep = 4.0 * std::atan(bulge);
+            double radius = chord / (2.0 * std::sin(std::abs(sweep) / 2.0));
+            // Center lies left of ab for a counter-clockwise arc shorter
+            // than a half turn; (1 - b^2) / (4b) of the chord from its middle
+            double offset = (1.0 - bulge * bulge) / (4.0 * bulge);
+            WorldPoint center((a.X + b.X) / 2.0 - dy * offset, (a.Y + b.Y) / 2.0 + dx * offset);
+            AddArc(center, radius, std::atan2(a.Y - center.Y, a.X - center.X), sweep);
+        }
+
+        // Buckets the added segments; call once after the last Add
+        void Finish()
+        {
+            m_offsets.clear();
+            m_ids.clear();
+            m_seen.assign(Size(), 0);
+            m_stamp = 0;
+            if (Size() == 0)
+            {
+                m_cols = m_rows = 0;
+                return;
+            }
+
+            m_minX = m_minY = std::numeric_limits<double>::max();
+            double maxX = -m_minX, maxY = -m_minY;
+            double lengthSum = 0.0;
+            for (size_t i = 0; i < Size(); ++i)
+            {
+                m_minX = (std::min)({ m_minX, m_ax[i], m_bx[i] });
+                m_minY = (std::min)({ m_minY, m_ay[i], m_by[i] });
+                maxX = (std::max)({ maxX, m_ax[i], m_bx[i] });
+                maxY = (std::max)({ maxY, m_ay[i], m_by[i] });
+                lengthSum += std::abs(m_bx[i] - m_ax[i]) + std::abs(m_by[i] - m_ay[i]);
+            }
+
+            // About one cell per segment, but not finer than the typical
+            // segment: a long line then spans few cells
+            double width = (std::max)(maxX - m_minX, 1.0);
+            double height = (std::max)(maxY - m_minY, 1.0);
+            double byCount = std::sqrt(width * height / static_cast<double>(Size()));
+            m_cellSize = (std::max)({ byCount, lengthSum / Size() / 2.0, MinCellSize });
+            m_cols = static_cast<int>((std::min)(std::ceil(width / m_cellSize), static_cast<double>(MaxCellsPerSide)));
+            m_rows = static_cast<int>((std::min)(std::ceil(height / m_cellSize), static_cast<double>(MaxCellsPerSide)));
+            m_cellSize = (std::max)(width / m_cols, height / m_rows);
+            m_cols = (std::max)(m_cols, 1);
+            m_rows = (std::max)(m_rows, 1);
+
+            // Counting pass, prefix sums, then the filling pass
+            m_offsets.assign(static_cast<size_t>(m_cols) * m_rows + 1, 0);
+            for (uint32_t i = 0; i < Size(); ++i)
+                ForEachCellOf(i, [&](size_t cell) { ++m_offsets[cell + 1]; });
+            for (size_t c = 1; c < m_offsets.size(); ++c)
+                m_offsets[c] += m_offsets[c - 1];
+
+            m_ids.resize(m_offsets.back());
+            std::vector<uint32_t> fill(m_offsets.begin(), m_offsets.end() - 1);
+            for (uint32_t i = 0; i < Size(); ++i)
+                ForEachCellOf(i, [&](size_t cell) { m_ids[fill[cell]++] = i; });
+        }
+
+        // ------------------------------------------------------------
+        // Queries
+        // ------------------------------------------------------------
+
+        uint32_t Size() const { return static_cast<uint32_t>(m_ax.size()); }
+        bool IsEmpty() const { return m_ax.empty(); }
+
+        WorldPoint GetStart(uint32_t i) const { return WorldPoint(m_ax[i], m_ay[i]); }
+        WorldPoint GetEnd(uint32_t i) const { return WorldPoint(m_bx[i], m_by[i]); }
+        uint8_t GetFlags(uint32_t i) const { return m_flags[i]; }
+
+        // Entity the segment was added for, 0 if none was begun
+        uint64_t GetEntity(uint32_t i) const
+        {
+            auto it = std::upper_bound(m_entityStarts.begin(), m_entityStarts.end(), i);
+            return it == m_entityStarts.begin() ? 0 : m_entityIds[it - m_entityStarts.begin() - 1];
+        }
+
+        // All segments as one span for the batched kernels
+        SegmentSpan GetSegments() const
+        {
+            return SegmentSpan{ m_ax.data(), m_ay.data(), m_bx.data(), m_by.data(), m_ax.size() };
+        }
+
+        // fn(segment) once for every segment in the cells within radius
+        // of p; they may still be farther than radius. fn returns false
+        // to stop. Not reentrant: one query at a time per index.
+        template <typename Fn>
+        void ForEachNear(const WorldPoint& p, double radius, Fn&& fn) const
+        {
+            if (m_cols == 0)
+                return;
+
+            int x0 = ColOf(p.X - radius), x1 = ColOf(p.X + radius);
+            int y0 = RowOf(p.Y - radius), y1 = RowOf(p.Y + radius);
+            if (++m_stamp == 0)
+            {
+                std::fill(m_seen.begin(), m_seen.end(), 0);
+                m_stamp = 1;
+            }
+
+            for (int y = y0; y <= y1; ++y)
+            {
+                for (int x = x0; x <= x1; ++x)
+                {
+                    size_t cell = static_cast<size_t>(y) * m_cols + x;
+                    for (uint32_t k = m_offsets[cell]; k < m_offsets[cell + 1]; ++k)
+                    {
+                        uint32_t id = m_ids[k];
+                        if (m_seen[id] == m_stamp)
+                            continue;
+                        m_seen[id] = m_stamp;
+                        if (!fn(id))
+                            return;
+                    }
+                }
+            }
+        }
+
+        // Bytes held, for diagnostics
+        size_t GetMemoryUsage() const
+        {
+            return m_ax.capacity() * sizeof(double) * 4 + m_flags.capacity()
+                + m_entityStarts.capacity() * sizeof(uint32_t) + m_entityIds.capacity() * sizeof(uint64_t)
+                + (m_offsets.capacity() + m_ids.capacity() + m_seen.capacity()) * sizeof(uint32_t);
+        }
+
+    private:
+        static constexpr double Pi = 3.14159265358979323846;
+        static constexpr double ChordError = 1.0;           // mm between a chord and its arc
+        static constexpr double MinCellSize = 10.0;         // mm
+        static constexpr int MaxCellsPerSide = 8192;
+        static constexpr int MaxChords = 65536;             // keeps ChordError up to a 100 km radius
+
+        static int ChordCount(double radius, double sweep)
+        {
+            double step = radius > ChordError ? 2.0 * std::acos(1.0 - ChordError / radius) : Pi / 2.0;
+            return static_cast<int>(std::clamp(std::ceil(sweep / step), 4.0, static_cast<double>(MaxChords)));
+        }
+
+        static WorldPoint PointOnArc(const WorldPoint& center, double radius, double angle)
+        {
+            return WorldPoint(center.X + radius * std::cos(angle), center.Y + radius * std::sin(angle));
+        }
+
+        int ColOf(double x) const
+        {
+            return std::clamp(static_cast<int>(std::floor((x - m_minX) / m_cellSize)), 0, m_cols - 1);
+        }
+
+        int RowOf(double y) const
+        {
+            return std::clamp(static_cast<int>(std::floor((y - m_minY) / m_cellSize)), 0, m_rows - 1);
+        }
+
+        // Cells a segment passes through: row by row, the columns
+        // covered by the part of the segment inside that row
+        template <typename Fn>
+        void ForEachCellOf(uint32_t i, Fn&& fn) const
+        {
+            double ax = m_ax[i], ay = m_ay[i], bx = m_bx[i], by = m_by[i];
+            if (ay > by)
+            {
+                std::swap(ax, bx);
+                std::swap(ay, by);
+            }
+
+            int r0 = RowOf(ay), r1 = RowOf(by);
+            for (int r = r0; r <= r1; ++r)
+            {
+                double xa = ax, xb = bx;
+                if (r0 != r1)
+                {
+                    double rowBottom = m_minY + r * m_cellSize;
+                    double rowTop = rowBottom + m_cellSize;
+                    double t0 = std::clamp((rowBottom - ay) / (by - ay), 0.0, 1.0);
+                    double t1 = std::clamp((rowTop - ay) / (by - ay), 0.0, 1.0);
+                    xa = ax + (bx - ax) * t0;
+                    xb = ax + (bx - ax) * t1;
+                }
+                int c0 = ColOf((std::min)(xa, xb)), c1 = ColOf((std::max)(xa, xb));
+                for (int c = c0; c <= c1; ++c)
+                    fn(static_cast<size_t>(r) * m_cols + c);
+            }
+        }
+
+        // Segments, structure of arrays
+        std::vector<double> m_ax, m_ay, m_bx, m_by;
+        std::vector<uint8_t> m_flags;
+        std::vector<uint32_t> m_entityStarts;   // first segment of each entity, ascending
+        std::vector<uint64_t> m_entityIds;
+
+        // Grid: ids of cell c are m_ids[m_offsets[c] .. m_offsets[c + 1])
+        double m_minX{ 0.0 };
+        double m_minY{ 0.0 };
+        double m_cellSize{ 1.0 };
+        int m_cols{ 0 };
+        int m_rows{ 0 };
+        std::vector<uint32_t> m_offsets;
+        std::vector<uint32_t> m_ids;
+
+        // Per-query visit marks, so a segment spanning cells is reported once
+        mutable std::vector<uint32_t> m_seen;
+        mutable uint32_t m_stamp{ 0 };
+    };
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+#include "pch.h"
+#include "SnapEngine.h"
+#include "ReferenceSnapIndex.h"
+#include "RobustPredicates.h"
+#include "DxfReference.h"
+#include "IfcReference.h"
+#include <vector>
+#include <cmath>
+
+namespace winrt::estimate1
+{
+    // =================================================================
+    // Reference snaps: endpoint, midpoint, intersection, perpendicular
+    // and nearest against visible DXF and IFC underlays
+    // =================================================================
+    // Each layer carries a ReferenceSnapIndex built at import. A query
+    // collects the segments within reach of the cursor from the grid
+    // cells around it and derives every snap kind from that short
+    // list; crossings are tested only among its first MaxCrossingTests
+    // entries. The walk checks the query deadline as it goes, so a
+    // dense underlay gives up a few snaps rather than a frame.
+    // =================================================================
+
+    class ReferenceSnapProvider : public SnapProvider
+    {
+    public:
+        ReferenceSnapProvider(const DxfReferenceManager& dxf, const IfcReferenceManager& ifc)
+            : m_dxf(dxf)
+            , m_ifc(ifc)
+        {
+        }
+
+        SnapKind GetRank() const override { return SnapKind::Endpoint; }
+
+        void Query(const SnapQuery& query, SnapHitList& hits) override
+        {
+            for (const auto& layer : m_dxf.GetLayers())
+            {
+                if (layer && layer->IsVisible())
+                    QueryIndex(layer->GetSnapIndex(), query, hits);
+            }
+            for (const auto& layer : m_ifc.GetLayers())
+            {
+                if (layer && layer->IsVisible())
+                    QueryIndex(layer->GetSnapIndex(), query, hits);
+            }
+        }
+
+        // Snaps of one index; public for tests and benchmarks
+        void QueryIndex(const ReferenceSnapIndex& index, const SnapQuery& query, SnapHitList& hits)
+        {
+            const WorldPoint& p = query.Cursor;
+            double tolerance = query.Tolerance;
+
+            m_near.clear();
+            size_t visited = 0;
+            index.ForEachNear(p, tolerance, [&](uint32_t i) {
+                if ((++visited % DeadlineStride) == 0 && query.IsOverBudget())
+                    return false;
+
+                WorldPoint a = index.GetStart(i), b = index.GetEnd(i);
+                double t;
+                double distSq = GeometryKernels::DistanceSqToSegment(p.X, p.Y, a.X, a.Y, b.X, b.Y, t);
+                if (distSq < tolerance * tolerance)
+                    m_near.push_back({ i, WorldPoint(a.X + (b.X - a.X) * t, a.Y + (b.Y - a.Y) * t) });
+                return true;
+            });
+
+            for (const Near& n : m_near)
+            {
+                WorldPoint a = index.GetStart(n.Segment), b = index.GetEnd(n.Segment);
+                uint8_t flags = index.GetFlags(n.Segment);
+
+                if (flags & ReferenceSnapIndex::StartIsVertex)
+                    Offer(query, hits, index, a, SnapKind::Endpoint, n.Segment);
+                if (flags & ReferenceSnapIndex::EndIsVertex)
+                    Offer(query, hits, index, b, SnapKind::Endpoint, n.Segment);
+                if (flags & ReferenceSnapIndex::HasMidpoint)
+                    Offer(query, hits, index, WorldPoint((a.X + b.X) / 2.0, (a.Y + b.Y) / 2.0), SnapKind::Midpoint, n.Segment);
+
+                if (query.StartPoint)
+                {
+                    double t;
+                    const WorldPoint& s = *query.StartPoint;
+                    GeometryKernels::DistanceSqToSegment(s.X, s.Y, a.X, a.Y, b.X, b.Y, t);
+                    if (t > 0.0 && t < 1.0)
+                        Offer(query, hits, index, WorldPoint(a.X + (b.X - a.X) * t, a.Y + (b.Y - a.Y) * t), SnapKind::Perpendicular, n.Segment);
+                }
+
+                Offer(query, hits, index, n.Closest, SnapKind::Nearest, n.Segment);
+            }
+
+            size_t crossingCount = (std::min)(m_near.size(), MaxCrossingTests);
+            for (size_t i = 0; i < crossingCount; ++i)
+            {
+                WorldPoint a = index.GetStart(m_near[i].Segment), b = index.GetEnd(m_near[i].Segment);
+                for (size_t j = i + 1; j < crossingCount; ++j)
+                {
+                    WorldPoint c = index.GetStart(m_near[j].Segment), d = index.GetEnd(m_near[j].Segment);
+                    double t, u;
+                    if (RobustPredicates::SegmentsCross(a, b, c, d, t, u))
+                        Offer(query, hits, index, WorldPoint(a.X + (b.X - a.X) * t, a.Y + (b.Y - a.Y) * t), SnapKind::Intersection, m_near[i].Segment);
+                }
+            }
+        }
+
+    private:
+        static constexpr size_t DeadlineStride = 256;       // segments between clock reads
+        static constexpr size_t MaxCrossingTests = 64;
+
+        struct Near
+        {
+            uint32_t Segment;
+            WorldPoint Closest;
+        };
+
+        // The hit's source is the entity the segment was drawn for
+        void Offer(const SnapQuery& query, SnapHitList& hits, const ReferenceSnapIndex& index,
+            const WorldPoint& point, SnapKind kind, uint32_t segment) const
+        {
+            double dist = query.Cursor.Distance(point);
+            if (dist < query.Tolerance && hits.CanImprove(kind, dist))
+                hits.Add(MakeHit(query, point, kind, index.GetEntity(segment)));
+        }
+
+        const DxfReferenceManager& m_dxf;
+        const IfcReferenceManager& m_ifc;
+        std::vector<Near> m_near;       // reused between queries
+    };
+}
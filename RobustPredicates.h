@@ -0,0 +1,188 @@
+#pragma once
+
+#include "Camera.h"
+#include <vector>
+#include <cmath>
+
+namespace winrt::estimate1
+{
+    // =================================================================
+    // ROBUST PREDICATES - orientation tests with an exact sign
+    // =================================================================
+    // Topology decisions (which side of a line a point lies on, whether
+    // two axes cross, the order of edges around a node) must agree with
+    // each other, or a face walk can fail to close and a room is lost.
+    // Fixed epsilons cannot promise that; these predicates can.
+    //
+    // Each test first evaluates the determinant in doubles and accepts
+    // it when it is larger than the rounding error bound (Shewchuk's
+    // orient2d filter). Only near-degenerate input, a few calls per
+    // plan, falls back to an exact sum of error-free products.
+    //
+    // Returned values always have the exact sign. Their magnitude is the
+    // rounded determinant on the fast path only; near-degenerate input
+    // returns the leading term of the exact sum, so callers must not
+    // rely on the magnitude there. Modelling tolerances (weld distance,
+    // mitre limits) stay with the callers.
+    // =================================================================
+
+    class RobustPredicates
+    {
+    public:
+        // cross(b - a, d - c): > 0 when cd turns counter-clockwise from ab,
+        // 0 exactly when the two are parallel
+        static double Cross(const WorldPoint& a, const WorldPoint& b, const WorldPoint& c, const WorldPoint& d)
+        {
+            double left = (b.X - a.X) * (d.Y - c.Y);
+            double right = (b.Y - a.Y) * (d.X - c.X);
+            double det = left - right;
+
+            double bound = ErrorBound * (std::abs(left) + std::abs(right));
+            if (det > bound || -det > bound)
+                return det;
+            return CrossExact(a, b, c, d);
+        }
+
+        // > 0 when c lies left of the directed line ab, < 0 right, 0 on it
+        static double Orient2D(const WorldPoint& a, const WorldPoint& b, const WorldPoint& c)
+        {
+            return Cross(a, b, a, c);
+        }
+
+        static int Sign(double v) { return (v > 0.0) - (v < 0.0); }
+
+        static bool AreParallel(const WorldPoint& a, const WorldPoint& b, const WorldPoint& c, const WorldPoint& d)
+        {
+            return Cross(a, b, c, d) == 0.0;
+        }
+
+        // Interiors of segments ab and cd cross at a single point. t and u
+        // are its parameters along ab and cd, strictly inside (0, 1). They
+        // are ratios of Orient2D values, so for nearly touching segments
+        // they are approximate (see above); only the crossing test is exact.
+        static bool SegmentsCross(const WorldPoint& a, const WorldPoint& b,
+                                  const WorldPoint& c, const WorldPoint& d,
+                                  double& t, double& u)
+        {
+            double c1 = Orient2D(a, b, c);
+            double d1 = Orient2D(a, b, d);
+            if (Sign(c1) * Sign(d1) >= 0)
+                return false;
+
+            double a2 = Orient2D(c, d, a);
+            double b2 = Orient2D(c, d, b);
+            if (Sign(a2) * Sign(b2) >= 0)
+                return false;
+
+            t = a2 / (a2 - b2);
+            u = c1 / (c1 - d1);
+            return true;
+        }
+
+        // Counter-clockwise order of the directions center->p and center->q,
+        // starting just past the negative X axis (the order of atan2)
+        static bool IsBeforeAround(const WorldPoint& center, const WorldPoint& p, const WorldPoint& q)
+        {
+            int hp = HalfPlane(center, p);
+            int hq = HalfPlane(center, q);
+            if (hp != hq)
+                return hp < hq;
+            return Orient2D(center, p, q) > 0.0;
+        }
+
+        // Even-odd rule with half-open edges: of polygons sharing an edge, a
+        // point on it is inside exactly one
+        static bool PointInPolygon(const std::vector<WorldPoint>& poly, const WorldPoint& p)
+        {
+            bool inside = false;
+            for (size_t i = 0, j = poly.size() - 1; i < poly.size(); j = i++)
+            {
+                const WorldPoint& pi = poly[i];
+                const WorldPoint& pj = poly[j];
+                if ((pi.Y > p.Y) == (pj.Y > p.Y))
+                    continue;
+
+                // Crossing right of p: p is left of the edge taken upwards
+                double side = pi.Y > pj.Y ? Orient2D(pj, pi, p) : Orient2D(pi, pj, p);
+                if (side > 0.0)
+                    inside = !inside;
+            }
+            return inside;
+        }
+
+    private:
+        // (3 + 16 eps) eps, eps = 2^-53: bound on the rounding error of the
+        // double determinant relative to |left| + |right|
+        static constexpr double Epsilon = 1.1102230246251565e-16;
+        static constexpr double ErrorBound = (3.0 + 16.0 * Epsilon) * Epsilon;
+
+        // 0: angles in (-pi, 0], 1: (0, pi]. Signs of coordinate
+        // differences are exact, so no rounding enters here.
+        static int HalfPlane(const WorldPoint& center, const WorldPoint& p)
+        {
+            if (p.Y < center.Y) return 0;
+            if (p.Y > center.Y) return 1;
+            return p.X > center.X ? 0 : 1;
+        }
+
+        // a + b = x + y exactly
+        static void TwoSum(double a, double b, double& x, double& y)
+        {
+            x = a + b;
+            double bv = x - a;
+            double av = x - bv;
+            y = (a - av) + (b - bv);
+        }
+
+        // Adds the exact product a * b to the expansion e[0..n)
+        static void AddProduct(double a, double b, double* e, int& n)
+        {
+            double hi = a * b;
+            double lo = std::fma(a, b, -hi);
+            AddTerm(lo, e, n);
+            AddTerm(hi, e, n);
+        }
+
+        // Grow-expansion with zero elimination: e stays non-overlapping
+        // and ordered by magnitude, so its sign is that of the last term
+        static void AddTerm(double b, double* e, int& n)
+        {
+            double q = b;
+            int m = 0;
+            for (int i = 0; i < n; ++i)
+            {
+                double x, y;
+                TwoSum(q, e[i], x, y);
+                q = x;
+                if (y != 0.0)
+                    e[m++] = y;
+            }
+            e[m++] = q;
+            n = m;
+        }
+
+        // (bx - ax)(dy - cy) - (by - ay)(dx - cx) as eight exact products.
+        // Returns the largest nonzero term of the expansion: the sign of
+        // the determinant, but not its correctly rounded value.
+        static double CrossExact(const WorldPoint& a, const WorldPoint& b, const WorldPoint& c, const WorldPoint& d)
+        {
+            double e[16];
+            int n = 0;
+            AddProduct(b.X, d.Y, e, n);
+            AddProduct(-b.X, c.Y, e, n);
+            AddProduct(-a.X, d.Y, e, n);
+            AddProduct(a.X, c.Y, e, n);
+            AddProduct(-b.Y, d.X, e, n);
+            AddProduct(b.Y, c.X, e, n);
+            AddProduct(a.Y, d.X, e, n);
+            AddProduct(-a.Y, c.X, e, n);
+
+            for (int i = n - 1; i >= 0; --i)
+            {
+                if (e[i] != 0.0)
+                    return e[i];
+            }
+            return 0.0;
+        }
+    };
+}
@@ -5,6 +5,7 @@
 
 #include "pch.h"
 #include "Models.h"
+#include "RobustPredicates.h"
 #include <vector>
 #include <string>
 #include <numeric>
@@ -60,7 +61,7 @@ namespace winrt::estimate1
         // 
         // =====================================================================
 
-        void SetNumber(const std::wstring& number) { m_number = number; }
+        void SetNumber(const std::wstring& number) { m_number = number; Touch(); }
         const std::wstring& GetNumber() const { return m_number; }
 
         void SetName(const std::wstring& name) 
@@ -68,17 +69,18 @@ namespace winrt::estimate1
             m_name = name;
             //    
             m_category = DetectCategoryFromName(name);
+            Touch();
         }
         const std::wstring& GetName() const { return m_name; }
 
-        void SetCategory(RoomCategory category) { m_category = category; }
+        void SetCategory(RoomCategory category) { m_category = category; Touch(); }
         RoomCategory GetCategory() const { return m_category; }
 
         // =====================================================================
         //   
         // =====================================================================
 
-        void SetCeilingHeight(double height) { m_ceilingHeight = height; }
+        void SetCeilingHeight(double height) { m_ceilingHeight = height; Touch(); }
         double GetCeilingHeight() const { return m_ceilingHeight; }
 
         void SetFloorLevel(double level) { m_floorLevel = level; }
@@ -108,7 +110,9 @@ namespace winrt::estimate1
         void SetContour(std::vector<WorldPoint> contour)
         {
             m_contour = std::move(contour);
+            m_netContour.clear();   // stale until the document recomputes it
             UpdateMetrics();
+            Touch();
         }
 
         double GetArea() const { return m_area; }
@@ -124,6 +128,33 @@ namespace winrt::estimate1
         double GetWallArea() const { return m_perimeter * m_ceilingHeight; }
         double GetWallAreaSqM() const { return GetWallArea() / 1000000.0; } // ?
 
+        // =====================================================================
+        // Net quantities (finish faces of the bounding walls)
+        // =====================================================================
+        // The contour above runs along the wall axes and overstates the floor
+        // by half a wall thickness on every side. The document sets the
+        // finish-face contour (RoomDetector::ComputeNetContour); until then
+        // the net quantities equal the axis ones. Values are cached and
+        // recomputed when the room's revision moves.
+
+        const std::vector<WorldPoint>& GetNetContour() const
+        {
+            return m_netContour.empty() ? m_contour : m_netContour;
+        }
+
+        bool HasNetContour() const { return !m_netContour.empty(); }
+
+        void SetNetContour(std::vector<WorldPoint> contour)
+        {
+            m_netContour = std::move(contour);
+            Touch();
+        }
+
+        double GetNetAreaSqM() const { EnsureNetQuantities(); return m_netAreaSqM; }
+        double GetNetPerimeterM() const { EnsureNetQuantities(); return m_netPerimeterM; }
+        double GetNetWallAreaSqM() const { EnsureNetQuantities(); return m_netWallAreaSqM; }
+        double GetNetVolumeCuM() const { EnsureNetQuantities(); return m_netVolumeCuM; }
+
         // =====================================================================
         //  
         // =====================================================================
@@ -132,6 +163,7 @@ namespace winrt::estimate1
         {
             m_boundaries = std::move(boundaries);
             RebuildBoundingWallIds();
+            Touch();
         }
 
         const std::vector<RoomBoundary>& GetBoundaries() const { return m_boundaries; }
@@ -201,21 +233,8 @@ namespace winrt::estimate1
                 return false;
             }
 
-            // Ray casting point-in-polygon
-            bool inside = false;
-            size_t count = m_contour.size();
-            for (size_t i = 0, j = count - 1; i < count; j = i++)
-            {
-                const WorldPoint& pi = m_contour[i];
-                const WorldPoint& pj = m_contour[j];
-
-                bool intersect = ((pi.Y > point.Y) != (pj.Y > point.Y)) &&
-                    (point.X < (pj.X - pi.X) * (point.Y - pi.Y) / ((pj.Y - pi.Y) + 1e-12) + pi.X);
-                if (intersect)
-                    inside = !inside;
-            }
-
-            return inside;
+            // Ray casting point-in-polygon with exact side tests
+            return RobustPredicates::PointInPolygon(m_contour, point);
         }
 
         void GetBounds(WorldPoint& minPoint, WorldPoint& maxPoint) const override
@@ -229,6 +248,20 @@ namespace winrt::estimate1
         }
 
     private:
+        void EnsureNetQuantities() const
+        {
+            if (m_netCacheValid && m_netCacheRevision == GetRevision())
+                return;
+
+            const auto& poly = GetNetContour();
+            m_netAreaSqM = std::abs(ComputeArea(poly)) / 1000000.0;
+            m_netPerimeterM = ComputePerimeter(poly) / 1000.0;
+            m_netWallAreaSqM = m_netPerimeterM * m_ceilingHeight / 1000.0;
+            m_netVolumeCuM = m_netAreaSqM * m_ceilingHeight / 1000.0;
+            m_netCacheRevision = GetRevision();
+            m_netCacheValid = true;
+        }
+
         void UpdateMetrics()
         {
             RecalcBounds();
@@ -357,6 +390,15 @@ namespace winrt::estimate1
         WorldPoint m_minBounds{ 0, 0 };
         WorldPoint m_maxBounds{ 0, 0 };
 
+        // Finish-face contour and its cached quantities
+        std::vector<WorldPoint> m_netContour;
+        mutable bool m_netCacheValid{ false };
+        mutable uint64_t m_netCacheRevision{ 0 };
+        mutable double m_netAreaSqM{ 0.0 };
+        mutable double m_netPerimeterM{ 0.0 };
+        mutable double m_netWallAreaSqM{ 0.0 };
+        mutable double m_netVolumeCuM{ 0.0 };
+
         // 
         std::wstring m_number;
         std::wstring m_name;
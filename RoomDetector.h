@@ -1,172 +1,646 @@
 #pragma once
 
 #include "Room.h"
+#include "WallStore.h"
+#include "WallGraph.h"
+#include "RobustPredicates.h"
+#include <vector>
 #include <unordered_set>
-#include <sstream>
+#include <unordered_map>
 #include <algorithm>
-#include <functional>
+#include <cmath>
 
 namespace winrt::estimate1
 {
+    // =================================================================
+    // ROOM DETECTOR - minimal faces of the wall planar graph
+    // =================================================================
+    // 1. WallGraph splits the wall axes at crossings and T-junctions and
+    //    welds endpoints closer than MergeTolerance into nodes.
+    // 2. Dangling edges (wall stubs) are pruned; they bound no room.
+    // 3. Outgoing half-edges are sorted by angle around every node and
+    //    each face is walked by turning to the next edge clockwise from
+    //    the one we came in on. Bounded faces come out counter-clockwise
+    //    (positive area); the outer face of each component is negative.
+    //
+    // Every half-edge is visited once, so detection is O(E log E) plus
+    // the intersection pass, and finds exactly the minimal enclosed
+    // rooms regardless of their corner count.
+    //
+    // UpdateRooms re-traces only the faces around changed walls and
+    // updates the existing Room objects in place, so ids, names,
+    // numbers, categories and label positions survive wall edits.
+    // =================================================================
+
+    // Result of an incremental update, for patching zones
+    struct RoomUpdate
+    {
+        std::vector<std::shared_ptr<Room>> Added;
+        std::vector<uint64_t> Removed;
+        std::vector<std::shared_ptr<Room>> Modified;    // same object, new contour
+
+        bool Empty() const { return Added.empty() && Removed.empty() && Modified.empty(); }
+    };
+
     class RoomDetector
     {
     public:
+        static constexpr double MergeTolerance = 5.0;   // mm
+        static constexpr double MinRoomArea = 1000.0;   // mm^2, drops slivers
+
         static std::vector<std::shared_ptr<Room>> DetectRooms(const std::vector<std::unique_ptr<Wall>>& walls)
+        {
+            WallHotData hot;
+            hot.Reserve(walls.size());
+            for (const auto& wall : walls)
+            {
+                if (wall) hot.PushBack(*wall);
+            }
+            return DetectRooms(hot);
+        }
+
+        // Reads endpoints from the dense WallStore arrays (no per-wall pointer chasing)
+        static std::vector<std::shared_ptr<Room>> DetectRooms(const WallHotData& walls)
+        {
+            if (walls.Size() < 3)
+                return {};
+            return DetectRooms(WallGraph::Build(walls, MergeTolerance));
+        }
+
+        // Reuses the document's cached graph (DocumentModel::GetWallGraph)
+        static std::vector<std::shared_ptr<Room>> DetectRooms(const WallGraph& graph)
         {
             std::vector<std::shared_ptr<Room>> rooms;
-            if (walls.size() < 3)
-                return rooms;
+            FaceWalker walker(graph);
+            std::vector<bool> visited(graph.GetEdges().size() * 2, false);
+
+            for (int h = 0; h < walker.HalfEdgeCount(); ++h)
+            {
+                Face face;
+                if (walker.Trace(h, visited, face))
+                    rooms.push_back(MakeRoom(face, rooms.size() + 1));
+            }
+            return rooms;
+        }
 
-            const double mergeTolerance = 5.0; // ��
+        // Brings 'rooms' up to date after the given walls were added, moved
+        // or removed. Rooms bounded by a changed wall, or whose bounds a
+        // changed wall reaches into, are re-traced from the walls around
+        // them; the rest are left alone. A re-traced face takes over the
+        // old room it overlaps (the largest one when rooms merge), so the
+        // larger part of a split room keeps its identity.
+        static RoomUpdate UpdateRooms(const WallGraph& graph,
+            std::vector<std::shared_ptr<Room>>& rooms,
+            const std::vector<uint64_t>& changedWalls,
+            bool fullRetrace = false)
+        {
+            RoomUpdate update;
+            std::unordered_set<uint64_t> changed(changedWalls.begin(), changedWalls.end());
+            const auto& nodes = graph.GetNodes();
+            const auto& edges = graph.GetEdges();
 
-            struct Node
+            // Where the changed walls are now
+            std::vector<std::pair<WorldPoint, WorldPoint>> changedBounds;
+            for (const auto& e : edges)
             {
-                WorldPoint pt;
-            };
+                if (!changed.count(e.WallId)) continue;
+                const WorldPoint& a = nodes[e.A];
+                const WorldPoint& b = nodes[e.B];
+                changedBounds.push_back({ WorldPoint((std::min)(a.X, b.X), (std::min)(a.Y, b.Y)),
+                                          WorldPoint((std::max)(a.X, b.X), (std::max)(a.Y, b.Y)) });
+            }
 
-            std::vector<Node> nodes;
-            auto findOrCreateNode = [&](const WorldPoint& p) -> int
+            // Dirty rooms, and the walls whose faces must be re-traced
+            std::vector<bool> dirty(rooms.size(), fullRetrace);
+            std::unordered_set<uint64_t> seedWalls(changed);
+            for (size_t i = 0; i < rooms.size(); ++i)
             {
-                for (int i = 0; i < static_cast<int>(nodes.size()); ++i)
+                const Room& room = *rooms[i];
+                if (!dirty[i])
+                {
+                    for (uint64_t id : room.GetBoundingWallIds())
+                        if (changed.count(id)) { dirty[i] = true; break; }
+                }
+                if (!dirty[i] && !changedBounds.empty())
                 {
-                    if (nodes[i].pt.Distance(p) <= mergeTolerance)
-                        return i;
+                    WorldPoint lo, hi;
+                    room.GetBounds(lo, hi);
+                    for (const auto& b : changedBounds)
+                    {
+                        if (b.first.X <= hi.X + MergeTolerance && b.second.X >= lo.X - MergeTolerance &&
+                            b.first.Y <= hi.Y + MergeTolerance && b.second.Y >= lo.Y - MergeTolerance)
+                        {
+                            dirty[i] = true;
+                            break;
+                        }
+                    }
                 }
-                nodes.push_back(Node{ p });
-                return static_cast<int>(nodes.size() - 1);
+                if (dirty[i])
+                    seedWalls.insert(room.GetBoundingWallIds().begin(), room.GetBoundingWallIds().end());
+            }
+
+            // Re-trace the faces along the seed walls
+            FaceWalker walker(graph);
+            std::vector<bool> visited(edges.size() * 2, false);
+            std::vector<Face> faces;
+            for (int h = 0; h < walker.HalfEdgeCount(); ++h)
+            {
+                if (!fullRetrace && !seedWalls.count(edges[h >> 1].WallId))
+                    continue;
+                Face face;
+                if (walker.Trace(h, visited, face))
+                    faces.push_back(std::move(face));
+            }
+
+            // Largest faces pick their old room first
+            std::sort(faces.begin(), faces.end(), [](const Face& a, const Face& b) { return a.Area > b.Area; });
+
+            std::vector<bool> claimed(rooms.size(), false);
+            std::vector<std::shared_ptr<Room>> added;
+            for (Face& face : faces)
+            {
+                // A clean neighbour traced through a shared seed wall: unchanged
+                int clean = FindOverlapping(face, rooms, claimed, dirty, false);
+                if (clean >= 0 && SameContour(rooms[clean]->GetContour(), face.Contour))
+                {
+                    claimed[clean] = true;
+                    continue;
+                }
+
+                int match = FindOverlapping(face, rooms, claimed, dirty, true);
+                if (match >= 0)
+                {
+                    claimed[match] = true;
+                    Room& room = *rooms[match];
+                    if (!SameContour(room.GetContour(), face.Contour))
+                    {
+                        room.SetContour(std::move(face.Contour));
+                        room.SetBoundaries(std::move(face.Boundaries));
+                        update.Modified.push_back(rooms[match]);
+                    }
+                    continue;
+                }
+
+                added.push_back(MakeRoom(face, 0));
+            }
+
+            // Dirty rooms nobody took over are gone
+            std::vector<std::shared_ptr<Room>> kept;
+            kept.reserve(rooms.size() + added.size());
+            int maxNumber = 0;
+            for (size_t i = 0; i < rooms.size(); ++i)
+            {
+                if (dirty[i] && !claimed[i])
+                {
+                    update.Removed.push_back(rooms[i]->GetId());
+                    continue;
+                }
+                maxNumber = (std::max)(maxNumber, ParseNumber(rooms[i]->GetNumber()));
+                kept.push_back(rooms[i]);
+            }
+
+            for (auto& room : added)
+            {
+                room->SetNumber(std::to_wstring(++maxNumber));
+                kept.push_back(room);
+                update.Added.push_back(room);
+            }
+
+            rooms = std::move(kept);
+            return update;
+        }
+
+        // Finish-face contour of a room. Each boundary run is shifted into
+        // the room by insetFor(boundary), the distance from the wall axis to
+        // the wall face on the room side, and neighbouring runs are
+        // re-intersected (mitred corners). Collinear runs of different
+        // thickness get a step between their faces. Returns an empty contour
+        // when the insets swallow the room.
+        template <typename InsetFn>
+        static std::vector<WorldPoint> ComputeNetContour(const std::vector<RoomBoundary>& boundaries, InsetFn insetFor)
+        {
+            struct Line
+            {
+                WorldPoint P;       // on the shifted line
+                WorldPoint D;       // unit direction
+                WorldPoint Start;   // start of the axis run
             };
 
-            // ������ ����
-            std::vector<std::vector<int>> adj;
-            auto ensureAdjSize = [&](int idx)
+            std::vector<Line> lines;
+            lines.reserve(boundaries.size());
+            for (const auto& b : boundaries)
             {
-                if (idx >= static_cast<int>(adj.size()))
-                    adj.resize(idx + 1);
+                double dx = b.EndPoint.X - b.StartPoint.X;
+                double dy = b.EndPoint.Y - b.StartPoint.Y;
+                double len = std::sqrt(dx * dx + dy * dy);
+                if (len < 1e-6) continue;
+
+                WorldPoint d(dx / len, dy / len);
+                double inset = insetFor(b);
+                // Room lies to the left of a counter-clockwise run
+                lines.push_back({ WorldPoint(b.StartPoint.X - d.Y * inset, b.StartPoint.Y + d.X * inset), d, b.StartPoint });
+            }
+            if (lines.size() < 3)
+                return {};
+
+            auto project = [](const Line& l, const WorldPoint& p) {
+                double t = (p.X - l.P.X) * l.D.X + (p.Y - l.P.Y) * l.D.Y;
+                return WorldPoint(l.P.X + l.D.X * t, l.P.Y + l.D.Y * t);
             };
 
+            std::vector<WorldPoint> result;
+            result.reserve(lines.size() + 2);
+            for (size_t i = 0; i < lines.size(); ++i)
+            {
+                const Line& a = lines[(i + lines.size() - 1) % lines.size()];
+                const Line& b = lines[i];
+                double cross = a.D.X * b.D.Y - a.D.Y * b.D.X;
+                if (std::abs(cross) < 1e-9)
+                {
+                    result.push_back(project(a, b.Start));
+                    result.push_back(project(b, b.Start));
+                    continue;
+                }
+                double t = ((b.P.X - a.P.X) * b.D.Y - (b.P.Y - a.P.Y) * b.D.X) / cross;
+                result.push_back(WorldPoint(a.P.X + a.D.X * t, a.P.Y + a.D.Y * t));
+            }
+
+            // Insets wider than the room turn the polygon inside out
+            if (Room::ComputeArea(result) <= 0.0)
+                return {};
+            return RemoveCollinear(result);
+        }
+
+        // Face offsets of a wall (Wall::GetFaceOffsets) and its direction.
+        // Copied out of the document so net contours can be computed on a
+        // worker thread without touching live walls.
+        struct WallFaces
+        {
+            double Left{ 0.0 };
+            double Right{ 0.0 };
+            WorldPoint Direction{ 1.0, 0.0 };
+        };
+        using WallFaceTable = std::unordered_map<uint64_t, WallFaces>;
+
+        // Walls is a WallStore or a snapshot's wall list
+        template <typename Walls>
+        static WallFaceTable BuildWallFaceTable(const Walls& walls)
+        {
+            WallFaceTable faces;
             for (const auto& wall : walls)
             {
-                if (!wall) continue;
-                int a = findOrCreateNode(wall->GetStartPoint());
-                int b = findOrCreateNode(wall->GetEndPoint());
-                if (a == b) continue;
-                ensureAdjSize((std::max)(a, b));
+                WallFaces f;
+                wall->GetFaceOffsets(f.Left, f.Right);
+                f.Direction = wall->GetDirection();
+                faces[wall->GetId()] = f;
+            }
+            return faces;
+        }
+
+        // Distance from the axis to the wall face on the room side of b
+        static double InsetFor(const WallFaceTable& faces, const RoomBoundary& b)
+        {
+            auto it = faces.find(b.ElementId);
+            if (it == faces.end() || b.Type != RoomBoundaryType::Wall)
+                return 0.0;
+
+            const WorldPoint& dir = it->second.Direction;
+            bool sameWay = (b.EndPoint.X - b.StartPoint.X) * dir.X + (b.EndPoint.Y - b.StartPoint.Y) * dir.Y >= 0.0;
+            // Room is left of the run: the wall's left face when running the same way
+            return sameWay ? it->second.Left : -it->second.Right;
+        }
+
+        // Finish-face contours of rooms whose walls changed (thickness and
+        // location line included); new and re-traced rooms have none yet.
+        // Returns the rooms that got a new net contour.
+        static std::vector<std::shared_ptr<Room>> RefreshNetContours(std::vector<std::shared_ptr<Room>>& rooms,
+            const std::vector<uint64_t>& changedWalls,
+            bool all,
+            const WallFaceTable& faces)
+        {
+            std::unordered_set<uint64_t> changed(changedWalls.begin(), changedWalls.end());
+            auto insetFor = [&faces](const RoomBoundary& b) { return InsetFor(faces, b); };
+
+            std::vector<std::shared_ptr<Room>> refreshed;
+            for (const auto& room : rooms)
+            {
+                bool stale = all || !room->HasNetContour();
+                for (auto it = room->GetBoundingWallIds().begin(); !stale && it != room->GetBoundingWallIds().end(); ++it)
+                    stale = changed.count(*it) != 0;
 
-                auto pushUnique = [](std::vector<int>& vec, int v)
+                if (stale)
                 {
-                    if (std::find(vec.begin(), vec.end(), v) == vec.end())
-                        vec.push_back(v);
-                };
+                    room->SetNetContour(ComputeNetContour(room->GetBoundaries(), insetFor));
+                    refreshed.push_back(room);
+                }
+            }
+            return refreshed;
+        }
+
+        // UpdateRooms followed by RefreshNetContours. Rooms whose net
+        // contour changed without a re-trace (a thickness edit) are added
+        // to Modified so zones drop their cached totals.
+        static RoomUpdate Recompute(const WallGraph& graph,
+            std::vector<std::shared_ptr<Room>>& rooms,
+            const std::vector<uint64_t>& changedWalls,
+            bool fullRetrace,
+            const WallFaceTable& faces)
+        {
+            RoomUpdate update = UpdateRooms(graph, rooms, changedWalls, fullRetrace);
+
+            std::unordered_set<const Room*> listed;
+            for (const auto& room : update.Added) listed.insert(room.get());
+            for (const auto& room : update.Modified) listed.insert(room.get());
 
-                pushUnique(adj[a], b);
-                pushUnique(adj[b], a);
+            for (const auto& room : RefreshNetContours(rooms, changedWalls, fullRetrace, faces))
+            {
+                if (listed.insert(room.get()).second)
+                    update.Modified.push_back(room);
             }
+            return update;
+        }
+
+    private:
+        struct Face
+        {
+            std::vector<WorldPoint> Contour;
+            std::vector<RoomBoundary> Boundaries;
+            double Area{ 0.0 };
+        };
 
-            std::vector<WorldPoint> nodePoints;
-            nodePoints.reserve(nodes.size());
-            for (const auto& n : nodes)
+        // Half-edge view of a WallGraph with dangling edges pruned.
+        // Half-edge h = 2e runs A->B, h = 2e+1 runs B->A.
+        class FaceWalker
+        {
+        public:
+            explicit FaceWalker(const WallGraph& graph)
+                : m_nodes(graph.GetNodes())
+                , m_edges(graph.GetEdges())
             {
-                nodePoints.push_back(n.pt);
+                PruneDangling();
+                CollectOutgoing();
             }
 
-            // ����� ������ ������� DFS
-            const int maxDepth = 12;
-            std::unordered_set<std::wstring> uniqueCycles;
-            std::vector<int> path;
+            int HalfEdgeCount() const { return static_cast<int>(m_edges.size() * 2); }
 
-            std::function<void(int, int, int)> dfs = [&](int start, int current, int depth)
+            // Walks the face left of 'start'. Returns false if the half-edge
+            // was already walked, is pruned, or bounds no room.
+            bool Trace(int start, std::vector<bool>& visited, Face& face) const
             {
-                if (depth > maxDepth)
-                    return;
+                if (!m_edgeAlive[start >> 1] || visited[start])
+                    return false;
+
+                std::vector<int> loop;
+                int h = start;
+                do
+                {
+                    visited[h] = true;
+                    loop.push_back(h);
+                    h = Next(h);
+                } while (h != start && !visited[h]);
+
+                if (h != start || loop.size() < 3)
+                    return false;
 
-                for (int next : adj[current])
+                std::vector<WorldPoint> contour;
+                contour.reserve(loop.size());
+                for (int e : loop)
+                    contour.push_back(m_nodes[Tail(e)]);
+
+                // Outer faces run clockwise
+                double area = Room::ComputeArea(contour);
+                if (area < MinRoomArea)
+                    return false;
+
+                // Boundaries per wall run; consecutive pieces of one wall are merged
+                std::vector<RoomBoundary> boundaries;
+                for (size_t i = 0; i < loop.size(); ++i)
                 {
-                    if (next == start && path.size() >= 3)
+                    uint64_t wallId = m_edges[loop[i] >> 1].WallId;
+                    const WorldPoint& p = contour[i];
+                    const WorldPoint& q = contour[(i + 1) % contour.size()];
+                    if (!boundaries.empty() && boundaries.back().ElementId == wallId)
                     {
-                        // �������� ����
-                        std::vector<int> cycle = path;
-                        AddCycle(cycle, nodePoints, uniqueCycles, rooms);
-                        continue;
+                        boundaries.back().EndPoint = q;
+                        boundaries.back().Length += p.Distance(q);
                     }
+                    else
+                    {
+                        boundaries.emplace_back(wallId, RoomBoundaryType::Wall, p, q);
+                    }
+                }
+                if (boundaries.size() > 1 && boundaries.front().ElementId == boundaries.back().ElementId)
+                {
+                    boundaries.front().StartPoint = boundaries.back().StartPoint;
+                    boundaries.front().Length += boundaries.back().Length;
+                    boundaries.pop_back();
+                }
 
-                    if (std::find(path.begin(), path.end(), next) != path.end())
-                        continue; // �������� �������� � ����
+                face.Contour = RemoveCollinear(contour);
+                face.Boundaries = std::move(boundaries);
+                face.Area = area;
+                return true;
+            }
 
-                    path.push_back(next);
-                    dfs(start, next, depth + 1);
-                    path.pop_back();
+        private:
+            int Tail(int h) const { return (h & 1) ? m_edges[h >> 1].B : m_edges[h >> 1].A; }
+            int Head(int h) const { return (h & 1) ? m_edges[h >> 1].A : m_edges[h >> 1].B; }
+
+            // Next half-edge of the face: clockwise neighbour of the twin
+            int Next(int h) const
+            {
+                const auto& out = Around(Head(h));
+                int k = m_slot[h ^ 1];
+                return out[(k + static_cast<int>(out.size()) - 1) % out.size()];
+            }
+
+            // Prune dangling edges repeatedly: a stub cannot bound a room
+            void PruneDangling()
+            {
+                std::vector<int> degree(m_nodes.size(), 0);
+                std::vector<std::vector<int>> incident(m_nodes.size());
+                for (int i = 0; i < static_cast<int>(m_edges.size()); ++i)
+                {
+                    ++degree[m_edges[i].A];
+                    ++degree[m_edges[i].B];
+                    incident[m_edges[i].A].push_back(i);
+                    incident[m_edges[i].B].push_back(i);
                 }
-            };
 
-            for (int i = 0; i < static_cast<int>(nodes.size()); ++i)
+                m_edgeAlive.assign(m_edges.size(), true);
+                std::vector<int> stack;
+                for (int n = 0; n < static_cast<int>(m_nodes.size()); ++n)
+                    if (degree[n] == 1) stack.push_back(n);
+
+                while (!stack.empty())
+                {
+                    int n = stack.back();
+                    stack.pop_back();
+                    for (int e : incident[n])
+                    {
+                        if (!m_edgeAlive[e]) continue;
+                        m_edgeAlive[e] = false;
+                        int other = m_edges[e].A == n ? m_edges[e].B : m_edges[e].A;
+                        --degree[n];
+                        if (--degree[other] == 1)
+                            stack.push_back(other);
+                    }
+                }
+            }
+
+            void CollectOutgoing()
+            {
+                m_outgoing.assign(m_nodes.size(), {});
+                for (int e = 0; e < static_cast<int>(m_edges.size()); ++e)
+                {
+                    if (!m_edgeAlive[e]) continue;
+                    m_outgoing[m_edges[e].A].push_back(2 * e);
+                    m_outgoing[m_edges[e].B].push_back(2 * e + 1);
+                }
+                m_sorted.assign(m_nodes.size(), false);
+                m_slot.assign(m_edges.size() * 2, -1);
+            }
+
+            // Outgoing half-edges sorted counter-clockwise. Sorted on first
+            // use, so a partial re-trace only pays for the nodes it visits.
+            const std::vector<int>& Around(int node) const
             {
-                path.clear();
-                path.push_back(i);
-                dfs(i, i, 0);
+                auto& out = m_outgoing[node];
+                if (m_sorted[node])
+                    return out;
+
+                // Exact angular order: nearly collinear edges never tie or
+                // swap, so every face walk closes (RobustPredicates.h)
+                const WorldPoint& center = m_nodes[node];
+                std::sort(out.begin(), out.end(), [&](int x, int y) {
+                    const WorldPoint& p = m_nodes[Head(x)];
+                    const WorldPoint& q = m_nodes[Head(y)];
+                    if (RobustPredicates::IsBeforeAround(center, p, q)) return true;
+                    if (RobustPredicates::IsBeforeAround(center, q, p)) return false;
+                    return x < y;
+                });
+                for (int i = 0; i < static_cast<int>(out.size()); ++i)
+                    m_slot[out[i]] = i;
+                m_sorted[node] = true;
+                return out;
             }
 
-            return rooms;
+            const std::vector<WorldPoint>& m_nodes;
+            const std::vector<WallGraph::Edge>& m_edges;
+            std::vector<bool> m_edgeAlive;
+            mutable std::vector<std::vector<int>> m_outgoing;
+            mutable std::vector<bool> m_sorted;
+            mutable std::vector<int> m_slot;
+        };
+
+        static std::shared_ptr<Room> MakeRoom(Face& face, size_t number)
+        {
+            auto room = std::make_shared<Room>();
+            room->SetContour(std::move(face.Contour));
+            room->SetBoundaries(std::move(face.Boundaries));
+            room->SetName(L"���������");
+            room->SetNumber(std::to_wstring(number));
+            return room;
         }
 
-    private:
-        static void AddCycle(const std::vector<int>& cycleNodes,
-            const std::vector<WorldPoint>& points,
-            std::unordered_set<std::wstring>& uniqueCycles,
-            std::vector<std::shared_ptr<Room>>& rooms)
-        {
-            if (cycleNodes.size() < 3)
-                return;
-
-            // ������������ ������������� ��� ������������
-            std::vector<int> normalized = cycleNodes;
-            // ����� ����������� ������
-            auto minIt = std::min_element(normalized.begin(), normalized.end());
-            size_t minPos = static_cast<size_t>(std::distance(normalized.begin(), minIt));
-
-            auto rotateToStart = [&](const std::vector<int>& src, size_t start) {
-                std::vector<int> res;
-                res.reserve(src.size());
-                for (size_t i = 0; i < src.size(); ++i)
+        // Unclaimed room (dirty or clean, as asked) overlapping the face:
+        // one contains a point of the other. Largest room wins.
+        static int FindOverlapping(const Face& face,
+            const std::vector<std::shared_ptr<Room>>& rooms,
+            const std::vector<bool>& claimed,
+            const std::vector<bool>& dirty,
+            bool wantDirty)
+        {
+            WorldPoint faceCentroid = Centroid(face.Contour);
+            int best = -1;
+            double bestArea = 0.0;
+            for (size_t i = 0; i < rooms.size(); ++i)
+            {
+                if (claimed[i] || dirty[i] != wantDirty)
+                    continue;
+                const Room& room = *rooms[i];
+                if (room.GetContour().size() < 3)
+                    continue;
+
+                bool overlaps = room.HitTest(faceCentroid, 0.0) ||
+                                Contains(face.Contour, Centroid(room.GetContour()));
+                if (overlaps && std::abs(room.GetArea()) > bestArea)
                 {
-                    res.push_back(src[(start + i) % src.size()]);
+                    bestArea = std::abs(room.GetArea());
+                    best = static_cast<int>(i);
                 }
-                return res;
-            };
+            }
+            return best;
+        }
 
-            auto forward = rotateToStart(normalized, minPos);
-            auto reversed = forward;
-            std::reverse(reversed.begin(), reversed.end());
-            auto canonicalVec = (forward < reversed) ? forward : reversed;
+        static WorldPoint Centroid(const std::vector<WorldPoint>& poly)
+        {
+            double a = Room::ComputeArea(poly);
+            if (std::abs(a) < 1e-9)
+                return poly.empty() ? WorldPoint{ 0, 0 } : poly.front();
 
-            std::wstringstream ss;
-            for (int v : canonicalVec)
+            double cx = 0.0, cy = 0.0;
+            for (size_t i = 0, j = poly.size() - 1; i < poly.size(); j = i++)
             {
-                ss << v << L"-";
+                double f = poly[j].X * poly[i].Y - poly[i].X * poly[j].Y;
+                cx += (poly[j].X + poly[i].X) * f;
+                cy += (poly[j].Y + poly[i].Y) * f;
             }
-            auto key = ss.str();
-            if (uniqueCycles.find(key) != uniqueCycles.end())
-                return;
+            return WorldPoint(cx / (6.0 * a), cy / (6.0 * a));
+        }
 
-            uniqueCycles.insert(key);
+        static bool Contains(const std::vector<WorldPoint>& poly, const WorldPoint& p)
+        {
+            return RobustPredicates::PointInPolygon(poly, p);
+        }
+
+        // Same polygon up to the starting vertex
+        static bool SameContour(const std::vector<WorldPoint>& a, const std::vector<WorldPoint>& b)
+        {
+            if (a.size() != b.size() || a.empty())
+                return false;
 
-            // ��������� ������
-            std::vector<WorldPoint> contour;
-            contour.reserve(canonicalVec.size());
-            for (int idx : canonicalVec)
+            for (size_t shift = 0; shift < b.size(); ++shift)
             {
-                contour.push_back(points[idx]);
+                if (a[0].Distance(b[shift]) > 0.5)
+                    continue;
+                bool same = true;
+                for (size_t i = 1; i < a.size() && same; ++i)
+                    same = a[i].Distance(b[(i + shift) % b.size()]) <= 0.5;
+                if (same)
+                    return true;
             }
+            return false;
+        }
 
-            // ��������� �������
-            double area = Room::ComputeArea(contour);
-            if (std::abs(area) < 1000.0) // ����� 1 ��.� � ����������
-                return;
+        static int ParseNumber(const std::wstring& number)
+        {
+            int value = 0;
+            for (wchar_t c : number)
+            {
+                if (c < L'0' || c > L'9') return 0;
+                value = value * 10 + (c - L'0');
+            }
+            return value;
+        }
 
-            auto room = std::make_shared<Room>();
-            room->SetContour(contour);
-            room->SetName(L"���������");
-            room->SetNumber(std::to_wstring(rooms.size() + 1));
-            rooms.push_back(room);
+        // T-junctions from the outside leave straight-through vertices
+        static std::vector<WorldPoint> RemoveCollinear(const std::vector<WorldPoint>& pts)
+        {
+            std::vector<WorldPoint> result;
+            size_t n = pts.size();
+            for (size_t i = 0; i < n; ++i)
+            {
+                const WorldPoint& prev = pts[(i + n - 1) % n];
+                const WorldPoint& cur = pts[i];
+                const WorldPoint& nxt = pts[(i + 1) % n];
+                double cross = (cur.X - prev.X) * (nxt.Y - cur.Y) - (cur.Y - prev.Y) * (nxt.X - cur.X);
+                double len = prev.Distance(nxt);
+                if (len > 0.0 && std::abs(cross) / len <= 1e-6 * len + 1e-9)
+                    continue;
+                result.push_back(cur);
+            }
+            return result.size() >= 3 ? result : pts;
         }
     };
 }
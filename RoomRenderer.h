@@ -7,6 +7,10 @@
 #include "Room.h"
 #include "Camera.h"
 #include "Element.h"
+#include "DisplayList.h"
+#include "DisplayListRenderer.h"
+#include "TextLayoutCache.h"
+#include <algorithm>
 #include <cmath>
 #include <vector>
 
@@ -53,6 +57,16 @@ namespace winrt::estimate1
             const Microsoft::Graphics::Canvas::CanvasDrawingSession& session,
             const Camera& camera,
             const std::vector<std::shared_ptr<Room>>& rooms)
+        {
+            m_scratch.Clear();
+            Build(m_scratch, rooms);
+            m_backend.Draw(session, camera, m_scratch);
+        }
+
+        //     
+        void Build(
+            DisplayList& list,
+            const std::vector<std::shared_ptr<Room>>& rooms)
         {
             if (!m_settings.ShowRooms)
                 return;
@@ -61,62 +75,85 @@ namespace winrt::estimate1
             {
                 if (room)
                 {
-                    DrawRoom(session, camera, *room);
+                    BuildRoom(list, *room);
                 }
             }
+
+            m_names.EndPass();
+            m_values.EndPass();
         }
 
     private:
-        void DrawRoom(
-            const Microsoft::Graphics::Canvas::CanvasDrawingSession& session,
-            const Camera& camera,
+        void BuildRoom(
+            DisplayList& list,
             const Room& room)
         {
             const auto& contour = room.GetContour();
             if (contour.size() < 3)
                 return;
 
-            auto builder = Microsoft::Graphics::Canvas::Geometry::CanvasPathBuilder(session.Device());
-            ScreenPoint start = camera.WorldToScreen(contour.front());
-            builder.BeginFigure(start.X, start.Y);
-            for (size_t i = 1; i < contour.size(); ++i)
-            {
-                ScreenPoint pt = camera.WorldToScreen(contour[i]);
-                builder.AddLine(pt.X, pt.Y);
-            }
-            builder.EndFigure(Microsoft::Graphics::Canvas::Geometry::CanvasFigureLoop::Closed);
-
-            auto geometry = Microsoft::Graphics::Canvas::Geometry::CanvasGeometry::CreatePath(builder);
-
             // 
             if (m_settings.FillStyle != RoomFillStyle::None)
             {
                 Windows::UI::Color fillColor = GetRoomColor(room);
                 uint8_t opacity = (m_settings.FillOpacity > 100 ? 100 : m_settings.FillOpacity);
                 fillColor.A = static_cast<uint8_t>(opacity * 255 / 100);
-                session.FillGeometry(geometry, fillColor);
+                list.AddPolygon(list.AddStyle(DisplayStyle::Fill(fillColor)), contour);
             }
 
             // 
-            session.DrawGeometry(
-                geometry,
-                Windows::UI::ColorHelper::FromArgb(255, 80, 80, 80),
-                m_settings.BorderWidth);
+            list.AddPolyline(
+                list.AddStyle(DisplayStyle::Stroke(
+                    Windows::UI::ColorHelper::FromArgb(255, 80, 80, 80),
+                    m_settings.BorderWidth)),
+                contour, true);
 
             if (m_settings.ShowLabels)
             {
-                DrawRoomLabel(session, camera, room);
+                BuildRoomLabel(list, room);
             }
         }
 
-        void DrawRoomLabel(
-            const Microsoft::Graphics::Canvas::CanvasDrawingSession& session,
-            const Camera& camera,
+        void BuildRoomLabel(
+            DisplayList& list,
             const Room& room)
         {
-            WorldPoint labelPoint = room.GetLabelPoint();
-            ScreenPoint screenPos = camera.WorldToScreen(labelPoint);
+            // /  / -  : 
+            //       .
+            //       ,
+            //  /   .
+            const std::wstring& name = m_names.Get(room.GetId(), room.GetRevision(),
+                [&]() { return FormatRoomName(room); });
+
+            double areaSqM = m_settings.ShowArea ? room.GetNetAreaSqM() : 0.0;
+            double perimeterM = m_settings.ShowPerimeter ? room.GetNetPerimeterM() : 0.0;
+            uint64_t stamp = LabelTextCache::ValueStamp(areaSqM);
+            stamp = LabelTextCache::CombineStamp(stamp, LabelTextCache::ValueStamp(perimeterM));
+            stamp = LabelTextCache::CombineStamp(stamp,
+                (m_settings.ShowArea ? 1u : 0u) | (m_settings.ShowPerimeter ? 2u : 0u));
+            const std::wstring& values = m_values.Get(room.GetId(), stamp,
+                [&]() { return FormatRoomValues(areaSqM, perimeterM); });
+
+            //       
+            float nameHeight = LineCount(name) * LabelLinePx;
+            float valuesHeight = LineCount(values) * LabelLinePx;
+            Windows::UI::Color textColor = Windows::UI::ColorHelper::FromArgb(255, 40, 40, 40);
+            DisplayStyle style = DisplayStyle::Text(textColor, 12.0f, DisplayFont::Sans, DisplayTextAlign::Center);
+
+            if (!name.empty())
+            {
+                list.AddText(list.AddStyle(style.WithPriority(DisplayLabelPriority::RoomName)),
+                    room.GetLabelPoint(), name, 0.0f, valuesHeight > 0.0f ? -valuesHeight / 2 - LabelGapPx : 0.0f);
+            }
+            if (!values.empty())
+            {
+                list.AddText(list.AddStyle(style.WithPriority(DisplayLabelPriority::RoomArea)),
+                    room.GetLabelPoint(), values, 0.0f, nameHeight > 0.0f ? nameHeight / 2 + LabelGapPx : 0.0f);
+            }
+        }
 
+        static std::wstring FormatRoomName(const Room& room)
+        {
             std::wstring labelText;
 
             if (!room.GetNumber().empty())
@@ -131,20 +168,22 @@ namespace winrt::estimate1
                 labelText += room.GetName();
             }
 
+            return labelText;
+        }
+
+        std::wstring FormatRoomValues(double areaSqM, double perimeterM) const
+        {
+            std::wstring labelText;
+
             if (m_settings.ShowArea)
             {
-                double areaSqM = std::abs(room.GetArea()) / 1000000.0;
                 wchar_t areaStr[64];
                 swprintf_s(areaStr, L"%.2f ?", areaSqM);
-
-                if (!labelText.empty())
-                    labelText += L"\n";
                 labelText += areaStr;
             }
 
             if (m_settings.ShowPerimeter)
             {
-                double perimeterM = room.GetPerimeter() / 1000.0;
                 wchar_t perimStr[64];
                 swprintf_s(perimStr, L"P: %.2f ", perimeterM);
 
@@ -153,33 +192,14 @@ namespace winrt::estimate1
                 labelText += perimStr;
             }
 
-            if (labelText.empty())
-                return;
-
-            auto textFormat = Microsoft::Graphics::Canvas::Text::CanvasTextFormat();
-            textFormat.FontFamily(L"Segoe UI");
-            textFormat.FontSize(12.0f);
-            textFormat.HorizontalAlignment(Microsoft::Graphics::Canvas::Text::CanvasHorizontalAlignment::Center);
-            textFormat.VerticalAlignment(Microsoft::Graphics::Canvas::Text::CanvasVerticalAlignment::Center);
-
-            auto textLayout = Microsoft::Graphics::Canvas::Text::CanvasTextLayout(
-                session.Device(),
-                labelText,
-                textFormat,
-                300.0f,
-                200.0f);
-
-            float textWidth = textLayout.LayoutBounds().Width;
-            float textHeight = textLayout.LayoutBounds().Height;
-
-            float textX = screenPos.X - textWidth / 2.0f;
-            float textY = screenPos.Y - textHeight / 2.0f;
+            return labelText;
+        }
 
-            Windows::UI::Color textColor = Windows::UI::ColorHelper::FromArgb(255, 40, 40, 40);
-            session.DrawTextLayout(
-                textLayout,
-                Windows::Foundation::Numerics::float2(textX, textY),
-                textColor);
+        static float LineCount(const std::wstring& text)
+        {
+            if (text.empty())
+                return 0.0f;
+            return static_cast<float>(1 + std::count(text.begin(), text.end(), L'\n'));
         }
 
         Windows::UI::Color GetRoomColor(const Room& room)
@@ -223,5 +243,13 @@ namespace winrt::estimate1
         }
 
         RoomDisplaySettings m_settings;
+        LabelTextCache m_names;             //      Id
+        LabelTextCache m_values;            //     Id
+
+        static constexpr float LabelLinePx = 16.0f;     //   
+        static constexpr float LabelGapPx = 3.0f;       //     (  )
+
+        DisplayList m_scratch;
+        DisplayListRenderer m_backend;
     };
 }
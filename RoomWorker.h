@@ -0,0 +1,221 @@
+#pragma once
+
+#include "pch.h"
+#include "Models.h"
+#include "Room.h"
+#include "WallGraph.h"
+#include "RoomDetector.h"
+#include "DocumentSnapshot.h"
+#include <vector>
+#include <memory>
+#include <optional>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+namespace winrt::estimate1
+{
+    // =================================================================
+    // ROOM WORKER - room and net area recomputation off the UI thread
+    // =================================================================
+    // DocumentModel posts a job holding a walls-only DocumentSnapshot,
+    // shared copies of the current rooms and the changed wall ids; the
+    // worker builds the wall graph and face table from the snapshot and
+    // never reads the live document. One job runs at a time and only
+    // the newest queued job is kept: a newer edit replaces a queued job
+    // and makes the running one stop at its next checkpoint.
+    //
+    // A finished result waits in a slot until the UI thread takes it
+    // (DocumentModel::ApplyCompletedRooms). Until then the renderer keeps
+    // drawing the rooms of the last applied result.
+    // =================================================================
+
+    struct RoomJob
+    {
+        uint64_t Generation{ 0 };       // assigned by Submit
+        uint64_t Revision{ 0 };         // journal revision the job reflects
+        std::shared_ptr<const DocumentSnapshot> Walls;
+        std::vector<std::shared_ptr<const Room>> Rooms;     // shared copies, never written
+        std::vector<uint64_t> ChangedWalls;
+        IdAllocator* Ids{ nullptr };    // document allocator for new rooms
+    };
+
+    struct RoomJobResult
+    {
+        uint64_t Generation{ 0 };
+        uint64_t Revision{ 0 };
+        std::vector<std::shared_ptr<Room>> Rooms;
+        RoomUpdate Update;
+    };
+
+    class RoomWorker
+    {
+    public:
+        // Called on the worker thread after a result is stored
+        using CompletionHandler = std::function<void()>;
+
+        RoomWorker() = default;
+        ~RoomWorker() { Stop(); }
+
+        RoomWorker(const RoomWorker&) = delete;
+        RoomWorker& operator=(const RoomWorker&) = delete;
+
+        void SetOnCompleted(CompletionHandler handler)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_onCompleted = std::move(handler);
+        }
+
+        // Queue a job, replacing any job not yet started. Returns its generation.
+        uint64_t Submit(RoomJob job)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            uint64_t generation = ++m_generation;
+            job.Generation = generation;
+            m_pending = std::move(job);
+            if (!m_thread.joinable())
+                m_thread = std::thread([this] { Run(); });
+            m_wake.notify_one();
+            return generation;
+        }
+
+        // Drop queued work, the running job and any unclaimed result
+        // (document cleared, level switched)
+        void Cancel()
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            ++m_generation;
+            m_pending.reset();
+            m_result.reset();
+        }
+
+        // Newest finished result, if one arrived since the last call
+        std::optional<RoomJobResult> TakeResult()
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            std::optional<RoomJobResult> result = std::move(m_result);
+            m_result.reset();
+            return result;
+        }
+
+        // Block until nothing is queued or running
+        void WaitIdle()
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_idle.wait(lock, [this] { return !m_pending && !m_running; });
+        }
+
+        bool IsBusy() const
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_pending.has_value() || m_running;
+        }
+
+        // Jobs finished and jobs abandoned for a newer one
+        uint64_t GetCompletedCount() const { return m_completed.load(); }
+        uint64_t GetAbandonedCount() const { return m_abandoned.load(); }
+
+    private:
+        void Stop()
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_stop = true;
+                ++m_generation;
+            }
+            m_wake.notify_all();
+            if (m_thread.joinable())
+                m_thread.join();
+        }
+
+        void Run()
+        {
+            for (;;)
+            {
+                RoomJob job;
+                {
+                    std::unique_lock<std::mutex> lock(m_mutex);
+                    m_wake.wait(lock, [this] { return m_stop || m_pending.has_value(); });
+                    if (m_stop)
+                        return;
+                    job = std::move(*m_pending);
+                    m_pending.reset();
+                    m_running = true;
+                }
+
+                RoomJobResult result;
+                bool finished = Process(job, result);
+
+                CompletionHandler handler;
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    m_running = false;
+                    if (finished && !IsStale(job.Generation))
+                    {
+                        m_result = std::move(result);
+                        handler = m_onCompleted;
+                        ++m_completed;
+                    }
+                    else
+                    {
+                        ++m_abandoned;
+                    }
+                }
+                m_idle.notify_all();
+
+                if (handler)
+                    handler();
+            }
+        }
+
+        // Checkpoints around the detection pass: a newer submission makes the run moot
+        bool Process(RoomJob& job, RoomJobResult& result)
+        {
+            if (IsStale(job.Generation))
+                return false;
+
+            std::optional<IdAllocatorScope> idScope;
+            if (job.Ids)
+                idScope.emplace(*job.Ids);
+
+            // The rooms are updated in place, so each job works on its own copies
+            std::vector<std::shared_ptr<Room>> rooms;
+            rooms.reserve(job.Rooms.size());
+            for (const auto& room : job.Rooms)
+                rooms.push_back(std::make_shared<Room>(*room));
+
+            WallGraph graph = WallGraph::Build(job.Walls->GetWallHotData());
+            RoomDetector::WallFaceTable faces = RoomDetector::BuildWallFaceTable(job.Walls->GetWalls());
+            if (IsStale(job.Generation))
+                return false;
+
+            result.Update = RoomDetector::Recompute(graph, rooms, job.ChangedWalls, false, faces);
+            if (IsStale(job.Generation))
+                return false;
+
+            result.Generation = job.Generation;
+            result.Revision = job.Revision;
+            result.Rooms = std::move(rooms);
+            return true;
+        }
+
+        bool IsStale(uint64_t generation) const { return m_generation.load() != generation; }
+
+        mutable std::mutex m_mutex;
+        std::condition_variable m_wake;
+        std::condition_variable m_idle;
+        std::thread m_thread;
+
+        std::atomic<uint64_t> m_generation{ 0 };
+        std::optional<RoomJob> m_pending;
+        std::optional<RoomJobResult> m_result;
+        bool m_running{ false };
+        bool m_stop{ false };
+        CompletionHandler m_onCompleted;
+
+        std::atomic<uint64_t> m_completed{ 0 };
+        std::atomic<uint64_t> m_abandoned{ 0 };
+    };
+}
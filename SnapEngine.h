@@ -0,0 +1,468 @@
+#pragma once
+
+#include "pch.h"
+#include "Element.h"
+#include "Layer.h"
+#include "WallSnapSystem.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace winrt::estimate1
+{
+    // =================================================================
+    // SNAP ENGINE - one ranked snap query over pluggable providers
+    // =================================================================
+    // Each kind of snap target (wall ends, axis crossings, wall faces,
+    // grid, imported underlays) is a SnapProvider that answers from a
+    // spatial index it shares with the rest of the document: the wall
+    // graph, the join grid, the wall snap index. The engine asks them
+    // in rank order and keeps the best few hits.
+    //
+    // Ranking is by kind first, then by distance: an endpoint within
+    // reach beats a closer midpoint, as it always did. Once a hit is
+    // found, providers that cannot emit a better kind are not asked.
+    //
+    // A query carries a deadline. The engine stops asking providers
+    // when it passes, and providers walking large sets check it as
+    // they go, so a huge underlay costs at most the budget per pointer
+    // move and the hits found so far are still returned.
+    // =================================================================
+
+    // In rank order: earlier kinds win over later ones
+    enum class SnapKind
+    {
+        Endpoint,
+        Intersection,
+        Midpoint,
+        Perpendicular,
+        WallPlane,          // wall axis or face (WallSnapSystem)
+        Nearest,            // any point on a line
+        Alignment,          // lined up with a wall end or the start point
+        Grid
+    };
+
+    inline const wchar_t* GetSnapKindName(SnapKind kind)
+    {
+        switch (kind)
+        {
+        case SnapKind::Endpoint:      return L"endpoint";
+        case SnapKind::Intersection:  return L"intersection";
+        case SnapKind::Midpoint:      return L"midpoint";
+        case SnapKind::Perpendicular: return L"perpendicular";
+        case SnapKind::WallPlane:     return L"wallplane";
+        case SnapKind::Nearest:       return L"nearest";
+        case SnapKind::Alignment:     return L"alignment";
+        case SnapKind::Grid:          return L"grid";
+        }
+        return L"";
+    }
+
+    class SnapProvider;
+
+    struct SnapQuery
+    {
+        using Clock = std::chrono::steady_clock;
+
+        WorldPoint Cursor{ 0, 0 };
+        std::optional<WorldPoint> StartPoint;   // first point of the element being drawn
+        double Zoom{ 1.0 };
+        double Tolerance{ 15.0 };               // snap radius in mm at this zoom
+        uint64_t ExcludeWallId{ 0 };            // the wall being drawn or moved
+        bool WallPlanes{ false };               // wall faces and alignment, for the wall tool
+        const SnapProvider* Preferred{ nullptr };   // asked first; its hits win over every rank
+
+        const DocumentModel* Document{ nullptr };
+        const LayerManager* Layers{ nullptr };
+
+        Clock::time_point Deadline{ Clock::time_point::max() };
+
+        bool IsOverBudget() const { return Clock::now() >= Deadline; }
+
+        bool IsVisible(const Wall& wall) const
+        {
+            return !Layers || Layers->IsWorkStateVisible(wall.GetWorkState());
+        }
+    };
+
+    struct SnapHit
+    {
+        WorldPoint Point{ 0, 0 };
+        SnapKind Kind{ SnapKind::Grid };
+        double Distance{ 0.0 };
+        uint64_t SourceId{ 0 };                 // wall or entity id, 0 if none
+        const SnapProvider* Provider{ nullptr };
+
+        bool operator<(const SnapHit& other) const
+        {
+            if (Kind != other.Kind)
+                return Kind < other.Kind;
+            return Distance < other.Distance;
+        }
+    };
+
+    // The best few hits of a query, best first
+    class SnapHitList
+    {
+    public:
+        static constexpr size_t Capacity = 8;
+
+        void Add(const SnapHit& hit)
+        {
+            if (m_hits.size() == Capacity && !(hit < m_hits.back()))
+                return;
+
+            m_hits.insert(std::upper_bound(m_hits.begin(), m_hits.end(), hit), hit);
+            if (m_hits.size() > Capacity)
+                m_hits.pop_back();
+        }
+
+        // True if a hit of this kind at this distance would rank among
+        // the kept ones; providers use it to skip work
+        bool CanImprove(SnapKind kind, double distance) const
+        {
+            if (m_hits.size() < Capacity)
+                return true;
+            SnapHit probe;
+            probe.Kind = kind;
+            probe.Distance = distance;
+            return probe < m_hits.back();
+        }
+
+        bool IsEmpty() const { return m_hits.empty(); }
+        size_t Size() const { return m_hits.size(); }
+        const SnapHit& Best() const { return m_hits.front(); }
+        const std::vector<SnapHit>& GetHits() const { return m_hits; }
+
+        void Clear() { m_hits.clear(); }
+
+    private:
+        std::vector<SnapHit> m_hits;
+    };
+
+    // One source of snap targets
+    class SnapProvider
+    {
+    public:
+        virtual ~SnapProvider() = default;
+
+        // Best kind this provider can emit; decides its turn in a query
+        virtual SnapKind GetRank() const = 0;
+
+        virtual void Query(const SnapQuery& query, SnapHitList& hits) = 0;
+
+        // Brings the indices Query reads up to date. Called before the
+        // query's clock starts, so a rebuild after an edit is not charged
+        // to the budget and does not push later providers out of it.
+        virtual void Prepare(const SnapQuery&) {}
+
+        bool IsEnabled() const { return m_enabled; }
+        void SetEnabled(bool enabled) { m_enabled = enabled; }
+
+    protected:
+        SnapHit MakeHit(const SnapQuery& query, const WorldPoint& point, SnapKind kind, uint64_t sourceId = 0) const
+        {
+            SnapHit hit;
+            hit.Point = point;
+            hit.Kind = kind;
+            hit.Distance = query.Cursor.Distance(point);
+            hit.SourceId = sourceId;
+            hit.Provider = this;
+            return hit;
+        }
+
+    private:
+        bool m_enabled{ true };
+    };
+
+    struct SnapEngineResult
+    {
+        SnapHitList Hits;
+        size_t ProvidersQueried{ 0 };
+        bool BudgetExceeded{ false };
+
+        bool HasSnap() const { return !Hits.IsEmpty(); }
+    };
+
+    class SnapEngine
+    {
+    public:
+        // Returns the provider so the caller can keep it to toggle it
+        template <typename T>
+        T* AddProvider(std::unique_ptr<T> provider)
+        {
+            T* raw = provider.get();
+            auto at = std::upper_bound(m_providers.begin(), m_providers.end(), raw->GetRank(),
+                [](SnapKind rank, const std::unique_ptr<SnapProvider>& p) { return rank < p->GetRank(); });
+            m_providers.insert(at, std::move(provider));
+            return raw;
+        }
+
+        void RemoveProvider(const SnapProvider* provider)
+        {
+            m_providers.erase(std::remove_if(m_providers.begin(), m_providers.end(),
+                [provider](const std::unique_ptr<SnapProvider>& p) { return p.get() == provider; }),
+                m_providers.end());
+        }
+
+        size_t GetProviderCount() const { return m_providers.size(); }
+
+        // Time one query may take; zero means no limit
+        void SetBudget(std::chrono::microseconds budget) { m_budget = budget; }
+        std::chrono::microseconds GetBudget() const { return m_budget; }
+
+        SnapEngineResult Find(SnapQuery query) const
+        {
+            SnapEngineResult result;
+            for (const auto& provider : m_providers)
+            {
+                if (provider->IsEnabled())
+                    provider->Prepare(query);
+            }
+
+            if (m_budget.count() > 0)
+                query.Deadline = SnapQuery::Clock::now() + m_budget;
+
+            // A preferred provider's hits stand alone: the wall tool lets
+            // faces and alignment win over plain wall ends, as they always have
+            for (const auto& provider : m_providers)
+            {
+                if (provider.get() != query.Preferred || !provider->IsEnabled())
+                    continue;
+                provider->Query(query, result.Hits);
+                ++result.ProvidersQueried;
+                if (!result.Hits.IsEmpty())
+                    return result;
+            }
+
+            for (const auto& provider : m_providers)
+            {
+                if (!provider->IsEnabled() || provider.get() == query.Preferred)
+                    continue;
+
+                // Providers come in rank order: once a hit outranks what
+                // the rest can emit, none of them can change the winner
+                if (!result.Hits.IsEmpty() && result.Hits.Best().Kind < provider->GetRank())
+                    break;
+
+                if (query.IsOverBudget())
+                {
+                    result.BudgetExceeded = true;
+                    break;
+                }
+
+                provider->Query(query, result.Hits);
+                ++result.ProvidersQueried;
+            }
+            return result;
+        }
+
+    private:
+        std::vector<std::unique_ptr<SnapProvider>> m_providers;     // by rank
+        std::chrono::microseconds m_budget{ 2000 };
+    };
+
+    // =================================================================
+    // Wall providers
+    // =================================================================
+
+    // Nodes of the document's wall graph: welded wall ends, and points
+    // where axes cross without either ending there. One pass serves both.
+    // Nodes only say where to look: a hit lies on the visible walls that
+    // meet there, at the exact end of one of them or the exact crossing
+    // of two, not at the welded position.
+    class WallNodeSnapProvider : public SnapProvider
+    {
+    public:
+        SnapKind GetRank() const override { return SnapKind::Endpoint; }
+
+        void Prepare(const SnapQuery& query) override
+        {
+            if (query.Document)
+                query.Document->GetWallGraph();
+        }
+
+        void Query(const SnapQuery& query, SnapHitList& hits) override
+        {
+            if (!query.Document)
+                return;
+
+            const DocumentModel& document = *query.Document;
+            const WallGraph& graph = document.GetWallGraph();
+            double weld = graph.GetTolerance();
+
+            // Exact ends lie within the weld tolerance of their node
+            graph.ForEachNodeNear(query.Cursor, query.Tolerance + weld, [&](int node, double) {
+                const WorldPoint& at = graph.GetNodes()[node];
+                const Wall* passing[2]{};
+                int passingCount = 0;
+                std::optional<WorldPoint> end;
+                uint64_t endWallId = 0;
+
+                for (uint64_t id : graph.GetWallsAt(node))
+                {
+                    const Wall* wall = document.GetWall(document.GetWallHandle(id));
+                    if (!wall || id == query.ExcludeWallId || !query.IsVisible(*wall))
+                        continue;
+
+                    for (const WorldPoint& p : { wall->GetStartPoint(), wall->GetEndPoint() })
+                    {
+                        if (p.Distance(at) <= weld && (!end || query.Cursor.Distance(p) < query.Cursor.Distance(*end)))
+                        {
+                            end = p;
+                            endWallId = id;
+                        }
+                    }
+                    if (passingCount < 2)
+                        passing[passingCount++] = wall;
+                }
+
+                // Ends of hidden walls do not make a visible node an endpoint
+                if (end)
+                {
+                    double dist = query.Cursor.Distance(*end);
+                    if (dist < query.Tolerance && hits.CanImprove(SnapKind::Endpoint, dist))
+                        hits.Add(MakeHit(query, *end, SnapKind::Endpoint, endWallId));
+                }
+                else if (passingCount == 2)
+                {
+                    WorldPoint crossing = AxisCrossing(*passing[0], *passing[1]).value_or(at);
+                    double dist = query.Cursor.Distance(crossing);
+                    if (dist < query.Tolerance && hits.CanImprove(SnapKind::Intersection, dist))
+                        hits.Add(MakeHit(query, crossing, SnapKind::Intersection, passing[0]->GetId()));
+                }
+            });
+        }
+
+    private:
+        // Crossing of the two axes as lines, none if they are parallel
+        static std::optional<WorldPoint> AxisCrossing(const Wall& first, const Wall& second)
+        {
+            WorldPoint a = first.GetStartPoint(), b = first.GetEndPoint();
+            WorldPoint c = second.GetStartPoint(), d = second.GetEndPoint();
+            double rx = b.X - a.X, ry = b.Y - a.Y;
+            double sx = d.X - c.X, sy = d.Y - c.Y;
+            double denom = rx * sy - ry * sx;
+            if (std::abs(denom) <= 1e-12 * (rx * rx + ry * ry + sx * sx + sy * sy))
+                return std::nullopt;
+
+            double t = ((c.X - a.X) * sy - (c.Y - a.Y) * sx) / denom;
+            return WorldPoint(a.X + rx * t, a.Y + ry * t);
+        }
+    };
+
+    // Axis midpoints; a midpoint lies inside the wall's footprint, so
+    // only walls in the join grid cells around the cursor can reach it
+    class WallMidpointSnapProvider : public SnapProvider
+    {
+    public:
+        SnapKind GetRank() const override { return SnapKind::Midpoint; }
+
+        void Prepare(const SnapQuery& query) override
+        {
+            if (query.Document)
+                query.Document->GetWallJoinIndex();
+        }
+
+        void Query(const SnapQuery& query, SnapHitList& hits) override
+        {
+            if (!query.Document)
+                return;
+
+            query.Document->GetWallJoinIndex().ForEachNear(query.Cursor, query.Tolerance, [&](const Wall& wall) {
+                if (wall.GetId() == query.ExcludeWallId || !query.IsVisible(wall))
+                    return;
+
+                WorldPoint midpoint(
+                    (wall.GetStartPoint().X + wall.GetEndPoint().X) / 2,
+                    (wall.GetStartPoint().Y + wall.GetEndPoint().Y) / 2);
+                double dist = query.Cursor.Distance(midpoint);
+                if (dist < query.Tolerance && hits.CanImprove(SnapKind::Midpoint, dist))
+                    hits.Add(MakeHit(query, midpoint, SnapKind::Midpoint, wall.GetId()));
+            });
+        }
+    };
+
+    // Wall axes, faces and alignment through WallSnapSystem. Its best
+    // candidate is kept for the alignment guides drawn by the wall tool.
+    class WallPlaneSnapProvider : public SnapProvider
+    {
+    public:
+        explicit WallPlaneSnapProvider(WallSnapSystem& system)
+            : m_system(system)
+        {
+        }
+
+        // Face endpoints rank with the other endpoints
+        SnapKind GetRank() const override { return SnapKind::Endpoint; }
+
+        void Prepare(const SnapQuery& query) override
+        {
+            if (query.Document && query.WallPlanes)
+                m_system.SyncIndex(*query.Document);
+        }
+
+        void Query(const SnapQuery& query, SnapHitList& hits) override
+        {
+            m_candidate = WallSnapCandidate{};
+            if (!query.Document || !query.WallPlanes)
+                return;
+
+            WallSnapCandidate candidate = m_system.FindBestSnap(
+                query.Cursor, query.StartPoint, *query.Document, query.Zoom, query.ExcludeWallId);
+            if (!candidate.IsValid)
+                return;
+
+            m_candidate = candidate;
+            hits.Add(MakeHit(query, candidate.ProjectedPoint, KindOf(candidate), candidate.WallId));
+        }
+
+        // Candidate behind this provider's hit in the last query
+        const WallSnapCandidate& GetCandidate() const { return m_candidate; }
+
+        static SnapKind KindOf(const WallSnapCandidate& candidate)
+        {
+            if (candidate.IsAlignment)
+                return SnapKind::Alignment;
+            if (candidate.IsEndpoint)
+                return SnapKind::Endpoint;
+            if (candidate.Plane == WallSnapPlane::Midpoint)
+                return SnapKind::Midpoint;
+            return SnapKind::WallPlane;
+        }
+
+    private:
+        WallSnapSystem& m_system;
+        WallSnapCandidate m_candidate;
+    };
+
+    // Nearest grid node
+    class GridSnapProvider : public SnapProvider
+    {
+    public:
+        SnapKind GetRank() const override { return SnapKind::Grid; }
+
+        void SetSpacing(double spacing) { m_spacing = spacing; }
+        double GetSpacing() const { return m_spacing; }
+
+        WorldPoint SnapToGrid(const WorldPoint& point) const
+        {
+            return WorldPoint(
+                std::round(point.X / m_spacing) * m_spacing,
+                std::round(point.Y / m_spacing) * m_spacing);
+        }
+
+        void Query(const SnapQuery& query, SnapHitList& hits) override
+        {
+            WorldPoint gridPoint = SnapToGrid(query.Cursor);
+            if (query.Cursor.Distance(gridPoint) < query.Tolerance)
+                hits.Add(MakeHit(query, gridPoint, SnapKind::Grid));
+        }
+
+    private:
+        double m_spacing{ 100.0 };      // mm
+    };
+}
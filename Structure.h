@@ -27,11 +27,12 @@ namespace winrt::estimate1
         std::wstring GetTypeName() const override { return L"Column"; }
 
         // 
-        void SetPosition(const WorldPoint& pos) { m_position = pos; }
+        void SetPosition(const WorldPoint& pos) { m_position = pos; Touch(); }
         WorldPoint GetPosition() const { return m_position; }
 
         void SetExample(double width, double depth)
         {
+            Touch();
             m_shape = ColumnShape::Rectangular;
             m_width = width;
             m_depth = depth;
@@ -39,6 +40,7 @@ namespace winrt::estimate1
 
         void SetCircular(double diameter)
         {
+            Touch();
             m_shape = ColumnShape::Circular;
             m_width = diameter; // Using width as diameter
             m_depth = diameter;
@@ -48,14 +50,14 @@ namespace winrt::estimate1
         double GetWidth() const { return m_width; }
         double GetDepth() const { return m_depth; } // Or Diameter for circular
 
-        void SetRotation(double degrees) { m_rotation = degrees; }
+        void SetRotation(double degrees) { m_rotation = degrees; Touch(); }
         double GetRotation() const { return m_rotation; }
 
         // 
-        void SetHeight(double h) { m_height = h; }
+        void SetHeight(double h) { m_height = h; Touch(); }
         double GetHeight() const { return m_height; }
         
-        void SetBaseOffset(double offset) { m_baseOffset = offset; }
+        void SetBaseOffset(double offset) { m_baseOffset = offset; Touch(); }
         double GetBaseOffset() const { return m_baseOffset; }
 
         // HitTest
@@ -171,25 +173,25 @@ namespace winrt::estimate1
         std::wstring GetTypeName() const override { return L"Beam"; }
 
         // 
-        void SetStartPoint(const WorldPoint& p) { m_start = p; }
+        void SetStartPoint(const WorldPoint& p) { m_start = p; Touch(); }
         const WorldPoint& GetStartPoint() const { return m_start; }
 
-        void SetEndPoint(const WorldPoint& p) { m_end = p; }
+        void SetEndPoint(const WorldPoint& p) { m_end = p; Touch(); }
         const WorldPoint& GetEndPoint() const { return m_end; }
 
-        void SetWidth(double w) { m_width = w; }
+        void SetWidth(double w) { m_width = w; Touch(); }
         double GetWidth() const { return m_width; }
 
-        void SetHeight(double h) { m_height = h; } //  
+        void SetHeight(double h) { m_height = h; Touch(); } //  
         double GetHeight() const { return m_height; }
         
-        void SetLevelOffset(double offset) { m_levelOffset = offset; }
+        void SetLevelOffset(double offset) { m_levelOffset = offset; Touch(); }
         double GetLevelOffset() const { return m_levelOffset; }
 
         bool HitTest(const WorldPoint& point, double tolerance) const override
         {
             // Simple distance to line segment check
-            double dist = DistancePointToSegment(point, m_start, m_end);
+            double dist = GeometryKernels::DistancePointToSegment(point, m_start, m_end);
             return dist <= (m_width / 2.0 + tolerance);
         }
 
@@ -203,16 +205,6 @@ namespace winrt::estimate1
         }
 
     private:
-        static double DistancePointToSegment(const WorldPoint& p, const WorldPoint& a, const WorldPoint& b)
-        {
-            double l2 = (b.X - a.X) * (b.X - a.X) + (b.Y - a.Y) * (b.Y - a.Y);
-            if (l2 == 0.0) return std::sqrt((p.X - a.X) * (p.X - a.X) + (p.Y - a.Y) * (p.Y - a.Y));
-            double t = ((p.X - a.X) * (b.X - a.X) + (p.Y - a.Y) * (b.Y - a.Y)) / l2;
-            t = (std::max)(0.0, (std::min)(1.0, t));
-            WorldPoint projection = { a.X + t * (b.X - a.X), a.Y + t * (b.Y - a.Y) };
-            return std::sqrt((p.X - projection.X) * (p.X - projection.X) + (p.Y - projection.Y) * (p.Y - projection.Y));
-        }
-
         WorldPoint m_start{ 0, 0 };
         WorldPoint m_end{ 0, 0 };
         double m_width{ 200.0 };
@@ -236,15 +228,16 @@ namespace winrt::estimate1
 
         void SetContour(const std::vector<WorldPoint>& points)
         {
+            Touch();
              m_contour = points;
              UpdateBounds();
         }
         const std::vector<WorldPoint>& GetContour() const { return m_contour; }
 
-        void SetThickness(double t) { m_thickness = t; }
+        void SetThickness(double t) { m_thickness = t; Touch(); }
         double GetThickness() const { return m_thickness; }
 
-        void SetLevelOffset(double offset) { m_levelOffset = offset; }
+        void SetLevelOffset(double offset) { m_levelOffset = offset; Touch(); }
         double GetLevelOffset() const { return m_levelOffset; }
 
         bool HitTest(const WorldPoint& point, double tolerance) const override
@@ -4,6 +4,7 @@
 #include "Structure.h"
 #include "Camera.h"
 #include "Layer.h"
+#include "DisplayList.h"
 #include <vector>
 #include <memory>
 #include <algorithm>
@@ -15,69 +16,61 @@ using winrt::Windows::UI::Color;
 
 namespace winrt::estimate1
 {
+    //  highlights    :  
+    //    .  highlights -   
+    //  ,  ,    .
     class StructureRenderer
     {
     public:
         //  
-        static void DrawColumns(
-            CanvasDrawingSession const& session,
-            const Camera& camera,
+        static void BuildColumns(
+            DisplayList& list,
             const std::vector<std::shared_ptr<Column>>& columns,
-            uint64_t hoverId = 0)
+            uint64_t hoverId = 0,
+            bool highlights = false)
         {
+            Color strokeColor = Colors::Black();
+            uint16_t cross = list.AddStyle(DisplayStyle::Stroke(strokeColor, 1.0f));
+
             for (const auto& col : columns)
             {
                 if (!col) continue;
 
-                bool isSelected = col->IsSelected();
-                bool isHovered = (col->GetId() == hoverId);
+                bool isSelected = highlights && col->IsSelected();
+                bool isHovered = highlights && col->GetId() == hoverId;
+                if (highlights && !isSelected && !isHovered) continue;
                 
                 //  
                 auto points = col->GetContour();
                 if (points.size() < 3) continue;
 
-                //  
-                CanvasPathBuilder builder(session);
-                ScreenPoint p0 = camera.WorldToScreen(points[0]);
-                builder.BeginFigure(p0.X, p0.Y);
-                for (size_t i = 1; i < points.size(); ++i)
-                {
-                    ScreenPoint p = camera.WorldToScreen(points[i]);
-                    builder.AddLine(p.X, p.Y);
-                }
-                builder.EndFigure(CanvasFigureLoop::Closed);
-                auto geometry = CanvasGeometry::CreatePath(builder);
-
                 // 
                 Color fillColor = isSelected ? Colors::Orange() : Colors::LightGray();
                 if (isHovered && !isSelected) fillColor = Colors::LightSlateGray();
                 
-                Color strokeColor = Colors::Black();
                 float strokeWidth = isSelected ? 2.0f : 1.0f;
 
                 //   
-                session.FillGeometry(geometry, fillColor);
-                session.DrawGeometry(geometry, strokeColor, strokeWidth);
+                list.AddPolygon(list.AddStyle(DisplayStyle::Fill(fillColor)), points);
+                list.AddPolyline(list.AddStyle(DisplayStyle::Stroke(strokeColor, strokeWidth)), points, true);
                 
                 //  ,     ( )
                 if (col->GetShape() == ColumnShape::Circular)
                 {
-                    WorldPoint center = col->GetPosition();
-                    ScreenPoint cs = camera.WorldToScreen(center);
-                    float r = 5.0f;
-                    session.DrawLine(cs.X - r, cs.Y, cs.X + r, cs.Y, strokeColor, 1.0f);
-                    session.DrawLine(cs.X, cs.Y - r, cs.X, cs.Y + r, strokeColor, 1.0f);
+                    list.AddMarker(cross, col->GetPosition(), MarkerShape::Cross, 10.0f);
                 }
             }
         }
 
         //  
-        static void DrawSlabs(
-            CanvasDrawingSession const& session,
-            const Camera& camera,
+        static void BuildSlabs(
+            DisplayList& list,
             const std::vector<std::shared_ptr<Slab>>& slabs,
-            uint64_t hoverId = 0)
+            uint64_t hoverId = 0,
+            bool highlights = false)
         {
+            uint16_t outline = list.AddStyle(DisplayStyle::Stroke(Colors::Gray(), 1.0f));
+
             for (const auto& slab : slabs)
             {
                 if (!slab) continue;
@@ -85,19 +78,9 @@ namespace winrt::estimate1
                 auto contour = slab->GetContour();
                 if (contour.size() < 3) continue;
 
-                bool isSelected = slab->IsSelected();
-                bool isHovered = (slab->GetId() == hoverId);
-
-                CanvasPathBuilder builder(session);
-                ScreenPoint p0 = camera.WorldToScreen(contour[0]);
-                builder.BeginFigure(p0.X, p0.Y);
-                for (size_t i = 1; i < contour.size(); ++i)
-                {
-                    ScreenPoint p = camera.WorldToScreen(contour[i]);
-                    builder.AddLine(p.X, p.Y);
-                }
-                builder.EndFigure(CanvasFigureLoop::Closed);
-                auto geometry = CanvasGeometry::CreatePath(builder);
+                bool isSelected = highlights && slab->IsSelected();
+                bool isHovered = highlights && slab->GetId() == hoverId;
+                if (highlights && !isSelected && !isHovered) continue;
 
                 // 
                 Color fillColor = Colors::LightBlue();
@@ -105,45 +88,40 @@ namespace winrt::estimate1
                 if (isSelected) fillColor = Colors::Orange(), fillColor.A = 100;
                 else if (isHovered) fillColor = Colors::LightCyan(), fillColor.A = 80;
 
-                session.FillGeometry(geometry, fillColor);
-                session.DrawGeometry(geometry, Colors::Gray(), 1.0f);
+                list.AddPolygon(list.AddStyle(DisplayStyle::Fill(fillColor)), contour);
+                list.AddPolyline(outline, contour, true);
             }
         }
 
         //  
-        static void DrawBeams(
-            CanvasDrawingSession const& session,
-            const Camera& camera,
+        static void BuildBeams(
+            DisplayList& list,
             const std::vector<std::shared_ptr<Beam>>& beams,
-            uint64_t hoverId = 0)
+            uint64_t hoverId = 0,
+            bool highlights = false)
         {
+            uint16_t axis = list.AddStyle(DisplayStyle::Stroke(Colors::Black(), 1.0f));
+
             for (const auto& beam : beams)
             {
                 if (!beam) continue;
 
-                bool isSelected = beam->IsSelected();
-                bool isHovered = (beam->GetId() == hoverId);
-
-                //     
-                WorldPoint start = beam->GetStartPoint();
-                WorldPoint end = beam->GetEndPoint();
-                ScreenPoint s = camera.WorldToScreen(start);
-                ScreenPoint e = camera.WorldToScreen(end);
+                bool isSelected = highlights && beam->IsSelected();
+                bool isHovered = highlights && beam->GetId() == hoverId;
+                if (highlights && !isSelected && !isHovered) continue;
 
-                float width = static_cast<float>(beam->GetWidth() * camera.GetZoom());
-                
                 Color color = Colors::DarkGray();
                 if (isSelected) color = Colors::Orange();
-                else if (isHovered) color = Colors::LightSlateGray(); // Note: LightSlateGray might not be in Colors enum in WinUI, check or use helper
-                
-                // Draw centerline
-                CanvasStrokeStyle style;
-                // style.DashStyle(CanvasDashStyle::Solid); 
+                else if (isHovered) color = Colors::LightSlateGray();
                 
-                session.DrawLine(s.X, s.Y, e.X, e.Y, color, width);
+                //       ( ,   )
+                WorldPoint start = beam->GetStartPoint();
+                WorldPoint end = beam->GetEndPoint();
+                uint16_t body = list.AddStyle(DisplayStyle::WorldStroke(color, static_cast<float>(beam->GetWidth())));
+                list.AddLine(body, start, end);
 
                 // Optional: draw centerline axis
-                session.DrawLine(s.X, s.Y, e.X, e.Y, Colors::Black(), 1.0f);
+                list.AddLine(axis, start, end);
             }
         }
     };
@@ -2,6 +2,7 @@
 #include "pch.h"
 #include "Camera.h"
 #include "Models.h"
+#include "TextLayoutCache.h"
 #include <vector>
 
 namespace winrt::estimate1
@@ -97,12 +98,8 @@ namespace winrt::estimate1
                 (lineP1.Y + lineP2.Y) / 2.0f - 10.0f);
 
             //    ( )
-            Microsoft::Graphics::Canvas::Text::CanvasTextFormat format;
-            format.FontSize(12);
-            format.HorizontalAlignment(Microsoft::Graphics::Canvas::Text::CanvasHorizontalAlignment::Center);
-
-            auto textLayout = Microsoft::Graphics::Canvas::Text::CanvasTextLayout(
-                session, text, format, 0.0f, 0.0f);
+            auto textLayout = TextLayoutCache::Shared().GetLayout(
+                session, text, DisplayFont::Default, 12.0f, DisplayTextAlign::TopCenter);
             
             auto bounds = textLayout.LayoutBounds();
             Windows::Foundation::Rect bgRect(
@@ -112,11 +109,10 @@ namespace winrt::estimate1
                 bounds.Height + 2);
 
             session.FillRectangle(bgRect, Windows::UI::Colors::White());
-            session.DrawText(
-                text,
+            session.DrawTextLayout(
+                textLayout,
                 Windows::Foundation::Numerics::float2(textPos.X, textPos.Y - bounds.Height / 2),
-                textColor,
-                format);
+                textColor);
         }
 
     private:
@@ -17,11 +17,35 @@
 #include "ViewSettings.h"
 #include "LineWeightTable.h"
 #include "WallPlanGeometry.h"
+#include "WallStore.h"
+#include "FrameProfiler.h"
+#include "LabelDeclutter.h"
+#include "TextLayoutCache.h"
+#include "RasterTileCache.h"
+#include "WallRenderer.h"
+#include "OpeningRenderer.h"
+#include "DxfReferenceRenderer.h"
+#include "ReferenceSnapProvider.h"
+#include "SnapEngine.h"
+#include "WallSnapSystem.h"
+#include "RobustPredicates.h"
+#include "GeometryKernels.h"
+#include "WallJunctionSolver.h"
+#include "WallJoinGraph.h"
+#include "WallJoinManager.h"
+#include "WallJoinSystem.h"
+#include "WallAttachmentSystem.h"
+#include "WallGraph.h"
+#include "RoomDetector.h"
+#include "ChangeJournal.h"
+#include "ProjectSerializer.h"
 #include <vector>
 #include <string>
 #include <functional>
 #include <sstream>
 #include <cmath>
+#include <thread>
+#include <set>
 
 namespace winrt::estimate1::tests
 {
@@ -725,6 +749,2955 @@ namespace winrt::estimate1::tests
         return runner.Run(L"WallPlanGeometry Tests");
     }
 
+    // ============================================================================
+    // WallStore Tests
+    // ============================================================================
+
+    inline TestSuite RunWallStoreTests()
+    {
+        TestRunner runner;
+
+        runner.AddTest(L"WallStore_InsertAndGet", []() {
+            WallStore store;
+            auto wall = std::make_unique<Wall>(WorldPoint{ 0, 0 }, WorldPoint{ 1000, 0 }, 200);
+            Wall* raw = wall.get();
+            WallHandle h = store.Insert(std::move(wall));
+
+            AssertTrue(h.IsValid(), "Handle should be valid");
+            AssertTrue(store.Get(h) == raw, "Handle should resolve to the inserted wall");
+            AssertTrue(store.FindById(raw->GetId()) == raw, "Lookup by id should work");
+            AssertEqual(store.Hot().EndX[0], 1000.0, 0.001, "Hot data should mirror geometry");
+        });
+
+        runner.AddTest(L"WallStore_StaleHandle", []() {
+            WallStore store;
+            WallHandle h1 = store.Insert(std::make_unique<Wall>(WorldPoint{ 0, 0 }, WorldPoint{ 1000, 0 }, 200));
+            store.Erase(h1);
+            WallHandle h2 = store.Insert(std::make_unique<Wall>(WorldPoint{ 0, 0 }, WorldPoint{ 0, 1000 }, 200));
+
+            AssertTrue(h1.Index == h2.Index, "Slot should be reused");
+            AssertTrue(store.Get(h1) == nullptr, "Stale handle must not resolve");
+            AssertTrue(store.Get(h2) != nullptr, "New handle should resolve");
+        });
+
+        runner.AddTest(L"WallStore_EraseKeepsOrderAndHandles", []() {
+            WallStore store;
+            WallHandle a = store.Insert(std::make_unique<Wall>(WorldPoint{ 0, 0 }, WorldPoint{ 100, 0 }, 200));
+            WallHandle b = store.Insert(std::make_unique<Wall>(WorldPoint{ 0, 0 }, WorldPoint{ 200, 0 }, 200));
+            WallHandle c = store.Insert(std::make_unique<Wall>(WorldPoint{ 0, 0 }, WorldPoint{ 300, 0 }, 200));
+            Wall* wallC = store.Get(c);
+
+            store.Erase(a);
+            AssertTrue(store.Get(c) == wallC, "Wall* must stay stable after erase");
+            AssertEqual(store.Hot().EndX[0], 200.0, 0.001, "Dense order should be preserved");
+            AssertEqual(static_cast<int>(store.DenseIndexOf(c)), 1, "Dense index should be updated");
+            AssertTrue(store.Get(b) != nullptr, "Other handles should stay valid");
+        });
+
+        runner.AddTest(L"WallStore_SyncDirectEdits", []() {
+            WallStore store;
+            WallHandle h = store.Insert(std::make_unique<Wall>(WorldPoint{ 0, 0 }, WorldPoint{ 1000, 0 }, 200));
+            store.Get(h)->SetEndPoint(WorldPoint{ 2500, 0 });
+
+            int changed = 0;
+            store.Sync([&changed](uint64_t) { ++changed; });
+            AssertEqual(changed, 1, "One row should be refreshed");
+            AssertEqual(store.Hot().EndX[0], 2500.0, 0.001, "Hot data should follow direct edits");
+            AssertEqual(static_cast<int>(store.Sync()), 0, "Second sync should be a no-op");
+        });
+
+        runner.AddTest(L"WallStore_DocumentHandles", []() {
+            DocumentModel doc;
+            Wall* wall = doc.AddWall({ 0, 0 }, { 1000, 0 }, 200);
+            WallHandle h = doc.GetWallHandle(wall->GetId());
+
+            AssertTrue(doc.GetWall(h) == wall, "Document handle should resolve");
+            doc.RemoveWall(wall->GetId());
+            AssertTrue(doc.GetWall(h) == nullptr, "Handle should be stale after removal");
+        });
+
+        return runner.Run(L"WallStore Tests");
+    }
+
+    // ============================================================================
+    // Id Allocation Tests
+    // ============================================================================
+
+    inline TestSuite RunIdAllocationTests()
+    {
+        TestRunner runner;
+
+        runner.AddTest(L"IdAllocator_BlockReservation", []() {
+            IdAllocator allocator;
+            uint64_t a = allocator.Next();
+            IdBlock block = allocator.ReserveBlock(10);
+            uint64_t b = allocator.Next();
+
+            AssertTrue(block.First == a + 1, "Block should start after the last id");
+            AssertTrue(b == block.First + 10, "Next id should follow the block");
+        });
+
+        runner.AddTest(L"IdAllocator_ConcurrentUnique", []() {
+            IdAllocator allocator;
+            const int threads = 4;
+            const int perThread = 2000;
+            std::vector<std::vector<uint64_t>> ids(threads);
+            std::vector<std::thread> workers;
+
+            for (int t = 0; t < threads; ++t)
+            {
+                workers.emplace_back([&allocator, &ids, t]() {
+                    IdAllocatorScope scope(allocator);
+                    IdBlock block = allocator.ReserveBlock(perThread / 2);
+                    IdBlockScope blockScope(block);
+                    for (int i = 0; i < perThread; ++i)
+                        ids[t].push_back(IdGenerator::Next());
+                });
+            }
+            for (auto& w : workers) w.join();
+
+            std::set<uint64_t> unique;
+            for (const auto& v : ids) unique.insert(v.begin(), v.end());
+            AssertEqual(static_cast<int>(unique.size()), threads * perThread, "Ids from worker threads must be unique");
+        });
+
+        runner.AddTest(L"IdAllocator_ScopeBindsThread", []() {
+            IdAllocator allocator;
+            allocator.EnsureAbove(1000000);
+            IdAllocator* previous = &IdGenerator::Current();
+            {
+                IdAllocatorScope scope(allocator);
+                Wall wall({ 0, 0 }, { 1000, 0 }, 200);
+                AssertTrue(wall.GetId() == 1000001, "Element should take its id from the bound allocator");
+            }
+            AssertTrue(&IdGenerator::Current() == previous, "Scope should restore the previous allocator");
+        });
+
+        runner.AddTest(L"IdRemapper_Deterministic", []() {
+            IdAllocator a1;
+            IdAllocator a2;
+            IdRemapper r1;
+            IdRemapper r2;
+            r1.Reserve(a1, { 42, 7, 19 });
+            r2.Reserve(a2, { 19, 42, 7, 7 });
+
+            AssertTrue(r1.Map(7) == r2.Map(7) && r1.Map(42) == r2.Map(42), "Same input must give the same mapping");
+            AssertTrue(r1.Map(7) < r1.Map(19) && r1.Map(19) < r1.Map(42), "Relative order should be preserved");
+            AssertTrue(r1.Map(5) == 0, "Unknown ids map to 0");
+        });
+
+        runner.AddTest(L"IdRemapper_DocumentIds", []() {
+            DocumentModel doc;
+            IdRemapper remap;
+            remap.Reserve(doc.GetIdAllocator(), { 900 });
+            IdBlock block = remap.BlockFor(900);
+            Wall* wall = nullptr;
+            {
+                IdBlockScope scope(block);
+                wall = doc.AddWall({ 0, 0 }, { 1000, 0 }, 200);
+            }
+            AssertTrue(wall->GetId() == remap.Map(900), "Loaded wall should receive its remapped id");
+            AssertTrue(doc.GetWall(remap.Map(900)) == wall, "Remapped id should resolve in the document");
+        });
+
+        runner.AddTest(L"IdRemapper_LevelsShareClaims", []() {
+            DocumentModel doc;
+            doc.SetAutoDimensionsEnabled(false);
+            doc.AddWall({ 0, 0 }, { 1000, 0 });
+            doc.SetActiveLevel(doc.AddLevel());
+            doc.AddWall({ 0, 0 }, { 0, 1000 });
+
+            ProjectMetadata metadata;
+            Camera camera;
+            LayerManager layers;
+            std::filesystem::path path = std::filesystem::temp_directory_path() / L"estimate1_level_ids.json";
+            AssertTrue(ProjectSerializer::SaveProject(path.wstring(), metadata, camera, layers, doc).Success, "Project saved");
+
+            // Give the upper level's wall the same saved id as the ground level's
+            std::ifstream in(path, std::ios::binary);
+            std::string content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+            in.close();
+            nlohmann::json root = nlohmann::json::parse(content.substr(3));
+            const size_t first = 0;
+            uint64_t groundId = root["elements"]["walls"][first]["id"].get_uint64();
+            root["levels"][first + 1]["content"]["elements"]["walls"][first]["id"] = groundId;
+            std::ofstream out(path, std::ios::binary);
+            out << root.dump();
+            out.close();
+
+            DocumentModel loaded;
+            auto result = ProjectSerializer::LoadProject(path.wstring(), metadata, camera, layers, loaded);
+            std::filesystem::remove(path);
+            AssertTrue(result.Success, "Project loaded");
+
+            std::vector<uint64_t> ids;
+            loaded.ForEachLevel([&](const Level&) {
+                for (const auto& wall : loaded.GetWalls())
+                    ids.push_back(wall->GetId());
+            });
+            AssertEqual(static_cast<int>(ids.size()), 2, "Both walls loaded");
+            AssertTrue(ids[0] != 0 && ids[1] != 0 && ids[0] != ids[1], "A saved id repeated on another level gets a fresh id");
+        });
+
+        return runner.Run(L"Id Allocation Tests");
+    }
+
+    // ============================================================================
+    // Change Journal Tests
+    // ============================================================================
+
+    inline TestSuite RunChangeJournalTests()
+    {
+        TestRunner runner;
+
+        runner.AddTest(L"ChangeJournal_RevisionsAdvance", []() {
+            DocumentModel doc;
+            doc.SetAutoDimensionsEnabled(false);
+            uint64_t before = doc.GetRevision();
+
+            Wall* wall = doc.AddWall({ 0, 0 }, { 1000, 0 });
+            uint64_t added = doc.GetElementRevision(wall->GetId());
+            doc.TrimExtendWall(wall->GetId(), { 0, 0 }, { 2000, 0 });
+
+            AssertTrue(added > before, "Adding a wall should advance the revision");
+            AssertTrue(doc.GetElementRevision(wall->GetId()) > added, "Editing should advance the element revision");
+            AssertTrue(doc.GetElementRevision(wall->GetId()) == doc.GetRevision(), "Last change should be the document revision");
+        });
+
+        runner.AddTest(L"ChangeJournal_NetChanges", []() {
+            DocumentModel doc;
+            doc.SetAutoDimensionsEnabled(false);
+            Wall* kept = doc.AddWall({ 0, 0 }, { 1000, 0 });
+            Wall* removed = doc.AddWall({ 0, 0 }, { 0, 1000 });
+            uint64_t keptId = kept->GetId();
+            uint64_t removedId = removed->GetId();
+            uint64_t since = doc.GetRevision();
+
+            Wall* temp = doc.AddWall({ 5000, 0 }, { 6000, 0 });
+            uint64_t tempId = temp->GetId();
+            Wall* fresh = doc.AddWall({ 0, 5000 }, { 1000, 5000 });
+            doc.TrimExtendWall(fresh->GetId(), { 0, 5000 }, { 2000, 5000 });
+            doc.TrimExtendWall(keptId, { 0, 0 }, { 1500, 0 });
+            doc.RemoveWall(removedId);
+            doc.RemoveWall(tempId);
+
+            ChangeSet changes = doc.GetChangesSince(since);
+            AssertEqual(static_cast<int>(changes.Added.size()), 1, "Only the surviving new wall is added");
+            AssertTrue(changes.Added[0] == fresh->GetId(), "Added wall id");
+            AssertEqual(static_cast<int>(changes.Modified.size()), 1, "One pre-existing wall modified");
+            AssertTrue(changes.Modified[0] == keptId, "Modified wall id");
+            AssertEqual(static_cast<int>(changes.Removed.size()), 1, "Add-then-remove cancels out");
+            AssertTrue(changes.Removed[0] == removedId, "Removed wall id");
+        });
+
+        runner.AddTest(L"ChangeJournal_DirectEditSync", []() {
+            DocumentModel doc;
+            doc.SetAutoDimensionsEnabled(false);
+            Wall* wall = doc.AddWall({ 0, 0 }, { 1000, 0 });
+            uint64_t since = doc.GetRevision();
+
+            // Undo commands write through Wall* without notifying
+            wall->SetThickness(300.0);
+            AssertTrue(doc.GetChangesSince(since).Empty(), "Direct edit is not journaled yet");
+
+            AssertEqual(static_cast<int>(doc.SyncWallEdits()), 1, "Sync should find the edited wall");
+            ChangeSet changes = doc.GetChangesSince(since);
+            AssertEqual(static_cast<int>(changes.Modified.size()), 1, "Synced edit is journaled");
+            AssertEqual(static_cast<int>(doc.SyncWallEdits()), 0, "Second sync finds nothing");
+        });
+
+        runner.AddTest(L"ChangeJournal_Subscribe", []() {
+            ChangeJournal journal;
+            int added = 0, removed = 0;
+            auto token = journal.Subscribe([&](const ChangeRecord& r) {
+                if (r.Kind == ChangeKind::Added) ++added;
+                if (r.Kind == ChangeKind::Removed) ++removed;
+            });
+
+            journal.RecordAdded(1, JournalElementKind::Wall);
+            journal.RecordRemoved(1, JournalElementKind::Wall);
+            journal.Unsubscribe(token);
+            journal.RecordAdded(2, JournalElementKind::Wall);
+
+            AssertEqual(added, 1, "Listener sees additions until unsubscribed");
+            AssertEqual(removed, 1, "Listener sees removals");
+        });
+
+        runner.AddTest(L"ChangeJournal_HistoryOverflow", []() {
+            ChangeJournal journal(16);
+            journal.RecordAdded(1, JournalElementKind::Wall);
+            uint64_t old = journal.GetRevision();
+            for (uint64_t i = 0; i < 100; ++i)
+                journal.RecordModified(1, JournalElementKind::Wall);
+            uint64_t recent = journal.GetRevision() - 2;
+
+            AssertTrue(journal.GetChangesSince(old).IsFullReset, "Consumers behind the history must rebuild");
+            AssertFalse(journal.GetChangesSince(recent).IsFullReset, "Recent consumers get a delta");
+            AssertTrue(journal.GetRecordCount() <= 16, "History is bounded");
+
+            journal.RecordReset();
+            AssertTrue(journal.GetChangesSince(recent).IsFullReset, "Reset forces a rebuild");
+        });
+
+        return runner.Run(L"Change Journal Tests");
+    }
+
+    // ============================================================================
+    // Document Snapshot Tests
+    // ============================================================================
+
+    inline TestSuite RunDocumentSnapshotTests()
+    {
+        TestRunner runner;
+
+        runner.AddTest(L"Snapshot_IsolatedFromEdits", []() {
+            DocumentModel doc;
+            doc.SetAutoDimensionsEnabled(false);
+            Wall* wall = doc.AddWall({ 0, 0 }, { 1000, 0 });
+            auto snapshot = doc.CreateSnapshot();
+
+            wall->SetEndPoint({ 5000, 0 });
+            doc.AddWall({ 0, 0 }, { 0, 1000 });
+
+            AssertEqual(static_cast<int>(snapshot->GetWalls().size()), 1, "Snapshot keeps its wall count");
+            AssertEqual(snapshot->GetWalls()[0]->GetLength(), 1000.0, 0.001, "Snapshot keeps old geometry");
+            AssertEqual(snapshot->GetWallHotData().EndX[0], 1000.0, 0.001, "Snapshot hot data keeps old geometry");
+        });
+
+        runner.AddTest(L"Snapshot_SharesUnchangedWalls", []() {
+            DocumentModel doc;
+            doc.SetAutoDimensionsEnabled(false);
+            Wall* a = doc.AddWall({ 0, 0 }, { 1000, 0 });
+            doc.AddWall({ 0, 0 }, { 0, 1000 });
+            double before = a->GetThickness();
+            auto first = doc.CreateSnapshot();
+
+            a->SetThickness(before + 100.0);
+            auto second = doc.CreateSnapshot();
+
+            AssertTrue(first->GetWalls()[0] != second->GetWalls()[0], "Edited wall is copied");
+            AssertTrue(first->GetWalls()[1] == second->GetWalls()[1], "Unchanged wall is shared");
+            AssertEqual(first->GetWalls()[0]->GetThickness(), before, 0.001, "Old snapshot keeps old thickness");
+        });
+
+        runner.AddTest(L"Snapshot_WorkStateCopies", []() {
+            DocumentModel doc;
+            doc.SetAutoDimensionsEnabled(false);
+            Wall* a = doc.AddWall({ 0, 0 }, { 1000, 0 });
+            auto first = doc.CreateSnapshot();
+
+            a->SetWorkState(WorkStateNative::Demolish);
+            auto second = doc.CreateSnapshot();
+
+            AssertTrue(first->GetWalls()[0]->GetWorkState() == WorkStateNative::Existing, "Old snapshot keeps work state");
+            AssertTrue(second->GetWalls()[0]->GetWorkState() == WorkStateNative::Demolish, "New snapshot sees work state");
+        });
+
+        runner.AddTest(L"Snapshot_EstimateMatchesDocument", []() {
+            DocumentModel doc;
+            doc.SetAutoDimensionsEnabled(false);
+            doc.AddWall({ 0, 0 }, { 4000, 0 })->SetWorkState(WorkStateNative::New);
+            doc.AddWall({ 4000, 0 }, { 4000, 3000 })->SetWorkState(WorkStateNative::Demolish);
+            auto snapshot = doc.CreateSnapshot();
+
+            EstimationEngine engine;
+            EstimationResult live = engine.Calculate(doc);
+            EstimationResult snap = engine.Calculate(*snapshot);
+
+            AssertEqual(snap.NewWalls.TotalLength, live.NewWalls.TotalLength, 0.001, "New wall length");
+            AssertEqual(snap.DemolitionWalls.TotalArea, live.DemolitionWalls.TotalArea, 0.001, "Demolition area");
+            AssertEqual(static_cast<int>(snap.Items.size()), static_cast<int>(live.Items.size()), "Same estimate lines");
+        });
+
+        runner.AddTest(L"Snapshot_WorkerThread", []() {
+            DocumentModel doc;
+            doc.SetAutoDimensionsEnabled(false);
+            for (int i = 0; i < 200; ++i)
+                doc.AddWall({ i * 100.0, 0 }, { i * 100.0, 3000 });
+            auto snapshot = doc.CreateSnapshot();
+
+            double workerLength = 0.0;
+            std::thread worker([snapshot, &workerLength]() {
+                for (const auto& wall : snapshot->GetWalls())
+                    workerLength += wall->GetLength();
+            });
+
+            // UI keeps editing meanwhile
+            for (const auto& wall : doc.GetWalls())
+                wall->SetEndPoint({ wall->GetStartPoint().X, 6000 });
+            worker.join();
+
+            AssertEqual(workerLength, 200 * 3000.0, 0.001, "Worker sees the snapshot geometry");
+        });
+
+        runner.AddTest(L"Snapshot_RoomJobKeepsSharedCopies", []() {
+            DocumentModel doc;
+            doc.SetAutoDimensionsEnabled(false);
+            Wall* wall = doc.AddWall({ 0, 0 }, { 4000, 0 });
+            doc.AddDoor(std::make_shared<Door>(wall->GetId(), 0.3));
+            doc.AddWindow(std::make_shared<Window>(wall->GetId(), 0.7));
+            doc.AddColumn(std::make_shared<Column>());
+            doc.AddSlab(std::make_shared<Slab>());
+            doc.AddBeam(std::make_shared<Beam>());
+            doc.EnableBackgroundRooms(true);
+            auto first = doc.CreateSnapshot();
+            size_t copies = doc.GetSnapshotCopyCount();
+
+            // A wall edit sends a walls-only snapshot to the room worker
+            wall->SetThickness(wall->GetThickness() + 50.0);
+            doc.NotifyWallChanged(wall->GetId());
+            doc.RebuildRooms();
+            AssertEqual(static_cast<int>(doc.GetSnapshotCopyCount()), static_cast<int>(copies + 1), "Room job copies the edited wall");
+
+            auto second = doc.CreateSnapshot();
+            AssertEqual(static_cast<int>(doc.GetSnapshotCopyCount()), static_cast<int>(copies + 1), "Other kinds are not copied again");
+            AssertTrue(first->GetDoors()[0] == second->GetDoors()[0], "Door shared");
+            AssertTrue(first->GetWindows()[0] == second->GetWindows()[0], "Window shared");
+            AssertTrue(first->GetColumns()[0] == second->GetColumns()[0], "Column shared");
+            AssertTrue(first->GetSlabs()[0] == second->GetSlabs()[0], "Slab shared");
+            AssertTrue(first->GetBeams()[0] == second->GetBeams()[0], "Beam shared");
+        });
+
+        return runner.Run(L"Document Snapshot Tests");
+    }
+
+    // ============================================================================
+    // Level Tests
+    // ============================================================================
+
+    inline TestSuite RunLevelTests()
+    {
+        TestRunner runner;
+
+        runner.AddTest(L"Level_StackElevation", []() {
+            DocumentModel doc;
+            AssertEqual(static_cast<int>(doc.GetLevelCount()), 1, "New document has one level");
+
+            uint64_t second = doc.AddLevel(L"", 3300.0);
+            uint64_t third = doc.AddLevel();
+            AssertEqual(doc.GetLevel(second)->GetElevation(), 3000.0, 0.001, "Second level sits on the first");
+            AssertEqual(doc.GetLevel(third)->GetElevation(), 6300.0, 0.001, "Third level sits on the second");
+        });
+
+        runner.AddTest(L"Level_PartitionsAreSeparate", []() {
+            DocumentModel doc;
+            doc.SetAutoDimensionsEnabled(false);
+            uint64_t ground = doc.GetActiveLevel().GetId();
+            doc.AddWall({ 0, 0 }, { 1000, 0 });
+
+            uint64_t upper = doc.AddLevel();
+            doc.SetActiveLevel(upper);
+            AssertEqual(static_cast<int>(doc.GetWallCount()), 0, "Upper level starts empty");
+            doc.AddWall({ 0, 0 }, { 0, 2000 });
+            doc.AddWall({ 0, 2000 }, { 2000, 2000 });
+
+            doc.SetActiveLevel(ground);
+            AssertEqual(static_cast<int>(doc.GetWallCount()), 1, "Ground level keeps its wall");
+            AssertTrue(doc.HitTest({ 0, 1000 }, 10.0, LayerManager()) == nullptr, "Upper walls are not hit on ground level");
+        });
+
+        runner.AddTest(L"Level_RoomsPerLevel", []() {
+            DocumentModel doc;
+            doc.SetAutoDimensionsEnabled(false);
+            uint64_t ground = doc.GetActiveLevel().GetId();
+            doc.AddWall({ 0, 0 }, { 4000, 0 });
+            doc.AddWall({ 4000, 0 }, { 4000, 3000 });
+            doc.AddWall({ 4000, 3000 }, { 0, 3000 });
+            doc.AddWall({ 0, 3000 }, { 0, 0 });
+            doc.RebuildRooms();
+            size_t groundRooms = doc.GetRooms().size();
+            AssertEqual(static_cast<int>(groundRooms), 1, "Ground level has a room");
+
+            uint64_t upper = doc.AddLevel();
+            doc.SetActiveLevel(upper);
+            doc.RebuildRooms();
+            AssertEqual(static_cast<int>(doc.GetRooms().size()), 0, "Upper level has no rooms");
+
+            doc.SetActiveLevel(ground);
+            AssertTrue(doc.GetRooms().size() == groundRooms, "Ground rooms survive the switch");
+        });
+
+        runner.AddTest(L"Level_ParallelEstimate", []() {
+            DocumentModel doc;
+            doc.SetAutoDimensionsEnabled(false);
+            doc.AddWall({ 0, 0 }, { 4000, 0 })->SetWorkState(WorkStateNative::New);
+
+            uint64_t upper = doc.AddLevel();
+            doc.SetActiveLevel(upper);
+            doc.AddWall({ 0, 0 }, { 6000, 0 })->SetWorkState(WorkStateNative::New);
+
+            EstimationEngine engine;
+            MultiLevelEstimate estimate = engine.CalculateLevels(doc.CreateAllLevelSnapshots());
+            AssertEqual(static_cast<int>(estimate.Levels.size()), 2, "One result per level");
+            AssertEqual(estimate.Levels[0].NewWalls.TotalLength, 4000.0, 0.001, "Ground level length");
+            AssertEqual(estimate.Levels[1].NewWalls.TotalLength, 6000.0, 0.001, "Upper level length");
+            AssertEqual(estimate.Total.NewWalls.TotalLength, 10000.0, 0.001, "Project total");
+            AssertEqual(engine.CalculateProject(doc.CreateAllLevelSnapshots()).NewWalls.TotalLength, 10000.0, 0.001,
+                "Project estimate covers every level");
+        });
+
+        runner.AddTest(L"Level_ParkedJoinsBuiltOnce", []() {
+            DocumentModel doc;
+            doc.SetAutoDimensionsEnabled(false);
+            uint64_t ground = doc.GetActiveLevel().GetId();
+            doc.AddWall({ 0, 0 }, { 4000, 0 });
+            doc.AddWall({ 4000, 0 }, { 4000, 3000 });
+            doc.SetActiveLevel(doc.AddLevel());
+
+            auto first = doc.CreateLevelSnapshot(ground);
+            auto second = doc.CreateLevelSnapshot(ground);
+            AssertTrue(&first->GetWallJoinGraph() == &second->GetWallJoinGraph(), "Parked joins are reused");
+
+            doc.SetActiveLevel(ground);
+            doc.GetWalls()[0]->SetThickness(400.0);
+            doc.SetActiveLevel(doc.GetLevels()[1].GetId());
+            auto edited = doc.CreateLevelSnapshot(ground);
+            AssertTrue(&edited->GetWallJoinGraph() != &first->GetWallJoinGraph(), "Parking again detects joins afresh");
+        });
+
+        runner.AddTest(L"Level_ForEachRestoresActive", []() {
+            DocumentModel doc;
+            doc.SetAutoDimensionsEnabled(false);
+            doc.AddWall({ 0, 0 }, { 1000, 0 });
+            uint64_t upper = doc.AddLevel();
+            doc.SetActiveLevel(upper);
+            doc.AddWall({ 0, 0 }, { 1000, 0 });
+            doc.AddWall({ 0, 0 }, { 0, 1000 });
+
+            uint64_t revision = doc.GetRevision();
+            std::vector<int> counts;
+            doc.ForEachLevel([&](const Level&) { counts.push_back(static_cast<int>(doc.GetWallCount())); });
+
+            AssertEqual(static_cast<int>(counts.size()), 2, "Visits every level");
+            AssertEqual(counts[0] + counts[1], 3, "Sees each level's walls");
+            AssertTrue(doc.GetActiveLevel().GetId() == upper, "Active level restored");
+            AssertTrue(doc.GetRevision() == revision, "Visiting levels does not reset caches");
+            AssertFalse(doc.RemoveLevel(upper), "Active level cannot be removed");
+        });
+
+        runner.AddTest(L"Level_ForEachDerivedDataPerLevel", []() {
+            DocumentModel doc;
+            doc.SetAutoDimensionsEnabled(false);
+            doc.AddWall({ 0, 0 }, { 1000, 0 });
+            uint64_t ground = doc.GetActiveLevel().GetId();
+            uint64_t upper = doc.AddLevel();
+            doc.SetActiveLevel(upper);
+            doc.AddWall({ 0, 0 }, { 1000, 0 });
+            doc.AddWall({ 0, 0 }, { 0, 1000 });
+            AssertEqual(static_cast<int>(doc.GetWallGraph().GetNodeCount()), 3, "Upper graph cached");
+            doc.GetWallJoinGraph();
+
+            // Derived data inside the callback is the visited level's
+            std::vector<int> nodes, joined;
+            doc.ForEachLevel([&](const Level&) {
+                nodes.push_back(static_cast<int>(doc.GetWallGraph().GetNodeCount()));
+                joined.push_back(static_cast<int>(doc.GetWallJoinGraph().GetWallCount()));
+            });
+            AssertEqual(nodes[0], 2, "Ground graph built from ground walls");
+            AssertEqual(joined[0], 1, "Ground joins built from ground walls");
+            AssertEqual(nodes[1], 3, "Upper graph after the restore");
+            AssertEqual(joined[1], 2, "Upper joins after the restore");
+
+            // An edit on another level resets the journal once restored
+            uint64_t revision = doc.GetRevision();
+            doc.ForEachLevel([&](const Level& level) {
+                if (level.GetId() == ground)
+                    doc.AddWall({ 1000, 0 }, { 1000, 1000 });
+            });
+            AssertTrue(doc.GetChangesSince(revision).IsFullReset, "Foreign edits reset the journal");
+            AssertEqual(static_cast<int>(doc.GetWallGraph().GetNodeCount()), 3, "Upper graph unchanged");
+            AssertEqual(static_cast<int>(doc.GetWallJoinGraph().GetWallCount()), 2, "Upper joins unchanged");
+            AssertEqual(static_cast<int>(doc.CreateLevelSnapshot(ground)->GetWalls().size()), 2, "Edit kept on the ground level");
+        });
+
+        return runner.Run(L"Level Tests");
+    }
+
+    // ============================================================================
+    // Room Detector Tests
+    // ============================================================================
+
+    inline std::vector<std::unique_ptr<Wall>> MakeWalls(std::initializer_list<std::pair<WorldPoint, WorldPoint>> axes)
+    {
+        std::vector<std::unique_ptr<Wall>> walls;
+        for (const auto& axis : axes)
+            walls.push_back(std::make_unique<Wall>(axis.first, axis.second, 200.0));
+        return walls;
+    }
+
+    inline TestSuite RunRoomDetectorTests()
+    {
+        TestRunner runner;
+
+        runner.AddTest(L"RoomDetector_SingleRectangle", []() {
+            auto walls = MakeWalls({
+                { { 0, 0 }, { 4000, 0 } }, { { 4000, 0 }, { 4000, 3000 } },
+                { { 4000, 3000 }, { 0, 3000 } }, { { 0, 3000 }, { 0, 0 } } });
+            auto rooms = RoomDetector::DetectRooms(walls);
+            AssertEqual(static_cast<int>(rooms.size()), 1, "One rectangle is one room");
+            AssertEqual(rooms[0]->GetAreaSqM(), 12.0, 0.001, "Room area");
+            AssertEqual(static_cast<int>(rooms[0]->GetBoundaries().size()), 4, "One boundary per wall");
+        });
+
+        runner.AddTest(L"RoomDetector_Grid", []() {
+            DocumentModel doc;
+            doc.SetAutoDimensionsEnabled(false);
+            for (int i = 0; i <= 2; ++i)
+            {
+                doc.AddWall({ 0, i * 3000.0 }, { 6000, i * 3000.0 });
+                doc.AddWall({ i * 3000.0, 0 }, { i * 3000.0, 6000 });
+            }
+            auto rooms = RoomDetector::DetectRooms(doc.GetWallHotData());
+            AssertEqual(static_cast<int>(rooms.size()), 4, "2x2 grid has four rooms");
+            for (const auto& room : rooms)
+                AssertEqual(room->GetAreaSqM(), 9.0, 0.001, "Each cell is 3x3 m");
+        });
+
+        runner.AddTest(L"RoomDetector_TJunctionSplits", []() {
+            // Partition ends on the middle of the long walls
+            auto walls = MakeWalls({
+                { { 0, 0 }, { 6000, 0 } }, { { 6000, 0 }, { 6000, 3000 } },
+                { { 6000, 3000 }, { 0, 3000 } }, { { 0, 3000 }, { 0, 0 } },
+                { { 2000, 0 }, { 2000, 3000 } } });
+            auto rooms = RoomDetector::DetectRooms(walls);
+            AssertEqual(static_cast<int>(rooms.size()), 2, "Partition splits the room");
+
+            std::set<int> areas;
+            for (const auto& room : rooms)
+                areas.insert(static_cast<int>(std::round(room->GetAreaSqM())));
+            AssertTrue(areas.count(6) == 1 && areas.count(12) == 1, "Areas 6 and 12 m2");
+        });
+
+        runner.AddTest(L"RoomDetector_CrossingAndDangling", []() {
+            // Two walls cross in the middle; a stub sticks out of the outline
+            auto walls = MakeWalls({
+                { { 0, 0 }, { 4000, 0 } }, { { 4000, 0 }, { 4000, 4000 } },
+                { { 4000, 4000 }, { 0, 4000 } }, { { 0, 4000 }, { 0, 0 } },
+                { { 2000, -500 }, { 2000, 4500 } }, { { 0, 2000 }, { 4000, 2000 } },
+                { { 4000, 1000 }, { 5500, 1000 } } });
+            auto rooms = RoomDetector::DetectRooms(walls);
+            AssertEqual(static_cast<int>(rooms.size()), 4, "Crossing walls make four rooms");
+            for (const auto& room : rooms)
+                AssertEqual(static_cast<int>(room->GetContour().size()), 4, "Stubs leave no extra corners");
+        });
+
+        runner.AddTest(L"RoomDetector_ManyCorners", []() {
+            // Stepped outline with 14 corners, beyond the old DFS depth limit
+            std::vector<WorldPoint> pts = {
+                { 0, 0 }, { 6000, 0 }, { 6000, 1000 }, { 5000, 1000 }, { 5000, 2000 },
+                { 4000, 2000 }, { 4000, 3000 }, { 3000, 3000 }, { 3000, 4000 },
+                { 2000, 4000 }, { 2000, 5000 }, { 1000, 5000 }, { 1000, 6000 }, { 0, 6000 } };
+            std::vector<std::unique_ptr<Wall>> walls;
+            for (size_t i = 0; i < pts.size(); ++i)
+                walls.push_back(std::make_unique<Wall>(pts[i], pts[(i + 1) % pts.size()], 200.0));
+
+            auto rooms = RoomDetector::DetectRooms(walls);
+            AssertEqual(static_cast<int>(rooms.size()), 1, "Stepped room found");
+            AssertEqual(static_cast<int>(rooms[0]->GetContour().size()), 14, "All corners kept");
+        });
+
+        return runner.Run(L"Room Detector Tests");
+    }
+
+    // ============================================================================
+    // Wall Graph Tests
+    // ============================================================================
+
+    inline TestSuite RunWallGraphTests()
+    {
+        TestRunner runner;
+
+        runner.AddTest(L"WallGraph_WelderMergesWithinTolerance", []() {
+            VertexWelder welder(5.0);
+            int a = welder.Weld({ 1000, 1000 });
+            int b = welder.Weld({ 1003, 998 });
+            int c = welder.Weld({ 1010, 1000 });
+            AssertEqual(a, b, "Points 3.6 mm apart are welded");
+            AssertTrue(a != c, "Points 10 mm apart stay separate");
+
+            // Neighbouring cell across a cell boundary
+            int d = welder.Weld({ -0.5, 0 });
+            int e = welder.Weld({ 0.5, 0 });
+            AssertEqual(d, e, "Welding works across cell boundaries");
+        });
+
+        runner.AddTest(L"WallGraph_CornerNode", []() {
+            auto walls = MakeWalls({ { { 0, 0 }, { 3000, 0 } }, { { 3002, 1 }, { 3000, 3000 } } });
+            WallHotData hot;
+            for (const auto& w : walls) hot.PushBack(*w);
+
+            WallGraph graph = WallGraph::Build(hot);
+            AssertEqual(static_cast<int>(graph.GetNodeCount()), 3, "Corner is one node");
+            AssertEqual(static_cast<int>(graph.GetWallsAt(WorldPoint(3000, 0)).size()), 2, "Both walls meet at the corner");
+            AssertTrue(graph.IsWallEnd(graph.FindNode({ 3000, 0 }, 5.0)), "Corner is a wall end");
+        });
+
+        runner.AddTest(L"WallGraph_TJunctionSplitsEdge", []() {
+            auto walls = MakeWalls({ { { 0, 0 }, { 6000, 0 } }, { { 2000, 0 }, { 2000, 3000 } } });
+            WallHotData hot;
+            for (const auto& w : walls) hot.PushBack(*w);
+
+            WallGraph graph = WallGraph::Build(hot);
+            AssertEqual(static_cast<int>(graph.GetEdges().size()), 3, "Long wall is split at the junction");
+            AssertEqual(static_cast<int>(graph.GetWallsAt(WorldPoint(2000, 0)).size()), 2, "Junction lists both walls");
+        });
+
+        runner.AddTest(L"WallGraph_CachedPerRevision", []() {
+            DocumentModel doc;
+            doc.SetAutoDimensionsEnabled(false);
+            Wall* wall = doc.AddWall({ 0, 0 }, { 4000, 0 });
+            doc.AddWall({ 4000, 0 }, { 4000, 3000 });
+
+            const WallGraph* first = &doc.GetWallGraph();
+            AssertEqual(static_cast<int>(first->GetNodeCount()), 3, "Three nodes");
+            AssertTrue(&doc.GetWallGraph() == first, "Same graph while nothing changes");
+
+            // Direct edit is seen after sync
+            wall->SetStartPoint({ -1000, 0 });
+            doc.SyncWallEdits();
+            AssertTrue(doc.GetWallGraph().FindNode({ -1000, 0 }, 1.0) >= 0, "Graph follows the edit");
+            AssertTrue(doc.GetWallGraph().FindNode({ 0, 0 }, 1.0) < 0, "Old endpoint is gone");
+        });
+
+        runner.AddTest(L"WallGraph_EndpointSnap", []() {
+            DocumentModel doc;
+            doc.SetAutoDimensionsEnabled(false);
+            doc.AddWall({ 0, 0 }, { 4000, 0 });
+            doc.AddWall({ 2000, -2000 }, { 2000, 2000 });
+
+            SnapManager snap;
+            Camera camera;
+            SnapResult r = snap.FindSnap({ 4005, 3 }, doc, LayerManager(), camera);
+            AssertTrue(r.hasSnap && r.snapType == L"endpoint", "Snaps to the wall end");
+            AssertEqual(r.point.X, 4000.0, 0.001, "Snapped X");
+
+            // Crossing point is a graph node but not an endpoint
+            r = snap.FindSnap({ 2003, 3 }, doc, LayerManager(), camera);
+            AssertTrue(!r.hasSnap || r.snapType != L"endpoint", "Crossings are not endpoints");
+        });
+
+        runner.AddTest(L"WallGraph_SnapsToExactVisibleEnd", []() {
+            DocumentModel doc;
+            doc.SetAutoDimensionsEnabled(false);
+            doc.AddWall({ 0, 0 }, { 4000, 0 });
+            Wall* other = doc.AddWall({ 4003, 0 }, { 4003, 3000 });
+
+            // Both ends weld into one node; the hit is the wall's own end
+            SnapManager snap;
+            Camera camera;
+            SnapResult r = snap.FindSnap({ 4004, 1 }, doc, LayerManager(), camera);
+            AssertTrue(r.hasSnap && r.snapType == L"endpoint", "Welded corner snaps as an endpoint");
+            AssertEqual(r.point.X, 4003.0, 1e-9, "Exact end of the nearer wall");
+
+            // A hidden wall's end does not make the node snappable as its end
+            other->SetWorkState(WorkStateNative::Demolish);
+            LayerManager layers;
+            layers.GetLayerByWorkState(WorkStateNative::Demolish)->SetVisible(false);
+            r = snap.FindSnap({ 4004, 1 }, doc, layers, camera);
+            AssertTrue(r.hasSnap && r.snapType == L"endpoint", "Visible wall still ends here");
+            AssertEqual(r.point.X, 4000.0, 1e-9, "End of the visible wall only");
+        });
+
+        return runner.Run(L"Wall Graph Tests");
+    }
+
+    // ============================================================================
+    // Incremental Room Tests
+    // ============================================================================
+
+    // 6 x 3 m outline with a partition at x = 2 m
+    inline uint64_t BuildPartitionedRoom(DocumentModel& doc)
+    {
+        doc.SetAutoDimensionsEnabled(false);
+        doc.AddWall({ 0, 0 }, { 6000, 0 });
+        doc.AddWall({ 6000, 0 }, { 6000, 3000 });
+        doc.AddWall({ 6000, 3000 }, { 0, 3000 });
+        doc.AddWall({ 0, 3000 }, { 0, 0 });
+        uint64_t partition = doc.AddWall({ 2000, 0 }, { 2000, 3000 })->GetId();
+        doc.RebuildRooms();
+        return partition;
+    }
+
+    inline std::shared_ptr<Room> RoomAt(const DocumentModel& doc, const WorldPoint& p)
+    {
+        for (const auto& room : doc.GetRooms())
+            if (room->HitTest(p, 0.0)) return room;
+        return nullptr;
+    }
+
+    inline TestSuite RunIncrementalRoomTests()
+    {
+        TestRunner runner;
+
+        runner.AddTest(L"IncrementalRoom_MoveKeepsIdentity", []() {
+            DocumentModel doc;
+            uint64_t partition = BuildPartitionedRoom(doc);
+            auto left = RoomAt(doc, { 1000, 1500 });
+            AssertTrue(left != nullptr, "Left room exists");
+            left->SetName(L"Kitchen");
+            uint64_t leftId = left->GetId();
+
+            doc.TrimExtendWall(partition, { 3000, 0 }, { 3000, 3000 });
+
+            AssertEqual(static_cast<int>(doc.GetRooms().size()), 2, "Still two rooms");
+            auto moved = RoomAt(doc, { 1000, 1500 });
+            AssertTrue(moved && moved->GetId() == leftId, "Left room keeps its id");
+            AssertTrue(moved->GetName() == L"Kitchen", "Left room keeps its name");
+            AssertEqual(moved->GetAreaSqM(), 9.0, 0.001, "Area follows the wall");
+        });
+
+        runner.AddTest(L"IncrementalRoom_SplitAddsRoom", []() {
+            DocumentModel doc;
+            BuildPartitionedRoom(doc);
+            auto right = RoomAt(doc, { 4000, 1500 });
+            uint64_t rightId = right->GetId();
+
+            // Splits the 4 x 3 m room into 3 x 3 and 1 x 3
+            doc.AddWall({ 5000, 0 }, { 5000, 3000 });
+            doc.RebuildRooms();
+
+            AssertEqual(static_cast<int>(doc.GetRooms().size()), 3, "Three rooms");
+            AssertTrue(RoomAt(doc, { 4000, 1500 })->GetId() == rightId, "Larger part keeps the id");
+            auto added = RoomAt(doc, { 5500, 1500 });
+            AssertTrue(added->GetId() != rightId, "Smaller part is a new room");
+            AssertTrue(added->GetNumber() == L"3", "New room gets the next number");
+        });
+
+        runner.AddTest(L"IncrementalRoom_RemoveMerges", []() {
+            DocumentModel doc;
+            uint64_t partition = BuildPartitionedRoom(doc);
+            uint64_t rightId = RoomAt(doc, { 4000, 1500 })->GetId();
+
+            doc.RemoveWall(partition);
+
+            AssertEqual(static_cast<int>(doc.GetRooms().size()), 1, "Rooms merge");
+            AssertTrue(doc.GetRooms()[0]->GetId() == rightId, "Larger room survives");
+            AssertEqual(doc.GetRooms()[0]->GetAreaSqM(), 18.0, 0.001, "Merged area");
+        });
+
+        runner.AddTest(L"IncrementalRoom_FarEditLeavesRoomsAlone", []() {
+            DocumentModel doc;
+            BuildPartitionedRoom(doc);
+            auto left = RoomAt(doc, { 1000, 1500 });
+            auto right = RoomAt(doc, { 4000, 1500 });
+            left->SetLabelPosition({ 500, 500 });
+
+            // Separate room far away
+            doc.AddWall({ 20000, 0 }, { 23000, 0 });
+            doc.AddWall({ 23000, 0 }, { 23000, 3000 });
+            doc.AddWall({ 23000, 3000 }, { 20000, 3000 });
+            doc.AddWall({ 20000, 3000 }, { 20000, 0 });
+            doc.RebuildRooms();
+
+            AssertEqual(static_cast<int>(doc.GetRooms().size()), 3, "New room added");
+            AssertTrue(RoomAt(doc, { 1000, 1500 }) == left, "Left room object untouched");
+            AssertTrue(RoomAt(doc, { 4000, 1500 }) == right, "Right room object untouched");
+            AssertEqual(left->GetLabelPoint().X, 500.0, 0.001, "Label override kept");
+        });
+
+        runner.AddTest(L"IncrementalRoom_ZonesPatched", []() {
+            DocumentModel doc;
+            uint64_t partition = BuildPartitionedRoom(doc);
+            RoomAt(doc, { 1000, 1500 })->SetCategory(RoomCategory::Wet);
+            doc.RebuildZones();
+
+            auto wetZone = [&doc]() -> std::shared_ptr<Zone> {
+                for (const auto& z : doc.GetAutoZones())
+                    if (z->GetType() == ZoneType::Wet) return z;
+                return nullptr;
+            };
+            auto zone = wetZone();
+            double before = zone->GetTotalAreaSqM();
+            AssertEqual(before, RoomAt(doc, { 1000, 1500 })->GetNetAreaSqM(), 0.001, "Wet zone holds the left room");
+
+            doc.TrimExtendWall(partition, { 2500, 0 }, { 2500, 3000 });
+            AssertTrue(wetZone() == zone, "Zone object kept");
+            AssertEqual(zone->GetTotalAreaSqM(), RoomAt(doc, { 1000, 1500 })->GetNetAreaSqM(), 0.001, "Zone total follows the moved wall");
+            AssertTrue(zone->GetTotalAreaSqM() > before, "Room grew");
+
+            // Merged room is the larger right one; the wet room is gone
+            doc.RemoveWall(partition);
+            AssertTrue(wetZone() == nullptr, "Empty zone dropped");
+            AssertEqual(doc.GetZoneManager().GetTotalAreaSqM(), doc.GetRooms()[0]->GetNetAreaSqM(), 0.001, "Total after merge");
+        });
+
+        return runner.Run(L"Incremental Room Tests");
+    }
+
+    // ============================================================================
+    // Room Net Area Tests
+    // ============================================================================
+
+    // Counter-clockwise 4 x 3 m outline with the given wall thickness
+    inline std::vector<Wall*> BuildThickRoom(DocumentModel& doc, double thickness)
+    {
+        doc.SetAutoDimensionsEnabled(false);
+        std::vector<Wall*> walls = {
+            doc.AddWall({ 0, 0 }, { 4000, 0 }),
+            doc.AddWall({ 4000, 0 }, { 4000, 3000 }),
+            doc.AddWall({ 4000, 3000 }, { 0, 3000 }),
+            doc.AddWall({ 0, 3000 }, { 0, 0 }) };
+        for (Wall* w : walls)
+            w->SetThickness(thickness);
+        doc.RebuildRooms();
+        return walls;
+    }
+
+    inline TestSuite RunRoomNetAreaTests()
+    {
+        TestRunner runner;
+
+        runner.AddTest(L"RoomNetArea_InnerFaces", []() {
+            DocumentModel doc;
+            BuildThickRoom(doc, 200.0);
+            const auto& room = doc.GetRooms()[0];
+            AssertEqual(room->GetAreaSqM(), 12.0, 0.001, "Axis area");
+            AssertEqual(room->GetNetAreaSqM(), 3.8 * 2.8, 0.001, "Area inside the wall faces");
+            AssertEqual(room->GetNetPerimeterM(), 2 * (3.8 + 2.8), 0.001, "Perimeter along the faces");
+        });
+
+        runner.AddTest(L"RoomNetArea_MixedThickness", []() {
+            DocumentModel doc;
+            auto walls = BuildThickRoom(doc, 200.0);
+            walls[1]->SetThickness(400.0);
+            doc.NotifyWallChanged(walls[1]->GetId());
+
+            const auto& room = doc.GetRooms()[0];
+            AssertEqual(room->GetNetAreaSqM(), 3.7 * 2.8, 0.001, "Thicker wall takes more floor");
+            AssertEqual(static_cast<int>(room->GetNetContour().size()), 4, "Still a rectangle");
+        });
+
+        runner.AddTest(L"RoomNetArea_LocationLine", []() {
+            DocumentModel doc;
+            auto walls = BuildThickRoom(doc, 200.0);
+            // Axis on the outer face: the whole thickness is inside the outline
+            for (Wall* w : walls)
+            {
+                w->SetLocationLineMode(LocationLineMode::FinishFaceExterior);
+                doc.NotifyWallChanged(w->GetId());
+            }
+            AssertEqual(doc.GetRooms()[0]->GetNetAreaSqM(), 3.6 * 2.6, 0.001, "Faces follow the location line");
+        });
+
+        runner.AddTest(L"RoomNetArea_CollinearStep", []() {
+            DocumentModel doc;
+            doc.SetAutoDimensionsEnabled(false);
+            std::vector<Wall*> walls = {
+                doc.AddWall({ 0, 0 }, { 2000, 0 }),
+                doc.AddWall({ 2000, 0 }, { 4000, 0 }),
+                doc.AddWall({ 4000, 0 }, { 4000, 3000 }),
+                doc.AddWall({ 4000, 3000 }, { 0, 3000 }),
+                doc.AddWall({ 0, 3000 }, { 0, 0 }) };
+            for (Wall* w : walls)
+                w->SetThickness(200.0);
+            walls[1]->SetThickness(400.0);
+            doc.RebuildRooms();
+
+            const auto& room = doc.GetRooms()[0];
+            AssertEqual(static_cast<int>(room->GetNetContour().size()), 6, "Step between the two faces");
+            AssertEqual(room->GetNetAreaSqM(), 3.8 * 2.8 - 1.9 * 0.1, 0.001, "Thicker half takes its share");
+        });
+
+        runner.AddTest(L"RoomNetArea_CacheFollowsRevision", []() {
+            DocumentModel doc;
+            BuildThickRoom(doc, 200.0);
+            auto room = doc.GetRooms()[0];
+            room->SetCeilingHeight(2500.0);
+            double wallArea = room->GetNetWallAreaSqM();
+            AssertEqual(wallArea, 2 * (3.8 + 2.8) * 2.5, 0.001, "Wall face area");
+
+            room->SetCeilingHeight(3000.0);
+            AssertEqual(room->GetNetWallAreaSqM(), 2 * (3.8 + 2.8) * 3.0, 0.001, "Recomputed after height change");
+            AssertEqual(room->GetNetVolumeCuM(), 3.8 * 2.8 * 3.0, 0.001, "Net volume");
+        });
+
+        runner.AddTest(L"RoomNetArea_ZoneTotalsFollowFaces", []() {
+            DocumentModel doc;
+            auto walls = BuildThickRoom(doc, 200.0);
+            AssertEqual(doc.GetZoneManager().GetTotalAreaSqM(), 3.8 * 2.8, 0.001, "Zone sums net areas");
+
+            // Neither edit re-traces the room; both must reach the zone
+            walls[1]->SetThickness(400.0);
+            doc.NotifyWallChanged(walls[1]->GetId());
+            AssertEqual(doc.GetZoneManager().GetTotalAreaSqM(), 3.7 * 2.8, 0.001, "Thickness edit reported");
+
+            walls[1]->SetLocationLineMode(LocationLineMode::FinishFaceExterior);
+            doc.NotifyWallChanged(walls[1]->GetId());
+            AssertEqual(doc.GetZoneManager().GetTotalAreaSqM(), 3.5 * 2.8, 0.001, "Location line edit reported");
+        });
+
+        return runner.Run(L"Room Net Area Tests");
+    }
+
+    // ============================================================================
+    // Room Worker Tests
+    // ============================================================================
+
+    inline TestSuite RunRoomWorkerTests()
+    {
+        TestRunner runner;
+
+        runner.AddTest(L"RoomWorker_AppliedOnFinish", []() {
+            DocumentModel doc;
+            doc.EnableBackgroundRooms(true);
+            BuildPartitionedRoom(doc);
+            AssertTrue(doc.IsRoomWorkPending(), "Detection runs in the background");
+
+            doc.FinishRoomWork();
+            AssertFalse(doc.IsRoomWorkPending(), "Nothing left after finishing");
+            AssertEqual(static_cast<int>(doc.GetRooms().size()), 2, "Both rooms applied");
+        });
+
+        runner.AddTest(L"RoomWorker_KeepsRoomObjects", []() {
+            DocumentModel doc;
+            uint64_t partition = BuildPartitionedRoom(doc);
+            doc.EnableBackgroundRooms(true);
+            auto left = RoomAt(doc, { 1000, 1500 });
+            left->SetName(L"Kitchen");
+
+            doc.TrimExtendWall(partition, { 3000, 0 }, { 3000, 3000 });
+            AssertEqual(left->GetAreaSqM(), 6.0, 0.001, "Old rooms shown until the result is applied");
+
+            doc.FinishRoomWork();
+            AssertTrue(RoomAt(doc, { 1000, 1500 }) == left, "Same room object");
+            AssertTrue(left->GetName() == L"Kitchen", "Name kept");
+            AssertEqual(left->GetAreaSqM(), 9.0, 0.001, "Geometry from the worker");
+        });
+
+        runner.AddTest(L"RoomWorker_NewestEditWins", []() {
+            DocumentModel doc;
+            uint64_t partition = BuildPartitionedRoom(doc);
+            doc.EnableBackgroundRooms(true);
+
+            for (double x : { 2500.0, 3000.0, 3500.0, 4000.0 })
+                doc.TrimExtendWall(partition, { x, 0 }, { x, 3000 });
+
+            doc.FinishRoomWork();
+            AssertEqual(static_cast<int>(doc.GetRooms().size()), 2, "Two rooms");
+            AssertEqual(RoomAt(doc, { 1000, 1500 })->GetAreaSqM(), 12.0, 0.001, "Last position applied");
+            AssertEqual(RoomAt(doc, { 5000, 1500 })->GetAreaSqM(), 6.0, 0.001, "Other side follows");
+        });
+
+        runner.AddTest(L"RoomWorker_LevelSwitchCancels", []() {
+            DocumentModel doc;
+            doc.EnableBackgroundRooms(true);
+            BuildPartitionedRoom(doc);
+            uint64_t upper = doc.AddLevel();
+
+            doc.SetActiveLevel(upper);
+            AssertFalse(doc.IsRoomWorkPending(), "Pending work dropped");
+            doc.FinishRoomWork();
+            AssertFalse(doc.ApplyCompletedRooms(), "Stale result never applied");
+            AssertTrue(doc.GetRooms().empty(), "Upper level has no rooms");
+        });
+
+        runner.AddTest(L"RoomWorker_ThicknessUpdatesZones", []() {
+            DocumentModel doc;
+            auto walls = BuildThickRoom(doc, 200.0);
+            doc.EnableBackgroundRooms(true);
+            double before = doc.GetZoneManager().GetTotalAreaSqM();
+
+            for (Wall* w : walls)
+            {
+                w->SetThickness(400.0);
+                doc.NotifyWallChanged(w->GetId());
+            }
+            doc.RebuildRooms();
+            doc.FinishRoomWork();
+
+            double net = doc.GetRooms()[0]->GetNetAreaSqM();
+            AssertTrue(net < before, "Thicker walls shrink the room");
+            AssertEqual(doc.GetZoneManager().GetTotalAreaSqM(), net, 0.001, "Zone totals refreshed");
+        });
+
+        return runner.Run(L"Room Worker Tests");
+    }
+
+    // ============================================================================
+    // Wall Join Index Tests
+    // ============================================================================
+
+    inline TestSuite RunWallJoinIndexTests()
+    {
+        TestRunner runner;
+
+        runner.AddTest(L"WallJoinIndex_CandidatesNearOnly", []() {
+            std::vector<std::unique_ptr<Wall>> walls;
+            walls.push_back(std::make_unique<Wall>(WorldPoint{ 0, 0 }, WorldPoint{ 3000, 0 }, 200.0));
+            walls.push_back(std::make_unique<Wall>(WorldPoint{ 3000, 0 }, WorldPoint{ 3000, 3000 }, 200.0));
+            walls.push_back(std::make_unique<Wall>(WorldPoint{ 20000, 0 }, WorldPoint{ 23000, 0 }, 200.0));
+            WallJoinIndex index(walls);
+
+            std::vector<uint64_t> found;
+            index.ForEachCandidate(*walls[0], 50.0, [&](const Wall& other) { found.push_back(other.GetId()); });
+
+            AssertEqual(static_cast<int>(found.size()), 1, "Only the touching wall");
+            AssertTrue(found[0] == walls[1]->GetId(), "Corner wall found");
+        });
+
+        runner.AddTest(L"WallJoinIndex_LongWallFound", []() {
+            // One wall spanning the plan, short walls ending on it
+            std::vector<std::unique_ptr<Wall>> walls;
+            walls.push_back(std::make_unique<Wall>(WorldPoint{ 0, 0 }, WorldPoint{ 200000, 200000 }, 200.0));
+            for (int i = 1; i < 20; ++i)
+            {
+                double t = i * 10000.0;
+                walls.push_back(std::make_unique<Wall>(WorldPoint{ t, t }, WorldPoint{ t + 1000, t - 1000 }, 200.0));
+            }
+            WallJoinIndex index(walls);
+
+            int hits = 0;
+            index.ForEachCandidate(*walls[5], 50.0, [&](const Wall& other) {
+                if (other.GetId() == walls[0]->GetId()) ++hits;
+            });
+            AssertEqual(hits, 1, "Long wall reported once");
+        });
+
+        runner.AddTest(L"WallJoinIndex_AllJoinsMatchPerWall", []() {
+            std::vector<std::unique_ptr<Wall>> walls;
+            for (int r = 0; r <= 4; ++r)
+                for (int c = 0; c < 4; ++c)
+                    walls.push_back(std::make_unique<Wall>(WorldPoint{ c * 3000.0, r * 3000.0 }, WorldPoint{ (c + 1) * 3000.0, r * 3000.0 }, 200.0));
+            for (int c = 0; c <= 4; ++c)
+                walls.push_back(std::make_unique<Wall>(WorldPoint{ c * 3000.0, 0 }, WorldPoint{ c * 3000.0, 12000 }, 200.0));
+
+            WallJoinSystem joins;
+            size_t perWall = 0;
+            for (const auto& w : walls)
+                perWall += joins.FindJoins(*w, walls).size();
+            AssertEqual(static_cast<int>(joins.FindAllJoins(walls).size()), static_cast<int>(perWall), "Join system");
+
+            WallAttachmentSystem attachment;
+            size_t perWallAttachment = 0;
+            for (const auto& w : walls)
+                perWallAttachment += attachment.FindJoins(*w, walls).size();
+            AssertEqual(static_cast<int>(attachment.FindAllJoins(walls).size()), static_cast<int>(perWallAttachment), "Attachment system");
+
+            WallJoinManager manager;
+            size_t perWallManager = 0;
+            for (const auto& w : walls)
+                perWallManager += manager.FindJoins(*w, walls).size();
+            AssertEqual(static_cast<int>(manager.FindAllJoins(walls).size()), static_cast<int>(perWallManager), "Join manager");
+            AssertTrue(perWallManager > 0, "Grid has joins");
+        });
+
+        runner.AddTest(L"WallJoinIndex_AttachmentLineCache", []() {
+            Wall wall({ 0, 0 }, { 3000, 0 }, 200.0);
+            WallAttachmentSystem attachment;
+
+            AttachmentLine core = attachment.GetCachedAttachmentLine(wall);
+            AssertEqual(core.Start.Y, 0.0, 0.001, "Core line on the axis");
+
+            wall.SetLocationLineMode(LocationLineMode::FinishFaceExterior);
+            AttachmentLine face = attachment.GetCachedAttachmentLine(wall);
+            AssertEqual(std::abs(face.Start.Y), 100.0, 0.001, "Line follows the location line");
+
+            wall.SetThickness(400.0);
+            AssertEqual(std::abs(attachment.GetCachedAttachmentLine(wall).Start.Y), 200.0, 0.001, "Line follows the thickness");
+        });
+
+        runner.AddTest(L"WallJoinIndex_DocumentRebuildsOnEdit", []() {
+            DocumentModel doc;
+            doc.SetAutoDimensionsEnabled(false);
+            Wall* a = doc.AddWall({ 0, 0 }, { 3000, 0 });
+            const WallJoinIndex* index = &doc.GetWallJoinIndex();
+            AssertEqual(static_cast<int>(index->Size()), 1, "One wall indexed");
+
+            doc.AddWall({ 3000, 0 }, { 3000, 3000 });
+            AssertEqual(static_cast<int>(doc.GetWallJoinIndex().Size()), 2, "Rebuilt after AddWall");
+
+            int near = 0;
+            doc.GetWallJoinIndex().ForEachCandidate(*a, 50.0, [&](const Wall&) { ++near; });
+            AssertEqual(near, 1, "New wall is a candidate");
+        });
+
+        return runner.Run(L"Wall Join Index Tests");
+    }
+
+    // ============================================================================
+    // Wall Join Graph Tests
+    // ============================================================================
+
+    inline void AddJoinGraphGrid(DocumentModel& doc, int cells)
+    {
+        double span = cells * 3000.0;
+        for (int r = 0; r <= cells; ++r)
+            for (int c = 0; c < cells; ++c)
+                doc.AddWall({ c * 3000.0, r * 3000.0 }, { (c + 1) * 3000.0, r * 3000.0 }, 200.0);
+        for (int c = 0; c <= cells; ++c)
+            doc.AddWall({ c * 3000.0, 0 }, { c * 3000.0, span }, 200.0);
+    }
+
+    inline TestSuite RunWallJoinGraphTests()
+    {
+        TestRunner runner;
+
+        runner.AddTest(L"WallJoinGraph_CornerContourMitred", []() {
+            DocumentModel doc;
+            doc.SetAutoDimensionsEnabled(false);
+            Wall* a = doc.AddWall({ 0, 0 }, { 3000, 0 }, 200.0);
+            doc.AddWall({ 3000, 0 }, { 3000, 3000 }, 200.0);
+
+            const auto& contour = doc.GetWallJoinGraph().GetContour(a->GetId());
+            AssertTrue(contour.size() >= 4, "Contour built");
+
+            // The outer face runs past the axis end by the half width
+            double maxX = -1e9, halfWidth = 0.0;
+            for (const auto& p : contour)
+            {
+                maxX = (std::max)(maxX, p.X);
+                halfWidth = (std::max)(halfWidth, std::abs(p.Y));
+            }
+            AssertTrue(halfWidth > 1.0, "Contour has width");
+            AssertEqual(maxX, 3000.0 + halfWidth, 0.5, "Outer face runs to the corner");
+            AssertFalse(doc.GetWallJoinGraph().GetJoins(a->GetId()).empty(), "Corner join stored");
+        });
+
+        runner.AddTest(L"WallJoinGraph_PatchMatchesRebuild", []() {
+            DocumentModel doc;
+            doc.SetAutoDimensionsEnabled(false);
+            AddJoinGraphGrid(doc, 4);
+            doc.GetWallJoinGraph();
+
+            // Move one interior vertical wall sideways
+            Wall* moved = doc.GetWalls()[doc.GetWalls().size() - 3].get();
+            moved->SetStartPoint({ moved->GetStartPoint().X + 1500, moved->GetStartPoint().Y });
+            moved->SetEndPoint({ moved->GetEndPoint().X + 1500, moved->GetEndPoint().Y });
+            doc.NotifyWallChanged(moved->GetId());
+
+            const WallJoinGraph& patched = doc.GetWallJoinGraph();
+            WallJoinGraph rebuilt;
+            rebuilt.Rebuild(doc.GetWallStore(), WallJoinIndex(doc.GetWalls()));
+
+            AssertEqual(static_cast<int>(patched.GetJoinCount()), static_cast<int>(rebuilt.GetJoinCount()), "Same join count");
+            for (const auto& wall : doc.GetWalls())
+            {
+                const auto& a = patched.GetContour(wall->GetId());
+                const auto& b = rebuilt.GetContour(wall->GetId());
+                AssertEqual(static_cast<int>(a.size()), static_cast<int>(b.size()), "Same contour size");
+                for (size_t i = 0; i < a.size(); ++i)
+                {
+                    AssertEqual(a[i].X, b[i].X, 0.001, "Same contour X");
+                    AssertEqual(a[i].Y, b[i].Y, 0.001, "Same contour Y");
+                }
+            }
+        });
+
+        runner.AddTest(L"WallJoinGraph_EditRefreshesNeighboursOnly", []() {
+            DocumentModel doc;
+            doc.SetAutoDimensionsEnabled(false);
+            AddJoinGraphGrid(doc, 6);
+            size_t total = doc.GetWallJoinGraph().GetLastRefreshedCount();
+            AssertEqual(static_cast<int>(total), static_cast<int>(doc.GetWalls().size()), "First build covers all walls");
+
+            Wall* edited = doc.GetWalls()[8].get();
+            edited->SetThickness(300.0);
+            doc.NotifyWallChanged(edited->GetId());
+
+            size_t refreshed = doc.GetWallJoinGraph().GetLastRefreshedCount();
+            AssertTrue(refreshed > 1, "Wall and neighbours refreshed");
+            AssertTrue(refreshed < 8, "Far walls untouched");
+        });
+
+        runner.AddTest(L"WallJoinGraph_RemoveClearsJoins", []() {
+            DocumentModel doc;
+            doc.SetAutoDimensionsEnabled(false);
+            Wall* a = doc.AddWall({ 0, 0 }, { 3000, 0 }, 200.0);
+            Wall* b = doc.AddWall({ 3000, 0 }, { 3000, 3000 }, 200.0);
+            uint64_t aId = a->GetId();
+            AssertFalse(doc.GetWallJoinGraph().GetJoins(aId).empty(), "Joined before removal");
+
+            doc.RemoveWall(b->GetId());
+            const WallJoinGraph& graph = doc.GetWallJoinGraph();
+            AssertTrue(graph.GetJoins(aId).empty(), "Join to removed wall dropped");
+            AssertEqual(static_cast<int>(graph.GetWallCount()), 1, "Removed wall forgotten");
+
+            double maxX = -1e9;
+            for (const auto& p : graph.GetContour(aId))
+                maxX = (std::max)(maxX, p.X);
+            AssertEqual(maxX, 3000.0, 0.001, "Plain end again");
+        });
+
+        runner.AddTest(L"WallJoinGraph_SnapshotKeepsItsGraph", []() {
+            DocumentModel doc;
+            doc.SetAutoDimensionsEnabled(false);
+            Wall* a = doc.AddWall({ 0, 0 }, { 3000, 0 }, 200.0);
+            Wall* b = doc.AddWall({ 3000, 0 }, { 3000, 3000 }, 200.0);
+            auto snapshot = doc.CreateSnapshot();
+            size_t before = snapshot->GetWallJoinGraph().GetContour(a->GetId()).size();
+            AssertTrue(before >= 4, "Snapshot carries outlines");
+
+            b->SetStartPoint({ 20000, 0 });
+            b->SetEndPoint({ 20000, 3000 });
+            doc.NotifyWallChanged(b->GetId());
+            AssertTrue(doc.GetWallJoinGraph().GetJoins(a->GetId()).empty(), "Document graph patched");
+            AssertEqual(static_cast<int>(snapshot->GetWallJoinGraph().GetContour(a->GetId()).size()), static_cast<int>(before), "Snapshot graph unchanged");
+            AssertFalse(snapshot->GetWallJoinGraph().GetJoins(a->GetId()).empty(), "Snapshot keeps the old join");
+        });
+
+        return runner.Run(L"Wall Join Graph Tests");
+    }
+
+    // ============================================================================
+    // Wall Junction Solver Tests
+    // ============================================================================
+
+    inline TestSuite RunWallJunctionSolverTests()
+    {
+        TestRunner runner;
+
+        runner.AddTest(L"Junction_CrossCapsTileNode", []() {
+            DocumentModel doc;
+            doc.SetAutoDimensionsEnabled(false);
+            doc.AddWall({ 0, 0 }, { 3000, 0 });
+            doc.AddWall({ 0, 3000 }, { 0, 0 });
+            doc.AddWall({ -3000, 0 }, { 0, 0 });
+            doc.AddWall({ 0, 0 }, { 0, -3000 });
+
+            double h = doc.GetWalls()[0]->GetThickness() / 2.0;
+            double total = 0.0;
+            for (const auto& wall : doc.GetWalls())
+                total += std::abs(Room::ComputeArea(doc.GetWallJoinGraph().GetContour(wall->GetId())));
+
+            // Four arms plus the centre square, nothing counted twice
+            AssertEqual(total, 4 * (3000.0 - h) * 2 * h + 4 * h * h, 0.01, "Caps tile the crossing");
+        });
+
+        runner.AddTest(L"Junction_EndsStopAtThroughWallFace", []() {
+            DocumentModel doc;
+            doc.SetAutoDimensionsEnabled(false);
+            doc.AddWall({ -3000, 0 }, { 3000, 0 });
+            Wall* up = doc.AddWall({ 0, 0 }, { 0, 3000 });
+            Wall* down = doc.AddWall({ 0, 0 }, { 0, -3000 });
+
+            double h = up->GetThickness() / 2.0;
+            for (Wall* wall : { up, down })
+            {
+                const auto& contour = doc.GetWallJoinGraph().GetContour(wall->GetId());
+                AssertEqual(static_cast<int>(contour.size()), 4, "Flat cap");
+                double nearest = 1e9;
+                for (const auto& p : contour)
+                    nearest = (std::min)(nearest, std::abs(p.Y));
+                AssertEqual(nearest, h, 0.001, "Cap on the through wall face");
+            }
+        });
+
+        runner.AddTest(L"Junction_ThreeWayCapsMeet", []() {
+            std::vector<std::unique_ptr<Wall>> walls;
+            const double pi = 3.14159265358979323846;
+            for (int k = 0; k < 3; ++k)
+            {
+                double a = k * 2.0 * pi / 3.0;
+                walls.push_back(std::make_unique<Wall>(WorldPoint{ 0, 0 }, WorldPoint{ 3000 * std::cos(a), 3000 * std::sin(a) }, 200.0));
+            }
+
+            std::vector<JunctionArm> arms;
+            for (const auto& wall : walls)
+                WallJunctionSolver::AddArms(*wall, { 0, 0 }, 5.0, arms);
+            auto caps = WallJunctionSolver::Solve({ 0, 0 }, arms);
+            AssertEqual(static_cast<int>(caps.size()), 3, "One cap per wall");
+
+            // Faces 100 mm off the axes cross 100 / sin(60) from the node
+            for (const auto& cap : caps)
+            {
+                AssertTrue(cap.HasCenter, "Cap runs through the node");
+                AssertEqual(cap.Left.Distance({ 0, 0 }), 100.0 / std::sin(pi / 3.0), 0.001, "Left corner");
+                AssertEqual(cap.Right.Distance({ 0, 0 }), 100.0 / std::sin(pi / 3.0), 0.001, "Right corner");
+            }
+
+            // Neighbouring caps share their corner
+            int shared = 0;
+            for (const auto& a : caps)
+                for (const auto& b : caps)
+                    if (a.WallId != b.WallId && a.Left.Distance(b.Right) < 1e-6) ++shared;
+            AssertEqual(shared, 3, "Corners shared around the node");
+        });
+
+        runner.AddTest(L"Junction_ThroughWallGetsNoCap", []() {
+            Wall through({ -3000, 0 }, { 3000, 0 }, 200.0);
+            Wall branch({ 3000, 3000 }, { 0, 0 }, 200.0);
+
+            std::vector<JunctionArm> arms;
+            WallJunctionSolver::AddArms(through, { 0, 0 }, 5.0, arms);
+            WallJunctionSolver::AddArms(branch, { 0, 0 }, 5.0, arms);
+            AssertEqual(static_cast<int>(arms.size()), 3, "Two arms for the through wall");
+
+            auto caps = WallJunctionSolver::Solve({ 0, 0 }, arms);
+            AssertEqual(static_cast<int>(caps.size()), 1, "Only the ending wall is capped");
+            AssertTrue(caps[0].WallId == branch.GetId() && !caps[0].AtStart, "Cap at the branch end");
+            AssertEqual(caps[0].Left.Y, 100.0, 0.001, "Left corner on the face");
+            AssertEqual(caps[0].Right.Y, 100.0, 0.001, "Right corner on the face");
+        });
+
+        runner.AddTest(L"Junction_SharpAngleCutSquare", []() {
+            Wall a({ 0, 0 }, { 3000, 0 }, 200.0);
+            Wall b({ 0, 0 }, { 3000, 100 }, 200.0);
+
+            std::vector<JunctionArm> arms;
+            WallJunctionSolver::AddArms(a, { 0, 0 }, 5.0, arms);
+            WallJunctionSolver::AddArms(b, { 0, 0 }, 5.0, arms);
+            auto caps = WallJunctionSolver::Solve({ 0, 0 }, arms);
+            AssertEqual(static_cast<int>(caps.size()), 2, "Both walls capped");
+
+            // The mitre would reach metres out; the limit keeps the ends square
+            for (const auto& cap : caps)
+            {
+                AssertTrue(cap.Left.Distance({ 0, 0 }) <= 100.0 + 1e-6, "Left corner near the node");
+                AssertTrue(cap.Right.Distance({ 0, 0 }) <= 100.0 + 1e-6, "Right corner near the node");
+            }
+        });
+
+        return runner.Run(L"Wall Junction Solver Tests");
+    }
+
+    // ============================================================================
+    // Geometry Kernels Tests
+    // ============================================================================
+
+    // Axis arrays for the batched kernels, deterministic pseudo-random
+    inline void MakeKernelSegments(size_t count, std::vector<double>& ax, std::vector<double>& ay,
+                                   std::vector<double>& bx, std::vector<double>& by)
+    {
+        uint32_t seed = 12345;
+        auto next = [&seed]() {
+            seed = seed * 1664525u + 1013904223u;
+            return static_cast<double>(seed % 20000) - 10000.0;
+        };
+        ax.resize(count); ay.resize(count); bx.resize(count); by.resize(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            ax[i] = next(); ay[i] = next();
+            bx[i] = next(); by[i] = next();
+        }
+    }
+
+    inline TestSuite RunGeometryKernelsTests()
+    {
+        TestRunner runner;
+
+        runner.AddTest(L"Kernels_BatchedMatchesScalar", []() {
+            // Counts that leave every possible SIMD tail
+            for (size_t count : { 1, 2, 3, 5, 7, 8, 301 })
+            {
+                std::vector<double> ax, ay, bx, by;
+                MakeKernelSegments(count, ax, ay, bx, by);
+                SegmentSpan span{ ax.data(), ay.data(), bx.data(), by.data(), count };
+
+                std::vector<double> d2(count);
+                WorldPoint p(123.0, -456.0);
+                GeometryKernels::DistanceSqToSegments(p, span, d2.data());
+                for (size_t i = 0; i < count; ++i)
+                {
+                    double d = GeometryKernels::DistancePointToSegment(p, { ax[i], ay[i] }, { bx[i], by[i] });
+                    AssertEqual(std::sqrt(d2[i]), d, 1e-6, "Same distance as the scalar kernel");
+                }
+            }
+        });
+
+        runner.AddTest(L"Kernels_DegenerateSegment", []() {
+            double ax[3] = { 0, 10, 0 }, ay[3] = { 0, 10, 0 };
+            double bx[3] = { 0, 10, 100 }, by[3] = { 0, 10, 0 };
+            SegmentSpan span{ ax, ay, bx, by, 3 };
+
+            double d2[3];
+            GeometryKernels::DistanceSqToSegments({ 3, 4 }, span, d2);
+            AssertEqual(d2[0], 25.0, 1e-9, "Point segment measures to its point");
+            AssertEqual(d2[1], 85.0, 1e-9, "Second point segment");
+            AssertEqual(d2[2], 16.0, 1e-9, "Regular segment");
+        });
+
+        runner.AddTest(L"Kernels_CollectWithinBands", []() {
+            // Horizontal segments at y = 0, 100, 200, 300
+            double ax[4] = { 0, 0, 0, 0 }, ay[4] = { 0, 100, 200, 300 };
+            double bx[4] = { 1000, 1000, 1000, 1000 }, by[4] = { 0, 100, 200, 300 };
+            double widths[4] = { 10, 10, 180, 10 };
+            SegmentSpan span{ ax, ay, bx, by, 4 };
+
+            std::vector<uint32_t> hits;
+            GeometryKernels::CollectWithin({ 500, 120 }, span, widths, 1.0, hits);
+            AssertEqual(static_cast<int>(hits.size()), 1, "Only the wide band reaches");
+            AssertEqual(static_cast<int>(hits[0]), 2, "Wide band index");
+
+            hits.clear();
+            GeometryKernels::CollectWithin({ 500, 120 }, span, nullptr, 30.0, hits);
+            AssertEqual(static_cast<int>(hits.size()), 1, "Bare segments within tolerance");
+            AssertEqual(static_cast<int>(hits[0]), 1, "Nearest bare segment");
+        });
+
+        runner.AddTest(L"Kernels_NearestSegment", []() {
+            std::vector<double> ax, ay, bx, by;
+            MakeKernelSegments(1000, ax, ay, bx, by);
+            SegmentSpan span{ ax.data(), ay.data(), bx.data(), by.data(), ax.size() };
+
+            WorldPoint p(250.0, 750.0);
+            size_t expected = GeometryKernels::NotFound;
+            double best = 1e300;
+            for (size_t i = 0; i < ax.size(); ++i)
+            {
+                double d = GeometryKernels::DistancePointToSegment(p, { ax[i], ay[i] }, { bx[i], by[i] });
+                if (d < best) { best = d; expected = i; }
+            }
+
+            double distance = 0.0;
+            AssertTrue(GeometryKernels::NearestSegment(p, span, 1e6, distance) == expected, "Nearest index");
+            AssertEqual(distance, best, 1e-6, "Nearest distance");
+            AssertTrue(GeometryKernels::NearestSegment(p, span, best * 0.5, distance) == GeometryKernels::NotFound,
+                       "Nothing within a smaller reach");
+        });
+
+        runner.AddTest(L"Kernels_DocumentHitTestTopmostWall", []() {
+            DocumentModel doc;
+            doc.SetAutoDimensionsEnabled(false);
+            doc.AddWall({ 0, 0 }, { 3000, 0 });
+            Wall* top = doc.AddWall({ 1500, -1000 }, { 1500, 1000 });
+            doc.AddWall({ 0, 2000 }, { 3000, 2000 });
+
+            AssertTrue(doc.HitTest({ 1500, 0 }, 5.0, LayerManager()) == top, "Last drawn wall wins at a crossing");
+            AssertTrue(doc.HitTest({ 500, 2030 }, 5.0, LayerManager()) == doc.GetWalls()[2].get(), "Hit inside the thickness");
+            AssertTrue(doc.HitTest({ 500, 1000 }, 5.0, LayerManager()) == nullptr, "Empty space");
+
+            // An edit made through the Wall* is picked up
+            top->SetStartPoint({ 2500, -1000 });
+            top->SetEndPoint({ 2500, 1000 });
+            AssertTrue(doc.HitTest({ 2500, 500 }, 5.0, LayerManager()) == top, "Moved wall is hit");
+        });
+
+        return runner.Run(L"Geometry Kernels Tests");
+    }
+
+    // ============================================================================
+    // Robust Predicates Tests
+    // ============================================================================
+
+    inline TestSuite RunRobustPredicatesTests()
+    {
+        TestRunner runner;
+
+        runner.AddTest(L"Predicates_OrientNearCollinear", []() {
+            // a = (0.5 + i*ulp, 0.5 + j*ulp) against the line through (12, 12)
+            // and (24, 24): the exact determinant is 12 ulp (j - i). Doubles
+            // alone round most of these to zero or the wrong sign.
+            const double ulp = std::ldexp(1.0, -53);
+            WorldPoint b(12.0, 12.0), c(24.0, 24.0);
+            for (int i = 0; i < 16; ++i)
+            {
+                for (int j = 0; j < 16; ++j)
+                {
+                    WorldPoint a(0.5 + i * ulp, 0.5 + j * ulp);
+                    int expected = (j > i) - (j < i);
+                    AssertEqual(RobustPredicates::Sign(RobustPredicates::Orient2D(a, b, c)), expected, "Exact sign");
+                }
+            }
+        });
+
+        runner.AddTest(L"Predicates_OrientConsistentUnderPermutation", []() {
+            uint32_t seed = 3;
+            auto jitter = [&seed]() {
+                seed = seed * 1664525u + 1013904223u;
+                return static_cast<int>(seed >> 28) - 8;
+            };
+            for (int k = 0; k < 2000; ++k)
+            {
+                // Three points within a few ulps of one line
+                double x = 1000.0 + k;
+                WorldPoint a(x, 2.0 * x + jitter() * 1e-13);
+                WorldPoint b(x * 3.1, 6.2 * x + jitter() * 1e-13);
+                WorldPoint c(x * 7.3, 14.6 * x + jitter() * 1e-13);
+
+                int s = RobustPredicates::Sign(RobustPredicates::Orient2D(a, b, c));
+                AssertEqual(RobustPredicates::Sign(RobustPredicates::Orient2D(b, c, a)), s, "Cyclic");
+                AssertEqual(RobustPredicates::Sign(RobustPredicates::Orient2D(b, a, c)), -s, "Swapped");
+            }
+        });
+
+        runner.AddTest(L"Predicates_SegmentsCross", []() {
+            double t = 0.0, u = 0.0;
+            AssertTrue(RobustPredicates::SegmentsCross({ 0, 0 }, { 10, 10 }, { 0, 10 }, { 10, 0 }, t, u), "X crossing");
+            AssertEqual(t, 0.5, 1e-12, "t");
+            AssertEqual(u, 0.5, 1e-12, "u");
+
+            AssertFalse(RobustPredicates::SegmentsCross({ 0, 0 }, { 10, 0 }, { 5, 0 }, { 5, 10 }, t, u), "Touching is no crossing");
+            AssertFalse(RobustPredicates::SegmentsCross({ 0, 0 }, { 10, 0 }, { 5, 0 }, { 15, 0 }, t, u), "Collinear overlap");
+            AssertFalse(RobustPredicates::SegmentsCross({ 0, 0 }, { 10, 0 }, { 0, 1 }, { 10, 1 }, t, u), "Parallel");
+
+            // Nearly parallel axes still cross at a parameter inside (0, 1)
+            AssertTrue(RobustPredicates::SegmentsCross({ 0, 0 }, { 1e6, 1e-9 }, { 0, 1e-9 }, { 1e6, 0 }, t, u), "Shallow crossing");
+            AssertTrue(t > 0.0 && t < 1.0 && u > 0.0 && u < 1.0, "Parameters inside");
+        });
+
+        runner.AddTest(L"Predicates_PointOnSharedEdgeInOnePolygon", []() {
+            // Two squares sharing x = 1000; points on the shared edge and
+            // on shared vertices belong to exactly one of them
+            std::vector<WorldPoint> left = { { 0, 0 }, { 1000, 0 }, { 1000, 1000 }, { 0, 1000 } };
+            std::vector<WorldPoint> right = { { 1000, 0 }, { 2000, 0 }, { 2000, 1000 }, { 1000, 1000 } };
+            for (double y : { 0.0, 0.1, 500.0, 999.9 })
+            {
+                WorldPoint p(1000.0, y);
+                int count = RobustPredicates::PointInPolygon(left, p) + RobustPredicates::PointInPolygon(right, p);
+                AssertEqual(count, 1, "Exactly one owner");
+            }
+            AssertTrue(RobustPredicates::PointInPolygon(left, { 500, 500 }), "Interior");
+            AssertFalse(RobustPredicates::PointInPolygon(left, { 1500, 500 }), "Outside");
+        });
+
+        runner.AddTest(L"Rooms_NearlyConcurrentWallsTileSquare", []() {
+            // Far from the origin, with several walls crossing the square
+            // almost, but not exactly, at one point
+            const double o = 1.0e7;
+            std::vector<std::unique_ptr<Wall>> walls;
+            auto add = [&](double x1, double y1, double x2, double y2) {
+                walls.push_back(std::make_unique<Wall>(WorldPoint{ o + x1, o + y1 }, WorldPoint{ o + x2, o + y2 }, 100.0));
+            };
+            add(0, 0, 6000, 0);
+            add(6000, 0, 6000, 6000);
+            add(6000, 6000, 0, 6000);
+            add(0, 6000, 0, 0);
+            add(0, 0, 6000, 6000);
+            add(0, 6000, 6000, 0);
+            add(0, 3000 + 1e-7, 6000, 3000 - 1e-7);
+            add(3000 - 1e-7, 0, 3000 + 1e-7, 6000);
+
+            auto rooms = RoomDetector::DetectRooms(walls);
+            double total = 0.0;
+            for (const auto& room : rooms)
+                total += room->GetArea();
+            AssertEqual(static_cast<int>(rooms.size()), 8, "Eight triangles");
+            AssertEqual(total, 6000.0 * 6000.0, 1.0, "Rooms tile the square");
+        });
+
+        return runner.Run(L"Robust Predicates Tests");
+    }
+
+    // ============================================================================
+    // Wall Snap Index Tests
+    // ============================================================================
+
+    inline TestSuite RunWallSnapIndexTests()
+    {
+        TestRunner runner;
+
+        runner.AddTest(L"SnapIndex_MatchesFullScan", []() {
+            DocumentModel doc;
+            doc.SetAutoDimensionsEnabled(false);
+            uint32_t seed = 1;
+            auto next = [&seed]() {
+                seed = seed * 1664525u + 1013904223u;
+                return static_cast<double>(seed % 100000) / 10.0;
+            };
+            for (int i = 0; i < 200; ++i)
+            {
+                double x = next(), y = next();
+                if (i % 2) doc.AddWall({ x, y }, { x + next() / 3, y });
+                else doc.AddWall({ x, y }, { x, y + next() / 3 });
+            }
+
+            WallSnapSystem snap;
+            for (int k = 0; k < 1000; ++k)
+            {
+                WorldPoint cursor(next(), next());
+                auto indexed = snap.FindBestSnap(cursor, std::nullopt, doc, 0.05);
+                auto scanned = snap.FindBestSnap(cursor, std::nullopt, doc.GetWalls(), 0.05);
+                AssertTrue(indexed.IsValid == scanned.IsValid, "Same validity");
+                AssertTrue(indexed.IsAlignment == scanned.IsAlignment, "Same kind");
+                if (indexed.IsValid && !indexed.IsAlignment)
+                {
+                    AssertTrue(indexed.Plane == scanned.Plane, "Same plane");
+                    AssertEqual(indexed.ProjectedPoint.Distance(scanned.ProjectedPoint), 0.0, 1e-9, "Same point");
+                }
+            }
+        });
+
+        runner.AddTest(L"SnapIndex_FollowsWallEdits", []() {
+            DocumentModel doc;
+            doc.SetAutoDimensionsEnabled(false);
+            Wall* wall = doc.AddWall({ 0, 0 }, { 4000, 0 });
+            doc.AddWall({ 0, 5000 }, { 4000, 5000 });
+
+            WallSnapSystem snap;
+            auto r = snap.FindBestSnap({ 4005, 3 }, std::nullopt, doc, 1.0);
+            AssertTrue(r.IsValid && r.IsEndpoint, "Snaps to the end");
+            AssertEqual(snap.GetIndex().Size(), static_cast<size_t>(2), "Both walls indexed");
+
+            // Direct edit, picked up through the journal after sync
+            wall->SetEndPoint({ 4000, 2000 });
+            doc.SyncWallEdits();
+            r = snap.FindBestSnap({ 4005, 2003 }, std::nullopt, doc, 1.0);
+            AssertTrue(r.IsValid && r.IsEndpoint, "Snaps to the moved end");
+            AssertEqual(r.ProjectedPoint.Y, 2000.0, 1e-9, "Moved end");
+
+            doc.RemoveWall(wall->GetId());
+            r = snap.FindBestSnap({ 4005, 2003 }, std::nullopt, doc, 1.0);
+            AssertFalse(r.IsValid && !r.IsAlignment, "Removed wall no longer snaps");
+            AssertEqual(snap.GetIndex().Size(), static_cast<size_t>(1), "Removed from the index");
+        });
+
+        runner.AddTest(L"SnapIndex_AlignmentNearestEnd", []() {
+            DocumentModel doc;
+            doc.SetAutoDimensionsEnabled(false);
+            doc.AddWall({ 0, 1000 }, { 0, 3000 });
+            doc.AddWall({ 5000, 1006 }, { 5000, 4000 });
+
+            WallSnapSystem snap;
+            auto r = snap.FindBestSnap({ 2500, 1004 }, std::nullopt, doc, 1.0);
+            AssertTrue(r.IsValid && r.IsAlignment && r.AlignmentHorizontal, "Horizontal alignment");
+            AssertEqual(r.ProjectedPoint.Y, 1006.0, 1e-9, "Aligned to the nearer end");
+            AssertEqual(r.AlignmentSource.X, 5000.0, 1e-9, "Source wall");
+        });
+
+        runner.AddTest(L"SnapIndex_ExcludedWallIgnored", []() {
+            DocumentModel doc;
+            doc.SetAutoDimensionsEnabled(false);
+            Wall* drawn = doc.AddWall({ 0, 0 }, { 4000, 0 });
+            doc.AddWall({ 0, 3000 }, { 4000, 3000 });
+
+            WallSnapSystem snap;
+            auto r = snap.FindBestSnap({ 4003, 2 }, std::nullopt, doc, 1.0, drawn->GetId());
+            AssertFalse(r.IsValid && !r.IsAlignment, "No snap to the wall being drawn");
+            r = snap.FindBestSnap({ 4003, 2998 }, std::nullopt, doc, 1.0, drawn->GetId());
+            AssertTrue(r.IsValid && r.IsEndpoint, "Other walls still snap");
+        });
+
+        runner.AddTest(L"SnapIndex_MidpointSnapNearCursor", []() {
+            DocumentModel doc;
+            doc.SetAutoDimensionsEnabled(false);
+            for (int i = 0; i < 50; ++i)
+                doc.AddWall({ i * 1000.0, 0 }, { i * 1000.0, 4000 });
+
+            SnapManager snap;
+            Camera camera;
+            SnapResult r = snap.FindSnap({ 17003, 2004 }, doc, LayerManager(), camera);
+            AssertTrue(r.hasSnap && r.snapType == L"midpoint", "Midpoint snap");
+            AssertEqual(r.point.X, 17000.0, 1e-9, "Nearest wall's midpoint");
+            AssertEqual(r.point.Y, 2000.0, 1e-9, "Midpoint Y");
+        });
+
+        return runner.Run(L"Wall Snap Index Tests");
+    }
+
+    // ============================================================================
+    // Snap Engine Tests
+    // ============================================================================
+
+    // Emits one fixed hit; optionally runs until the query's deadline
+    class FixedSnapProvider : public SnapProvider
+    {
+    public:
+        FixedSnapProvider(SnapKind kind, WorldPoint point, bool spin = false)
+            : m_kind(kind), m_point(point), m_spin(spin)
+        {
+        }
+
+        SnapKind GetRank() const override { return m_kind; }
+
+        void Query(const SnapQuery& query, SnapHitList& hits) override
+        {
+            ++Calls;
+            while (m_spin && !query.IsOverBudget())
+            {
+            }
+            hits.Add(MakeHit(query, m_point, m_kind));
+        }
+
+        // Stands in for an index rebuild after an edit
+        void Prepare(const SnapQuery&) override
+        {
+            auto until = SnapQuery::Clock::now() + PrepareTime;
+            while (SnapQuery::Clock::now() < until)
+            {
+            }
+        }
+
+        int Calls{ 0 };
+        std::chrono::microseconds PrepareTime{ 0 };
+
+    private:
+        SnapKind m_kind;
+        WorldPoint m_point;
+        bool m_spin;
+    };
+
+    inline TestSuite RunSnapEngineTests()
+    {
+        TestRunner runner;
+
+        runner.AddTest(L"SnapEngine_KindOutranksDistance", []() {
+            DocumentModel doc;
+            doc.SetAutoDimensionsEnabled(false);
+            doc.AddWall({ 0, 0 }, { 20, 0 });
+
+            SnapManager snap;
+            Camera camera;
+            SnapResult r = snap.FindSnap({ 12, 0 }, doc, LayerManager(), camera);
+            AssertTrue(r.hasSnap && r.kind == SnapKind::Endpoint, "Endpoint beats the closer midpoint");
+            AssertEqual(r.point.X, 20.0, 1e-9, "Wall end");
+        });
+
+        runner.AddTest(L"SnapEngine_AxisCrossing", []() {
+            DocumentModel doc;
+            doc.SetAutoDimensionsEnabled(false);
+            doc.AddWall({ 0, 0 }, { 4000, 0 });
+            doc.AddWall({ 1500, -2000 }, { 1500, 2000 });
+
+            SnapManager snap;
+            Camera camera;
+            SnapResult r = snap.FindSnap({ 1504, -3 }, doc, LayerManager(), camera);
+            AssertTrue(r.hasSnap && r.snapType == L"intersection", "Crossing snap");
+            AssertEqual(r.point.X, 1500.0, 1e-9, "Crossing X");
+            AssertEqual(r.point.Y, 0.0, 1e-9, "Crossing Y");
+
+            snap.SetEndpointSnapEnabled(false);
+            r = snap.FindSnap({ 1504, -3 }, doc, LayerManager(), camera);
+            AssertTrue(!r.hasSnap || r.kind != SnapKind::Intersection, "Follows the endpoint setting");
+        });
+
+        runner.AddTest(L"SnapEngine_SkipsOutrankedProviders", []() {
+            SnapEngine engine;
+            auto* grid = engine.AddProvider(std::make_unique<FixedSnapProvider>(SnapKind::Grid, WorldPoint(1, 0)));
+            auto* end = engine.AddProvider(std::make_unique<FixedSnapProvider>(SnapKind::Endpoint, WorldPoint(5, 0)));
+            auto* mid = engine.AddProvider(std::make_unique<FixedSnapProvider>(SnapKind::Midpoint, WorldPoint(2, 0)));
+
+            SnapEngineResult r = engine.Find(SnapQuery{});
+            AssertTrue(r.HasSnap() && r.Hits.Best().Kind == SnapKind::Endpoint, "Best kind wins");
+            AssertTrue(r.Hits.Best().Provider == end, "Hit knows its provider");
+            AssertTrue(end->Calls == 1 && mid->Calls == 0 && grid->Calls == 0, "Lower ranks are not asked");
+
+            end->SetEnabled(false);
+            r = engine.Find(SnapQuery{});
+            AssertTrue(r.Hits.Best().Kind == SnapKind::Midpoint && grid->Calls == 0, "Next rank takes over");
+        });
+
+        runner.AddTest(L"SnapEngine_BudgetKeepsPartialResult", []() {
+            SnapEngine engine;
+            engine.SetBudget(std::chrono::microseconds(500));
+            engine.AddProvider(std::make_unique<FixedSnapProvider>(SnapKind::Nearest, WorldPoint(3, 0), true));
+            auto* other = engine.AddProvider(std::make_unique<FixedSnapProvider>(SnapKind::Nearest, WorldPoint(1, 0)));
+
+            SnapEngineResult r = engine.Find(SnapQuery{});
+            AssertTrue(r.BudgetExceeded, "Deadline reached");
+            AssertTrue(other->Calls == 0, "Later providers skipped");
+            AssertTrue(r.HasSnap() && r.Hits.Best().Kind == SnapKind::Nearest, "Hits found so far are kept");
+        });
+
+        runner.AddTest(L"SnapEngine_PrepareOutsideBudget", []() {
+            SnapEngine engine;
+            engine.SetBudget(std::chrono::microseconds(500));
+            auto* slow = engine.AddProvider(std::make_unique<FixedSnapProvider>(SnapKind::Midpoint, WorldPoint(3, 0)));
+            auto* other = engine.AddProvider(std::make_unique<FixedSnapProvider>(SnapKind::Midpoint, WorldPoint(1, 0)));
+            slow->PrepareTime = std::chrono::microseconds(2000);
+
+            SnapEngineResult r = engine.Find(SnapQuery{});
+            AssertFalse(r.BudgetExceeded, "Index warm-up is not charged to the query");
+            AssertTrue(slow->Calls == 1 && other->Calls == 1, "Every provider is asked");
+        });
+
+        runner.AddTest(L"SnapEngine_PreferredProviderWins", []() {
+            SnapEngine engine;
+            auto* end = engine.AddProvider(std::make_unique<FixedSnapProvider>(SnapKind::Endpoint, WorldPoint(5, 0)));
+            auto* face = engine.AddProvider(std::make_unique<FixedSnapProvider>(SnapKind::WallPlane, WorldPoint(2, 0)));
+
+            SnapQuery query;
+            query.Preferred = face;
+            SnapEngineResult r = engine.Find(query);
+            AssertTrue(r.HasSnap() && r.Hits.Best().Provider == face, "Preferred hit wins over a better rank");
+            AssertTrue(end->Calls == 0, "Others are not asked once it hits");
+
+            face->SetEnabled(false);
+            r = engine.Find(query);
+            AssertTrue(r.HasSnap() && r.Hits.Best().Provider == end, "Ranked order when it is off");
+        });
+
+        runner.AddTest(L"SnapEngine_WallPlanesOnRequest", []() {
+            DocumentModel doc;
+            doc.SetAutoDimensionsEnabled(false);
+            doc.AddWall({ 0, 0 }, { 6000, 0 });
+
+            WallSnapSystem system;
+            SnapManager snap;
+            auto* planes = snap.AddProvider(std::make_unique<WallPlaneSnapProvider>(system));
+            Camera camera;
+
+            SnapQuery query = snap.MakeQuery({ 1300, 4 }, doc, LayerManager(), camera);
+            SnapResult r = snap.FindSnap(query);
+            AssertTrue(!r.hasSnap, "Other tools do not snap to faces");
+
+            query.WallPlanes = true;
+            r = snap.FindSnap(query);
+            AssertTrue(r.hasSnap && r.provider == planes, "Wall tool snaps to the axis");
+            AssertTrue(planes->GetCandidate().IsValid, "Candidate kept for the guides");
+            AssertEqual(r.point.Y, 0.0, 1e-9, "On the axis");
+        });
+
+        return runner.Run(L"Snap Engine Tests");
+    }
+
+    // ============================================================================
+    // Reference Snap Tests
+    // ============================================================================
+
+    inline TestSuite RunReferenceSnapTests()
+    {
+        TestRunner runner;
+
+        runner.AddTest(L"RefSnap_ArcChordsStayOnCurve", []() {
+            ReferenceSnapIndex index;
+            index.AddArc({ 0, 0 }, 5000.0, 0.0, 3.14159265358979323846 / 2.0);
+            index.AddBulge({ 1000, 0 }, { 0, 1000 }, std::tan(3.14159265358979323846 / 8.0));
+            index.Finish();
+
+            for (uint32_t i = 0; i < index.Size(); ++i)
+            {
+                double r = i < index.Size() / 2 ? 5000.0 : 1000.0;
+                WorldPoint a = index.GetStart(i), b = index.GetEnd(i);
+                WorldPoint mid((a.X + b.X) / 2.0, (a.Y + b.Y) / 2.0);
+                AssertTrue(r - mid.Distance({ 0, 0 }) <= 1.0 + 1e-9, "Chord within 1 mm of the arc");
+            }
+
+            // Bulge arc: counter-clockwise about the origin, ends are vertices
+            uint32_t last = index.Size() - 1;
+            AssertEqual(index.GetEnd(last).Distance({ 0, 1000 }), 0.0, 1e-6, "Bulge arc ends at b");
+            AssertTrue((index.GetFlags(last) & ReferenceSnapIndex::EndIsVertex) != 0, "Arc end is a vertex");
+            AssertTrue((index.GetFlags(last - 1) & ReferenceSnapIndex::EndIsVertex) == 0, "Chord joints are not");
+        });
+
+        runner.AddTest(L"RefSnap_LargeArcKeepsChordError", []() {
+            // A 500 m site boundary needs far more than a few hundred chords
+            ReferenceSnapIndex index;
+            index.AddArc({ 0, 0 }, 500000.0, 0.0, 2.0 * 3.14159265358979323846);
+            index.Finish();
+
+            AssertTrue(index.Size() > 1000, "Chord count follows the radius");
+            for (uint32_t i = 0; i < index.Size(); ++i)
+            {
+                WorldPoint a = index.GetStart(i), b = index.GetEnd(i);
+                WorldPoint mid((a.X + b.X) / 2.0, (a.Y + b.Y) / 2.0);
+                AssertTrue(500000.0 - mid.Distance({ 0, 0 }) <= 1.0 + 1e-6, "Chord within 1 mm of the arc");
+            }
+        });
+
+        runner.AddTest(L"RefSnap_GridMatchesBruteForce", []() {
+            ReferenceSnapIndex index;
+            uint32_t seed = 7;
+            auto next = [&seed]() {
+                seed = seed * 1664525u + 1013904223u;
+                return static_cast<double>(seed % 1000000) / 10.0;
+            };
+            for (int i = 0; i < 3000; ++i)
+            {
+                WorldPoint a(next(), next());
+                double len = i % 50 == 0 ? 60000.0 : 800.0;
+                index.AddSegment(a, WorldPoint(a.X + (next() / 100000.0 - 0.5) * len, a.Y + (next() / 100000.0 - 0.5) * len));
+            }
+            index.Finish();
+
+            for (int q = 0; q < 200; ++q)
+            {
+                WorldPoint p(next(), next());
+                double radius = 50.0 + q * 5.0;
+                std::vector<uint32_t> found;
+                index.ForEachNear(p, radius, [&](uint32_t i) {
+                    if (GeometryKernels::DistancePointToSegment(p, index.GetStart(i), index.GetEnd(i)) <= radius)
+                        found.push_back(i);
+                    return true;
+                });
+                std::sort(found.begin(), found.end());
+                AssertTrue(std::adjacent_find(found.begin(), found.end()) == found.end(), "Each segment once");
+
+                std::vector<uint32_t> expected;
+                for (uint32_t i = 0; i < index.Size(); ++i)
+                {
+                    if (GeometryKernels::DistancePointToSegment(p, index.GetStart(i), index.GetEnd(i)) <= radius)
+                        expected.push_back(i);
+                }
+                AssertTrue(found == expected, "Same segments as a full scan");
+            }
+        });
+
+        runner.AddTest(L"RefSnap_SnapKinds", []() {
+            DxfReferenceManager dxf;
+            IfcReferenceManager ifc;
+            ReferenceSnapProvider provider(dxf, ifc);
+
+            ReferenceSnapIndex index;
+            index.AddSegment({ 0, 0 }, { 1000, 0 });
+            index.AddSegment({ 600, -500 }, { 600, 500 });
+            index.Finish();
+
+            auto snapAt = [&](WorldPoint cursor, std::optional<WorldPoint> start = std::nullopt) {
+                SnapQuery query;
+                query.Cursor = cursor;
+                query.StartPoint = start;
+                SnapHitList hits;
+                provider.QueryIndex(index, query, hits);
+                return hits;
+            };
+
+            SnapHitList hits = snapAt({ 996, 4 });
+            AssertTrue(!hits.IsEmpty() && hits.Best().Kind == SnapKind::Endpoint, "Endpoint");
+            hits = snapAt({ 604, -5 });
+            AssertTrue(!hits.IsEmpty() && hits.Best().Kind == SnapKind::Intersection, "Intersection");
+            AssertEqual(hits.Best().Point.X, 600.0, 1e-9, "Crossing X");
+            hits = snapAt({ 503, 2 });
+            AssertTrue(!hits.IsEmpty() && hits.Best().Kind == SnapKind::Midpoint, "Midpoint");
+            hits = snapAt({ 302, 6 }, WorldPoint(300, 400));
+            AssertTrue(!hits.IsEmpty() && hits.Best().Kind == SnapKind::Perpendicular, "Perpendicular from the start point");
+            AssertEqual(hits.Best().Point.X, 300.0, 1e-9, "Foot of the perpendicular");
+            hits = snapAt({ 200, 7 });
+            AssertTrue(!hits.IsEmpty() && hits.Best().Kind == SnapKind::Nearest, "Nearest");
+            AssertEqual(hits.Best().Point.Y, 0.0, 1e-9, "On the line");
+        });
+
+        runner.AddTest(L"RefSnap_DxfLayerIndexedOnImport", []() {
+            // File order: circle, line, polyline; the spatial sort puts
+            // the circle last
+            std::vector<std::unique_ptr<DxfEntity>> entities;
+            auto circle = std::make_unique<DxfCircle>();
+            circle->Center = { 5000, 5000 };
+            circle->Radius = 300.0;
+            entities.push_back(std::move(circle));
+            auto line = std::make_unique<DxfLine>();
+            line->Start = { 0, 0 };
+            line->End = { 2000, 0 };
+            entities.push_back(std::move(line));
+            auto poly = std::make_unique<DxfPolyline>();
+            poly->Vertices = { { { 0, 1000 }, 0.0 }, { { 1000, 1000 }, 0.0 }, { { 1000, 2000 }, 0.0 } };
+            poly->IsClosed = true;
+            entities.push_back(std::move(poly));
+
+            DxfReferenceLayer layer;
+            layer.TakeEntities(entities);
+            const ReferenceSnapIndex& index = layer.GetSnapIndex();
+            AssertTrue(index.Size() > 4, "Lines, polyline edges and circle chords");
+
+            size_t vertices = 0;
+            for (uint32_t i = 0; i < index.Size(); ++i)
+                vertices += (index.GetFlags(i) & ReferenceSnapIndex::StartIsVertex) != 0;
+            AssertTrue(vertices == 4, "Circle chords carry no endpoints");
+            AssertTrue(index.GetEntity(0) == 2, "Line segment knows its place in the file");
+            AssertTrue(index.GetEntity(index.Size() - 1) == 1, "Circle chords know theirs");
+
+            // Hits carry the entity, not the segment index
+            DxfReferenceManager dxf;
+            IfcReferenceManager ifc;
+            ReferenceSnapProvider provider(dxf, ifc);
+            SnapQuery query;
+            query.Cursor = { 1004, 1995 };
+            SnapHitList hits;
+            provider.QueryIndex(index, query, hits);
+            AssertTrue(!hits.IsEmpty() && hits.Best().SourceId == 3, "Polyline vertex hit names the polyline");
+        });
+
+        runner.AddTest(L"RefSnap_EngineRanksUnderlayWithWalls", []() {
+            DocumentModel doc;
+            doc.SetAutoDimensionsEnabled(false);
+            doc.AddWall({ 0, 0 }, { 4000, 0 });
+
+            DxfReferenceManager dxf;
+            IfcReferenceManager ifc;
+            SnapManager snap;
+            auto* refs = snap.AddProvider(std::make_unique<ReferenceSnapProvider>(dxf, ifc));
+            Camera camera;
+
+            // No underlay: the wall end wins; the provider is asked but finds nothing
+            SnapResult r = snap.FindSnap({ 4004, 3 }, doc, LayerManager(), camera);
+            AssertTrue(r.hasSnap && r.kind == SnapKind::Endpoint && r.provider != refs, "Wall endpoint");
+        });
+
+        return runner.Run(L"Reference Snap Tests");
+    }
+
+    // ============================================================================
+    // Display List Tests
+    // ============================================================================
+
+    inline TestSuite RunDisplayListTests()
+    {
+        TestRunner runner;
+
+        runner.AddTest(L"DisplayList_BatchesByStyle", []() {
+            DisplayList list;
+            uint16_t black = list.AddStyle(DisplayStyle::Stroke(Windows::UI::ColorHelper::FromArgb(255, 0, 0, 0), 1.0f));
+            uint16_t red = list.AddStyle(DisplayStyle::Stroke(Windows::UI::ColorHelper::FromArgb(255, 255, 0, 0), 1.0f));
+            AssertTrue(list.AddStyle(DisplayStyle::Stroke(Windows::UI::ColorHelper::FromArgb(255, 0, 0, 0), 1.0f)) == black,
+                "Equal styles share an id");
+            AssertTrue(black != red, "Different colors get different ids");
+
+            for (int i = 0; i < 3; ++i)
+                list.AddLine(black, WorldPoint(i * 100.0, 0), WorldPoint(i * 100.0, 100));
+            list.AddLine(red, WorldPoint(0, 0), WorldPoint(1, 1));
+            list.AddLine(black, WorldPoint(0, 0), WorldPoint(1, 1));
+
+            AssertEqual(static_cast<int>(list.GetCommandCount()), 3, "Style changes start a new batch");
+            AssertEqual(static_cast<int>(list.GetCommands()[0].PointCount), 6, "Three lines in the first batch");
+            AssertEqual(static_cast<int>(list.GetStyleCount()), 2, "Two styles");
+        });
+
+        runner.AddTest(L"DisplayList_SplitsLongBatches", []() {
+            DisplayList list;
+            uint16_t style = list.AddStyle(DisplayStyle::Stroke(Windows::UI::ColorHelper::FromArgb(255, 0, 0, 0), 1.0f));
+            for (int i = 0; i < 600; ++i)
+                list.AddLine(style, WorldPoint(i * 10.0, 0), WorldPoint(i * 10.0 + 5, 0));
+
+            size_t expected = (1200 + DisplayList::MaxBatchPoints - 1) / DisplayList::MaxBatchPoints;
+            AssertEqual(static_cast<int>(list.GetCommandCount()), static_cast<int>(expected), "Batches capped");
+
+            // Each batch covers only its own stretch of the line work
+            const auto& first = list.GetCommands().front();
+            AssertEqual(first.Bounds.MinX, 0.0f, 1e-3f, "First batch starts at 0");
+            AssertTrue(first.Bounds.MaxX < 600.0f * 10.0f / 2.0f, "First batch ends early");
+            AssertEqual(list.GetBounds().MaxX, 5995.0f, 1e-1f, "List bounds cover all");
+
+            // Far apart lines are not batched beyond MaxBatchExtent
+            DisplayList wide;
+            for (int i = 0; i < 100; ++i)
+                wide.AddLine(style, WorldPoint(i * 1000.0, 0), WorldPoint(i * 1000.0 + 500, 0));
+            for (const auto& command : wide.GetCommands())
+                AssertTrue(command.Bounds.MaxX - command.Bounds.MinX <= DisplayList::MaxBatchExtent, "Batch extent capped");
+            AssertEqual(static_cast<int>(wide.GetCommandCount()), 10, "Ten lines per 10 m batch");
+        });
+
+        runner.AddTest(L"DisplayList_FiguresAndBounds", []() {
+            DisplayList list;
+            uint16_t style = list.AddStyle(DisplayStyle::WorldStroke(Windows::UI::ColorHelper::FromArgb(255, 0, 0, 0), 8.0f, true));
+            std::vector<WorldPoint> square = { { 0, 0 }, { 1000, 0 }, { 1000, 1000 }, { 0, 1000 } };
+            std::vector<WorldPoint> path = { { 2000, 0 }, { 3000, 500 }, { 4000, 0 } };
+            list.AddPolyline(style, square, true);
+            list.AddPolyline(style, path, false);
+            list.AddPolyline(style, std::vector<WorldPoint>{ { 0, 0 } }, false);
+            list.AddCircle(list.AddStyle(DisplayStyle::Stroke(Windows::UI::ColorHelper::FromArgb(255, 0, 0, 0), 1.0f)),
+                WorldPoint(10000, 10000), 500.0);
+
+            AssertEqual(static_cast<int>(list.GetCommandCount()), 2, "Polylines batched, circle apart");
+            std::vector<std::pair<uint32_t, bool>> figures;
+            list.ForEachFigure(list.GetCommands()[0], [&](const DisplayPoint*, uint32_t count, bool closed) {
+                figures.push_back({ count, closed });
+            });
+            AssertEqual(static_cast<int>(figures.size()), 2, "Two figures, the one-point path dropped");
+            AssertTrue(figures[0] == std::make_pair(4u, true) && figures[1] == std::make_pair(3u, false), "Counts and loops");
+
+            const auto& circle = list.GetCommands()[1].Bounds;
+            AssertEqual(circle.MinX, 9500.0f, 1e-3f, "Circle bounds include the radius");
+            AssertEqual(circle.MaxY, 10500.0f, 1e-3f, "Circle bounds include the radius");
+        });
+
+        runner.AddTest(L"DisplayList_HashAndAppend", []() {
+            auto build = [](DisplayList& list, double shift, bool withText) {
+                uint16_t line = list.AddStyle(DisplayStyle::Stroke(Windows::UI::ColorHelper::FromArgb(255, 0, 0, 0), 1.0f));
+                list.AddLine(line, WorldPoint(0, 0), WorldPoint(1000 + shift, 0));
+                if (withText)
+                {
+                    uint16_t text = list.AddStyle(DisplayStyle::Text(Windows::UI::ColorHelper::FromArgb(255, 0, 0, 0), 12.0f));
+                    list.AddText(text, WorldPoint(500, 0), L"1000", 6.0f, -10.0f);
+                    list.AddMarker(line, WorldPoint(0, 0), MarkerShape::Tick, 10.0f);
+                }
+            };
+
+            DisplayList a, b, moved;
+            build(a, 0.0, true);
+            build(b, 0.0, true);
+            build(moved, 1.0, true);
+            AssertTrue(a.ComputeHash() == b.ComputeHash(), "Same content, same hash");
+            AssertTrue(a.ComputeHash() != moved.ComputeHash(), "Moved point, different hash");
+
+            DisplayList label, dimensionLabel;
+            auto labelStyle = DisplayStyle::Text(Windows::UI::ColorHelper::FromArgb(255, 0, 0, 0), 12.0f);
+            label.AddText(label.AddStyle(labelStyle), WorldPoint(0, 0), L"A", 0.0f, 0.0f);
+            dimensionLabel.AddText(dimensionLabel.AddStyle(labelStyle.WithPriority(DisplayLabelPriority::Dimension)),
+                WorldPoint(0, 0), L"A", 0.0f, 0.0f);
+            AssertTrue(label.ComputeHash() != dimensionLabel.ComputeHash(), "Label priority changes the hash");
+
+            // Appending two halves equals building them in one list
+            DisplayList first, second, joined;
+            build(first, 0.0, false);
+            build(second, 0.0, true);
+            joined.Append(first);
+            joined.Append(second);
+            DisplayList direct;
+            build(direct, 0.0, false);
+            build(direct, 0.0, true);
+            AssertEqual(static_cast<int>(joined.GetStyleCount()), static_cast<int>(direct.GetStyleCount()), "Styles merged");
+            AssertTrue(joined.GetText(joined.GetCommands().back().Type == DisplayPrimitive::Text
+                ? joined.GetCommands().back() : joined.GetCommands()[joined.GetCommandCount() - 2], 0) == L"1000",
+                "Text remapped");
+            AssertEqual(static_cast<int>(joined.GetPointCount()), static_cast<int>(direct.GetPointCount()), "Same points");
+        });
+
+        runner.AddTest(L"DisplayList_FarCoordinatesKeepPrecision", []() {
+            // A georeferenced underlay about 12 km from the project origin
+            double x0 = 12000000.25, y0 = -8300000.75;
+            DisplayList list;
+            uint16_t style = list.AddStyle(DisplayStyle::Stroke(Windows::UI::ColorHelper::FromArgb(255, 0, 0, 0), 1.0f));
+            list.AddLine(style, WorldPoint(x0, y0), WorldPoint(x0 + 1.5, y0 + 0.5));
+            list.AddMarker(style, WorldPoint(x0 + 2.25, y0), MarkerShape::Cross, 6.0f);
+            AssertEqual(list.GetOrigin().X, 12000000.0, 1e-9, "Origin on the grid");
+            AssertEqual(list.GetOrigin().Y, -8000000.0, 1e-9, "Origin on the grid");
+
+            const DisplayCommand& line = list.GetCommands().front();
+            WorldPoint end = list.ToWorld(list.GetPoints(line)[1]);
+            AssertEqual(end.X, x0 + 1.5, 1e-3, "Point kept to the micron");
+            AssertEqual(end.Y, y0 + 0.5, 1e-3, "Point kept to the micron");
+
+            // The world transform matches the camera's double mapping
+            Camera camera;
+            camera.SetCanvasSize(800.0f, 600.0f);
+            camera.SetZoom(20.0);
+            camera.SetOffset(-x0, -y0);
+            const WorldPoint world[] = { WorldPoint(x0, y0), WorldPoint(x0 + 1.5, y0 + 0.5) };
+            for (int i = 0; i < 2; ++i)
+            {
+                ScreenPoint drawn = DisplayListRenderer::TransformPoint(camera, list, list.GetPoints(line)[i]);
+                ScreenPoint exact = camera.WorldToScreen(world[i]);
+                AssertEqual(drawn.X, exact.X, 0.05, "Same screen X as the camera");
+                AssertEqual(drawn.Y, exact.Y, 0.05, "Same screen Y as the camera");
+            }
+
+            // Appending into an empty list keeps the origin, and the
+            // hash tells lists with different origins apart
+            DisplayList joined;
+            joined.Append(list);
+            AssertEqual(joined.GetOrigin().X, list.GetOrigin().X, 1e-9, "Origin carried over");
+            AssertTrue(joined.ComputeHash() == list.ComputeHash(), "Same content, same hash");
+            DisplayList near;
+            near.AddStyle(DisplayStyle::Stroke(Windows::UI::ColorHelper::FromArgb(255, 0, 0, 0), 1.0f));
+            near.AddLine(style, WorldPoint(0.25, -0.75), WorldPoint(1.75, -0.25));
+            near.AddMarker(style, WorldPoint(2.25, -0.75), MarkerShape::Cross, 6.0f);
+            AssertTrue(near.ComputeHash() != list.ComputeHash(), "Same points elsewhere, different hash");
+        });
+
+        runner.AddTest(L"DisplayList_DxfLayerBuild", []() {
+            std::vector<std::unique_ptr<DxfEntity>> entities;
+            for (int i = 0; i < 10; ++i)
+            {
+                auto line = std::make_unique<DxfLine>();
+                line->Start = WorldPoint(i * 100.0, 0);
+                line->End = WorldPoint(i * 100.0, 1000);
+                entities.push_back(std::move(line));
+            }
+            auto poly = std::make_unique<DxfPolyline>();
+            poly->Vertices = { { { 0, 0 }, 0.0 }, { { 1000, 0 }, 1.0 }, { { 1000, 1000 }, 0.0 } };
+            poly->IsClosed = true;
+            entities.push_back(std::move(poly));
+            auto circle = std::make_unique<DxfCircle>();
+            circle->Center = WorldPoint(5000, 5000);
+            circle->Radius = 250.0;
+            entities.push_back(std::move(circle));
+            auto text = std::make_unique<DxfText>();
+            text->Content = L"A-1";
+            text->Height = 300.0;
+            entities.push_back(std::move(text));
+
+            DxfReferenceLayer layer;
+            layer.TakeEntities(entities);
+            DisplayList list;
+            DxfReferenceRenderer::BuildLayer(list, layer);
+
+            // Grouped by place first: the far circle comes after the text
+            const auto& commands = list.GetCommands();
+            AssertEqual(static_cast<int>(commands.size()), 4, "Lines, polyline, text, circle");
+            AssertTrue(commands[0].Type == DisplayPrimitive::Lines && commands[0].PointCount == 20, "Ten lines in one batch");
+            AssertTrue(commands[1].Type == DisplayPrimitive::Polylines && commands[1].ItemCount == 1, "Polyline is one figure");
+            AssertTrue(commands[1].PointCount > 10, "Bulge segment split into chords");
+            AssertTrue(commands[2].Type == DisplayPrimitive::Text, "Text over the line work of its cell");
+            const DisplayStyle& textStyle = list.GetStyle(commands[2].Style);
+            AssertTrue(textStyle.WorldFont && textStyle.FontSize == 300.0f, "Text sized in mm");
+            AssertTrue(commands[3].Type == DisplayPrimitive::Circles, "Circle kept as a circle");
+        });
+
+        return runner.Run(L"Display List Tests");
+    }
+
+    // ============================================================================
+    // Wall Render Cache Tests
+    // ============================================================================
+
+    inline TestSuite RunWallRenderCacheTests()
+    {
+        TestRunner runner;
+
+        runner.AddTest(L"WallRenderCache_StaticPlanKeepsList", []() {
+            DocumentModel doc;
+            doc.SetAutoDimensionsEnabled(false);
+            AddJoinGraphGrid(doc, 4);
+            LayerManager layers;
+            ViewSettings view;
+            WallRenderer renderer;
+
+            renderer.Update(doc, layers, 0, view);
+            AssertEqual(static_cast<int>(renderer.GetLastRebuiltCount()), static_cast<int>(doc.GetWalls().size()), "First update builds all");
+            uint64_t version = renderer.GetWallList().GetVersion();
+
+            renderer.Update(doc, layers, 0, view);
+            AssertEqual(static_cast<int>(renderer.GetLastRebuiltCount()), 0, "Nothing rebuilt");
+            AssertTrue(renderer.GetWallList().GetVersion() == version, "Same list kept");
+        });
+
+        runner.AddTest(L"WallRenderCache_EditRebuildsNeighboursOnly", []() {
+            DocumentModel doc;
+            doc.SetAutoDimensionsEnabled(false);
+            AddJoinGraphGrid(doc, 6);
+            LayerManager layers;
+            ViewSettings view;
+            WallRenderer renderer;
+            renderer.Update(doc, layers, 0, view);
+            uint64_t version = renderer.GetWallList().GetVersion();
+
+            Wall* edited = doc.GetWalls()[8].get();
+            edited->SetThickness(300.0);
+            doc.NotifyWallChanged(edited->GetId());
+            doc.SyncWallEdits();
+
+            renderer.Update(doc, layers, 0, view);
+            size_t rebuilt = renderer.GetLastRebuiltCount();
+            AssertTrue(rebuilt > 1, "Wall and neighbours rebuilt");
+            AssertTrue(rebuilt < 8, "Far walls kept");
+            AssertTrue(renderer.GetWallList().GetVersion() != version, "List reassembled");
+        });
+
+        runner.AddTest(L"WallRenderCache_HoverAndSelectionKeepWallList", []() {
+            DocumentModel doc;
+            doc.SetAutoDimensionsEnabled(false);
+            AddJoinGraphGrid(doc, 3);
+            LayerManager layers;
+            ViewSettings view;
+            WallRenderer renderer;
+            renderer.Update(doc, layers, 0, view);
+            uint64_t version = renderer.GetWallList().GetVersion();
+            AssertTrue(renderer.GetHighlightList().IsEmpty(), "Nothing highlighted");
+
+            renderer.Update(doc, layers, doc.GetWalls()[2]->GetId(), view);
+            AssertFalse(renderer.GetHighlightList().IsEmpty(), "Hovered wall highlighted");
+            doc.GetWalls()[4]->SetSelected(true);
+            renderer.Update(doc, layers, 0, view);
+            AssertFalse(renderer.GetHighlightList().IsEmpty(), "Selected wall highlighted");
+            AssertTrue(renderer.GetWallList().GetVersion() == version, "Wall list untouched");
+        });
+
+        runner.AddTest(L"WallRenderCache_UsesJoinContour", []() {
+            DocumentModel doc;
+            doc.SetAutoDimensionsEnabled(false);
+            doc.AddWall({ 0, 0 }, { 3000, 0 }, 200.0);
+            doc.AddWall({ 3000, 0 }, { 3000, 3000 }, 200.0);
+            LayerManager layers;
+            ViewSettings view;
+            WallRenderer renderer;
+            renderer.Update(doc, layers, 0, view);
+
+            // The first wall's outline runs to the outer corner, not the axis end
+            const DisplayList& list = renderer.GetWallList();
+            float maxX = -1e9f, halfWidth = 0.0f;
+            bool first = true;
+            list.ForEachFigure(list.GetCommands().front(), [&](const DisplayPoint* points, uint32_t count, bool closed) {
+                if (!first)
+                    return;
+                first = false;
+                AssertTrue(closed, "Outline closed");
+                for (uint32_t i = 0; i < count; ++i)
+                {
+                    maxX = (std::max)(maxX, points[i].X);
+                    halfWidth = (std::max)(halfWidth, std::abs(points[i].Y));
+                }
+            });
+            AssertTrue(halfWidth > 1.0f, "Outline has width");
+            AssertEqual(maxX, 3000.0f + halfWidth, 0.5f, "Outer face runs to the corner");
+        });
+
+        runner.AddTest(L"WallRenderCache_RemovedWallsForgotten", []() {
+            DocumentModel doc;
+            doc.SetAutoDimensionsEnabled(false);
+            AddJoinGraphGrid(doc, 3);
+            LayerManager layers;
+            ViewSettings view;
+            WallRenderer renderer;
+            renderer.Update(doc, layers, 0, view);
+            size_t points = renderer.GetWallList().GetPointCount();
+
+            doc.RemoveWall(doc.GetWalls()[0]->GetId());
+            renderer.Update(doc, layers, 0, view);
+            AssertEqual(static_cast<int>(renderer.GetCachedWallCount()), static_cast<int>(doc.GetWalls().size()), "Cache follows the document");
+            AssertTrue(renderer.GetWallList().GetPointCount() < points, "Removed wall not drawn");
+        });
+
+        return runner.Run(L"Wall Render Cache Tests");
+    }
+
+    // ============================================================================
+    // Raster Tile Cache Tests
+    // ============================================================================
+
+    inline TestSuite RunRasterTileCacheTests()
+    {
+        TestRunner runner;
+
+        auto makeCamera = [](double zoom, double centerX, double centerY) {
+            Camera camera;
+            camera.SetCanvasSize(1600.0f, 1000.0f);
+            camera.SetZoom(zoom);
+            camera.SetOffset(-centerX, -centerY);
+            return camera;
+        };
+
+        // Plans frames until the cache has nothing left to render
+        auto settle = [](RasterTileCache& cache, const Camera& camera, uint64_t key) {
+            int frames = 0;
+            do
+            {
+                cache.Plan(camera, key);
+                ++frames;
+            } while (cache.HasPendingTiles() && frames < 100);
+            return frames;
+        };
+
+        runner.AddTest(L"RasterTileCache_OctaveSelection", []() {
+            AssertEqual(RasterTileCache::OctaveOf(1.0), 0, "Zoom 1 is octave 0");
+            AssertEqual(RasterTileCache::OctaveOf(0.3), -1, "Octave at or above the zoom");
+            AssertEqual(RasterTileCache::OctaveOf(0.5), -1, "Exact powers stay put");
+            AssertEqual(RasterTileCache::OctaveOf(100.0), 3, "Clamped to the camera's zoom limit");
+
+            // A tile camera maps the tile's square onto the whole target
+            RasterTileKey key{ 1, 2, -3 };
+            Camera camera = RasterTileCache::TileCamera(key);
+            WorldPoint origin = RasterTileCache::TileOrigin(key);
+            double size = RasterTileCache::TileWorldSize(1);
+            AssertEqual(size, 256.0, 1e-9, "512 px at 2 px/mm");
+            ScreenPoint a = camera.WorldToScreen(origin);
+            ScreenPoint b = camera.WorldToScreen(WorldPoint(origin.X + size, origin.Y + size));
+            AssertEqual(a.X, 0.0f, 1e-3f, "Origin at the left edge");
+            AssertEqual(a.Y, 0.0f, 1e-3f, "Origin at the top edge");
+            AssertEqual(b.X, 512.0f, 1e-3f, "Far corner at the right edge");
+            AssertEqual(b.Y, 512.0f, 1e-3f, "Far corner at the bottom edge");
+        });
+
+        runner.AddTest(L"RasterTileCache_SettlesAfterKeyChange", [makeCamera]() {
+            RasterTileCache cache;
+            Camera camera = makeCamera(1.0, 0, 0);
+
+            RasterTileFrame frame = cache.Plan(camera, 7);
+            AssertTrue(!frame.UseTiles && frame.Render.empty(), "New key draws live");
+            AssertTrue(cache.HasPendingTiles(), "New key asks for another frame");
+            frame = cache.Plan(camera, 7);
+            AssertTrue(frame.Render.empty(), "Still settling");
+            frame = cache.Plan(camera, 7);
+            AssertEqual(static_cast<int>(frame.Render.size()), static_cast<int>(RasterTileCache::MaxRenderedPerFrame),
+                "Rendering starts once the key holds");
+
+            // Another edit drops every tile
+            frame = cache.Plan(camera, 8);
+            AssertEqual(static_cast<int>(cache.GetTileCount()), 0, "Key change clears tiles");
+            AssertTrue(!frame.UseTiles, "Draws live after the edit");
+        });
+
+        runner.AddTest(L"RasterTileCache_VisibleFirstWithinBudget", [makeCamera]() {
+            RasterTileCache cache;
+            Camera camera = makeCamera(1.0, 100, 100);
+            std::vector<RasterTileKey> visible;
+            RasterTileCache::CollectTiles(camera, 0, 0, visible);
+            AssertTrue(visible.size() > RasterTileCache::MaxRenderedPerFrame, "View needs several frames");
+
+            cache.Plan(camera, 1);
+            cache.Plan(camera, 1);
+            size_t rendered = 0;
+            bool composited = false;
+            for (int i = 0; i < 100 && !composited; ++i)
+            {
+                RasterTileFrame frame = cache.Plan(camera, 1);
+                AssertTrue(frame.Render.size() <= RasterTileCache::MaxRenderedPerFrame, "Budget per frame");
+                for (const auto& key : frame.Render)
+                {
+                    AssertTrue(std::find(visible.begin(), visible.end(), key) != visible.end(), "Visible tiles before the margin");
+                    ++rendered;
+                }
+                composited = frame.UseTiles;
+                if (composited)
+                    AssertEqual(static_cast<int>(frame.Composite.size()), static_cast<int>(visible.size()), "Composite covers the view");
+            }
+            AssertTrue(composited, "View eventually composited");
+            AssertEqual(static_cast<int>(rendered), static_cast<int>(visible.size()), "Each visible tile rendered once");
+            AssertTrue(cache.HasPendingTiles(), "Margin ring still to render");
+
+            std::vector<RasterTileKey> wanted;
+            RasterTileCache::CollectTiles(camera, 0, RasterTileCache::MarginTiles, wanted);
+            while (cache.HasPendingTiles())
+                cache.Plan(camera, 1);
+            AssertEqual(static_cast<int>(cache.GetTileCount()), static_cast<int>(wanted.size()), "View and margin cached");
+        });
+
+        runner.AddTest(L"RasterTileCache_FallsBackToNeighbourOctave", [makeCamera, settle]() {
+            RasterTileCache cache;
+            settle(cache, makeCamera(1.0, 0, 0), 3);
+
+            // Zooming in within the octave keeps compositing
+            RasterTileFrame frame = cache.Plan(makeCamera(0.8, 0, 0), 3);
+            AssertTrue(frame.UseTiles && frame.Octave == 0, "Same octave reused");
+
+            // The next octave is missing: its coarser neighbour stands in
+            frame = cache.Plan(makeCamera(1.5, 0, 0), 3);
+            AssertTrue(!frame.Render.empty(), "Sharper tiles started");
+            AssertTrue(frame.UseTiles, "Composited meanwhile");
+            AssertEqual(frame.Octave, 0, "From the coarser octave");
+
+            settle(cache, makeCamera(1.5, 0, 0), 3);
+            frame = cache.Plan(makeCamera(1.5, 0, 0), 3);
+            AssertEqual(frame.Octave, 1, "Own octave once rendered");
+        });
+
+        runner.AddTest(L"RasterTileCache_EvictsLeastRecentlyUsed", [makeCamera, settle]() {
+            RasterTileCache cache;
+            for (int step = 0; step < 20; ++step)
+                settle(cache, makeCamera(1.0, step * 2000.0, 0), 5);
+
+            AssertTrue(cache.GetTileCount() <= RasterTileCache::MaxTiles, "Tile count capped");
+            std::vector<RasterTileKey> visible;
+            RasterTileCache::CollectTiles(makeCamera(1.0, 19 * 2000.0, 0), 0, 0, visible);
+            for (const auto& key : visible)
+                AssertTrue(cache.HasTile(key), "Current view kept");
+            std::vector<RasterTileKey> first;
+            RasterTileCache::CollectTiles(makeCamera(1.0, 0, 0), 0, 0, first);
+            AssertTrue(!cache.HasTile(first.front()), "Oldest view evicted");
+
+            cache.SetEnabled(false);
+            AssertEqual(static_cast<int>(cache.GetTileCount()), 0, "Disabling drops tiles");
+            AssertTrue(!cache.Plan(makeCamera(1.0, 0, 0), 5).UseTiles, "Disabled cache draws live");
+        });
+
+        runner.AddTest(L"RasterTileCache_PlanIgnoresSelection", []() {
+            DocumentModel doc;
+            doc.SetAutoDimensionsEnabled(false);
+            Wall* wall = doc.AddWall({ 0, 0 }, { 4000, 0 }, 200.0);
+            Door* door = doc.AddDoor(std::make_shared<Door>(wall->GetId(), 0.5));
+
+            // Tiled content is the same whatever is selected or hovered
+            OpeningRenderer renderer;
+            DisplayList plain, selected;
+            renderer.Build(plain, 1.0, doc);
+            door->SetSelected(true);
+            renderer.Build(selected, 1.0, doc);
+            AssertTrue(plain.ComputeHash() == selected.ComputeHash(), "Selection not in the tiled list");
+
+            // The highlight carries it instead, with its handles
+            DisplayList highlights;
+            renderer.BuildHighlights(highlights, 1.0, doc, 0, 0);
+            AssertTrue(highlights.IsEmpty(), "Nothing selected, nothing drawn live");
+            renderer.BuildHighlights(highlights, 1.0, doc, door->GetId(), 0);
+            AssertFalse(highlights.IsEmpty(), "Selected door drawn live");
+
+            // Pixel insets follow the scale passed in, not a camera
+            DisplayList finer;
+            renderer.Build(finer, 4.0, doc);
+            AssertTrue(finer.ComputeHash() != plain.ComputeHash(), "Insets at the octave scale");
+        });
+
+        return runner.Run(L"Raster Tile Cache Tests");
+    }
+
+    // ============================================================================
+    // Display Culling Tests
+    // ============================================================================
+
+    inline TestSuite RunDisplayCullingTests()
+    {
+        TestRunner runner;
+
+        auto box = [](float minX, float minY, float maxX, float maxY) {
+            DisplayBounds bounds;
+            bounds.Extend(minX, minY);
+            bounds.Extend(maxX, maxY);
+            return bounds;
+        };
+
+        runner.AddTest(L"DisplayCulling_SpatialOrderKey", []() {
+            AssertTrue(SpatialOrderKey(WorldPoint(100, 200)) == SpatialOrderKey(WorldPoint(900, 900)), "Same metre cell, same key");
+            AssertTrue(SpatialOrderKey(WorldPoint(0, 0)) < SpatialOrderKey(WorldPoint(1000, 0)), "X steps up the curve");
+            AssertTrue(SpatialOrderKey(WorldPoint(1000, 0)) < SpatialOrderKey(WorldPoint(0, 1000)), "Y is the higher bit");
+            AssertTrue(SpatialOrderKey(WorldPoint(-1000, -1000)) < SpatialOrderKey(WorldPoint(0, 0)), "Negative coordinates order first");
+
+            // A 2x2 block of cells is contiguous on the curve
+            uint64_t base = SpatialOrderKey(WorldPoint(4000, 4000));
+            AssertTrue(SpatialOrderKey(WorldPoint(5000, 5000)) == base + 3, "Block of four is contiguous");
+        });
+
+        runner.AddTest(L"DisplayCulling_IndexMatchesScan", [box]() {
+            DisplayList list;
+            uint16_t styles[] = {
+                list.AddStyle(DisplayStyle::Stroke(Windows::UI::ColorHelper::FromArgb(255, 0, 0, 0), 1.0f)),
+                list.AddStyle(DisplayStyle::Stroke(Windows::UI::ColorHelper::FromArgb(255, 255, 0, 0), 1.0f)) };
+            uint32_t seed = 12345;
+            auto next = [&seed]() { seed = seed * 1664525u + 1013904223u; return (seed >> 8) / 16777216.0; };
+            for (int i = 0; i < 2000; ++i)
+            {
+                WorldPoint a(next() * 100000.0, next() * 100000.0);
+                list.AddLine(styles[i % 2], a, WorldPoint(a.X + next() * 2000.0, a.Y + next() * 2000.0));
+            }
+
+            DisplayCommandIndex index;
+            index.Build(list);
+            AssertTrue(index.IsGridded(), "Long list gridded");
+            AssertEqual(static_cast<int>(index.GetPrimitiveCount()), 2000, "Primitives counted");
+
+            std::vector<uint32_t> found;
+            for (int q = 0; q < 20; ++q)
+            {
+                float x = static_cast<float>(next() * 100000.0), y = static_cast<float>(next() * 100000.0);
+                DisplayBounds view = box(x, y, x + 8000.0f, y + 5000.0f);
+                index.Query(view, found);
+
+                std::vector<uint32_t> expected;
+                for (uint32_t i = 0; i < list.GetCommandCount(); ++i)
+                {
+                    if (list.GetCommands()[i].Bounds.Intersects(view))
+                        expected.push_back(i);
+                }
+                AssertTrue(found == expected, "Grid query equals a full scan, in list order");
+                AssertTrue(found.size() < list.GetCommandCount() / 4, "Most commands culled");
+            }
+        });
+
+        runner.AddTest(L"DisplayCulling_GrowsByWorldStroke", [box]() {
+            DisplayList list;
+            uint16_t beam = list.AddStyle(DisplayStyle::WorldStroke(Windows::UI::ColorHelper::FromArgb(255, 0, 0, 0), 400.0f));
+            list.AddLine(beam, WorldPoint(0, 0), WorldPoint(5000, 0));
+
+            DisplayCommandIndex index;
+            index.Build(list);
+            AssertTrue(!index.IsGridded(), "Short list scanned");
+            std::vector<uint32_t> found;
+            index.Query(box(1000, 150, 2000, 300), found);
+            AssertEqual(static_cast<int>(found.size()), 1, "Stroke edge within half its width");
+            index.Query(box(1000, 250, 2000, 300), found);
+            AssertEqual(static_cast<int>(found.size()), 0, "Beyond the stroke culled");
+        });
+
+        runner.AddTest(L"DisplayCulling_LargeCommandsKept", [box]() {
+            DisplayList list;
+            uint16_t fill = list.AddStyle(DisplayStyle::Fill(Windows::UI::ColorHelper::FromArgb(255, 0, 0, 255)));
+            uint16_t line = list.AddStyle(DisplayStyle::Stroke(Windows::UI::ColorHelper::FromArgb(255, 0, 0, 0), 1.0f));
+            list.AddPolygon(fill, std::vector<WorldPoint>{ { 0, 0 }, { 9000, 0 }, { 9000, 9000 }, { 0, 9000 } });
+            for (int i = 0; i < 100; ++i)
+            {
+                list.AddLine(line, WorldPoint(i * 90.0, i * 90.0), WorldPoint(i * 90.0 + 10, i * 90.0));
+                list.AddPolygon(fill, std::vector<WorldPoint>{ { i * 90.0, 0 }, { i * 90.0 + 10, 0 }, { i * 90.0, 10 } });
+            }
+
+            DisplayCommandIndex index;
+            index.Build(list);
+            AssertTrue(index.IsGridded(), "Gridded");
+            std::vector<uint32_t> found;
+            index.Query(box(4400, 4400, 4460, 4460), found);
+            AssertTrue(!found.empty() && found.front() == 0, "Plan-sized polygon found from any cell, first");
+            AssertTrue(std::is_sorted(found.begin(), found.end()), "Draw order kept");
+            AssertTrue(found.size() <= 4, "Only the nearby batches");
+        });
+
+        runner.AddTest(L"DisplayCulling_ScatteredWallsBatchByPlace", []() {
+            DocumentModel doc;
+            doc.SetAutoDimensionsEnabled(false);
+            std::vector<int> cells(400);
+            for (int i = 0; i < 400; ++i)
+                cells[i] = i;
+            uint32_t seed = 7;
+            for (int i = 399; i > 0; --i)
+            {
+                seed = seed * 1664525u + 1013904223u;
+                std::swap(cells[i], cells[(seed >> 8) % (i + 1)]);
+            }
+            for (int cell : cells)
+            {
+                double x = (cell % 20) * 5000.0, y = (cell / 20) * 5000.0;
+                doc.AddWall({ x, y }, { x + 2000.0, y }, 200.0);
+            }
+
+            LayerManager layers;
+            ViewSettings view;
+            WallRenderer renderer;
+            renderer.Update(doc, layers, 0, view);
+            const DisplayList& list = renderer.GetWallList();
+            for (const auto& command : list.GetCommands())
+                AssertTrue(command.Bounds.MaxX - command.Bounds.MinX <= DisplayList::MaxBatchExtent + 500.0f, "Batches stay local");
+
+            // A view of a few walls replays a few batches
+            Camera camera;
+            camera.SetCanvasSize(800.0f, 600.0f);
+            camera.SetZoom(0.05);
+            camera.SetOffset(-50000.0, -50000.0);
+            DisplayCommandIndex index;
+            index.Build(list);
+            std::vector<uint32_t> found;
+            index.Query(DisplayListRenderer::CullBounds(camera), found);
+            size_t primitives = 0;
+            for (uint32_t id : found)
+                primitives += list.GetCommands()[id].GetPrimitiveCount();
+            AssertTrue(primitives > 0, "View shows walls");
+            AssertTrue(primitives < index.GetPrimitiveCount() / 4, "Most walls culled");
+        });
+
+        return runner.Run(L"Display Culling Tests");
+    }
+
+    // ============================================================================
+    // Text Layout Cache Tests
+    // ============================================================================
+
+    inline TestSuite RunTextLayoutCacheTests()
+    {
+        TestRunner runner;
+
+        runner.AddTest(L"TextLayoutCache_FormatKeyBuckets", []() {
+            uint32_t key = TextLayoutCache::FormatKey(DisplayFont::Default, 12.0f, DisplayTextAlign::TopLeft);
+            AssertEqual(key, TextLayoutCache::FormatKey(DisplayFont::Default, 12.05f, DisplayTextAlign::TopLeft), "Sizes within a quarter pixel share a key");
+            AssertTrue(key != TextLayoutCache::FormatKey(DisplayFont::Default, 12.25f, DisplayTextAlign::TopLeft), "Next quarter pixel has its own key");
+            AssertTrue(key != TextLayoutCache::FormatKey(DisplayFont::Sans, 12.0f, DisplayTextAlign::TopLeft), "Font is part of the key");
+            AssertTrue(key != TextLayoutCache::FormatKey(DisplayFont::Default, 12.0f, DisplayTextAlign::Center), "Alignment is part of the key");
+        });
+
+        runner.AddTest(L"TextLayoutCache_ReusesFormats", []() {
+            TextLayoutCache cache;
+            cache.GetFormat(DisplayFont::Default, 11.0f);
+            cache.GetFormat(DisplayFont::Default, 11.0f);
+            cache.GetFormat(DisplayFont::Default, 11.0f, DisplayTextAlign::TopCenter);
+            AssertEqual(cache.GetFormatCount(), size_t(2), "One format per size and alignment");
+        });
+
+        runner.AddTest(L"TextLayoutCache_ReusesLayouts", []() {
+            TextLayoutCache cache;
+            Microsoft::Graphics::Canvas::CanvasRenderTarget target(
+                Microsoft::Graphics::Canvas::CanvasDevice::GetSharedDevice(), 64.0f, 64.0f, 96.0f);
+            auto session = target.CreateDrawingSession();
+            for (int frame = 0; frame < 3; ++frame)
+            {
+                cache.BeginFrame();
+                cache.GetLayout(session, L"3600 мм", DisplayFont::Default, 12.0f);
+                cache.GetLayout(session, L"2400 мм", DisplayFont::Default, 12.0f);
+            }
+            AssertEqual(cache.GetLayoutsCreated(), size_t(2), "Each label laid out once");
+            AssertEqual(cache.GetHits(), size_t(4), "Later frames hit the cache");
+
+            cache.GetLayout(session, L"3600 мм", DisplayFont::Default, 12.0f, DisplayTextAlign::TopLeft, 100.0f, 30.0f);
+            AssertEqual(cache.GetLayoutCount(), size_t(3), "A box is part of the key");
+            session.Close();
+        });
+
+        runner.AddTest(L"LabelTextCache_FormatsOnChange", []() {
+            LabelTextCache labels;
+            int calls = 0;
+            auto format = [&calls](double value) {
+                return [&calls, value]() { ++calls; return std::to_wstring(static_cast<int>(value)); };
+            };
+
+            AssertTrue(labels.Get(7, LabelTextCache::ValueStamp(3600.0), format(3600.0)) == L"3600", "First request formats");
+            labels.Get(7, LabelTextCache::ValueStamp(3600.0), format(3600.0));
+            AssertEqual(calls, 1, "Same value is not formatted again");
+
+            AssertTrue(labels.Get(7, LabelTextCache::ValueStamp(4200.0), format(4200.0)) == L"4200", "New value is formatted");
+            AssertEqual(calls, 2, "Formatted once per change");
+        });
+
+        runner.AddTest(L"LabelTextCache_EndPassDropsStale", []() {
+            LabelTextCache labels;
+            auto text = []() { return std::wstring(L"A"); };
+            labels.Get(1, 0, text);
+            labels.Get(2, 0, text);
+            labels.EndPass();
+            AssertEqual(labels.GetCount(), size_t(2), "Labels asked for are kept");
+
+            labels.Get(1, 0, text);
+            labels.EndPass();
+            AssertEqual(labels.GetCount(), size_t(1), "Label not asked for is dropped");
+            AssertEqual(labels.GetFormattedCount(), size_t(2), "Kept label is not formatted again");
+        });
+
+        return runner.Run(L"Text Layout Cache Tests");
+    }
+
+    // ============================================================================
+    // Label Declutter Tests
+    // ============================================================================
+
+    inline TestSuite RunLabelDeclutterTests()
+    {
+        TestRunner runner;
+
+        auto box = [](float minX, float minY, float maxX, float maxY) {
+            DisplayBounds bounds;
+            bounds.Extend(minX, minY);
+            bounds.Extend(maxX, maxY);
+            return bounds;
+        };
+
+        runner.AddTest(L"LabelDeclutter_RejectsOverlap", [box]() {
+            LabelDeclutter declutter;
+            declutter.Begin(800.0f, 600.0f);
+            AssertTrue(declutter.TryPlace(box(100, 100, 200, 120)), "First label is placed");
+            AssertFalse(declutter.TryPlace(box(150, 110, 260, 130)), "Overlapping label is rejected");
+            AssertTrue(declutter.TryPlace(box(300, 100, 400, 120)), "Label clear of others is placed");
+            AssertTrue(declutter.TryPlace(box(100, 140, 200, 160)), "Label below in the same cells is placed");
+            AssertEqual(declutter.GetPlacedCount(), size_t(3), "Placed count");
+            AssertEqual(declutter.GetRejectedCount(), size_t(1), "Rejected count");
+        });
+
+        runner.AddTest(L"LabelDeclutter_RejectsOffCanvas", [box]() {
+            LabelDeclutter declutter;
+            declutter.Begin(800.0f, 600.0f);
+            AssertFalse(declutter.TryPlace(box(-200, 100, -100, 120)), "Label left of the canvas");
+            AssertFalse(declutter.TryPlace(box(100, 700, 200, 720)), "Label below the canvas");
+            AssertTrue(declutter.TryPlace(box(-50, -10, 50, 10)), "Label on the corner is placed");
+        });
+
+        runner.AddTest(L"LabelDeclutter_BeginForgetsLabels", [box]() {
+            LabelDeclutter declutter;
+            declutter.Begin(800.0f, 600.0f);
+            declutter.TryPlace(box(100, 100, 200, 120));
+            declutter.Begin(1600.0f, 1200.0f);
+            AssertTrue(declutter.TryPlace(box(100, 100, 200, 120)), "New frame starts empty");
+            AssertTrue(declutter.TryPlace(box(1400, 1000, 1500, 1020)), "Grid covers the new size");
+        });
+
+        runner.AddTest(L"LabelDeclutter_EstimateBox", []() {
+            DisplayBounds left = LabelDeclutter::EstimateBox(L"3600", 10.0f, DisplayTextAlign::TopLeft, 100.0f, 50.0f);
+            AssertEqual(left.MinX, 100.0f - LabelDeclutter::GapPx, 0.01, "Top-left box starts at the anchor");
+            AssertEqual(left.MaxX - left.MinX, 4 * 10.0f * LabelDeclutter::CharWidthEm + 2 * LabelDeclutter::GapPx, 0.01, "Width from characters");
+
+            DisplayBounds center = LabelDeclutter::EstimateBox(L"101\nKitchen", 10.0f, DisplayTextAlign::Center, 100.0f, 50.0f);
+            AssertEqual((center.MinX + center.MaxX) / 2, 100.0f, 0.01, "Centered horizontally");
+            AssertEqual((center.MinY + center.MaxY) / 2, 50.0f, 0.01, "Centered vertically");
+            AssertEqual(center.MaxY - center.MinY, 2 * 10.0f * LabelDeclutter::LineHeightEm + 2 * LabelDeclutter::GapPx, 0.01, "Height from lines");
+        });
+
+        runner.AddTest(L"LabelDeclutter_PriorityAcrossLists", []() {
+            Camera camera;
+            camera.SetCanvasSize(800.0f, 600.0f);
+            camera.SetZoom(1.0);
+            camera.SetOffset(0.0, 0.0);
+
+            DisplayList underlay;
+            uint16_t underlayStyle = underlay.AddStyle(DisplayStyle::Text(Windows::UI::ColorHelper::FromArgb(255, 0, 0, 0), 12.0f)
+                .WithPriority(DisplayLabelPriority::Underlay));
+            underlay.AddText(underlayStyle, WorldPoint(0, 0), L"UNDERLAY NOTE");
+            underlay.AddText(underlayStyle, WorldPoint(300, 0), L"FAR");
+
+            DisplayList plan;
+            plan.AddText(plan.AddStyle(DisplayStyle::Text(Windows::UI::ColorHelper::FromArgb(255, 0, 0, 0), 12.0f)
+                .WithPriority(DisplayLabelPriority::Dimension)), WorldPoint(0, 0), L"3600 mm");
+
+            DisplayListRenderer renderer;
+            renderer.PlaceLabels(camera, { &underlay, &plan });
+            AssertEqual(renderer.GetDeclutter().GetPlacedCount(), size_t(2), "Dimension and the far note are placed");
+            AssertEqual(renderer.GetDeclutter().GetRejectedCount(), size_t(1), "Covered note is rejected");
+
+            AssertFalse(renderer.IsLabelShown(underlay, 0), "Underlay note under the dimension is not drawn");
+            AssertTrue(renderer.IsLabelShown(underlay, 1), "Far note is drawn");
+            AssertTrue(renderer.IsLabelShown(plan, 0), "Dimension is drawn");
+
+            // A list left out of placement draws all of its labels
+            DisplayList other;
+            other.AddText(other.AddStyle(DisplayStyle::Text(Windows::UI::ColorHelper::FromArgb(255, 0, 0, 0), 12.0f)),
+                WorldPoint(0, 0), L"OTHER");
+            AssertTrue(renderer.IsLabelShown(other, 0), "Unplaced list keeps its labels");
+        });
+
+        return runner.Run(L"Label Declutter Tests");
+    }
+
+    // ============================================================================
+    // Frame Profiler Tests
+    // ============================================================================
+
+    inline TestSuite RunFrameProfilerTests()
+    {
+        TestRunner runner;
+
+        runner.AddTest(L"FrameProfiler_DisabledRecordsNothing", []() {
+            FrameProfiler profiler;
+            {
+                ProfileFrame frame(profiler);
+                ProfileScope scope(L"Walls draw", profiler);
+            }
+            AssertEqual(profiler.GetFrameCount(), size_t(0), "No frame recorded");
+            AssertEqual(profiler.GetEventCount(), size_t(0), "No event recorded");
+            AssertTrue(profiler.GetScopeStats().empty(), "No scope recorded");
+        });
+
+        runner.AddTest(L"FrameProfiler_ScopesPerFrame", []() {
+            FrameProfiler profiler;
+            profiler.SetEnabled(true);
+            {
+                ProfileFrame frame(profiler);
+                for (int i = 0; i < 2; ++i)
+                {
+                    ProfileScope scope(L"Walls draw", profiler);
+                    ProfileScope nested(L"Labels", profiler);
+                }
+            }
+            // A query between frames counts towards the next one
+            {
+                ProfileScope scope(L"Snap", profiler);
+            }
+            {
+                ProfileFrame frame(profiler);
+            }
+
+            AssertEqual(profiler.GetFrameCount(), size_t(2), "Two frames");
+            AssertEqual(profiler.GetEventCount(), size_t(7), "Frames and scopes are events");
+            auto scopes = profiler.GetScopeStats();
+            AssertEqual(scopes.size(), size_t(3), "Three scope names");
+            for (const auto& scope : scopes)
+            {
+                if (scope.Name == L"Snap")
+                    AssertEqual(static_cast<int>(scope.LastCalls), 1, "Snap counted in the second frame");
+                else
+                    AssertEqual(static_cast<int>(scope.LastCalls), 0, "First frame's scopes not in the second");
+                AssertTrue(scope.MaxMs >= scope.LastMs, "Max covers last");
+            }
+        });
+
+        runner.AddTest(L"FrameProfiler_RollingWindow", []() {
+            FrameProfiler profiler;
+            profiler.SetEnabled(true);
+            size_t frames = FrameProfiler::HistoryFrames + 10;
+            for (size_t i = 0; i < frames; ++i)
+            {
+                ProfileFrame frame(profiler);
+            }
+
+            auto stats = profiler.GetFrameStats();
+            AssertEqual(profiler.GetFrameCount(), frames, "Every frame counted");
+            AssertEqual(stats.Frames, FrameProfiler::HistoryFrames, "Window keeps the last frames");
+            size_t histogram = 0;
+            for (size_t count : stats.Histogram)
+                histogram += count;
+            AssertEqual(histogram, FrameProfiler::HistoryFrames, "Histogram covers the window");
+            AssertTrue(stats.P50Ms <= stats.P95Ms && stats.P95Ms <= stats.MaxMs, "Percentiles are ordered");
+        });
+
+        runner.AddTest(L"FrameProfiler_ChromeTrace", []() {
+            FrameProfiler profiler;
+            profiler.SetEnabled(true);
+            {
+                ProfileFrame frame(profiler);
+                ProfileScope scope(L"Стены \"A\"", profiler);
+            }
+
+            std::string json = profiler.ExportChromeTrace();
+            AssertTrue(json.rfind("{\"traceEvents\":[", 0) == 0, "Trace event object");
+            AssertTrue(json.find("\"name\":\"Frame\",\"cat\":\"frame\",\"ph\":\"X\"") != std::string::npos, "Frame as a complete event");
+            AssertTrue(json.find("\"name\":\"\xD0\xA1\xD1\x82\xD0\xB5\xD0\xBD\xD1\x8B \\\"A\\\"\"") != std::string::npos, "Scope name escaped in UTF-8");
+            AssertTrue(json.find("\"dur\":") != std::string::npos, "Durations exported");
+        });
+
+        runner.AddTest(L"FrameProfiler_ClearKeepsEnabled", []() {
+            FrameProfiler profiler;
+            profiler.SetEnabled(true);
+            {
+                ProfileFrame frame(profiler);
+                ProfileScope scope(L"Grid", profiler);
+            }
+            profiler.Clear();
+            AssertTrue(profiler.IsEnabled(), "Still enabled");
+            AssertEqual(profiler.GetEventCount(), size_t(0), "Events dropped");
+            AssertEqual(profiler.GetFrameStats().Frames, size_t(0), "Window emptied");
+            AssertTrue(profiler.GetScopeStats().empty(), "Scope statistics dropped");
+        });
+
+        return runner.Run(L"Frame Profiler Tests");
+    }
+
     // ============================================================================
     // Run All Tests
     // ============================================================================
@@ -782,6 +3755,31 @@ namespace winrt::estimate1::tests
         result.Suites.push_back(RunViewSettingsTests());
         result.Suites.push_back(RunLineWeightTests());
         result.Suites.push_back(RunWallGeometryTests());
+        result.Suites.push_back(RunWallStoreTests());
+        result.Suites.push_back(RunIdAllocationTests());
+        result.Suites.push_back(RunChangeJournalTests());
+        result.Suites.push_back(RunDocumentSnapshotTests());
+        result.Suites.push_back(RunLevelTests());
+        result.Suites.push_back(RunRoomDetectorTests());
+        result.Suites.push_back(RunWallGraphTests());
+        result.Suites.push_back(RunIncrementalRoomTests());
+        result.Suites.push_back(RunRoomNetAreaTests());
+        result.Suites.push_back(RunRoomWorkerTests());
+        result.Suites.push_back(RunWallJoinIndexTests());
+        result.Suites.push_back(RunWallJoinGraphTests());
+        result.Suites.push_back(RunWallJunctionSolverTests());
+        result.Suites.push_back(RunGeometryKernelsTests());
+        result.Suites.push_back(RunRobustPredicatesTests());
+        result.Suites.push_back(RunWallSnapIndexTests());
+        result.Suites.push_back(RunSnapEngineTests());
+        result.Suites.push_back(RunReferenceSnapTests());
+        result.Suites.push_back(RunDisplayListTests());
+        result.Suites.push_back(RunWallRenderCacheTests());
+        result.Suites.push_back(RunRasterTileCacheTests());
+        result.Suites.push_back(RunDisplayCullingTests());
+        result.Suites.push_back(RunTextLayoutCacheTests());
+        result.Suites.push_back(RunLabelDeclutterTests());
+        result.Suites.push_back(RunFrameProfilerTests());
 
         // Aggregate results
         for (const auto& suite : result.Suites)
@@ -0,0 +1,270 @@
+#pragma once
+
+#include "pch.h"
+#include "DisplayList.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <winrt/Microsoft.Graphics.Canvas.h>
+#include <winrt/Microsoft.Graphics.Canvas.Text.h>
+
+namespace winrt::estimate1
+{
+    // =================================================================
+    // TEXT LAYOUT CACHE - text formats and laid-out labels across frames
+    // =================================================================
+    // Drawing a string with a format makes Win2D lay it out again on
+    // every call, and a new CanvasTextFormat per label costs a
+    // DirectWrite object each. The labels of a plan repeat from frame
+    // to frame (dimension values, room names, underlay text), so
+    // formats are kept per (font, size, alignment) and laid-out text
+    // per (string, format, box).
+    //
+    // Sizes are bucketed to quarter pixels. Layouts belong to a device
+    // and are dropped when it changes; past MaxLayouts, the ones used
+    // longest ago are evicted by BeginFrame. Shared() is the instance
+    // the renderers use; it is touched from the UI thread only.
+    // =================================================================
+
+    class TextLayoutCache
+    {
+    public:
+        static constexpr size_t MaxLayouts = 4096;
+
+        static TextLayoutCache& Shared()
+        {
+            static TextLayoutCache cache;
+            return cache;
+        }
+
+        // Key of a format; sizes are in quarter pixels so that sizes
+        // differing by rounding share it. 0 px is the default size.
+        static uint32_t FormatKey(DisplayFont font, float sizePx, DisplayTextAlign align)
+        {
+            uint32_t size = static_cast<uint32_t>(std::lround((std::max)(sizePx, 0.0f) * 4.0f));
+            return (size << 8) | (static_cast<uint32_t>(font) << 4) | static_cast<uint32_t>(align);
+        }
+
+        Microsoft::Graphics::Canvas::Text::CanvasTextFormat GetFormat(
+            DisplayFont font, float sizePx, DisplayTextAlign align = DisplayTextAlign::TopLeft)
+        {
+            using namespace Microsoft::Graphics::Canvas::Text;
+
+            uint32_t key = FormatKey(font, sizePx, align);
+            auto it = m_formats.find(key);
+            if (it != m_formats.end())
+                return it->second;
+
+            CanvasTextFormat format;
+            if (sizePx > 0.0f)
+                format.FontSize(static_cast<float>(key >> 8) / 4.0f);
+            if (font == DisplayFont::Sans)
+                format.FontFamily(L"Segoe UI");
+            else if (font == DisplayFont::Mono)
+                format.FontFamily(L"Consolas");
+            if (align != DisplayTextAlign::TopLeft)
+                format.HorizontalAlignment(CanvasHorizontalAlignment::Center);
+            if (align == DisplayTextAlign::Center)
+                format.VerticalAlignment(CanvasVerticalAlignment::Center);
+
+            m_formats.emplace(key, format);
+            return format;
+        }
+
+        // Text laid out for the session's device. A 0 x 0 box lays it
+        // out on one line around its anchor, as DrawText at a point does;
+        // a box lays it out within it, wrapping.
+        Microsoft::Graphics::Canvas::Text::CanvasTextLayout GetLayout(
+            const Microsoft::Graphics::Canvas::CanvasDrawingSession& session,
+            const std::wstring& text,
+            DisplayFont font,
+            float sizePx,
+            DisplayTextAlign align = DisplayTextAlign::TopLeft,
+            float boxWidth = 0.0f,
+            float boxHeight = 0.0f)
+        {
+            using namespace Microsoft::Graphics::Canvas::Text;
+
+            auto device = session.Device();
+            if (device != m_device)
+            {
+                m_layouts.clear();
+                m_device = device;
+            }
+
+            m_probe.Text.assign(text);
+            m_probe.Format = FormatKey(font, sizePx, align);
+            m_probe.BoxWidth = static_cast<uint32_t>(std::lround((std::max)(boxWidth, 0.0f)));
+            m_probe.BoxHeight = static_cast<uint32_t>(std::lround((std::max)(boxHeight, 0.0f)));
+
+            auto it = m_layouts.find(m_probe);
+            if (it != m_layouts.end())
+            {
+                it->second.LastUsed = m_frame;
+                ++m_hits;
+                return it->second.Layout;
+            }
+
+            CanvasTextLayout layout(session, winrt::hstring(text), GetFormat(font, sizePx, align),
+                static_cast<float>(m_probe.BoxWidth), static_cast<float>(m_probe.BoxHeight));
+            if (m_probe.BoxWidth == 0)
+                layout.WordWrapping(CanvasWordWrapping::NoWrap);
+
+            m_layouts.emplace(m_probe, Entry{ layout, m_frame });
+            ++m_created;
+            return layout;
+        }
+
+        // Starts a frame: evicts the layouts used longest ago once there
+        // are more than MaxLayouts
+        void BeginFrame()
+        {
+            ++m_frame;
+            if (m_layouts.size() <= MaxLayouts)
+                return;
+
+            std::vector<uint64_t> ages;
+            ages.reserve(m_layouts.size());
+            for (const auto& entry : m_layouts)
+                ages.push_back(entry.second.LastUsed);
+            // Keep the newest half
+            auto middle = ages.begin() + ages.size() / 2;
+            std::nth_element(ages.begin(), middle, ages.end());
+            uint64_t cutoff = *middle;
+            for (auto it = m_layouts.begin(); it != m_layouts.end();)
+            {
+                if (it->second.LastUsed < cutoff)
+                    it = m_layouts.erase(it);
+                else
+                    ++it;
+            }
+        }
+
+        void Clear()
+        {
+            m_layouts.clear();
+            m_formats.clear();
+        }
+
+        size_t GetLayoutCount() const { return m_layouts.size(); }
+        size_t GetFormatCount() const { return m_formats.size(); }
+        size_t GetLayoutsCreated() const { return m_created; }
+        size_t GetHits() const { return m_hits; }
+
+    private:
+        struct Key
+        {
+            std::wstring Text;
+            uint32_t Format{ 0 };
+            uint32_t BoxWidth{ 0 };     // px, 0 for none
+            uint32_t BoxHeight{ 0 };
+
+            bool operator==(const Key& other) const
+            {
+                return Format == other.Format && BoxWidth == other.BoxWidth
+                    && BoxHeight == other.BoxHeight && Text == other.Text;
+            }
+        };
+
+        struct KeyHash
+        {
+            size_t operator()(const Key& key) const
+            {
+                size_t hash = std::hash<std::wstring>()(key.Text);
+                uint64_t rest = (static_cast<uint64_t>(key.Format) << 32) ^ (key.BoxWidth << 16) ^ key.BoxHeight;
+                return hash ^ (std::hash<uint64_t>()(rest) + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2));
+            }
+        };
+
+        struct Entry
+        {
+            Microsoft::Graphics::Canvas::Text::CanvasTextLayout Layout{ nullptr };
+            uint64_t LastUsed{ 0 };
+        };
+
+        std::unordered_map<uint32_t, Microsoft::Graphics::Canvas::Text::CanvasTextFormat> m_formats;
+        std::unordered_map<Key, Entry, KeyHash> m_layouts;
+        Microsoft::Graphics::Canvas::CanvasDevice m_device{ nullptr };
+        Key m_probe;                            // lookup key, reused so a hit does not allocate
+        uint64_t m_frame{ 0 };
+        size_t m_created{ 0 };
+        size_t m_hits{ 0 };
+    };
+
+    // =================================================================
+    // LABEL TEXT CACHE - formatted label strings per element
+    // =================================================================
+    // A label is formatted again only when the stamp its owner passes
+    // changes (the measured value, the room's name and area), so a
+    // static plan pays no swprintf per label per frame. Entries of
+    // elements not asked for during a pass are dropped by EndPass.
+    // =================================================================
+
+    class LabelTextCache
+    {
+    public:
+        // The label of an element; format() builds it when stamp changed
+        template <typename Format>
+        const std::wstring& Get(uint64_t id, uint64_t stamp, Format&& format)
+        {
+            Entry& entry = m_entries[id];
+            entry.Pass = m_pass;
+            if (!entry.Valid || entry.Stamp != stamp)
+            {
+                entry.Text = format();
+                entry.Stamp = stamp;
+                entry.Valid = true;
+                ++m_formatted;
+            }
+            return entry.Text;
+        }
+
+        // Drops the labels not asked for since the previous EndPass
+        void EndPass()
+        {
+            for (auto it = m_entries.begin(); it != m_entries.end();)
+            {
+                if (it->second.Pass != m_pass)
+                    it = m_entries.erase(it);
+                else
+                    ++it;
+            }
+            ++m_pass;
+        }
+
+        // Stamp of a measured value: its bit pattern
+        static uint64_t ValueStamp(double value)
+        {
+            uint64_t bits = 0;
+            std::memcpy(&bits, &value, sizeof(bits));
+            return bits;
+        }
+
+        // Folds one more part (a value stamp, a revision, a flag) into a stamp
+        static uint64_t CombineStamp(uint64_t stamp, uint64_t part)
+        {
+            return (stamp ^ part) * 1099511628211ull + 0x9e3779b97f4a7c15ull;
+        }
+
+        void Clear() { m_entries.clear(); }
+        size_t GetCount() const { return m_entries.size(); }
+        size_t GetFormattedCount() const { return m_formatted; }
+
+    private:
+        struct Entry
+        {
+            std::wstring Text;
+            uint64_t Stamp{ 0 };
+            uint64_t Pass{ 0 };
+            bool Valid{ false };
+        };
+
+        std::unordered_map<uint64_t, Entry> m_entries;
+        uint64_t m_pass{ 0 };
+        size_t m_formatted{ 0 };
+    };
+}
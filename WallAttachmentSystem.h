@@ -4,11 +4,13 @@
 #include "pch.h"
 #include "Models.h"
 #include "Camera.h"
+#include "WallJoinIndex.h"
 #include <cmath>
 #include <vector>
 #include <array>
 #include <algorithm>
 #include <optional>
+#include <unordered_map>
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
@@ -104,7 +106,7 @@ namespace winrt::estimate1
         // Геометрия угла для рендеринга (полигон из 4-8 точек)
         std::vector<WorldPoint> CornerPolygon;
 
-        bool IsValid() const { return WallId1 != 0 && WallId2 != 0; }
+        bool IsValid() const { return WallId1 != 0 && WallId2 != 0 && Type != JoinType::None; }
     };
 
     // =====================================================
@@ -122,23 +124,7 @@ namespace winrt::estimate1
             double& t1,     // Параметр на первой линии (0-1 = на отрезке)
             double& t2)     // Параметр на второй линии
         {
-            double x1 = p1.X, y1 = p1.Y;
-            double x2 = p2.X, y2 = p2.Y;
-            double x3 = p3.X, y3 = p3.Y;
-            double x4 = p4.X, y4 = p4.Y;
-
-            double denom = (x1 - x2) * (y3 - y4) - (y1 - y2) * (x3 - x4);
-
-            if (std::abs(denom) < 1e-10)
-                return false;   // Параллельные линии
-
-            t1 = ((x1 - x3) * (y3 - y4) - (y1 - y3) * (x3 - x4)) / denom;
-            t2 = -((x1 - x2) * (y1 - y3) - (y1 - y2) * (x1 - x3)) / denom;
-
-            intersection.X = x1 + t1 * (x2 - x1);
-            intersection.Y = y1 + t1 * (y2 - y1);
-
-            return true;
+            return GeometryKernels::LineIntersection(p1, p2, p3, p4, intersection, t1, t2);
         }
 
         // Упрощённая версия без параметров
@@ -217,21 +203,7 @@ namespace winrt::estimate1
             double& t,
             WorldPoint& projection)
         {
-            WorldPoint ab(b.X - a.X, b.Y - a.Y);
-            double abLen2 = ab.X * ab.X + ab.Y * ab.Y;
-            if (abLen2 < 1e-10)
-            {
-                t = 0.0;
-                projection = a;
-                return Distance(p, a);
-            }
-
-            WorldPoint ap(p.X - a.X, p.Y - a.Y);
-            t = Dot(ap, ab) / abLen2;
-            t = std::clamp(t, 0.0, 1.0);
-
-            projection = WorldPoint(a.X + ab.X * t, a.Y + ab.Y * t);
-            return Distance(p, projection);
+            return GeometryKernels::DistancePointToSegment(p, a, b, t, projection);
         }
     };
 
@@ -332,42 +304,74 @@ namespace winrt::estimate1
             const std::vector<std::unique_ptr<Wall>>& allWalls,
             double tolerance = 50.0) const
         {
+            TrimLineCache(allWalls.size());
             std::vector<AttachmentJoinInfo> results;
+            AttachmentLine line1 = GetAttachmentLine(wall);
+            WallJoinIndex::ForEachCandidate(wall, allWalls, tolerance, [&](const Wall& other) {
+                AppendJoins(wall, line1, other, tolerance, results);
+            });
+            return results;
+        }
 
+        // Same with an index: only walls within tolerance are tested
+        std::vector<AttachmentJoinInfo> FindJoins(
+            const Wall& wall,
+            const WallJoinIndex& index,
+            double tolerance = 50.0) const
+        {
+            TrimLineCache(index.Size());
+            std::vector<AttachmentJoinInfo> results;
             AttachmentLine line1 = GetAttachmentLine(wall);
+            index.ForEachCandidate(wall, tolerance, [&](const Wall& other) {
+                AppendJoins(wall, line1, other, tolerance, results);
+            });
+            return results;
+        }
 
-            for (const auto& other : allWalls)
+        // Joins of every wall in the plan, near-linear in the wall count
+        std::vector<AttachmentJoinInfo> FindAllJoins(
+            const std::vector<std::unique_ptr<Wall>>& allWalls,
+            double tolerance = 50.0) const
+        {
+            WallJoinIndex index(allWalls);
+            TrimLineCache(index.Size());
+            std::vector<AttachmentJoinInfo> results;
+            for (const auto& wall : allWalls)
             {
-                if (!other || other->GetId() == wall.GetId())
-                    continue;
-
-                AttachmentLine line2 = GetAttachmentLine(*other);
-
-                // Проверка соединения в начале wall
-                if (wall.IsJoinAllowedAtStart())
-                {
-                    auto join = DetectJoin(wall, true, line1, *other, line2, tolerance);
-                    if (join.IsValid())
-                        results.push_back(join);
-                }
-
-                // Проверка соединения в конце wall
-                if (wall.IsJoinAllowedAtEnd())
-                {
-                    auto join = DetectJoin(wall, false, line1, *other, line2, tolerance);
-                    if (join.IsValid())
-                        results.push_back(join);
-                }
-
-                // Дополнительная проверка: X-стыки и коллинеарность (середина-середина)
-                auto midJoin = DetectCrossOrCollinear(wall, line1, *other, line2, tolerance);
-                if (midJoin.IsValid())
-                    results.push_back(midJoin);
+                if (!wall) continue;
+                const AttachmentLine& line1 = GetCachedAttachmentLine(*wall);
+                index.ForEachCandidate(*wall, tolerance, [&](const Wall& other) {
+                    AppendJoins(*wall, line1, other, tolerance, results);
+                });
             }
+            return results;
+        }
 
+        // Joins of wall with one other wall (WallJoinGraph patches per pair)
+        std::vector<AttachmentJoinInfo> FindJoinsBetween(
+            const Wall& wall,
+            const Wall& other,
+            double tolerance = 50.0) const
+        {
+            std::vector<AttachmentJoinInfo> results;
+            AppendJoins(wall, GetCachedAttachmentLine(wall), other, tolerance, results);
             return results;
         }
 
+        // Attachment line of a plan wall, reused while its geometry revision
+        // (endpoints, thickness, location line) is unchanged
+        const AttachmentLine& GetCachedAttachmentLine(const Wall& wall) const
+        {
+            CachedLine& entry = m_lineCache[wall.GetId()];
+            if (entry.Source != &wall || entry.Revision != wall.GetGeometryRevision())
+            {
+                entry.Line = GetAttachmentLine(wall);
+                entry.Source = &wall;
+                entry.Revision = wall.GetGeometryRevision();
+            }
+            return entry.Line;
+        }
+
         // =====================================================
         // 4.3 ПОСТРОЕНИЕ КОНТУРА С УЧЁТОМ СОЕДИНЕНИЙ
         // =====================================================
@@ -477,6 +481,50 @@ namespace winrt::estimate1
         // ВСПОМОГАТЕЛЬНЫЕ МЕТОДЫ
         // =====================================================
 
+        struct CachedLine
+        {
+            const Wall* Source{ nullptr };
+            uint64_t Revision{ 0 };
+            AttachmentLine Line;
+        };
+
+        mutable std::unordered_map<uint64_t, CachedLine> m_lineCache;
+
+        // Entries of erased walls pile up; start over once they dominate
+        void TrimLineCache(size_t wallCount) const
+        {
+            if (m_lineCache.size() > wallCount * 2 + 64)
+                m_lineCache.clear();
+        }
+
+        // Joins at the ends of wall and crossings in the middle with one candidate
+        void AppendJoins(const Wall& wall, const AttachmentLine& line1, const Wall& other,
+            double tolerance, std::vector<AttachmentJoinInfo>& results) const
+        {
+            const AttachmentLine& line2 = GetCachedAttachmentLine(other);
+
+            // Проверка соединения в начале wall
+            if (wall.IsJoinAllowedAtStart())
+            {
+                auto join = DetectJoin(wall, true, line1, other, line2, tolerance);
+                if (join.IsValid())
+                    results.push_back(join);
+            }
+
+            // Проверка соединения в конце wall
+            if (wall.IsJoinAllowedAtEnd())
+            {
+                auto join = DetectJoin(wall, false, line1, other, line2, tolerance);
+                if (join.IsValid())
+                    results.push_back(join);
+            }
+
+            // Дополнительная проверка: X-стыки и коллинеарность (середина-середина)
+            auto midJoin = DetectCrossOrCollinear(wall, line1, other, line2, tolerance);
+            if (midJoin.IsValid())
+                results.push_back(midJoin);
+        }
+
         // Конвертация LocationLineMode → WallAttachmentMode
         static WallAttachmentMode ConvertLocationLineMode(LocationLineMode mode)
         {
@@ -0,0 +1,378 @@
+#pragma once
+
+#include "pch.h"
+#include "Models.h"
+#include "WallStore.h"
+#include "RobustPredicates.h"
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <algorithm>
+#include <cmath>
+
+namespace winrt::estimate1
+{
+    // =================================================================
+    // WALL GRAPH - welded vertex graph of the wall axes
+    // =================================================================
+    // Wall endpoints closer than the weld tolerance share one node, and
+    // wall axes are split where they cross or where another wall ends on
+    // them (T-junction). Room detection walks the faces of this graph;
+    // joins and snapping ask it which walls meet at a point.
+    //
+    // DocumentModel builds it once per document revision (GetWallGraph).
+    // =================================================================
+
+    // Spatial hash on tolerance-sized cells. A point is welded to an
+    // existing vertex in one of the 3x3 cells around it, so lookups are
+    // O(1) on average regardless of the number of vertices.
+    class VertexWelder
+    {
+    public:
+        explicit VertexWelder(double tolerance = 5.0)
+            : m_tolerance(tolerance)
+            , m_cellSize((std::max)(tolerance, 1e-6))
+        {
+        }
+
+        double GetTolerance() const { return m_tolerance; }
+
+        const std::vector<WorldPoint>& GetVertices() const { return m_vertices; }
+        size_t Size() const { return m_vertices.size(); }
+
+        void Reserve(size_t n)
+        {
+            m_vertices.reserve(n);
+            m_cells.reserve(n);
+        }
+
+        // Index of the vertex within tolerance of p, adding p if there is none
+        int Weld(const WorldPoint& p)
+        {
+            int found = Find(p, m_tolerance);
+            if (found >= 0)
+                return found;
+
+            int index = static_cast<int>(m_vertices.size());
+            m_vertices.push_back(p);
+            m_cells[Key(CellOf(p.X), CellOf(p.Y))].push_back(index);
+            return index;
+        }
+
+        // Nearest vertex within radius, -1 if none
+        int Find(const WorldPoint& p, double radius) const
+        {
+            int best = -1;
+            double bestDist = radius;
+            ForEachNear(p, radius, [&](int i, double d) {
+                if (d <= bestDist) { bestDist = d; best = i; }
+            });
+            return best;
+        }
+
+        // fn(index, distance) for every vertex within radius of p
+        template <typename Fn>
+        void ForEachNear(const WorldPoint& p, double radius, Fn&& fn) const
+        {
+            int64_t reach = static_cast<int64_t>(std::ceil(radius / m_cellSize));
+
+            // A huge radius would visit more cells than there are vertices
+            if ((2 * reach + 1) * (2 * reach + 1) > static_cast<int64_t>(m_vertices.size()) + 9)
+            {
+                for (int i = 0; i < static_cast<int>(m_vertices.size()); ++i)
+                {
+                    double d = m_vertices[i].Distance(p);
+                    if (d <= radius) fn(i, d);
+                }
+                return;
+            }
+
+            int64_t cx = CellOf(p.X);
+            int64_t cy = CellOf(p.Y);
+            for (int64_t y = cy - reach; y <= cy + reach; ++y)
+            {
+                for (int64_t x = cx - reach; x <= cx + reach; ++x)
+                {
+                    auto it = m_cells.find(Key(x, y));
+                    if (it == m_cells.end())
+                        continue;
+                    for (int i : it->second)
+                    {
+                        double d = m_vertices[i].Distance(p);
+                        if (d <= radius) fn(i, d);
+                    }
+                }
+            }
+        }
+
+    private:
+        int64_t CellOf(double v) const { return static_cast<int64_t>(std::floor(v / m_cellSize)); }
+
+        static uint64_t Key(int64_t x, int64_t y)
+        {
+            return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(y);
+        }
+
+        double m_tolerance;
+        double m_cellSize;
+        std::vector<WorldPoint> m_vertices;
+        std::unordered_map<uint64_t, std::vector<int>> m_cells;
+    };
+
+    class WallGraph
+    {
+    public:
+        static constexpr double DefaultTolerance = 5.0;   // mm
+
+        struct Edge
+        {
+            int A{ 0 };
+            int B{ 0 };
+            uint64_t WallId{ 0 };
+        };
+
+        WallGraph() = default;
+
+        static WallGraph Build(const WallHotData& walls, double tolerance = DefaultTolerance)
+        {
+            WallGraph graph;
+            graph.m_welder = VertexWelder(tolerance);
+
+            // Wall axes long enough to matter
+            std::vector<size_t> segments;
+            segments.reserve(walls.Size());
+            for (size_t w = 0; w < walls.Size(); ++w)
+            {
+                if (walls.GetStart(w).Distance(walls.GetEnd(w)) > tolerance)
+                    segments.push_back(w);
+            }
+
+            // Split parameters along each segment (0 and 1 are the ends)
+            std::vector<std::vector<double>> splits(segments.size(), std::vector<double>{ 0.0, 1.0 });
+            CollectSplits(walls, segments, tolerance, splits);
+
+            graph.m_welder.Reserve(segments.size() * 2);
+            graph.m_edges.reserve(segments.size());
+
+            std::unordered_set<uint64_t> edgeKeys;
+            edgeKeys.reserve(segments.size() * 2);
+
+            for (size_t s = 0; s < segments.size(); ++s)
+            {
+                size_t w = segments[s];
+                WorldPoint a = walls.GetStart(w);
+                WorldPoint b = walls.GetEnd(w);
+
+                std::vector<double>& ts = splits[s];
+                std::sort(ts.begin(), ts.end());
+
+                int prev = -1;
+                for (double t : ts)
+                {
+                    int node = graph.m_welder.Weld(WorldPoint(a.X + (b.X - a.X) * t, a.Y + (b.Y - a.Y) * t));
+                    graph.AddWallAt(node, walls.Ids[w], t == 0.0 || t == 1.0);
+
+                    if (prev >= 0 && node != prev)
+                    {
+                        // Overlapping walls would give the same edge twice
+                        uint64_t lo = static_cast<uint64_t>((std::min)(prev, node));
+                        uint64_t hi = static_cast<uint64_t>((std::max)(prev, node));
+                        if (edgeKeys.insert((lo << 32) | hi).second)
+                            graph.m_edges.push_back({ prev, node, walls.Ids[w] });
+                    }
+                    prev = node;
+                }
+            }
+
+            return graph;
+        }
+
+        double GetTolerance() const { return m_welder.GetTolerance(); }
+
+        const std::vector<WorldPoint>& GetNodes() const { return m_welder.GetVertices(); }
+        const std::vector<Edge>& GetEdges() const { return m_edges; }
+        size_t GetNodeCount() const { return m_welder.Size(); }
+
+        // Nearest node within radius, -1 if none
+        int FindNode(const WorldPoint& p, double radius) const { return m_welder.Find(p, radius); }
+
+        template <typename Fn>
+        void ForEachNodeNear(const WorldPoint& p, double radius, Fn&& fn) const
+        {
+            m_welder.ForEachNear(p, radius, std::forward<Fn>(fn));
+        }
+
+        // True if some wall starts or ends here, false for pure crossings
+        bool IsWallEnd(int node) const
+        {
+            return node >= 0 && node < static_cast<int>(m_nodeIsEnd.size()) && m_nodeIsEnd[node];
+        }
+
+        // Walls that end at, start at, or pass through the node
+        const std::vector<uint64_t>& GetWallsAt(int node) const
+        {
+            static const std::vector<uint64_t> empty;
+            if (node < 0 || node >= static_cast<int>(m_nodeWalls.size()))
+                return empty;
+            return m_nodeWalls[node];
+        }
+
+        std::vector<uint64_t> GetWallsAt(const WorldPoint& p) const
+        {
+            return GetWallsAt(FindNode(p, GetTolerance()));
+        }
+
+    private:
+        void AddWallAt(int node, uint64_t wallId, bool isEnd)
+        {
+            if (node >= static_cast<int>(m_nodeWalls.size()))
+            {
+                m_nodeWalls.resize(node + 1);
+                m_nodeIsEnd.resize(node + 1, false);
+            }
+            if (isEnd)
+                m_nodeIsEnd[node] = true;
+
+            // A wall is added once per node it touches; a short list suffices
+            auto& ids = m_nodeWalls[node];
+            if (std::find(ids.begin(), ids.end(), wallId) == ids.end())
+                ids.push_back(wallId);
+        }
+
+        // Crossings and T-junctions between wall axes. Segment boxes,
+        // grown by the tolerance, are bucketed in a uniform grid about one
+        // segment long per cell; only segments sharing a cell are tested.
+        // Unlike a sweep along X, long walls do not make every later
+        // segment a candidate. A pair is tested in the first cell its
+        // boxes share, so it is tested once.
+        static void CollectSplits(const WallHotData& walls,
+            const std::vector<size_t>& segments,
+            double tolerance,
+            std::vector<std::vector<double>>& splits)
+        {
+            size_t count = segments.size();
+            if (count < 2)
+                return;
+
+            struct Box { double MinX, MinY, MaxX, MaxY; };
+            std::vector<Box> boxes(count);
+            double extent = 0.0;
+            for (size_t s = 0; s < count; ++s)
+            {
+                WorldPoint a = walls.GetStart(segments[s]), b = walls.GetEnd(segments[s]);
+                boxes[s] = { (std::min)(a.X, b.X) - tolerance, (std::min)(a.Y, b.Y) - tolerance,
+                    (std::max)(a.X, b.X) + tolerance, (std::max)(a.Y, b.Y) + tolerance };
+                extent += (std::max)(boxes[s].MaxX - boxes[s].MinX, boxes[s].MaxY - boxes[s].MinY);
+            }
+            double cell = (std::max)(extent / count, tolerance * 4);
+
+            struct Range { int64_t X0, Y0, X1, Y1; };
+            std::vector<Range> ranges(count);
+            std::vector<std::pair<uint64_t, uint32_t>> entries;     // (cell key, segment)
+            entries.reserve(count * 4);
+            for (size_t s = 0; s < count; ++s)
+            {
+                Range& r = ranges[s];
+                r = { static_cast<int64_t>(std::floor(boxes[s].MinX / cell)), static_cast<int64_t>(std::floor(boxes[s].MinY / cell)),
+                    static_cast<int64_t>(std::floor(boxes[s].MaxX / cell)), static_cast<int64_t>(std::floor(boxes[s].MaxY / cell)) };
+                for (int64_t y = r.Y0; y <= r.Y1; ++y)
+                    for (int64_t x = r.X0; x <= r.X1; ++x)
+                        entries.emplace_back(CellKey(x, y), static_cast<uint32_t>(s));
+            }
+            std::sort(entries.begin(), entries.end());
+
+            for (size_t first = 0; first < entries.size();)
+            {
+                size_t last = first;
+                while (last < entries.size() && entries[last].first == entries[first].first)
+                    ++last;
+
+                for (size_t m = first; m < last; ++m)
+                {
+                    size_t i = entries[m].second;
+                    for (size_t n = m + 1; n < last; ++n)
+                    {
+                        size_t j = entries[n].second;
+                        const Box& bi = boxes[i];
+                        const Box& bj = boxes[j];
+                        if (bi.MaxX < bj.MinX || bj.MaxX < bi.MinX || bi.MaxY < bj.MinY || bj.MaxY < bi.MinY)
+                            continue;
+
+                        // Only in the lowest cell both ranges cover
+                        const Range& ri = ranges[i];
+                        const Range& rj = ranges[j];
+                        uint64_t firstShared = CellKey((std::max)(ri.X0, rj.X0), (std::max)(ri.Y0, rj.Y0));
+                        if (firstShared != entries[first].first)
+                            continue;
+
+                        SplitPair(walls, segments, j, i, tolerance, splits);
+                    }
+                }
+                first = last;
+            }
+        }
+
+        static uint64_t CellKey(int64_t x, int64_t y)
+        {
+            return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(y);
+        }
+
+        static void SplitPair(const WallHotData& walls,
+            const std::vector<size_t>& segments,
+            size_t i, size_t j,
+            double tolerance,
+            std::vector<std::vector<double>>& splits)
+        {
+            WorldPoint a = walls.GetStart(segments[i]), b = walls.GetEnd(segments[i]);
+            WorldPoint c = walls.GetStart(segments[j]), d = walls.GetEnd(segments[j]);
+
+            // Quick reject on Y
+            if ((std::max)(a.Y, b.Y) + tolerance < (std::min)(c.Y, d.Y) ||
+                (std::max)(c.Y, d.Y) + tolerance < (std::min)(a.Y, b.Y))
+                return;
+
+            // T-junctions: an endpoint of one wall on the interior of the other
+            AddIfOnInterior(c, a, b, tolerance, splits[i]);
+            AddIfOnInterior(d, a, b, tolerance, splits[i]);
+            AddIfOnInterior(a, c, d, tolerance, splits[j]);
+            AddIfOnInterior(b, c, d, tolerance, splits[j]);
+
+            // Proper crossing, decided by exact orientation so that near-
+            // parallel axes split consistently (RobustPredicates.h)
+            double t, u;
+            if (!RobustPredicates::SegmentsCross(a, b, c, d, t, u))
+                return;
+
+            double epsT = tolerance / a.Distance(b);
+            double epsU = tolerance / c.Distance(d);
+            if (t > epsT && t < 1.0 - epsT && u > epsU && u < 1.0 - epsU)
+            {
+                splits[i].push_back(t);
+                splits[j].push_back(u);
+            }
+        }
+
+        static void AddIfOnInterior(const WorldPoint& p, const WorldPoint& a, const WorldPoint& b,
+            double tolerance, std::vector<double>& ts)
+        {
+            double dx = b.X - a.X, dy = b.Y - a.Y;
+            double len2 = dx * dx + dy * dy;
+            if (len2 <= 0.0)
+                return;
+
+            double t = ((p.X - a.X) * dx + (p.Y - a.Y) * dy) / len2;
+            double eps = tolerance / std::sqrt(len2);
+            if (t <= eps || t >= 1.0 - eps)
+                return;
+
+            WorldPoint closest(a.X + dx * t, a.Y + dy * t);
+            if (closest.Distance(p) <= tolerance)
+                ts.push_back(t);
+        }
+
+        VertexWelder m_welder;
+        std::vector<Edge> m_edges;
+        std::vector<std::vector<uint64_t>> m_nodeWalls;
+        std::vector<bool> m_nodeIsEnd;
+    };
+}
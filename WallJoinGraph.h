@@ -0,0 +1,295 @@
+#pragma once
+
+#include "pch.h"
+#include "Models.h"
+#include "WallStore.h"
+#include "WallJoinIndex.h"
+#include "WallAttachmentSystem.h"
+#include "WallJunctionSolver.h"
+#include "ChangeJournal.h"
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <algorithm>
+
+namespace winrt::estimate1
+{
+    // =================================================================
+    // WALL JOIN GRAPH - persistent joins and outlines of the walls
+    // =================================================================
+    // For every wall the graph keeps the joins found from its side
+    // (AttachmentJoinInfo: type, contact ends, corner polygon) and the
+    // outline WallAttachmentSystem::BuildWallContour makes from them, so
+    // renderers and exporters read an outline in O(1) per wall. Ends
+    // joined to two or more walls take their cap from WallJunctionSolver
+    // instead of a pairwise corner polygon.
+    //
+    // After wall edits only pairs involving an edited wall are detected
+    // again: its own joins, and the joins its old and new neighbours
+    // have with it. Outlines are rebuilt for those walls only.
+    //
+    // DocumentModel owns one (GetWallJoinGraph) and shares it with
+    // snapshots; it is copied before a patch while a snapshot holds it.
+    // =================================================================
+
+    class WallJoinGraph
+    {
+    public:
+        explicit WallJoinGraph(double tolerance = 50.0)
+            : m_tolerance(tolerance)
+        {
+        }
+
+        double GetTolerance() const { return m_tolerance; }
+
+        void Rebuild(const WallStore& walls, const WallJoinIndex& index)
+        {
+            m_entries.clear();
+            m_incoming.clear();
+            m_entries.reserve(walls.Size());
+
+            for (const auto& wall : walls)
+            {
+                Entry& entry = m_entries[wall->GetId()];
+                entry.Joins = m_system.FindJoins(*wall, index, m_tolerance);
+                Link(wall->GetId(), entry.Joins);
+            }
+            for (const auto& wall : walls)
+                Refresh(*wall, walls);
+
+            m_lastRefreshed = walls.Size();
+        }
+
+        // Patch after wall changes. The index must already include them.
+        void Update(const WallStore& walls, const WallJoinIndex& index, const ChangeSet& changes)
+        {
+            if (changes.IsFullReset)
+            {
+                Rebuild(walls, index);
+                return;
+            }
+
+            std::unordered_set<uint64_t> changed;
+            changed.insert(changes.Added.begin(), changes.Added.end());
+            changed.insert(changes.Modified.begin(), changes.Modified.end());
+            changed.insert(changes.Removed.begin(), changes.Removed.end());
+
+            // Walls whose join list changed and need a new outline
+            std::unordered_set<uint64_t> touched;
+
+            // Forget every pair involving a changed wall
+            for (uint64_t id : changed)
+            {
+                auto incoming = m_incoming.find(id);
+                if (incoming != m_incoming.end())
+                {
+                    for (uint64_t other : incoming->second)
+                    {
+                        auto it = m_entries.find(other);
+                        if (it == m_entries.end())
+                            continue;
+                        auto& joins = it->second.Joins;
+                        joins.erase(std::remove_if(joins.begin(), joins.end(),
+                            [id](const AttachmentJoinInfo& j) { return j.WallId2 == id; }), joins.end());
+                        touched.insert(other);
+                    }
+                    m_incoming.erase(incoming);
+                }
+
+                auto own = m_entries.find(id);
+                if (own != m_entries.end())
+                {
+                    Unlink(id, own->second.Joins);
+                    m_entries.erase(own);
+                }
+            }
+
+            // Detect the pairs again from both sides
+            for (uint64_t id : changed)
+            {
+                const Wall* wall = walls.FindById(id);
+                if (!wall)
+                    continue;
+
+                Entry& entry = m_entries[id];
+                entry.Joins = m_system.FindJoins(*wall, index, m_tolerance);
+                Link(id, entry.Joins);
+                touched.insert(id);
+
+                index.ForEachCandidate(*wall, m_tolerance, [&](const Wall& other) {
+                    // A changed neighbour finds this pair in its own pass
+                    if (changed.count(other.GetId()))
+                        return;
+                    auto joins = m_system.FindJoinsBetween(other, *wall, m_tolerance);
+                    if (joins.empty())
+                        return;
+                    auto& list = m_entries[other.GetId()].Joins;
+                    list.insert(list.end(), joins.begin(), joins.end());
+                    m_incoming[id].insert(other.GetId());
+                    touched.insert(other.GetId());
+                });
+            }
+
+            m_lastRefreshed = 0;
+            for (uint64_t id : touched)
+            {
+                if (const Wall* wall = walls.FindById(id))
+                {
+                    Refresh(*wall, walls);
+                    ++m_lastRefreshed;
+                }
+            }
+        }
+
+        // Joins found from the side of the wall (it is WallId1)
+        const std::vector<AttachmentJoinInfo>& GetJoins(uint64_t wallId) const
+        {
+            static const std::vector<AttachmentJoinInfo> empty;
+            auto it = m_entries.find(wallId);
+            return it != m_entries.end() ? it->second.Joins : empty;
+        }
+
+        // Plan outline with the join corners applied; empty if unknown
+        const std::vector<WorldPoint>& GetContour(uint64_t wallId) const
+        {
+            static const std::vector<WorldPoint> empty;
+            auto it = m_entries.find(wallId);
+            return it != m_entries.end() ? it->second.Contour : empty;
+        }
+
+        size_t GetWallCount() const { return m_entries.size(); }
+
+        size_t GetJoinCount() const
+        {
+            size_t count = 0;
+            for (const auto& entry : m_entries)
+                count += entry.second.Joins.size();
+            return count;
+        }
+
+        // Outlines rebuilt by the last Rebuild or Update
+        size_t GetLastRefreshedCount() const { return m_lastRefreshed; }
+
+    private:
+        struct Entry
+        {
+            std::vector<AttachmentJoinInfo> Joins;
+            std::vector<WorldPoint> Contour;
+        };
+
+        // Same join order whether a list was built at once or patched
+        void Refresh(const Wall& wall, const WallStore& walls)
+        {
+            Entry& entry = m_entries[wall.GetId()];
+            std::stable_sort(entry.Joins.begin(), entry.Joins.end(),
+                [](const AttachmentJoinInfo& a, const AttachmentJoinInfo& b) { return a.WallId2 < b.WallId2; });
+
+            bool startJunction = CountPartnersAt(entry.Joins, AttachmentJoinInfo::ContactType::Start) >= 2;
+            bool endJunction = CountPartnersAt(entry.Joins, AttachmentJoinInfo::ContactType::End) >= 2;
+            if (!startJunction && !endJunction)
+            {
+                entry.Contour = m_system.BuildWallContour(wall, entry.Joins);
+                return;
+            }
+
+            // Pairwise outline for the other end; a junction end comes out
+            // as the two plain corners and is replaced by the solved cap
+            std::vector<AttachmentJoinInfo> pairwise;
+            for (const auto& join : entry.Joins)
+            {
+                if ((startJunction && join.Wall1Contact == AttachmentJoinInfo::ContactType::Start) ||
+                    (endJunction && join.Wall1Contact == AttachmentJoinInfo::ContactType::End))
+                    continue;
+                pairwise.push_back(join);
+            }
+            std::vector<WorldPoint> base = m_system.BuildWallContour(wall, pairwise);
+
+            std::vector<WorldPoint> contour;
+            contour.reserve(base.size() + 2);
+            if (startJunction)
+                SolveCap(wall, true, entry.Joins, walls).AppendTo(contour);
+            contour.insert(contour.end(), base.begin() + (startJunction ? 2 : 0), base.end() - (endJunction ? 2 : 0));
+            if (endJunction)
+                SolveCap(wall, false, entry.Joins, walls).AppendTo(contour);
+            entry.Contour = std::move(contour);
+        }
+
+        static size_t CountPartnersAt(const std::vector<AttachmentJoinInfo>& joins, AttachmentJoinInfo::ContactType contact)
+        {
+            size_t count = 0;
+            uint64_t last = 0;
+            for (const auto& join : joins)
+            {
+                // Sorted by partner, so repeats are adjacent
+                if (join.Wall1Contact == contact && join.WallId2 != last)
+                {
+                    ++count;
+                    last = join.WallId2;
+                }
+            }
+            return count;
+        }
+
+        // Cap of one wall end from every wall joined there
+        JunctionCap SolveCap(const Wall& wall, bool atStart,
+                             const std::vector<AttachmentJoinInfo>& joins, const WallStore& walls) const
+        {
+            const WorldPoint& node = atStart ? wall.GetStartPoint() : wall.GetEndPoint();
+            auto contact = atStart ? AttachmentJoinInfo::ContactType::Start : AttachmentJoinInfo::ContactType::End;
+
+            std::vector<JunctionArm> arms;
+            WallJunctionSolver::AddArms(wall, node, 0.0, arms);
+            uint64_t last = 0;
+            for (const auto& join : joins)
+            {
+                if (join.Wall1Contact != contact || join.WallId2 == last)
+                    continue;
+                last = join.WallId2;
+                if (const Wall* other = walls.FindById(join.WallId2))
+                    WallJunctionSolver::AddArms(*other, node, m_tolerance, arms);
+            }
+
+            for (const auto& cap : WallJunctionSolver::Solve(node, arms))
+            {
+                if (cap.WallId == wall.GetId() && cap.AtStart == atStart)
+                    return cap;
+            }
+
+            // Degenerate wall: plain corners
+            WorldPoint p1, p2, p3, p4;
+            wall.GetCornerPoints(p1, p2, p3, p4);
+            JunctionCap cap;
+            cap.WallId = wall.GetId();
+            cap.AtStart = atStart;
+            cap.Left = atStart ? p1 : p4;
+            cap.Right = atStart ? p2 : p3;
+            return cap;
+        }
+
+        // m_incoming[b] lists the walls whose join lists mention b
+        void Link(uint64_t id, const std::vector<AttachmentJoinInfo>& joins)
+        {
+            for (const auto& join : joins)
+                m_incoming[join.WallId2].insert(id);
+        }
+
+        void Unlink(uint64_t id, const std::vector<AttachmentJoinInfo>& joins)
+        {
+            for (const auto& join : joins)
+            {
+                auto it = m_incoming.find(join.WallId2);
+                if (it == m_incoming.end())
+                    continue;
+                it->second.erase(id);
+                if (it->second.empty())
+                    m_incoming.erase(it);
+            }
+        }
+
+        double m_tolerance;
+        WallAttachmentSystem m_system;
+        std::unordered_map<uint64_t, Entry> m_entries;
+        std::unordered_map<uint64_t, std::unordered_set<uint64_t>> m_incoming;
+        size_t m_lastRefreshed{ 0 };
+    };
+}
@@ -0,0 +1,328 @@
+#pragma once
+
+#include "pch.h"
+#include "Models.h"
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <algorithm>
+#include <cmath>
+
+namespace winrt::estimate1
+{
+    // =================================================================
+    // WALL JOIN INDEX - walls that can join a given wall
+    // =================================================================
+    // Uniform grid over wall footprints: the axis box grown by half the
+    // thickness, so the attachment lines of every location line mode
+    // lie inside it. A join query visits only the cells around the
+    // queried wall instead of every wall in the plan.
+    //
+    // Shared by WallJoinSystem, WallAttachmentSystem and WallJoinManager.
+    // DocumentModel keeps one and patches it from the change journal
+    // (GetWallJoinIndex); the systems' FindAllJoins build one per call.
+    // =================================================================
+
+    class WallJoinIndex
+    {
+    public:
+        WallJoinIndex() = default;
+
+        explicit WallJoinIndex(const std::vector<std::unique_ptr<Wall>>& walls)
+        {
+            Build(walls);
+        }
+
+        void Build(const std::vector<std::unique_ptr<Wall>>& walls)
+        {
+            Clear();
+            m_walls.reserve(walls.size());
+            m_boxes.reserve(walls.size());
+            for (const auto& wall : walls)
+            {
+                if (!wall) continue;
+                m_slotOf[wall->GetId()] = static_cast<uint32_t>(m_walls.size());
+                m_walls.push_back(wall.get());
+                m_boxes.push_back(Footprint(*wall, 0.0));
+                m_extentSum += Extent(m_boxes.back());
+            }
+            Regrid();
+        }
+
+        void Clear()
+        {
+            m_walls.clear();
+            m_boxes.clear();
+            m_cells.clear();
+            m_large.clear();
+            m_free.clear();
+            m_slotOf.clear();
+            m_extentSum = 0.0;
+        }
+
+        // Incremental edits (DocumentModel patches its index from the
+        // change journal). The grid is re-laid when the average wall size
+        // drifts far from the cell size.
+        void Insert(const Wall& wall)
+        {
+            if (m_slotOf.count(wall.GetId()))
+            {
+                Update(wall);
+                return;
+            }
+
+            uint32_t slot;
+            if (!m_free.empty())
+            {
+                slot = m_free.back();
+                m_free.pop_back();
+                m_walls[slot] = &wall;
+                m_boxes[slot] = Footprint(wall, 0.0);
+            }
+            else
+            {
+                slot = static_cast<uint32_t>(m_walls.size());
+                m_walls.push_back(&wall);
+                m_boxes.push_back(Footprint(wall, 0.0));
+            }
+            m_slotOf[wall.GetId()] = slot;
+            m_extentSum += Extent(m_boxes[slot]);
+
+            double cell = AverageExtent();
+            if (Size() >= RegridMinWalls && (cell > m_cellSize * 2.0 || cell < m_cellSize * 0.5))
+                Regrid();
+            else
+                AddToGrid(slot);
+        }
+
+        void Remove(uint64_t wallId)
+        {
+            auto it = m_slotOf.find(wallId);
+            if (it == m_slotOf.end())
+                return;
+
+            uint32_t slot = it->second;
+            RemoveFromGrid(slot);
+            m_extentSum -= Extent(m_boxes[slot]);
+            m_walls[slot] = nullptr;
+            m_free.push_back(slot);
+            m_slotOf.erase(it);
+        }
+
+        // Re-read the footprint of a wall already in the index
+        void Update(const Wall& wall)
+        {
+            auto it = m_slotOf.find(wall.GetId());
+            if (it == m_slotOf.end())
+            {
+                Insert(wall);
+                return;
+            }
+
+            uint32_t slot = it->second;
+            RemoveFromGrid(slot);
+            m_extentSum -= Extent(m_boxes[slot]);
+            m_walls[slot] = &wall;
+            m_boxes[slot] = Footprint(wall, 0.0);
+            m_extentSum += Extent(m_boxes[slot]);
+            AddToGrid(slot);
+        }
+
+        bool Contains(uint64_t wallId) const { return m_slotOf.count(wallId) != 0; }
+
+        size_t Size() const { return m_slotOf.size(); }
+        bool Empty() const { return m_slotOf.empty(); }
+
+        // fn(other) once for every indexed wall, other than wall itself,
+        // whose footprint comes within tolerance of the footprint of wall
+        template <typename Fn>
+        void ForEachCandidate(const Wall& wall, double tolerance, Fn&& fn) const
+        {
+            if (Empty())
+                return;
+
+            Box query = Footprint(wall, tolerance);
+            std::vector<uint32_t> found;
+            Collect(query, found);
+
+            for (uint32_t i : found)
+            {
+                if (m_walls[i]->GetId() != wall.GetId())
+                    fn(*m_walls[i]);
+            }
+        }
+
+        // fn(wall) once for every indexed wall whose footprint comes within
+        // radius of p
+        template <typename Fn>
+        void ForEachNear(const WorldPoint& p, double radius, Fn&& fn) const
+        {
+            if (Empty())
+                return;
+
+            std::vector<uint32_t> found;
+            Collect({ p.X - radius, p.Y - radius, p.X + radius, p.Y + radius }, found);
+            for (uint32_t i : found)
+                fn(*m_walls[i]);
+        }
+
+        // ForEachCandidate over a plain wall list, for one-off queries
+        // where building the grid would cost more than it saves
+        template <typename Fn>
+        static void ForEachCandidate(const Wall& wall,
+            const std::vector<std::unique_ptr<Wall>>& walls,
+            double tolerance,
+            Fn&& fn)
+        {
+            Box query = Footprint(wall, tolerance);
+            for (const auto& other : walls)
+            {
+                if (other && other->GetId() != wall.GetId() && Footprint(*other, 0.0).Overlaps(query))
+                    fn(*other);
+            }
+        }
+
+    private:
+        static constexpr double MinCellSize = 100.0;        // mm
+        static constexpr int64_t MaxCellsPerWall = 64;
+        static constexpr size_t RegridMinWalls = 16;
+
+        struct Box
+        {
+            double MinX, MinY, MaxX, MaxY;
+
+            bool Overlaps(const Box& o) const
+            {
+                return MinX <= o.MaxX && o.MinX <= MaxX && MinY <= o.MaxY && o.MinY <= MaxY;
+            }
+        };
+
+        static Box Footprint(const Wall& wall, double margin)
+        {
+            const WorldPoint& a = wall.GetStartPoint();
+            const WorldPoint& b = wall.GetEndPoint();
+            double grow = wall.GetThickness() / 2.0 + margin;
+            return { (std::min)(a.X, b.X) - grow, (std::min)(a.Y, b.Y) - grow,
+                     (std::max)(a.X, b.X) + grow, (std::max)(a.Y, b.Y) + grow };
+        }
+
+        // Indices of walls whose footprint overlaps the box, ascending
+        void Collect(const Box& query, std::vector<uint32_t>& found) const
+        {
+            int64_t x0 = CellOf(query.MinX), x1 = CellOf(query.MaxX);
+            int64_t y0 = CellOf(query.MinY), y1 = CellOf(query.MaxY);
+
+            if ((x1 - x0 + 1) * (y1 - y0 + 1) > static_cast<int64_t>(m_cells.size()))
+            {
+                // Query larger than the plan: scanning the boxes is cheaper
+                for (uint32_t i = 0; i < m_boxes.size(); ++i)
+                    if (m_walls[i] && m_boxes[i].Overlaps(query)) found.push_back(i);
+                return;
+            }
+
+            for (int64_t y = y0; y <= y1; ++y)
+            {
+                for (int64_t x = x0; x <= x1; ++x)
+                {
+                    auto it = m_cells.find(Key(x, y));
+                    if (it == m_cells.end())
+                        continue;
+                    for (uint32_t i : it->second)
+                        if (m_boxes[i].Overlaps(query)) found.push_back(i);
+                }
+            }
+            for (uint32_t i : m_large)
+                if (m_boxes[i].Overlaps(query)) found.push_back(i);
+
+            // A wall spanning several cells is seen once per cell
+            std::sort(found.begin(), found.end());
+            found.erase(std::unique(found.begin(), found.end()), found.end());
+        }
+
+        static double Extent(const Box& box)
+        {
+            return (std::max)(box.MaxX - box.MinX, box.MaxY - box.MinY);
+        }
+
+        double AverageExtent() const
+        {
+            return m_slotOf.empty() ? MinCellSize : m_extentSum / m_slotOf.size();
+        }
+
+        // Cells about one wall long: a wall touches a few cells and a
+        // cell holds a few walls
+        void Regrid()
+        {
+            m_cells.clear();
+            m_large.clear();
+            m_cellSize = (std::max)(AverageExtent(), MinCellSize);
+            m_cells.reserve(Size() * 2);
+            for (const auto& entry : m_slotOf)
+                AddToGrid(entry.second);
+        }
+
+        void AddToGrid(uint32_t slot)
+        {
+            const Box& box = m_boxes[slot];
+            int64_t x0 = CellOf(box.MinX), x1 = CellOf(box.MaxX);
+            int64_t y0 = CellOf(box.MinY), y1 = CellOf(box.MaxY);
+
+            // Walls spanning much of the plan are checked by every query
+            if ((x1 - x0 + 1) * (y1 - y0 + 1) > MaxCellsPerWall)
+            {
+                m_large.push_back(slot);
+                return;
+            }
+            for (int64_t y = y0; y <= y1; ++y)
+                for (int64_t x = x0; x <= x1; ++x)
+                    m_cells[Key(x, y)].push_back(slot);
+        }
+
+        void RemoveFromGrid(uint32_t slot)
+        {
+            auto drop = [slot](std::vector<uint32_t>& list) {
+                auto it = std::find(list.begin(), list.end(), slot);
+                if (it == list.end())
+                    return false;
+                *it = list.back();
+                list.pop_back();
+                return true;
+            };
+
+            if (drop(m_large))
+                return;
+
+            const Box& box = m_boxes[slot];
+            int64_t x0 = CellOf(box.MinX), x1 = CellOf(box.MaxX);
+            int64_t y0 = CellOf(box.MinY), y1 = CellOf(box.MaxY);
+            for (int64_t y = y0; y <= y1; ++y)
+            {
+                for (int64_t x = x0; x <= x1; ++x)
+                {
+                    auto it = m_cells.find(Key(x, y));
+                    if (it == m_cells.end())
+                        continue;
+                    drop(it->second);
+                    if (it->second.empty())
+                        m_cells.erase(it);
+                }
+            }
+        }
+
+        int64_t CellOf(double v) const { return static_cast<int64_t>(std::floor(v / m_cellSize)); }
+
+        static uint64_t Key(int64_t x, int64_t y)
+        {
+            return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(y);
+        }
+
+        double m_cellSize{ MinCellSize };
+        std::vector<const Wall*> m_walls;                   // by slot, nullptr when free
+        std::vector<Box> m_boxes;
+        std::unordered_map<uint64_t, std::vector<uint32_t>> m_cells;
+        std::vector<uint32_t> m_large;
+        std::vector<uint32_t> m_free;                       // slots of removed walls
+        std::unordered_map<uint64_t, uint32_t> m_slotOf;    // wall id -> slot
+        double m_extentSum{ 0.0 };
+    };
+}
@@ -3,6 +3,7 @@
 #include "pch.h"
 #include "Models.h"
 #include "Element.h"
+#include "WallJoinIndex.h"
 #include <cmath>
 #include <vector>
 #include <algorithm>
@@ -44,36 +45,34 @@ namespace winrt::estimate1
             const std::vector<std::unique_ptr<Wall>>& allWalls)
         {
             std::vector<WallJoinResult> results;
-            
-            WorldPoint start = wall.GetStartPoint();
-            WorldPoint end = wall.GetEndPoint();
-
-            for (const auto& other : allWalls)
-            {
-                if (!other || other->GetId() == wall.GetId())
-                    continue;
+            WallJoinIndex::ForEachCandidate(wall, allWalls, m_joinTolerance, [&](const Wall& other) {
+                AppendJoins(wall, other, results);
+            });
+            return results;
+        }
 
-                // ��������� ���������� � ������ ������� �����
-                if (wall.IsJoinAllowedAtStart())
-                {
-                    auto joinResult = CheckJoinAtPoint(start, true, wall, *other);
-                    if (joinResult.joinType != WallJoinType::None)
-                    {
-                        results.push_back(joinResult);
-                    }
-                }
+        // Same with an index: only walls within join tolerance are tested
+        std::vector<WallJoinResult> FindJoins(const Wall& wall, const WallJoinIndex& index)
+        {
+            std::vector<WallJoinResult> results;
+            index.ForEachCandidate(wall, m_joinTolerance, [&](const Wall& other) {
+                AppendJoins(wall, other, results);
+            });
+            return results;
+        }
 
-                // ��������� ���������� � ����� ������� �����
-                if (wall.IsJoinAllowedAtEnd())
-                {
-                    auto joinResult = CheckJoinAtPoint(end, false, wall, *other);
-                    if (joinResult.joinType != WallJoinType::None)
-                    {
-                        results.push_back(joinResult);
-                    }
-                }
+        // Joins of every wall in the plan, near-linear in the wall count
+        std::vector<WallJoinResult> FindAllJoins(const std::vector<std::unique_ptr<Wall>>& allWalls)
+        {
+            WallJoinIndex index(allWalls);
+            std::vector<WallJoinResult> results;
+            for (const auto& wall : allWalls)
+            {
+                if (!wall) continue;
+                index.ForEachCandidate(*wall, m_joinTolerance, [&](const Wall& other) {
+                    AppendJoins(*wall, other, results);
+                });
             }
-
             return results;
         }
 
@@ -119,22 +118,8 @@ namespace winrt::estimate1
             const WorldPoint& p3, const WorldPoint& p4,
             WorldPoint& intersection)
         {
-            double x1 = p1.X, y1 = p1.Y;
-            double x2 = p2.X, y2 = p2.Y;
-            double x3 = p3.X, y3 = p3.Y;
-            double x4 = p4.X, y4 = p4.Y;
-
-            double denom = (x1 - x2) * (y3 - y4) - (y1 - y2) * (x3 - x4);
-            
-            if (std::abs(denom) < 0.0001)
-                return false; // ������������ �����
-
-            double t = ((x1 - x3) * (y3 - y4) - (y1 - y3) * (x3 - x4)) / denom;
-            
-            intersection.X = x1 + t * (x2 - x1);
-            intersection.Y = y1 + t * (y2 - y1);
-            
-            return true;
+            double t1, t2;
+            return GeometryKernels::LineIntersection(p1, p2, p3, p4, intersection, t1, t2);
         }
 
         // ���������, ��������� �� ����� �� �������
@@ -154,6 +139,33 @@ namespace winrt::estimate1
     private:
         double m_joinTolerance{ 50.0 }; // ��
 
+        // Joins at the start and end of wall with one candidate
+        void AppendJoins(const Wall& wall, const Wall& other, std::vector<WallJoinResult>& results)
+        {
+            WorldPoint start = wall.GetStartPoint();
+            WorldPoint end = wall.GetEndPoint();
+
+            // ��������� ���������� � ������ ������� �����
+            if (wall.IsJoinAllowedAtStart())
+            {
+                auto joinResult = CheckJoinAtPoint(start, true, wall, other);
+                if (joinResult.joinType != WallJoinType::None)
+                {
+                    results.push_back(joinResult);
+                }
+            }
+
+            // ��������� ���������� � ����� ������� �����
+            if (wall.IsJoinAllowedAtEnd())
+            {
+                auto joinResult = CheckJoinAtPoint(end, false, wall, other);
+                if (joinResult.joinType != WallJoinType::None)
+                {
+                    results.push_back(joinResult);
+                }
+            }
+        }
+
         // ��������� ���������� � ���������� �����
         WallJoinResult CheckJoinAtPoint(
             const WorldPoint& point,
@@ -187,7 +199,7 @@ namespace winrt::estimate1
             }
 
             // ��������� ���������� � �������� ������ ����� (T-join)
-            double distToSegment = DistancePointToSegment(point, otherStart, otherEnd);
+            double distToSegment = GeometryKernels::DistancePointToSegment(point, otherStart, otherEnd);
             if (distToSegment < m_joinTolerance)
             {
                 // ���������, ��� ����� �� ������� ������ � ������
@@ -210,24 +222,6 @@ namespace winrt::estimate1
             return result;
         }
 
-        // ���������� �� ����� �� �������
-        static double DistancePointToSegment(const WorldPoint& point, const WorldPoint& segStart, const WorldPoint& segEnd)
-        {
-            double dx = segEnd.X - segStart.X;
-            double dy = segEnd.Y - segStart.Y;
-            double lengthSq = dx * dx + dy * dy;
-
-            if (lengthSq < 0.0001)
-                return point.Distance(segStart);
-
-            double t = std::clamp(
-                ((point.X - segStart.X) * dx + (point.Y - segStart.Y) * dy) / lengthSq,
-                0.0, 1.0);
-
-            WorldPoint closest(segStart.X + t * dx, segStart.Y + t * dy);
-            return point.Distance(closest);
-        }
-
         // �������� ����� �� �������
         static WorldPoint ProjectPointOnSegment(const WorldPoint& point, const WorldPoint& segStart, const WorldPoint& segEnd)
         {
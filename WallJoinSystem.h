@@ -4,6 +4,8 @@
 #include "pch.h"
 #include "Models.h"
 #include "Camera.h"
+#include "WallJoinIndex.h"
+#include "TextLayoutCache.h"
 #include <cmath>
 #include <vector>
 #include <array>
@@ -100,23 +102,7 @@ namespace winrt::estimate1
             double& t1,     // �������� �� ������ ����� (0-1 = �� �������)
             double& t2)     // �������� �� ������ �����
         {
-            double x1 = p1.X, y1 = p1.Y;
-            double x2 = p2.X, y2 = p2.Y;
-            double x3 = p3.X, y3 = p3.Y;
-            double x4 = p4.X, y4 = p4.Y;
-
-            double denom = (x1 - x2) * (y3 - y4) - (y1 - y2) * (x3 - x4);
-
-            if (std::abs(denom) < 1e-10)
-                return false;   // ������������ �����
-
-            t1 = ((x1 - x3) * (y3 - y4) - (y1 - y3) * (x3 - x4)) / denom;
-            t2 = -((x1 - x2) * (y1 - y3) - (y1 - y2) * (x1 - x3)) / denom;
-
-            intersection.X = x1 + t1 * (x2 - x1);
-            intersection.Y = y1 + t1 * (y2 - y1);
-
-            return true;
+            return GeometryKernels::LineIntersection(p1, p2, p3, p4, intersection, t1, t2);
         }
 
         // ���������� ������
@@ -236,29 +222,34 @@ namespace winrt::estimate1
             const std::vector<std::unique_ptr<Wall>>& allWalls) const
         {
             std::vector<JoinInfo> results;
+            WallJoinIndex::ForEachCandidate(wall, allWalls, m_settings.JoinTolerance, [&](const Wall& other) {
+                AppendJoins(wall, other, results);
+            });
+            return results;
+        }
 
-            for (const auto& other : allWalls)
-            {
-                if (!other || other->GetId() == wall.GetId())
-                    continue;
-
-                // ��������� ���������� � ������ wall
-                if (wall.IsJoinAllowedAtStart())
-                {
-                    auto join = DetectJoinType(wall, true, *other);
-                    if (join.IsValid())
-                        results.push_back(join);
-                }
+        // Same with an index: only walls within join tolerance are tested
+        std::vector<JoinInfo> FindJoins(const Wall& wall, const WallJoinIndex& index) const
+        {
+            std::vector<JoinInfo> results;
+            index.ForEachCandidate(wall, m_settings.JoinTolerance, [&](const Wall& other) {
+                AppendJoins(wall, other, results);
+            });
+            return results;
+        }
 
-                // ��������� ���������� � ����� wall
-                if (wall.IsJoinAllowedAtEnd())
-                {
-                    auto join = DetectJoinType(wall, false, *other);
-                    if (join.IsValid())
-                        results.push_back(join);
-                }
+        // Joins of every wall in the plan, near-linear in the wall count
+        std::vector<JoinInfo> FindAllJoins(const std::vector<std::unique_ptr<Wall>>& allWalls) const
+        {
+            WallJoinIndex index(allWalls);
+            std::vector<JoinInfo> results;
+            for (const auto& wall : allWalls)
+            {
+                if (!wall) continue;
+                index.ForEachCandidate(*wall, m_settings.JoinTolerance, [&](const Wall& other) {
+                    AppendJoins(*wall, other, results);
+                });
             }
-
             return results;
         }
 
@@ -302,7 +293,7 @@ namespace winrt::estimate1
             }
 
             // �������� T-join (����� wall1 �� ���� wall2)
-            double distToWall2 = DistancePointToSegment(p1, start2, end2);
+            double distToWall2 = GeometryKernels::DistancePointToSegment(p1, start2, end2);
             if (distToWall2 < tolerance)
             {
                 // �������� ��� ����� �� � ������ wall2
@@ -532,22 +523,22 @@ namespace winrt::estimate1
     private:
         JoinSettings m_settings;
 
-        // ���������� �� ����� �� �������
-        static double DistancePointToSegment(const WorldPoint& point, const WorldPoint& segStart, const WorldPoint& segEnd)
+        // Joins at the start and end of wall with one candidate
+        void AppendJoins(const Wall& wall, const Wall& other, std::vector<JoinInfo>& results) const
         {
-            double dx = segEnd.X - segStart.X;
-            double dy = segEnd.Y - segStart.Y;
-            double lengthSq = dx * dx + dy * dy;
-
-            if (lengthSq < 1e-10)
-                return point.Distance(segStart);
-
-            double t = std::clamp(
-                ((point.X - segStart.X) * dx + (point.Y - segStart.Y) * dy) / lengthSq,
-                0.0, 1.0);
+            if (wall.IsJoinAllowedAtStart())
+            {
+                auto join = DetectJoinType(wall, true, other);
+                if (join.IsValid())
+                    results.push_back(join);
+            }
 
-            WorldPoint closest(segStart.X + t * dx, segStart.Y + t * dy);
-            return point.Distance(closest);
+            if (wall.IsJoinAllowedAtEnd())
+            {
+                auto join = DetectJoinType(wall, false, other);
+                if (join.IsValid())
+                    results.push_back(join);
+            }
         }
 
         // �������� ����� �� �����
@@ -822,14 +813,9 @@ namespace winrt::estimate1
             float textY = center.Y - 20.0f;
 
             // ��� ��� ������
-            auto textFormat = Microsoft::Graphics::Canvas::Text::CanvasTextFormat();
-            textFormat.FontSize(11);
-
-            auto textLayout = Microsoft::Graphics::Canvas::Text::CanvasTextLayout(
-                session.Device(),
-                angleText,
-                textFormat,
-                100, 30);
+            auto textLayout = TextLayoutCache::Shared().GetLayout(
+                session, angleText, DisplayFont::Default, 11.0f,
+                DisplayTextAlign::TopLeft, 100.0f, 30.0f);
 
             float textWidth = textLayout.LayoutBounds().Width;
             float textHeight = textLayout.LayoutBounds().Height;
@@ -843,11 +829,7 @@ namespace winrt::estimate1
                 ? Windows::UI::ColorHelper::FromArgb(255, 0, 150, 0)     // ������ ��� 90�
                 : Windows::UI::ColorHelper::FromArgb(255, 200, 100, 0); // ��������� ��� ������
 
-            session.DrawText(
-                angleText,
-                textX,
-                textY,
-                textColor);
+            session.DrawTextLayout(textLayout, textX, textY, textColor);
         }
 
         // ��������� ���� ����������
@@ -878,9 +860,8 @@ namespace winrt::estimate1
                 badgeSize / 2,
                 Windows::UI::ColorHelper::FromArgb(200, 60, 60, 60));
 
-            auto textFormat = Microsoft::Graphics::Canvas::Text::CanvasTextFormat();
-            textFormat.FontSize(10);
-            textFormat.HorizontalAlignment(Microsoft::Graphics::Canvas::Text::CanvasHorizontalAlignment::Center);
+            auto textFormat = TextLayoutCache::Shared().GetFormat(
+                DisplayFont::Default, 10.0f, DisplayTextAlign::TopCenter);
 
             session.DrawText(
                 typeName,
@@ -0,0 +1,231 @@
+#pragma once
+
+#include "pch.h"
+#include "Models.h"
+#include "RobustPredicates.h"
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+namespace winrt::estimate1
+{
+    // =================================================================
+    // WALL JUNCTION SOLVER - end caps of all walls meeting at one node
+    // =================================================================
+    // Pairwise joins give each pair of walls its own mitre, so at a node
+    // shared by three or four walls the corner polygons overlap. Here
+    // every wall at the node becomes an arm leaving the node; arms are
+    // sorted by angle and each gap between neighbouring arms closes at
+    // the crossing of their facing wall faces. A wall ending at the node
+    // gets the corner on each side plus the node itself, so the caps of
+    // all walls tile the junction without overlap.
+    //
+    // A wall passing through the node adds an arm each way but gets no
+    // cap: the walls ending on it stop at its faces, and their caps meet
+    // on the face instead of at the node.
+    // =================================================================
+
+    struct JunctionArm
+    {
+        uint64_t WallId{ 0 };
+        bool AtStart{ false };          // the wall starts at the node (else ends there)
+        bool PassesThrough{ false };    // node on the wall's interior, no cap
+        WorldPoint Origin;              // axis point at the node
+        WorldPoint Direction;           // unit, away from the node
+        double Left{ 0.0 };             // face offsets along the arm's left normal
+        double Right{ 0.0 };
+    };
+
+    // Corners in the wall's own frame (Wall::GetPerpendicular side is left)
+    struct JunctionCap
+    {
+        uint64_t WallId{ 0 };
+        bool AtStart{ false };
+        WorldPoint Left;
+        WorldPoint Right;
+        WorldPoint Center;
+        bool HasCenter{ false };        // false when the node lies on the Left-Right line
+
+        // Cap points in contour order (Wall::GetCornerPoints runs p1-p2 at
+        // the start, p3-p4 at the end)
+        void AppendTo(std::vector<WorldPoint>& contour) const
+        {
+            const WorldPoint& first = AtStart ? Left : Right;
+            const WorldPoint& last = AtStart ? Right : Left;
+            contour.push_back(first);
+            if (HasCenter)
+                contour.push_back(Center);
+            contour.push_back(last);
+        }
+    };
+
+    class WallJunctionSolver
+    {
+    public:
+        // Arms a wall contributes at node; tolerance decides whether an end
+        // counts as being at the node
+        static void AddArms(const Wall& wall, const WorldPoint& node, double tolerance,
+                            std::vector<JunctionArm>& arms)
+        {
+            const WorldPoint& a = wall.GetStartPoint();
+            const WorldPoint& b = wall.GetEndPoint();
+            double length = a.Distance(b);
+            if (length < 1e-6)
+                return;
+
+            WorldPoint d((b.X - a.X) / length, (b.Y - a.Y) / length);
+            double left, right;
+            wall.GetFaceOffsets(left, right);
+
+            double toStart = a.Distance(node);
+            double toEnd = b.Distance(node);
+            if ((std::min)(toStart, toEnd) <= tolerance)
+            {
+                bool atStart = toStart <= toEnd;
+                JunctionArm arm;
+                arm.WallId = wall.GetId();
+                arm.AtStart = atStart;
+                arm.Origin = atStart ? a : b;
+                if (atStart)
+                {
+                    arm.Direction = d;
+                    arm.Left = left;
+                    arm.Right = right;
+                }
+                else
+                {
+                    // The arm runs back along the wall: left and right swap
+                    arm.Direction = WorldPoint(-d.X, -d.Y);
+                    arm.Left = -right;
+                    arm.Right = -left;
+                }
+                arms.push_back(arm);
+                return;
+            }
+
+            double t = ((node.X - a.X) * d.X + (node.Y - a.Y) * d.Y);
+            if (t <= 0.0 || t >= length)
+                return;
+
+            JunctionArm forward;
+            forward.WallId = wall.GetId();
+            forward.PassesThrough = true;
+            forward.Origin = WorldPoint(a.X + d.X * t, a.Y + d.Y * t);
+            forward.Direction = d;
+            forward.Left = left;
+            forward.Right = right;
+            arms.push_back(forward);
+
+            JunctionArm backward = forward;
+            backward.Direction = WorldPoint(-d.X, -d.Y);
+            backward.Left = -right;
+            backward.Right = -left;
+            arms.push_back(backward);
+        }
+
+        // Caps of the arms that end at node, one pass over the sorted arms
+        static std::vector<JunctionCap> Solve(const WorldPoint& node, std::vector<JunctionArm>& arms)
+        {
+            std::vector<JunctionCap> caps;
+            size_t n = arms.size();
+            if (n < 2)
+                return caps;
+
+            // Exact angular order (RobustPredicates.h): arms a hair apart
+            // never tie
+            const WorldPoint origin(0.0, 0.0);
+            std::sort(arms.begin(), arms.end(), [&origin](const JunctionArm& x, const JunctionArm& y) {
+                return RobustPredicates::IsBeforeAround(origin, x.Direction, y.Direction);
+            });
+
+            // leftCorner[i] == rightCorner[i + 1]: where arm i's left face
+            // meets the right face of the next arm counter-clockwise
+            std::vector<WorldPoint> leftCorner(n), rightCorner(n);
+            for (size_t i = 0; i < n; ++i)
+            {
+                size_t j = (i + 1) % n;
+                CloseGap(node, arms[i], arms[j], leftCorner[i], rightCorner[j]);
+            }
+
+            // A wall running through the node owns it: caps meet on its face
+            const JunctionArm* through = nullptr;
+            for (const auto& arm : arms)
+            {
+                if (arm.PassesThrough)
+                {
+                    through = &arm;
+                    break;
+                }
+            }
+
+            for (size_t i = 0; i < n; ++i)
+            {
+                const JunctionArm& arm = arms[i];
+                if (arm.PassesThrough)
+                    continue;
+
+                JunctionCap cap;
+                cap.WallId = arm.WallId;
+                cap.AtStart = arm.AtStart;
+                cap.Center = through ? FacePointToward(*through, arm.Direction) : node;
+
+                // Back to the wall's frame: at the end the arm's left is the wall's right
+                cap.Left = arm.AtStart ? leftCorner[i] : rightCorner[i];
+                cap.Right = arm.AtStart ? rightCorner[i] : leftCorner[i];
+                cap.HasCenter = !IsOnLine(cap.Center, cap.Left, cap.Right);
+                caps.push_back(cap);
+            }
+            return caps;
+        }
+
+    private:
+        // Mitre spikes longer than this many face offsets are cut square
+        static constexpr double MiterLimit = 4.0;
+
+        static void CloseGap(const WorldPoint& node, const JunctionArm& a, const JunctionArm& b,
+                             WorldPoint& aLeft, WorldPoint& bRight)
+        {
+            WorldPoint na(-a.Direction.Y, a.Direction.X);
+            WorldPoint nb(-b.Direction.Y, b.Direction.X);
+            WorldPoint pa(a.Origin.X + na.X * a.Left, a.Origin.Y + na.Y * a.Left);
+            WorldPoint pb(b.Origin.X + nb.X * b.Right, b.Origin.Y + nb.Y * b.Right);
+
+            // Square ends unless the faces cross at a sensible distance
+            aLeft = pa;
+            bRight = pb;
+
+            double cross = a.Direction.X * b.Direction.Y - a.Direction.Y * b.Direction.X;
+            if (std::abs(cross) < 1e-6 || a.WallId == b.WallId)
+                return;
+
+            double s = ((pb.X - pa.X) * b.Direction.Y - (pb.Y - pa.Y) * b.Direction.X) / cross;
+            WorldPoint q(pa.X + a.Direction.X * s, pa.Y + a.Direction.Y * s);
+
+            double reach = (std::max)({ std::abs(a.Left), std::abs(b.Right), 1.0 });
+            if (q.Distance(node) > MiterLimit * reach)
+                return;
+
+            aLeft = q;
+            bRight = q;
+        }
+
+        // Point on the face of a through wall on the side direction points to
+        static WorldPoint FacePointToward(const JunctionArm& through, const WorldPoint& direction)
+        {
+            WorldPoint normal(-through.Direction.Y, through.Direction.X);
+            double side = direction.X * normal.X + direction.Y * normal.Y;
+            double offset = side >= 0.0 ? through.Left : through.Right;
+            return WorldPoint(through.Origin.X + normal.X * offset, through.Origin.Y + normal.Y * offset);
+        }
+
+        static bool IsOnLine(const WorldPoint& p, const WorldPoint& a, const WorldPoint& b)
+        {
+            double dx = b.X - a.X, dy = b.Y - a.Y;
+            double length = std::sqrt(dx * dx + dy * dy);
+            if (length < 1e-9)
+                return p.Distance(a) < 1e-6;
+            double offLine = std::abs((p.X - a.X) * dy - (p.Y - a.Y) * dx) / length;
+            return offLine < 1e-6;
+        }
+    };
+}
@@ -7,7 +7,10 @@
 #include "ViewSettings.h"
 #include "LineWeightTable.h"
 #include "WallPlanGeometry.h"
+#include "DisplayList.h"
+#include "DisplayListRenderer.h"
 #include <unordered_map>
+#include <algorithm>
 
 namespace winrt::estimate1
 {
@@ -20,6 +23,16 @@ namespace winrt::estimate1
     // 3. Lineweight is controlled by VIEW SCALE (1:50 vs 1:100)
     // 4. At extreme zoom, you can zoom INTO the outline itself
     // 5. Outline is rendered as filled geometry band, not as stroke
+    //
+    // The walls are kept as a retained display list. Each wall's plan
+    // geometry (join-aware contour from the document's WallJoinGraph,
+    // layer boundaries) is cached with a key made of its own revision
+    // and those of the walls it joins, so an edit rebuilds the edited
+    // walls and their neighbours only, without InvalidateCache calls.
+    // The list itself is reassembled only when a wall, its visibility
+    // or the detail level changed; selection and hover go into a small
+    // highlight list drawn over it, so the main list (and the device
+    // geometry the backend keeps for it) survives pointer moves.
     // =================================================================
 
     class WallRenderer
@@ -48,19 +61,60 @@ namespace winrt::estimate1
             uint64_t hoverWallId,
             const ViewSettings& viewSettings)
         {
-            const auto& walls = document.GetWalls();
+            Update(document, layerManager, hoverWallId, viewSettings);
+            m_backend.Draw(session, camera, m_wallList);
+            m_backend.Draw(session, camera, m_highlightList);
+        }
 
-            for (const auto& wall : walls)
+        // Brings the wall and highlight lists up to date with the
+        // document. Call after DocumentModel::SyncWallEdits().
+        void Update(
+            const DocumentModel& document,
+            const LayerManager& layerManager,
+            uint64_t hoverWallId,
+            const ViewSettings& viewSettings)
+        {
+            DetailLevel detailLevel = viewSettings.GetDetailLevel();
+            m_lastRebuilt = 0;
+            uint64_t planKey = ComputePlanKey(document, layerManager, detailLevel);
+            if (planKey != m_planKey)
             {
-                if (!layerManager.IsWorkStateVisible(wall->GetWorkState()))
-                    continue;
+                RebuildWallList(document, layerManager, detailLevel);
+                m_planKey = planKey;
+            }
 
+            m_highlightList.Clear();
+            for (const auto& wall : document.GetWalls())
+            {
                 bool isHovered = (hoverWallId != 0 && wall->GetId() == hoverWallId);
+                if (!(wall->IsSelected() || isHovered) || !layerManager.IsWorkStateVisible(wall->GetWorkState()))
+                    continue;
 
-                DrawWall(session, camera, *wall, viewSettings, false, isHovered);
+                auto it = m_cache.find(wall->GetId());
+                if (it != m_cache.end())
+                    BuildWall(m_highlightList, *wall, it->second.Geometry, detailLevel, false, isHovered, wall->IsSelected());
             }
         }
 
+        // Visible walls in their plain state, as of the last Update
+        const DisplayList& GetWallList() const { return m_wallList; }
+
+        // Selected and hovered walls, drawn over the wall list
+        const DisplayList& GetHighlightList() const { return m_highlightList; }
+
+        // Appends the visible walls to a display list
+        void Build(
+            DisplayList& list,
+            const DocumentModel& document,
+            const LayerManager& layerManager,
+            uint64_t hoverWallId,
+            const ViewSettings& viewSettings)
+        {
+            Update(document, layerManager, hoverWallId, viewSettings);
+            list.Append(m_wallList);
+            list.Append(m_highlightList);
+        }
+
         // Draw wall preview during creation
         void DrawPreview(
             const Microsoft::Graphics::Canvas::CanvasDrawingSession& session,
@@ -80,7 +134,10 @@ namespace winrt::estimate1
             previewWall.SetWorkState(workState);
             previewWall.SetLocationLineMode(locationLine);
 
-            DrawWall(session, camera, previewWall, m_defaultViewSettings, true, false);
+            WallPlanGeometry geometry = m_geometryBuilder.BuildBasic(previewWall, m_defaultViewSettings.GetDetailLevel());
+            m_scratch.Clear();
+            BuildWall(m_scratch, previewWall, geometry, m_defaultViewSettings.GetDetailLevel(), true, false, false);
+            m_backend.Draw(session, camera, m_scratch);
         }
 
         // Draw snap point indicator
@@ -121,30 +178,36 @@ namespace winrt::estimate1
         LineWeightTable& GetLineWeightTable() { return m_lineWeightTable; }
         const LineWeightTable& GetLineWeightTable() const { return m_lineWeightTable; }
 
-        // Clear geometry cache (call when walls are modified)
-        void InvalidateCache() { m_geometryCache.clear(); }
-        void InvalidateCache(uint64_t wallId) { m_geometryCache.erase(wallId); }
+        // Drops every cached wall. Wall edits are picked up by revision;
+        // this is only needed after a wall type is edited in place.
+        void InvalidateCache()
+        {
+            m_cache.clear();
+            m_planKey = 0;
+        }
+
+        // Walls whose geometry was built by the last Update, and walls held
+        size_t GetLastRebuiltCount() const { return m_lastRebuilt; }
+        size_t GetCachedWallCount() const { return m_cache.size(); }
 
     private:
         // =================================================================
         // CORE WALL DRAWING - REVIT-LIKE BEHAVIOR
         // =================================================================
-        void DrawWall(
-            const Microsoft::Graphics::Canvas::CanvasDrawingSession& session,
-            const Camera& camera,
+        void BuildWall(
+            DisplayList& list,
             const Wall& wall,
-            const ViewSettings& viewSettings,
-            bool isPreview = false,
-            bool isHovered = false)
+            const WallPlanGeometry& geometry,
+            DetailLevel detailLevel,
+            bool isPreview,
+            bool isHovered,
+            bool isSelected)
         {
-            // Build or retrieve cached geometry
-            WallPlanGeometry geometry = GetOrBuildGeometry(wall, viewSettings.GetDetailLevel());
-            
             if (!geometry.IsValid())
                 return;
 
             // Determine colors based on state
-            Windows::UI::Color strokeColor = DetermineStrokeColor(wall, isPreview, isHovered);
+            Windows::UI::Color strokeColor = DetermineStrokeColor(isPreview, isHovered, isSelected);
 
             // REVIT-STYLE: Fixed thickness in WORLD coordinates (millimeters)
             // This thickness scales with zoom - at higher zoom, outline appears thicker
@@ -152,7 +215,7 @@ namespace winrt::estimate1
             double outlineWorldThickness = m_fixedOutlineThicknessMm;
 
             // Add extra width for selection (in world units)
-            if (wall.IsSelected())
+            if (isSelected)
             {
                 outlineWorldThickness += 1.0; // Add 1mm for selection highlight
             }
@@ -165,305 +228,168 @@ namespace winrt::estimate1
             }
 
             // =================================================================
-            // REVIT-STYLE RENDERING: Outline as GEOMETRY, not stroke
-            // Draw the outline as a filled band around the wall boundary
-            // This makes it part of world geometry - it scales with zoom!
+            // REVIT-STYLE RENDERING: Outline stroked in WORLD units with
+            // mitered joins, so it is part of world geometry and scales
+            // with zoom
             // =================================================================
-            
-            DrawWallWithGeometricOutline(session, camera, geometry, strokeColor, outlineWorldThickness);
+            if (geometry.BoundaryPath.Points.size() >= 2)
+            {
+                uint16_t outline = list.AddStyle(DisplayStyle::WorldStroke(
+                    strokeColor, static_cast<float>(outlineWorldThickness), true));
+                list.AddPolyline(outline, geometry.BoundaryPath.Points, geometry.BoundaryPath.IsClosed);
+            }
 
             // Draw layer boundaries for Fine detail level
-            if (viewSettings.GetDetailLevel() == DetailLevel::Fine)
+            if (detailLevel == DetailLevel::Fine)
             {
                 // Layer boundaries use thinner outline (half of main outline)
                 double layerWorldThickness = m_fixedOutlineThicknessMm * 0.5;
 
                 Windows::UI::Color layerColor = m_lineWeightTable.GetStyle(
                     LineCategory::WallLayerBoundary).Color;
+                uint16_t layerStyle = list.AddStyle(DisplayStyle::WorldStroke(
+                    layerColor, static_cast<float>(layerWorldThickness), true));
 
                 for (const auto& layerBoundary : geometry.LayerBoundaries)
                 {
-                    DrawPolylineAsGeometry(session, camera, layerBoundary, layerColor, layerWorldThickness);
+                    list.AddPolyline(layerStyle, layerBoundary.Points, layerBoundary.IsClosed);
                 }
             }
 
             // Optional: draw semi-transparent fill for selection/hover feedback
-            if ((wall.IsSelected() || isHovered) && m_showSelectionFill)
+            if ((isSelected || isHovered) && m_showSelectionFill)
             {
-                DrawWallFill(session, camera, geometry, wall.IsSelected(), isHovered);
+                // Very subtle fill color
+                Windows::UI::Color fillColor = isSelected
+                    ? Windows::UI::ColorHelper::FromArgb(40, 90, 180, 255)
+                    : Windows::UI::ColorHelper::FromArgb(25, 120, 210, 255);
+                list.AddPolygon(list.AddStyle(DisplayStyle::Fill(fillColor)), geometry.BoundaryPath.Points);
             }
         }
 
-        // =================================================================
-        // REVIT-STYLE: Draw wall with GEOMETRIC outline (not stroke)
-        // The outline is rendered as a filled band that is part of world geometry
-        // This makes it scale with zoom naturally
-        // =================================================================
-        void DrawWallWithGeometricOutline(
-            const Microsoft::Graphics::Canvas::CanvasDrawingSession& session,
-            const Camera& camera,
-            const WallPlanGeometry& geometry,
-            Windows::UI::Color outlineColor,
-            double outlineWorldThickness)
+        // Determine stroke color based on wall state
+        Windows::UI::Color DetermineStrokeColor(bool isPreview, bool isHovered, bool isSelected)
         {
-            if (geometry.BoundaryPath.Points.size() < 2)
-                return;
-
-            // Create the geometry in WORLD coordinates
-            auto pathBuilder = Microsoft::Graphics::Canvas::Geometry::CanvasPathBuilder(session.Device());
-            
-            const auto& points = geometry.BoundaryPath.Points;
-            pathBuilder.BeginFigure(Windows::Foundation::Numerics::float2(
-                static_cast<float>(points[0].X),
-                static_cast<float>(points[0].Y)));
-            
-            for (size_t i = 1; i < points.size(); ++i)
+            if (isPreview)
             {
-                pathBuilder.AddLine(Windows::Foundation::Numerics::float2(
-                    static_cast<float>(points[i].X),
-                    static_cast<float>(points[i].Y)));
+                return Windows::UI::ColorHelper::FromArgb(179, 255, 255, 255);
             }
             
-            pathBuilder.EndFigure(geometry.BoundaryPath.IsClosed 
-                ? Microsoft::Graphics::Canvas::Geometry::CanvasFigureLoop::Closed
-                : Microsoft::Graphics::Canvas::Geometry::CanvasFigureLoop::Open);
-
-            auto worldGeometry = Microsoft::Graphics::Canvas::Geometry::CanvasGeometry::CreatePath(pathBuilder);
-            
-            // Create camera transformation
-            float centerX = camera.GetCanvasWidth() / 2.0f;
-            float centerY = camera.GetCanvasHeight() / 2.0f;
-            float zoom = static_cast<float>(camera.GetZoom());
-            float offsetX = static_cast<float>(-camera.GetOffset().X);
-            float offsetY = static_cast<float>(-camera.GetOffset().Y);
-            
-            auto transform = Windows::Foundation::Numerics::make_float3x2_translation(-offsetX, -offsetY) *
-                           Windows::Foundation::Numerics::make_float3x2_scale(zoom) *
-                           Windows::Foundation::Numerics::make_float3x2_translation(centerX, centerY);
-            
-            // CRITICAL: Use hairline stroke with Normal behavior to draw the outline
-            // The key is that outlineWorldThickness is in WORLD units (mm)
-            // When transformed by zoom, it becomes proportionally larger on screen
-            auto strokeStyle = Microsoft::Graphics::Canvas::Geometry::CanvasStrokeStyle();
-            strokeStyle.LineJoin(Microsoft::Graphics::Canvas::Geometry::CanvasLineJoin::Miter);
-            strokeStyle.StartCap(Microsoft::Graphics::Canvas::Geometry::CanvasCapStyle::Flat);
-            strokeStyle.EndCap(Microsoft::Graphics::Canvas::Geometry::CanvasCapStyle::Flat);
-            strokeStyle.TransformBehavior(
-                Microsoft::Graphics::Canvas::Geometry::CanvasStrokeTransformBehavior::Normal);
-
-            auto oldTransform = session.Transform();
-            session.Transform(transform);
-            
-            // Draw outline with world-space thickness
-            session.DrawGeometry(worldGeometry, outlineColor, 
-                static_cast<float>(outlineWorldThickness), strokeStyle);
-            
-            session.Transform(oldTransform);
-        }
-
-        // Draw polyline as geometric outline (for layer boundaries)
-        void DrawPolylineAsGeometry(
-            const Microsoft::Graphics::Canvas::CanvasDrawingSession& session,
-            const Camera& camera,
-            const WorldPolyline& polyline,
-            Windows::UI::Color color,
-            double worldThickness)
-        {
-            if (polyline.Points.size() < 2)
-                return;
-
-            auto pathBuilder = Microsoft::Graphics::Canvas::Geometry::CanvasPathBuilder(session.Device());
-            
-            pathBuilder.BeginFigure(Windows::Foundation::Numerics::float2(
-                static_cast<float>(polyline.Points[0].X),
-                static_cast<float>(polyline.Points[0].Y)));
-            
-            for (size_t i = 1; i < polyline.Points.size(); ++i)
+            if (isSelected)
             {
-                pathBuilder.AddLine(Windows::Foundation::Numerics::float2(
-                    static_cast<float>(polyline.Points[i].X),
-                    static_cast<float>(polyline.Points[i].Y)));
+                return Windows::UI::ColorHelper::FromArgb(255, 90, 180, 255);
             }
             
-            pathBuilder.EndFigure(polyline.IsClosed 
-                ? Microsoft::Graphics::Canvas::Geometry::CanvasFigureLoop::Closed
-                : Microsoft::Graphics::Canvas::Geometry::CanvasFigureLoop::Open);
-
-            auto worldGeometry = Microsoft::Graphics::Canvas::Geometry::CanvasGeometry::CreatePath(pathBuilder);
-            
-            float centerX = camera.GetCanvasWidth() / 2.0f;
-            float centerY = camera.GetCanvasHeight() / 2.0f;
-            float zoom = static_cast<float>(camera.GetZoom());
-            float offsetX = static_cast<float>(-camera.GetOffset().X);
-            float offsetY = static_cast<float>(-camera.GetOffset().Y);
+            if (isHovered)
+            {
+                return Windows::UI::ColorHelper::FromArgb(255, 120, 210, 255);
+            }
             
-            auto transform = Windows::Foundation::Numerics::make_float3x2_translation(-offsetX, -offsetY) *
-                           Windows::Foundation::Numerics::make_float3x2_scale(zoom) *
-                           Windows::Foundation::Numerics::make_float3x2_translation(centerX, centerY);
+            // Default wall color (light for dark theme)
+            return Windows::UI::Colors::White();
+        }
 
-            auto strokeStyle = Microsoft::Graphics::Canvas::Geometry::CanvasStrokeStyle();
-            strokeStyle.LineJoin(Microsoft::Graphics::Canvas::Geometry::CanvasLineJoin::Miter);
-            strokeStyle.TransformBehavior(
-                Microsoft::Graphics::Canvas::Geometry::CanvasStrokeTransformBehavior::Normal);
+        struct CachedWall
+        {
+            uint64_t Key{ 0 };
+            uint64_t Pass{ 0 };
+            WallPlanGeometry Geometry;
+        };
 
-            auto oldTransform = session.Transform();
-            session.Transform(transform);
-            
-            session.DrawGeometry(worldGeometry, color, 
-                static_cast<float>(worldThickness), strokeStyle);
-            
-            session.Transform(oldTransform);
+        static uint64_t Mix(uint64_t hash, uint64_t value)
+        {
+            return (hash ^ value) * 1099511628211ull;
         }
 
-        // Legacy method - can be removed if not used elsewhere
-        void DrawPolyline(
-            const Microsoft::Graphics::Canvas::CanvasDrawingSession& session,
-            const Camera& camera,
-            const WorldPolyline& polyline,
-            Windows::UI::Color color,
-            float strokeWidth,
-            const Microsoft::Graphics::Canvas::Geometry::CanvasStrokeStyle& strokeStyle)
+        // Changes with every edit of a wall, persistent or geometric
+        static uint64_t WallStamp(const Wall& wall)
         {
-            if (polyline.Points.size() < 2)
-                return;
+            return wall.GetRevision() + wall.GetGeometryRevision();
+        }
 
-            // Create geometry in WORLD coordinates first
-            auto pathBuilder = Microsoft::Graphics::Canvas::Geometry::CanvasPathBuilder(session.Device());
-            
-            pathBuilder.BeginFigure(Windows::Foundation::Numerics::float2(
-                static_cast<float>(polyline.Points[0].X),
-                static_cast<float>(polyline.Points[0].Y)));
-            
-            for (size_t i = 1; i < polyline.Points.size(); ++i)
+        // Everything the plain wall list depends on
+        static uint64_t ComputePlanKey(const DocumentModel& document, const LayerManager& layerManager, DetailLevel detailLevel)
+        {
+            uint64_t key = Mix(14695981039346656037ull, static_cast<uint64_t>(detailLevel));
+            for (const auto& wall : document.GetWalls())
             {
-                pathBuilder.AddLine(Windows::Foundation::Numerics::float2(
-                    static_cast<float>(polyline.Points[i].X),
-                    static_cast<float>(polyline.Points[i].Y)));
+                key = Mix(key, wall->GetId());
+                key = Mix(key, WallStamp(*wall));
+                key = Mix(key, reinterpret_cast<uintptr_t>(wall->GetType().get()));
+                key = Mix(key, layerManager.IsWorkStateVisible(wall->GetWorkState()) ? 1 : 2);
             }
-            
-            pathBuilder.EndFigure(polyline.IsClosed 
-                ? Microsoft::Graphics::Canvas::Geometry::CanvasFigureLoop::Closed
-                : Microsoft::Graphics::Canvas::Geometry::CanvasFigureLoop::Open);
-
-            auto worldGeometry = Microsoft::Graphics::Canvas::Geometry::CanvasGeometry::CreatePath(pathBuilder);
-            
-            // Create camera transformation matrix
-            float centerX = camera.GetCanvasWidth() / 2.0f;
-            float centerY = camera.GetCanvasHeight() / 2.0f;
-            float zoom = static_cast<float>(camera.GetZoom());
-            float offsetX = static_cast<float>(-camera.GetOffset().X);
-            float offsetY = static_cast<float>(-camera.GetOffset().Y);
-            
-            // Transformation: Translate to camera center, scale by zoom, translate to canvas center
-            auto transform = Windows::Foundation::Numerics::make_float3x2_translation(-offsetX, -offsetY) *
-                           Windows::Foundation::Numerics::make_float3x2_scale(zoom) *
-                           Windows::Foundation::Numerics::make_float3x2_translation(centerX, centerY);
-            
-            // REVIT-LIKE BEHAVIOR: Apply transform to DrawingSession
-            // With Normal stroke behavior, the outline SCALES WITH ZOOM
-            // User can zoom in and see the outline grow, eventually zooming "into" the line itself
-            auto oldTransform = session.Transform();
-            session.Transform(transform);
-            
-            // Draw geometry in WORLD coordinates - stroke scales with zoom
-            session.DrawGeometry(worldGeometry, color, strokeWidth, strokeStyle);
-            
-            // Restore original transform
-            session.Transform(oldTransform);
+            return key;
         }
 
-        // Draw optional selection/hover fill
-        void DrawWallFill(
-            const Microsoft::Graphics::Canvas::CanvasDrawingSession& session,
-            const Camera& camera,
-            const WallPlanGeometry& geometry,
-            bool isSelected,
-            bool isHovered)
+        // The wall's contour depends on the walls it joins, so their
+        // ids and revisions are part of its key
+        static uint64_t ComputeWallKey(const Wall& wall, const WallStore& walls, const WallJoinGraph& joinGraph, DetailLevel detailLevel)
         {
-            if (geometry.BoundaryPath.Points.size() < 3)
-                return;
-
-            // Build closed polygon from boundary path
-            auto pathBuilder = Microsoft::Graphics::Canvas::Geometry::CanvasPathBuilder(session.Device());
-            
-            ScreenPoint first = camera.WorldToScreen(geometry.BoundaryPath.Points[0]);
-            pathBuilder.BeginFigure(Windows::Foundation::Numerics::float2(first.X, first.Y));
-            
-            for (size_t i = 1; i < geometry.BoundaryPath.Points.size(); ++i)
+            uint64_t key = Mix(Mix(14695981039346656037ull, WallStamp(wall)), static_cast<uint64_t>(detailLevel));
+            key = Mix(key, reinterpret_cast<uintptr_t>(wall.GetType().get()));
+            for (const auto& join : joinGraph.GetJoins(wall.GetId()))
             {
-                ScreenPoint screen = camera.WorldToScreen(geometry.BoundaryPath.Points[i]);
-                pathBuilder.AddLine(Windows::Foundation::Numerics::float2(screen.X, screen.Y));
+                key = Mix(key, join.WallId2);
+                if (const Wall* other = walls.FindById(join.WallId2))
+                    key = Mix(key, WallStamp(*other));
             }
-            
-            pathBuilder.EndFigure(Microsoft::Graphics::Canvas::Geometry::CanvasFigureLoop::Closed);
-            
-            auto fillGeometry = Microsoft::Graphics::Canvas::Geometry::CanvasGeometry::CreatePath(pathBuilder);
+            return key;
+        }
 
-            // Very subtle fill color
-            Windows::UI::Color fillColor;
-            if (isSelected)
-            {
-                fillColor = Windows::UI::ColorHelper::FromArgb(40, 90, 180, 255);
-            }
-            else if (isHovered)
-            {
-                fillColor = Windows::UI::ColorHelper::FromArgb(25, 120, 210, 255);
-            }
-            else
+        WallPlanGeometry BuildGeometry(const Wall& wall, const WallJoinGraph& joinGraph, DetailLevel detailLevel) const
+        {
+            WallPlanGeometry geometry = m_geometryBuilder.BuildBasic(wall, detailLevel);
+            const auto& contour = joinGraph.GetContour(wall.GetId());
+            if (geometry.IsValid() && contour.size() >= 3)
             {
-                return;
+                geometry.BoundaryPath.Points = contour;
+                geometry.BoundaryPath.IsClosed = true;
             }
-
-            session.FillGeometry(fillGeometry, fillColor);
+            return geometry;
         }
 
-        // Determine stroke color based on wall state
-        Windows::UI::Color DetermineStrokeColor(const Wall& wall, bool isPreview, bool isHovered)
+        void RebuildWallList(const DocumentModel& document, const LayerManager& layerManager, DetailLevel detailLevel)
         {
-            if (isPreview)
-            {
-                return Windows::UI::ColorHelper::FromArgb(179, 255, 255, 255);
-            }
-            
-            if (wall.IsSelected())
-            {
-                return Windows::UI::ColorHelper::FromArgb(255, 90, 180, 255);
-            }
-            
-            if (isHovered)
+            const WallStore& walls = document.GetWallStore();
+            const WallJoinGraph& joinGraph = document.GetWallJoinGraph();
+            ++m_pass;
+            m_wallList.Clear();
+
+            // Neighbouring walls share batches, so the backend can cull them
+            m_order.clear();
+            for (const auto& wall : walls)
             {
-                return Windows::UI::ColorHelper::FromArgb(255, 120, 210, 255);
+                WorldPoint middle((wall->GetStartPoint().X + wall->GetEndPoint().X) / 2,
+                    (wall->GetStartPoint().Y + wall->GetEndPoint().Y) / 2);
+                m_order.emplace_back(SpatialOrderKey(middle), wall.get());
             }
-            
-            // Default wall color (light for dark theme)
-            return Windows::UI::Colors::White();
-        }
+            std::stable_sort(m_order.begin(), m_order.end(),
+                [](const auto& a, const auto& b) { return a.first < b.first; });
 
-        // Get cached geometry or build new
-        WallPlanGeometry GetOrBuildGeometry(const Wall& wall, DetailLevel detailLevel)
-        {
-            uint64_t wallId = wall.GetId();
-            
-            auto it = m_geometryCache.find(wallId);
-            if (it != m_geometryCache.end())
+            for (const auto& [order, wall] : m_order)
             {
-                // Check if cache is still valid
-                if (m_geometryBuilder.IsCacheValid(wall, it->second))
+                CachedWall& cached = m_cache[wall->GetId()];
+                cached.Pass = m_pass;
+                uint64_t key = ComputeWallKey(*wall, walls, joinGraph, detailLevel);
+                if (cached.Key != key || !cached.Geometry.IsValid())
                 {
-                    return it->second;
+                    cached.Geometry = BuildGeometry(*wall, joinGraph, detailLevel);
+                    cached.Key = key;
+                    ++m_lastRebuilt;
                 }
+
+                if (layerManager.IsWorkStateVisible(wall->GetWorkState()))
+                    BuildWall(m_wallList, *wall, cached.Geometry, detailLevel, false, false, false);
             }
-            
-            // Build new geometry
-            WallPlanGeometry geometry = m_geometryBuilder.BuildBasic(wall, detailLevel);
-            
-            // Cache it (for non-preview walls)
-            if (wallId != 0)
+
+            // Walls gone from the document
+            for (auto it = m_cache.begin(); it != m_cache.end();)
             {
-                m_geometryCache[wallId] = geometry;
+                if (it->second.Pass != m_pass)
+                    it = m_cache.erase(it);
+                else
+                    ++it;
             }
-            
-            return geometry;
         }
 
     private:
@@ -476,12 +402,24 @@ namespace winrt::estimate1
         // Geometry builder
         WallPlanGeometryBuilder m_geometryBuilder;
         
-        // Geometry cache (per wall ID)
-        std::unordered_map<uint64_t, WallPlanGeometry> m_geometryCache;
+        // Geometry per wall id, with the key it was built for
+        std::unordered_map<uint64_t, CachedWall> m_cache;
+        uint64_t m_pass{ 0 };
+        size_t m_lastRebuilt{ 0 };
+        std::vector<std::pair<uint64_t, const Wall*>> m_order;     // scratch, walls by SpatialOrderKey
+
+        // Retained output; m_planKey is what m_wallList was built from
+        DisplayList m_wallList;
+        DisplayList m_highlightList;
+        uint64_t m_planKey{ 0 };
         
         // Whether to show selection fill (subtle fill for selected/hovered walls)
         bool m_showSelectionFill{ true };
 
+        // Preview and stand-alone Draw() go through a list of their own
+        DisplayList m_scratch;
+        DisplayListRenderer m_backend;
+
         // Fixed outline thickness in world coordinates (millimeters)
         // This makes the outline scale with zoom, allowing zoom "into" the outline
         double m_fixedOutlineThicknessMm{ 8.0 };
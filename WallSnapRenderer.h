@@ -3,6 +3,7 @@
 #include "pch.h"
 #include "Camera.h"
 #include "WallSnapSystem.h"
+#include "TextLayoutCache.h"
 #include <winrt/Microsoft.Graphics.Canvas.h>
 #include <winrt/Microsoft.Graphics.Canvas.Geometry.h>
 #include <winrt/Microsoft.Graphics.Canvas.Text.h>
@@ -142,15 +143,10 @@ namespace winrt::estimate1
             float tooltipY = screenPos.Y - 16.0f;
 
             //   
-            auto textFormat = Microsoft::Graphics::Canvas::Text::CanvasTextFormat();
-            textFormat.FontSize(11.0f);
-
             //    
-            auto textLayout = Microsoft::Graphics::Canvas::Text::CanvasTextLayout(
-                session.Device(),
-                winrt::hstring(text),
-                textFormat,
-                200.0f, 50.0f);
+            auto textLayout = TextLayoutCache::Shared().GetLayout(
+                session, text, DisplayFont::Default, 11.0f,
+                DisplayTextAlign::TopLeft, 200.0f, 50.0f);
 
             float textWidth = static_cast<float>(textLayout.LayoutBounds().Width);
             float textHeight = static_cast<float>(textLayout.LayoutBounds().Height);
@@ -168,11 +164,10 @@ namespace winrt::estimate1
                 Windows::UI::ColorHelper::FromArgb(220, 40, 40, 40));
 
             // 
-            session.DrawText(
-                winrt::hstring(text),
+            session.DrawTextLayout(
+                textLayout,
                 tooltipX, tooltipY,
-                Windows::UI::ColorHelper::FromArgb(255, 255, 255, 255),
-                textFormat);
+                Windows::UI::ColorHelper::FromArgb(255, 255, 255, 255));
         }
 
         // ============================================================
@@ -275,8 +270,7 @@ namespace winrt::estimate1
         {
             std::wstring modeText = L": " + WallSnapSystem::GetReferenceModeName(mode);
 
-            auto textFormat = Microsoft::Graphics::Canvas::Text::CanvasTextFormat();
-            textFormat.FontSize(11.0f);
+            auto textFormat = TextLayoutCache::Shared().GetFormat(DisplayFont::Default, 11.0f);
 
             session.DrawText(
                 winrt::hstring(modeText),
@@ -331,9 +325,8 @@ namespace winrt::estimate1
             wchar_t distText[32];
             swprintf_s(distText, L"%.1f", distanceMM);
             
-            auto format = Microsoft::Graphics::Canvas::Text::CanvasTextFormat();
-            format.FontSize(11.0f);
-            format.HorizontalAlignment(Microsoft::Graphics::Canvas::Text::CanvasHorizontalAlignment::Center);
+            auto format = TextLayoutCache::Shared().GetFormat(
+                DisplayFont::Default, 11.0f, DisplayTextAlign::TopCenter);
 
             session.DrawText(distText, 
                 Windows::Foundation::Numerics::float2((d1.X + d2.X) / 2, (d1.Y + d2.Y) / 2 - 16.0f),
@@ -4,10 +4,12 @@
 #include "Models.h"
 #include "Element.h"
 #include "WallType.h"
+#include "WallJoinIndex.h"
 #include <vector>
 #include <algorithm>
 #include <cmath>
 #include <optional>
+#include <unordered_map>
 
 namespace winrt::estimate1
 {
@@ -134,6 +136,386 @@ namespace winrt::estimate1
 
             return ((point.X - Start.X) * dx + (point.Y - Start.Y) * dy) / lengthSq;
         }
+
+        // Appends the reference lines of a wall: axis, finish faces and,
+        // for layered types, the core lines
+        static void AppendForWall(const Wall& wall, std::vector<WallReferenceLine>& lines)
+        {
+            WorldPoint start = wall.GetStartPoint();
+            WorldPoint end = wall.GetEndPoint();
+            double thickness = wall.GetThickness();
+
+            //   
+            double dx = end.X - start.X;
+            double dy = end.Y - start.Y;
+            double len = std::sqrt(dx * dx + dy * dy);
+
+            if (len < 0.001)
+                return;
+
+            //  
+            double dirX = dx / len;
+            double dirY = dy / len;
+
+            //  (  )
+            double perpX = -dirY;
+            double perpY = dirX;
+
+            //  
+            double halfThickness = thickness / 2.0;
+
+            // 1.   (Centerline)
+            {
+                WallReferenceLine line;
+                line.Start = start;
+                line.End = end;
+                line.Plane = WallSnapPlane::Centerline;
+                line.WallId = wall.GetId();
+                lines.push_back(line);
+            }
+
+            // 2.    (Finish Face Exterior)
+            {
+                WallReferenceLine line;
+                line.Start = WorldPoint(start.X + perpX * halfThickness, start.Y + perpY * halfThickness);
+                line.End = WorldPoint(end.X + perpX * halfThickness, end.Y + perpY * halfThickness);
+                line.Plane = WallSnapPlane::FinishFaceExterior;
+                line.WallId = wall.GetId();
+                lines.push_back(line);
+            }
+
+            // 3.    (Finish Face Interior)
+            {
+                WallReferenceLine line;
+                line.Start = WorldPoint(start.X - perpX * halfThickness, start.Y - perpY * halfThickness);
+                line.End = WorldPoint(end.X - perpX * halfThickness, end.Y - perpY * halfThickness);
+                line.Plane = WallSnapPlane::FinishFaceInterior;
+                line.WallId = wall.GetId();
+                lines.push_back(line);
+            }
+
+            // 4.   (      )
+            auto wallType = wall.GetType();
+            if (wallType && wallType->GetLayerCount() > 1)
+            {
+                double coreThickness = wallType->GetCoreThickness();
+                double finishThickness = (thickness - coreThickness) / 2.0;
+                double halfCoreThickness = coreThickness / 2.0;
+
+                //    (Core Centerline)
+                {
+                    WallReferenceLine line;
+                    line.Start = start;
+                    line.End = end;
+                    line.Plane = WallSnapPlane::CoreCenterline;
+                    line.WallId = wall.GetId();
+                    lines.push_back(line);
+                }
+
+                //    (Core Face Exterior)
+                {
+                    WallReferenceLine line;
+                    line.Start = WorldPoint(
+                        start.X + perpX * halfCoreThickness,
+                        start.Y + perpY * halfCoreThickness);
+                    line.End = WorldPoint(
+                        end.X + perpX * halfCoreThickness,
+                        end.Y + perpY * halfCoreThickness);
+                    line.Plane = WallSnapPlane::CoreFaceExterior;
+                    line.WallId = wall.GetId();
+                    lines.push_back(line);
+                }
+
+                //    (Core Face Interior)
+                {
+                    WallReferenceLine line;
+                    line.Start = WorldPoint(
+                        start.X - perpX * halfCoreThickness,
+                        start.Y - perpY * halfCoreThickness);
+                    line.End = WorldPoint(
+                        end.X - perpX * halfCoreThickness,
+                        end.Y - perpY * halfCoreThickness);
+                    line.Plane = WallSnapPlane::CoreFaceInterior;
+                    line.WallId = wall.GetId();
+                    lines.push_back(line);
+                }
+            }
+        }
+    };
+
+    // ============================================================================
+    // Wall Snap Index
+    // ============================================================================
+    // Reference lines of every wall, kept between pointer moves, with a
+    // footprint grid (WallJoinIndex) for the walls near the cursor and
+    // wall ends sorted by X and by Y for alignment. Sync() patches it
+    // with the walls changed since the last document revision it saw,
+    // so a snap query touches only the walls within reach.
+    //
+    // Edited ends go to a short unsorted list and removed ones are only
+    // marked, so an edit does not shift the sorted arrays; both are
+    // folded back in once the list grows.
+    // ============================================================================
+
+    class WallSnapIndex
+    {
+    public:
+        // Brings the index up to the document's revision
+        void Sync(const DocumentModel& document)
+        {
+            uint64_t revision = document.GetRevision();
+            if (m_valid && m_revision == revision)
+                return;
+
+            ChangeSet changes;
+            if (m_valid)
+                changes = document.GetChangesSince(m_revision, JournalElementKind::Wall);
+
+            if (!m_valid || changes.IsFullReset)
+            {
+                Rebuild(document.GetWalls());
+            }
+            else
+            {
+                const WallStore& walls = document.GetWallStore();
+                for (uint64_t id : changes.Removed)
+                    Remove(id);
+                for (const auto* ids : { &changes.Added, &changes.Modified })
+                {
+                    for (uint64_t id : *ids)
+                    {
+                        if (const Wall* wall = walls.FindById(id))
+                            Update(*wall);
+                    }
+                }
+            }
+            m_revision = revision;
+            m_valid = true;
+        }
+
+        void Rebuild(const std::vector<std::unique_ptr<Wall>>& walls)
+        {
+            m_entries.clear();
+            m_grid.Build(walls);
+
+            std::vector<AxisKey> byX, byY;
+            byX.reserve(walls.size() * 2);
+            byY.reserve(walls.size() * 2);
+            m_entries.reserve(walls.size());
+            for (const auto& wall : walls)
+            {
+                if (!wall) continue;
+                Entry& entry = m_entries[wall->GetId()];
+                Fill(entry, *wall);
+                for (const WorldPoint& p : { entry.Start, entry.End })
+                {
+                    byX.push_back({ p.X, p, wall->GetId(), false });
+                    byY.push_back({ p.Y, p, wall->GetId(), false });
+                }
+            }
+            m_byX.Assign(std::move(byX));
+            m_byY.Assign(std::move(byY));
+        }
+
+        // Re-reads a wall, adding it if new
+        void Update(const Wall& wall)
+        {
+            Remove(wall.GetId());
+
+            Entry& entry = m_entries[wall.GetId()];
+            Fill(entry, wall);
+            m_grid.Insert(wall);
+            for (const WorldPoint& p : { entry.Start, entry.End })
+            {
+                m_byX.Insert({ p.X, p, wall.GetId(), false });
+                m_byY.Insert({ p.Y, p, wall.GetId(), false });
+            }
+        }
+
+        void Remove(uint64_t wallId)
+        {
+            auto it = m_entries.find(wallId);
+            if (it == m_entries.end())
+                return;
+
+            for (const WorldPoint& p : { it->second.Start, it->second.End })
+            {
+                m_byX.Erase(p.X, wallId);
+                m_byY.Erase(p.Y, wallId);
+            }
+            m_grid.Remove(wallId);
+            m_entries.erase(it);
+        }
+
+        size_t Size() const { return m_entries.size(); }
+
+        // fn(wall, lines) for every wall whose footprint comes within
+        // radius of p; lines are its reference lines
+        template <typename Fn>
+        void ForEachWallNear(const WorldPoint& p, double radius, Fn&& fn) const
+        {
+            m_grid.ForEachNear(p, radius, [&](const Wall& wall) {
+                auto it = m_entries.find(wall.GetId());
+                if (it != m_entries.end())
+                    fn(wall, it->second.Lines);
+            });
+        }
+
+        // Wall end nearest in X (vertical alignment) or Y (horizontal)
+        // to value, closer than threshold; false if none
+        bool FindAlignedX(double value, double threshold, uint64_t excludeWallId, WorldPoint& source) const
+        {
+            return m_byX.FindNearest(value, threshold, excludeWallId, source);
+        }
+
+        bool FindAlignedY(double value, double threshold, uint64_t excludeWallId, WorldPoint& source) const
+        {
+            return m_byY.FindNearest(value, threshold, excludeWallId, source);
+        }
+
+    private:
+        struct Entry
+        {
+            WorldPoint Start;
+            WorldPoint End;
+            std::vector<WallReferenceLine> Lines;
+        };
+
+        struct AxisKey
+        {
+            double Value{ 0.0 };
+            WorldPoint Point;
+            uint64_t WallId{ 0 };
+            bool Removed{ false };
+
+            bool operator<(const AxisKey& other) const
+            {
+                return Value < other.Value || (Value == other.Value && WallId < other.WallId);
+            }
+        };
+
+        // Wall ends ordered along one axis
+        class AxisKeys
+        {
+        public:
+            void Assign(std::vector<AxisKey> keys)
+            {
+                std::sort(keys.begin(), keys.end());
+                m_sorted = std::move(keys);
+                m_pending.clear();
+                m_removed = 0;
+            }
+
+            void Insert(const AxisKey& key)
+            {
+                m_pending.push_back(key);
+                if (m_pending.size() > MaxPending)
+                    Merge();
+            }
+
+            void Erase(double value, uint64_t wallId)
+            {
+                for (size_t i = 0; i < m_pending.size(); ++i)
+                {
+                    if (m_pending[i].Value == value && m_pending[i].WallId == wallId)
+                    {
+                        m_pending[i] = m_pending.back();
+                        m_pending.pop_back();
+                        return;
+                    }
+                }
+
+                // A wall parallel to the axis has both ends under one key
+                AxisKey key{ value, {}, wallId, false };
+                for (auto it = std::lower_bound(m_sorted.begin(), m_sorted.end(), key);
+                     it != m_sorted.end() && it->Value == value && it->WallId == wallId; ++it)
+                {
+                    if (!it->Removed)
+                    {
+                        it->Removed = true;
+                        if (++m_removed > MaxPending)
+                            Merge();
+                        return;
+                    }
+                }
+            }
+
+            // Nearest end closer than threshold, walking out from value
+            bool FindNearest(double value, double threshold, uint64_t excludeWallId, WorldPoint& source) const
+            {
+                const AxisKey* best = nullptr;
+                double bestGap = threshold;
+
+                auto mid = std::lower_bound(m_sorted.begin(), m_sorted.end(), AxisKey{ value, {}, 0, false });
+                for (auto it = mid; it != m_sorted.end() && it->Value - value < bestGap; ++it)
+                {
+                    if (!it->Removed && it->WallId != excludeWallId)
+                    {
+                        best = &*it;
+                        bestGap = it->Value - value;
+                        break;
+                    }
+                }
+                for (auto it = mid; it != m_sorted.begin() && value - (it - 1)->Value < bestGap; --it)
+                {
+                    const AxisKey& key = *(it - 1);
+                    if (!key.Removed && key.WallId != excludeWallId)
+                    {
+                        best = &key;
+                        bestGap = value - key.Value;
+                        break;
+                    }
+                }
+                for (const auto& key : m_pending)
+                {
+                    double gap = std::abs(key.Value - value);
+                    if (gap < bestGap && key.WallId != excludeWallId)
+                    {
+                        best = &key;
+                        bestGap = gap;
+                    }
+                }
+
+                if (!best)
+                    return false;
+                source = best->Point;
+                return true;
+            }
+
+        private:
+            static constexpr size_t MaxPending = 64;
+
+            void Merge()
+            {
+                m_sorted.erase(std::remove_if(m_sorted.begin(), m_sorted.end(),
+                    [](const AxisKey& key) { return key.Removed; }), m_sorted.end());
+                std::sort(m_pending.begin(), m_pending.end());
+                size_t middle = m_sorted.size();
+                m_sorted.insert(m_sorted.end(), m_pending.begin(), m_pending.end());
+                std::inplace_merge(m_sorted.begin(), m_sorted.begin() + middle, m_sorted.end());
+                m_pending.clear();
+                m_removed = 0;
+            }
+
+            std::vector<AxisKey> m_sorted;
+            std::vector<AxisKey> m_pending;     // inserted since the last merge, unsorted
+            size_t m_removed{ 0 };              // marked in m_sorted since the last merge
+        };
+
+        static void Fill(Entry& entry, const Wall& wall)
+        {
+            entry.Start = wall.GetStartPoint();
+            entry.End = wall.GetEndPoint();
+            entry.Lines.clear();
+            WallReferenceLine::AppendForWall(wall, entry.Lines);
+        }
+
+        std::unordered_map<uint64_t, Entry> m_entries;
+        WallJoinIndex m_grid;                   // wall footprints cover every reference line
+        AxisKeys m_byX;
+        AxisKeys m_byY;
+        uint64_t m_revision{ 0 };
+        bool m_valid{ false };
     };
 
     // ============================================================================
@@ -186,6 +568,7 @@ namespace winrt::estimate1
             return FindBestSnap(cursor, std::nullopt, walls, zoomFactor, excludeWallId);
         }
 
+        // Full scan over a plain wall list
         WallSnapCandidate FindBestSnap(
             const WorldPoint& cursor,
             const std::optional<WorldPoint>& startPoint,
@@ -193,24 +576,100 @@ namespace winrt::estimate1
             double zoomFactor,
             uint64_t excludeWallId = 0)
         {
-            std::vector<WallSnapCandidate> candidates;
+            Thresholds limits(m_snapThresholdPx, m_endpointThresholdPx, zoomFactor);
 
-            //      
-            double snapThresholdMM = m_snapThresholdPx / zoomFactor;
-            double endpointThresholdMM = m_endpointThresholdPx / zoomFactor;
+            WallSnapCandidate alignSnap = AlignToStart(cursor, startPoint, limits);
+            for (const auto& wall : walls)
+            {
+                if (!wall || wall->GetId() == excludeWallId)
+                    continue;
+                AlignTo(alignSnap, cursor, wall->GetStartPoint(), limits);
+                AlignTo(alignSnap, cursor, wall->GetEndPoint(), limits);
+            }
+
+            WallSnapCandidate best = FinishAlignment(alignSnap, cursor);
+            std::vector<WallReferenceLine> lines;
+            for (const auto& wall : walls)
+            {
+                if (!wall || wall->GetId() == excludeWallId)
+                    continue;
+                lines.clear();
+                WallReferenceLine::AppendForWall(*wall, lines);
+                ConsiderLines(cursor, *wall, lines, limits, best);
+            }
+            return best;
+        }
 
-            // 1. R-SNAP:    (Horizontal/Vertical)
+        // The document's walls through the snap index (WallSnapIndex):
+        // only walls within reach of the cursor are looked at, and
+        // alignment is two binary searches. Call DocumentModel::
+        // SyncWallEdits() first if walls were edited through Wall*.
+        WallSnapCandidate FindBestSnap(
+            const WorldPoint& cursor,
+            const std::optional<WorldPoint>& startPoint,
+            const DocumentModel& document,
+            double zoomFactor,
+            uint64_t excludeWallId = 0)
+        {
+            m_index.Sync(document);
+            Thresholds limits(m_snapThresholdPx, m_endpointThresholdPx, zoomFactor);
+
+            WallSnapCandidate alignSnap = AlignToStart(cursor, startPoint, limits);
+            WorldPoint source;
+            if (!alignSnap.AlignmentHorizontal && m_index.FindAlignedY(cursor.Y, limits.Alignment, excludeWallId, source))
+                AlignTo(alignSnap, cursor, source, limits);
+            if (!alignSnap.AlignmentVertical && m_index.FindAlignedX(cursor.X, limits.Alignment, excludeWallId, source))
+                AlignTo(alignSnap, cursor, source, limits);
+
+            WallSnapCandidate best = FinishAlignment(alignSnap, cursor);
+            double reach = (std::max)(limits.Line, limits.Endpoint);
+            m_index.ForEachWallNear(cursor, reach, [&](const Wall& wall, const std::vector<WallReferenceLine>& lines) {
+                if (wall.GetId() != excludeWallId)
+                    ConsiderLines(cursor, wall, lines, limits, best);
+            });
+            return best;
+        }
+
+        const WallSnapIndex& GetIndex() const { return m_index; }
+        void SyncIndex(const DocumentModel& document) { m_index.Sync(document); }
+
+    private:
+        // Snap distances in mm at the current zoom
+        struct Thresholds
+        {
+            Thresholds(double linePx, double endpointPx, double zoomFactor)
+                : Line(linePx / zoomFactor)
+                , Endpoint(endpointPx / zoomFactor)
+                , Alignment(endpointPx / zoomFactor * 0.8)   //     
+            {
+            }
+
+            double Line;
+            double Endpoint;
+            double Alignment;
+        };
+
+        // Best of the two: keeps a running minimum instead of sorting
+        // every candidate
+        static void Consider(WallSnapCandidate& best, const WallSnapCandidate& candidate)
+        {
+            if (!best.IsValid || candidate < best)
+                best = candidate;
+        }
+
+        // R-SNAP: ortho   
+        static WallSnapCandidate AlignToStart(const WorldPoint& cursor,
+            const std::optional<WorldPoint>& startPoint,
+            const Thresholds& limits)
+        {
             WallSnapCandidate alignSnap;
             alignSnap.IsValid = false;
             alignSnap.ProjectedPoint = cursor;
             alignSnap.IsAlignment = true;
 
-            const double alignmentThresholdMM = endpointThresholdMM * 0.8; //     
-
-            //  ortho   
             if (startPoint)
             {
-                if (std::abs(cursor.Y - startPoint->Y) < alignmentThresholdMM)
+                if (std::abs(cursor.Y - startPoint->Y) < limits.Alignment)
                 {
                     alignSnap.ProjectedPoint.Y = startPoint->Y;
                     alignSnap.AlignmentHorizontal = true;
@@ -218,7 +677,7 @@ namespace winrt::estimate1
                     alignSnap.AlignmentLabel = L"";
                     alignSnap.IsValid = true;
                 }
-                if (std::abs(cursor.X - startPoint->X) < alignmentThresholdMM)
+                if (std::abs(cursor.X - startPoint->X) < limits.Alignment)
                 {
                     alignSnap.ProjectedPoint.X = startPoint->X;
                     alignSnap.AlignmentVertical = true;
@@ -227,154 +686,140 @@ namespace winrt::estimate1
                     alignSnap.IsValid = true;
                 }
             }
+            return alignSnap;
+        }
 
-            //       
-            for (const auto& wall : walls)
+        //     
+        static void AlignTo(WallSnapCandidate& alignSnap, const WorldPoint& cursor,
+            const WorldPoint& p, const Thresholds& limits)
+        {
+            if (!alignSnap.AlignmentHorizontal && std::abs(cursor.Y - p.Y) < limits.Alignment)
             {
-                if (!wall || wall->GetId() == excludeWallId)
-                    continue;
-
-                WorldPoint pts[] = { wall->GetStartPoint(), wall->GetEndPoint() };
-                for (const auto& p : pts)
-                {
-                    if (!alignSnap.AlignmentHorizontal && std::abs(cursor.Y - p.Y) < alignmentThresholdMM)
-                    {
-                        alignSnap.ProjectedPoint.Y = p.Y;
-                        alignSnap.AlignmentHorizontal = true;
-                        alignSnap.AlignmentSource = p;
-                        alignSnap.AlignmentLabel = L"";
-                        alignSnap.IsValid = true;
-                    }
-                    if (!alignSnap.AlignmentVertical && std::abs(cursor.X - p.X) < alignmentThresholdMM)
-                    {
-                        alignSnap.ProjectedPoint.X = p.X;
-                        alignSnap.AlignmentVertical = true;
-                        alignSnap.AlignmentSource = p;
-                        alignSnap.AlignmentLabel = L"";
-                        alignSnap.IsValid = true;
-                    }
-                }
+                alignSnap.ProjectedPoint.Y = p.Y;
+                alignSnap.AlignmentHorizontal = true;
+                alignSnap.AlignmentSource = p;
+                alignSnap.AlignmentLabel = L"";
+                alignSnap.IsValid = true;
             }
+            if (!alignSnap.AlignmentVertical && std::abs(cursor.X - p.X) < limits.Alignment)
+            {
+                alignSnap.ProjectedPoint.X = p.X;
+                alignSnap.AlignmentVertical = true;
+                alignSnap.AlignmentSource = p;
+                alignSnap.AlignmentLabel = L"";
+                alignSnap.IsValid = true;
+            }
+        }
 
+        static WallSnapCandidate FinishAlignment(WallSnapCandidate& alignSnap, const WorldPoint& cursor)
+        {
             if (alignSnap.IsValid)
             {
                 alignSnap.Distance = cursor.Distance(alignSnap.ProjectedPoint);
-                candidates.push_back(alignSnap);
+                return alignSnap;
             }
 
-            // 2.   
-            for (const auto& wall : walls)
+            //  
+            WallSnapCandidate noSnap;
+            noSnap.IsValid = false;
+            return noSnap;
+        }
+
+        //       
+        void ConsiderLines(const WorldPoint& cursor, const Wall& wall,
+            const std::vector<WallReferenceLine>& refLines,
+            const Thresholds& limits, WallSnapCandidate& best) const
+        {
+            for (const auto& refLine : refLines)
             {
-                if (!wall || wall->GetId() == excludeWallId)
+                //    
+                if (!IsPlaneAllowedByMode(refLine.Plane))
                     continue;
 
-                //      
-                auto refLines = GetWallReferenceLines(*wall);
+                //     
+                double distToStart = cursor.Distance(refLine.Start);
+                double distToEnd = cursor.Distance(refLine.End);
 
-                for (const auto& refLine : refLines)
+                //    
+                if (distToStart < limits.Endpoint && wall.IsJoinAllowedAtStart())
                 {
-                    //    
-                    if (!IsPlaneAllowedByMode(refLine.Plane))
-                        continue;
+                    WallSnapCandidate candidate;
+                    candidate.WallId = wall.GetId();
+                    candidate.Plane = WallSnapPlane::Endpoint;
+                    candidate.ProjectedPoint = refLine.Start;
+                    candidate.Distance = distToStart;
+                    candidate.IsEndpoint = true;
+                    candidate.IsValid = true;
+                    Consider(best, candidate);
+                }
 
-                    //     
-                    double distToStart = cursor.Distance(refLine.Start);
-                    double distToEnd = cursor.Distance(refLine.End);
+                //    
+                if (distToEnd < limits.Endpoint && wall.IsJoinAllowedAtEnd())
+                {
+                    WallSnapCandidate candidate;
+                    candidate.WallId = wall.GetId();
+                    candidate.Plane = WallSnapPlane::Endpoint;
+                    candidate.ProjectedPoint = refLine.End;
+                    candidate.Distance = distToEnd;
+                    candidate.IsEndpoint = true;
+                    candidate.IsValid = true;
+                    Consider(best, candidate);
+                }
 
-                    //    
-                    if (distToStart < endpointThresholdMM && wall->IsJoinAllowedAtStart())
-                    {
-                        WallSnapCandidate candidate;
-                        candidate.WallId = wall->GetId();
-                        candidate.Plane = WallSnapPlane::Endpoint;
-                        candidate.ProjectedPoint = refLine.Start;
-                        candidate.Distance = distToStart;
-                        candidate.IsEndpoint = true;
-                        candidate.IsValid = true;
-                        candidates.push_back(candidate);
-                    }
+                //    (  centerline)
+                if (refLine.Plane == WallSnapPlane::Centerline)
+                {
+                    WorldPoint mid(
+                        (refLine.Start.X + refLine.End.X) / 2.0,
+                        (refLine.Start.Y + refLine.End.Y) / 2.0);
+                    double distToMid = cursor.Distance(mid);
 
-                    //    
-                    if (distToEnd < endpointThresholdMM && wall->IsJoinAllowedAtEnd())
+                    if (distToMid < limits.Endpoint)
                     {
                         WallSnapCandidate candidate;
-                        candidate.WallId = wall->GetId();
-                        candidate.Plane = WallSnapPlane::Endpoint;
-                        candidate.ProjectedPoint = refLine.End;
-                        candidate.Distance = distToEnd;
-                        candidate.IsEndpoint = true;
+                        candidate.WallId = wall.GetId();
+                        candidate.Plane = WallSnapPlane::Midpoint;
+                        candidate.ProjectedPoint = mid;
+                        candidate.Distance = distToMid;
+                        candidate.IsEndpoint = false;
                         candidate.IsValid = true;
-                        candidates.push_back(candidate);
+                        Consider(best, candidate);
                     }
+                }
 
-                    //    (  centerline)
-                    if (refLine.Plane == WallSnapPlane::Centerline)
+                //    (  )
+                if (m_faceSnapEnabled || refLine.Plane == WallSnapPlane::Centerline)
+                {
+                    WorldPoint proj = refLine.ProjectPoint(cursor);
+                    double distToLine = cursor.Distance(proj);
+
+                    if (distToLine < limits.Line)
                     {
-                        WorldPoint mid(
-                            (refLine.Start.X + refLine.End.X) / 2.0,
-                            (refLine.Start.Y + refLine.End.Y) / 2.0);
-                        double distToMid = cursor.Distance(mid);
-                        
-                        if (distToMid < endpointThresholdMM)
+                        // ,     (   )
+                        double t = refLine.GetParameterT(proj);
+                        if (t >= -0.01 && t <= 1.01)
                         {
+                            //    ,       
+                            if (t <= 0.0)
+                                proj = refLine.Start;
+                            else if (t >= 1.0)
+                                proj = refLine.End;
+
                             WallSnapCandidate candidate;
-                            candidate.WallId = wall->GetId();
-                            candidate.Plane = WallSnapPlane::Midpoint;
-                            candidate.ProjectedPoint = mid;
-                            candidate.Distance = distToMid;
+                            candidate.WallId = wall.GetId();
+                            candidate.Plane = refLine.Plane;
+                            candidate.ProjectedPoint = proj;
+                            candidate.Distance = distToLine;
                             candidate.IsEndpoint = false;
                             candidate.IsValid = true;
-                            candidates.push_back(candidate);
-                        }
-                    }
-
-                    //    (  )
-                    if (m_faceSnapEnabled || refLine.Plane == WallSnapPlane::Centerline)
-                    {
-                        WorldPoint proj = refLine.ProjectPoint(cursor);
-                        double distToLine = cursor.Distance(proj);
-
-                        if (distToLine < snapThresholdMM)
-                        {
-                            // ,     (   )
-                            double t = refLine.GetParameterT(proj);
-                            if (t >= -0.01 && t <= 1.01)
-                            {
-                                //    ,       
-                                if (t <= 0.0)
-                                    proj = refLine.Start;
-                                else if (t >= 1.0)
-                                    proj = refLine.End;
-
-                                WallSnapCandidate candidate;
-                                candidate.WallId = wall->GetId();
-                                candidate.Plane = refLine.Plane;
-                                candidate.ProjectedPoint = proj;
-                                candidate.Distance = distToLine;
-                                candidate.IsEndpoint = false;
-                                candidate.IsValid = true;
-                                candidates.push_back(candidate);
-                            }
+                            Consider(best, candidate);
                         }
                     }
                 }
             }
-
-            //      
-            std::sort(candidates.begin(), candidates.end());
-
-            //   
-            if (!candidates.empty())
-            {
-                return candidates.front();
-            }
-
-            //  
-            WallSnapCandidate noSnap;
-            noSnap.IsValid = false;
-            return noSnap;
         }
 
+    public:
         // ============================================================
         //     
         // ============================================================
@@ -382,107 +827,7 @@ namespace winrt::estimate1
         std::vector<WallReferenceLine> GetWallReferenceLines(const Wall& wall) const
         {
             std::vector<WallReferenceLine> lines;
-
-            WorldPoint start = wall.GetStartPoint();
-            WorldPoint end = wall.GetEndPoint();
-            double thickness = wall.GetThickness();
-
-            //   
-            double dx = end.X - start.X;
-            double dy = end.Y - start.Y;
-            double len = std::sqrt(dx * dx + dy * dy);
-
-            if (len < 0.001)
-                return lines;
-
-            //  
-            double dirX = dx / len;
-            double dirY = dy / len;
-
-            //  (  )
-            double perpX = -dirY;
-            double perpY = dirX;
-
-            //  
-            double halfThickness = thickness / 2.0;
-
-            // 1.   (Centerline)
-            {
-                WallReferenceLine line;
-                line.Start = start;
-                line.End = end;
-                line.Plane = WallSnapPlane::Centerline;
-                line.WallId = wall.GetId();
-                lines.push_back(line);
-            }
-
-            // 2.    (Finish Face Exterior)
-            {
-                WallReferenceLine line;
-                line.Start = WorldPoint(start.X + perpX * halfThickness, start.Y + perpY * halfThickness);
-                line.End = WorldPoint(end.X + perpX * halfThickness, end.Y + perpY * halfThickness);
-                line.Plane = WallSnapPlane::FinishFaceExterior;
-                line.WallId = wall.GetId();
-                lines.push_back(line);
-            }
-
-            // 3.    (Finish Face Interior)
-            {
-                WallReferenceLine line;
-                line.Start = WorldPoint(start.X - perpX * halfThickness, start.Y - perpY * halfThickness);
-                line.End = WorldPoint(end.X - perpX * halfThickness, end.Y - perpY * halfThickness);
-                line.Plane = WallSnapPlane::FinishFaceInterior;
-                line.WallId = wall.GetId();
-                lines.push_back(line);
-            }
-
-            // 4.   (      )
-            auto wallType = wall.GetType();
-            if (wallType && wallType->GetLayerCount() > 1)
-            {
-                double coreThickness = wallType->GetCoreThickness();
-                double finishThickness = (thickness - coreThickness) / 2.0;
-                double halfCoreThickness = coreThickness / 2.0;
-
-                //    (Core Centerline)
-                {
-                    WallReferenceLine line;
-                    line.Start = start;
-                    line.End = end;
-                    line.Plane = WallSnapPlane::CoreCenterline;
-                    line.WallId = wall.GetId();
-                    lines.push_back(line);
-                }
-
-                //    (Core Face Exterior)
-                {
-                    WallReferenceLine line;
-                    line.Start = WorldPoint(
-                        start.X + perpX * halfCoreThickness,
-                        start.Y + perpY * halfCoreThickness);
-                    line.End = WorldPoint(
-                        end.X + perpX * halfCoreThickness,
-                        end.Y + perpY * halfCoreThickness);
-                    line.Plane = WallSnapPlane::CoreFaceExterior;
-                    line.WallId = wall.GetId();
-                    lines.push_back(line);
-                }
-
-                //    (Core Face Interior)
-                {
-                    WallReferenceLine line;
-                    line.Start = WorldPoint(
-                        start.X - perpX * halfCoreThickness,
-                        start.Y - perpY * halfCoreThickness);
-                    line.End = WorldPoint(
-                        end.X - perpX * halfCoreThickness,
-                        end.Y - perpY * halfCoreThickness);
-                    line.Plane = WallSnapPlane::CoreFaceInterior;
-                    line.WallId = wall.GetId();
-                    lines.push_back(line);
-                }
-            }
-
+            WallReferenceLine::AppendForWall(wall, lines);
             return lines;
         }
 
@@ -570,6 +915,7 @@ namespace winrt::estimate1
         double m_endpointThresholdPx{ 12.0 };   //     ()
         SnapReferenceMode m_referenceMode{ SnapReferenceMode::Auto };
         bool m_faceSnapEnabled{ true };
+        WallSnapIndex m_index;
 
         // ,     
         bool IsPlaneAllowedByMode(WallSnapPlane plane) const
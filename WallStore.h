@@ -0,0 +1,309 @@
+#pragma once
+
+#include "pch.h"
+#include "Models.h"
+#include "GeometryKernels.h"
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <limits>
+
+namespace winrt::estimate1
+{
+    // =================================================================
+    // WALL STORE - slot map with generational handles
+    // =================================================================
+    // Walls stay heap objects (Wall* remains stable for tools, selection
+    // and undo), but the geometry that bulk passes read - endpoints,
+    // thickness, height, location line, join flags - is mirrored into
+    // dense structure-of-arrays storage. Joins, room detection, snapping
+    // and estimation iterate these arrays instead of chasing one pointer
+    // (and one vtable, wstring and shared_ptr<WallType>) per wall.
+    //
+    // A WallHandle survives erasure of other walls; a handle to an erased
+    // wall is detected by its generation and resolves to nullptr.
+    // =================================================================
+
+    struct WallHandle
+    {
+        static constexpr uint32_t InvalidIndex = (std::numeric_limits<uint32_t>::max)();
+
+        uint32_t Index{ InvalidIndex };
+        uint32_t Generation{ 0 };
+
+        bool IsValid() const { return Index != InvalidIndex; }
+
+        bool operator==(const WallHandle& other) const
+        {
+            return Index == other.Index && Generation == other.Generation;
+        }
+        bool operator!=(const WallHandle& other) const { return !(*this == other); }
+    };
+
+    // Bit flags stored per wall in WallHotData::Flags
+    enum WallHotFlags : uint8_t
+    {
+        WallHotFlag_None = 0,
+        WallHotFlag_JoinStart = 1 << 0,
+        WallHotFlag_JoinEnd = 1 << 1,
+        WallHotFlag_HasType = 1 << 2
+    };
+
+    // Hot wall data in SoA layout. Row i describes Objects()[i].
+    struct WallHotData
+    {
+        std::vector<uint64_t> Ids;
+        std::vector<double> StartX;
+        std::vector<double> StartY;
+        std::vector<double> EndX;
+        std::vector<double> EndY;
+        std::vector<double> Thickness;
+        std::vector<double> Height;
+        std::vector<LocationLineMode> LocationModes;
+        std::vector<uint8_t> Flags;
+
+        size_t Size() const { return Ids.size(); }
+        bool Empty() const { return Ids.empty(); }
+
+        WorldPoint GetStart(size_t i) const { return WorldPoint(StartX[i], StartY[i]); }
+        WorldPoint GetEnd(size_t i) const { return WorldPoint(EndX[i], EndY[i]); }
+
+        bool IsJoinAllowedAtStart(size_t i) const { return (Flags[i] & WallHotFlag_JoinStart) != 0; }
+        bool IsJoinAllowedAtEnd(size_t i) const { return (Flags[i] & WallHotFlag_JoinEnd) != 0; }
+
+        // Wall axes for the batched kernels in GeometryKernels.h
+        SegmentSpan Segments() const { return { StartX.data(), StartY.data(), EndX.data(), EndY.data(), Size() }; }
+
+        void Reserve(size_t n)
+        {
+            Ids.reserve(n); StartX.reserve(n); StartY.reserve(n); EndX.reserve(n); EndY.reserve(n);
+            Thickness.reserve(n); Height.reserve(n); LocationModes.reserve(n); Flags.reserve(n);
+        }
+
+        void Clear()
+        {
+            Ids.clear(); StartX.clear(); StartY.clear(); EndX.clear(); EndY.clear();
+            Thickness.clear(); Height.clear(); LocationModes.clear(); Flags.clear();
+        }
+
+        void PushBack(const Wall& wall)
+        {
+            Ids.push_back(0); StartX.push_back(0.0); StartY.push_back(0.0); EndX.push_back(0.0); EndY.push_back(0.0);
+            Thickness.push_back(0.0); Height.push_back(0.0);
+            LocationModes.push_back(LocationLineMode::WallCenterline); Flags.push_back(WallHotFlag_None);
+            Write(Size() - 1, wall);
+        }
+
+        void Write(size_t i, const Wall& wall)
+        {
+            Ids[i] = wall.GetId();
+            StartX[i] = wall.GetStartPoint().X;
+            StartY[i] = wall.GetStartPoint().Y;
+            EndX[i] = wall.GetEndPoint().X;
+            EndY[i] = wall.GetEndPoint().Y;
+            Thickness[i] = wall.GetThickness();
+            Height[i] = wall.GetHeight();
+            LocationModes[i] = wall.GetLocationLineMode();
+
+            uint8_t flags = WallHotFlag_None;
+            if (wall.IsJoinAllowedAtStart()) flags |= WallHotFlag_JoinStart;
+            if (wall.IsJoinAllowedAtEnd()) flags |= WallHotFlag_JoinEnd;
+            if (wall.GetType()) flags |= WallHotFlag_HasType;
+            Flags[i] = flags;
+        }
+
+        // Order-preserving erase of row i
+        void Erase(size_t i)
+        {
+            Ids.erase(Ids.begin() + i);
+            StartX.erase(StartX.begin() + i);
+            StartY.erase(StartY.begin() + i);
+            EndX.erase(EndX.begin() + i);
+            EndY.erase(EndY.begin() + i);
+            Thickness.erase(Thickness.begin() + i);
+            Height.erase(Height.begin() + i);
+            LocationModes.erase(LocationModes.begin() + i);
+            Flags.erase(Flags.begin() + i);
+        }
+    };
+
+    class WallStore
+    {
+    public:
+        WallStore() = default;
+
+        WallStore(const WallStore&) = delete;
+        WallStore& operator=(const WallStore&) = delete;
+        WallStore(WallStore&&) = default;
+        WallStore& operator=(WallStore&&) = default;
+
+        // Take ownership of a wall and return its handle
+        WallHandle Insert(std::unique_ptr<Wall> wall)
+        {
+            if (!wall)
+                return WallHandle{};
+
+            uint32_t slotIndex;
+            if (!m_freeSlots.empty())
+            {
+                slotIndex = m_freeSlots.back();
+                m_freeSlots.pop_back();
+            }
+            else
+            {
+                slotIndex = static_cast<uint32_t>(m_slots.size());
+                m_slots.push_back(Slot{});
+            }
+
+            Slot& slot = m_slots[slotIndex];
+            slot.DenseIndex = static_cast<uint32_t>(m_objects.size());
+
+            m_idToSlot[wall->GetId()] = slotIndex;
+            m_hot.PushBack(*wall);
+            m_hotRevisions.push_back(wall->GetGeometryRevision());
+            m_denseToSlot.push_back(slotIndex);
+            m_objects.push_back(std::move(wall));
+
+            return WallHandle{ slotIndex, slot.Generation };
+        }
+
+        // Remove a wall. Dense order of the remaining walls is preserved
+        // (draw and hit-test order depend on it); removal is O(N) but rare.
+        bool Erase(WallHandle handle)
+        {
+            if (!IsAlive(handle))
+                return false;
+
+            uint32_t dense = m_slots[handle.Index].DenseIndex;
+            m_idToSlot.erase(m_objects[dense]->GetId());
+
+            m_objects.erase(m_objects.begin() + dense);
+            m_hot.Erase(dense);
+            m_hotRevisions.erase(m_hotRevisions.begin() + dense);
+            m_denseToSlot.erase(m_denseToSlot.begin() + dense);
+
+            for (size_t i = dense; i < m_denseToSlot.size(); ++i)
+                m_slots[m_denseToSlot[i]].DenseIndex = static_cast<uint32_t>(i);
+
+            Slot& slot = m_slots[handle.Index];
+            slot.DenseIndex = WallHandle::InvalidIndex;
+            ++slot.Generation;
+            m_freeSlots.push_back(handle.Index);
+            return true;
+        }
+
+        bool EraseById(uint64_t id) { return Erase(FindHandle(id)); }
+
+        bool IsAlive(WallHandle handle) const
+        {
+            return handle.Index < m_slots.size() &&
+                   m_slots[handle.Index].Generation == handle.Generation &&
+                   m_slots[handle.Index].DenseIndex != WallHandle::InvalidIndex;
+        }
+
+        Wall* Get(WallHandle handle) const
+        {
+            return IsAlive(handle) ? m_objects[m_slots[handle.Index].DenseIndex].get() : nullptr;
+        }
+
+        WallHandle FindHandle(uint64_t id) const
+        {
+            auto it = m_idToSlot.find(id);
+            if (it == m_idToSlot.end())
+                return WallHandle{};
+            return WallHandle{ it->second, m_slots[it->second].Generation };
+        }
+
+        Wall* FindById(uint64_t id) const { return Get(FindHandle(id)); }
+
+        // Row of the wall in Objects()/Hot(), or SIZE_MAX
+        size_t DenseIndexOf(WallHandle handle) const
+        {
+            return IsAlive(handle) ? m_slots[handle.Index].DenseIndex : (std::numeric_limits<size_t>::max)();
+        }
+
+        WallHandle HandleAt(size_t denseIndex) const
+        {
+            uint32_t slotIndex = m_denseToSlot[denseIndex];
+            return WallHandle{ slotIndex, m_slots[slotIndex].Generation };
+        }
+
+        // Re-read one wall into the hot arrays
+        void Refresh(WallHandle handle)
+        {
+            if (!IsAlive(handle))
+                return;
+            size_t dense = m_slots[handle.Index].DenseIndex;
+            m_hot.Write(dense, *m_objects[dense]);
+            m_hotRevisions[dense] = m_objects[dense]->GetGeometryRevision();
+        }
+
+        void RefreshById(uint64_t id) { Refresh(FindHandle(id)); }
+
+        // Bring stale rows up to date (walls edited directly through Wall*,
+        // e.g. by undo commands). Calls onChanged(id) for every refreshed row.
+        template <typename Callback>
+        size_t Sync(Callback&& onChanged)
+        {
+            size_t changed = 0;
+            for (size_t i = 0; i < m_objects.size(); ++i)
+            {
+                uint64_t revision = m_objects[i]->GetGeometryRevision();
+                if (revision == m_hotRevisions[i])
+                    continue;
+                m_hot.Write(i, *m_objects[i]);
+                m_hotRevisions[i] = revision;
+                onChanged(m_hot.Ids[i]);
+                ++changed;
+            }
+            return changed;
+        }
+
+        size_t Sync() { return Sync([](uint64_t) {}); }
+
+        const std::vector<std::unique_ptr<Wall>>& Objects() const { return m_objects; }
+        const WallHotData& Hot() const { return m_hot; }
+
+        size_t Size() const { return m_objects.size(); }
+        bool Empty() const { return m_objects.empty(); }
+
+        void Clear()
+        {
+            // Bump generations so outstanding handles become stale
+            for (uint32_t slotIndex : m_denseToSlot)
+            {
+                Slot& slot = m_slots[slotIndex];
+                slot.DenseIndex = WallHandle::InvalidIndex;
+                ++slot.Generation;
+                m_freeSlots.push_back(slotIndex);
+            }
+            m_objects.clear();
+            m_hot.Clear();
+            m_hotRevisions.clear();
+            m_denseToSlot.clear();
+            m_idToSlot.clear();
+        }
+
+        // Range-for over walls in dense order
+        auto begin() const { return m_objects.begin(); }
+        auto end() const { return m_objects.end(); }
+        auto rbegin() const { return m_objects.rbegin(); }
+        auto rend() const { return m_objects.rend(); }
+
+    private:
+        struct Slot
+        {
+            uint32_t DenseIndex{ WallHandle::InvalidIndex };
+            uint32_t Generation{ 0 };
+        };
+
+        std::vector<Slot> m_slots;
+        std::vector<uint32_t> m_freeSlots;
+        std::vector<uint32_t> m_denseToSlot;
+
+        std::vector<std::unique_ptr<Wall>> m_objects;   // cold data: names, types, work state
+        WallHotData m_hot;                              // hot geometry, same order as m_objects
+        std::vector<uint64_t> m_hotRevisions;           // Wall::GetGeometryRevision() at last write
+        std::unordered_map<uint64_t, uint32_t> m_idToSlot;
+    };
+}
@@ -109,6 +109,13 @@ namespace winrt::estimate1
             InvalidateCache();
         }
 
+        // Room kept its id but its contour changed: totals are stale
+        void OnRoomChanged(uint64_t roomId)
+        {
+            if (ContainsRoom(roomId))
+                InvalidateCache();
+        }
+
         const std::set<uint64_t>& GetRoomIds() const { return m_roomIds; }
 
         bool ContainsRoom(uint64_t roomId) const
@@ -244,10 +251,10 @@ namespace winrt::estimate1
             for (const auto& room : m_cachedRooms)
             {
                 if (!room) continue;
-                m_cachedAreaSqM += room->GetAreaSqM();
-                m_cachedPerimeterM += room->GetPerimeterM();
-                m_cachedWallAreaSqM += room->GetWallAreaSqM();
-                m_cachedVolumeCuM += room->GetVolumeCuM();
+                m_cachedAreaSqM += room->GetNetAreaSqM();
+                m_cachedPerimeterM += room->GetNetPerimeterM();
+                m_cachedWallAreaSqM += room->GetNetWallAreaSqM();
+                m_cachedVolumeCuM += room->GetNetVolumeCuM();
             }
 
             m_cacheValid = true;
@@ -315,6 +322,52 @@ namespace winrt::estimate1
                 });
         }
 
+        // Patch zones after an incremental room update instead of
+        // regrouping every room (see RoomDetector::UpdateRooms)
+        void ApplyRoomChanges(const std::vector<std::shared_ptr<Room>>& added,
+                              const std::vector<uint64_t>& removed,
+                              const std::vector<std::shared_ptr<Room>>& modified)
+        {
+            for (uint64_t id : removed)
+            {
+                for (auto& z : m_autoZones)
+                    if (z && z->ContainsRoom(id)) z->RemoveRoom(id);
+                for (auto& z : m_customZones)
+                    if (z && z->ContainsRoom(id)) z->RemoveRoom(id);
+            }
+            m_autoZones.erase(
+                std::remove_if(m_autoZones.begin(), m_autoZones.end(),
+                    [](const std::shared_ptr<Zone>& z) { return !z || z->GetRoomCount() == 0; }),
+                m_autoZones.end());
+
+            for (const auto& room : modified)
+            {
+                if (!room) continue;
+                for (auto& z : m_autoZones)
+                    if (z) z->OnRoomChanged(room->GetId());
+                for (auto& z : m_customZones)
+                    if (z) z->OnRoomChanged(room->GetId());
+            }
+
+            for (const auto& room : added)
+            {
+                if (!room) continue;
+                ZoneType zoneType = Zone::FromRoomCategory(room->GetCategory());
+                auto it = std::find_if(m_autoZones.begin(), m_autoZones.end(),
+                    [zoneType](const std::shared_ptr<Zone>& z) { return z->GetType() == zoneType; });
+                if (it == m_autoZones.end())
+                {
+                    // Keep the order RebuildFromRooms produces
+                    auto pos = std::find_if(m_autoZones.begin(), m_autoZones.end(),
+                        [zoneType](const std::shared_ptr<Zone>& z) {
+                            return static_cast<int>(z->GetType()) > static_cast<int>(zoneType);
+                        });
+                    it = m_autoZones.insert(pos, std::make_shared<Zone>(zoneType));
+                }
+                (*it)->AddRoom(room);
+            }
+        }
+
         //    
         const std::vector<std::shared_ptr<Zone>>& GetAutoZones() const { return m_autoZones; }
 